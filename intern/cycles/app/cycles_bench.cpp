@@ -0,0 +1,772 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Cycles Benchmark
+ *
+ * Renders a set of scenes in background mode and writes the time spent in
+ * every phase of the render, the sample rate and the peak memory usage as
+ * JSON, to track performance between versions.
+ *
+ * Scenes are either XML files or the name of one of the built-in procedural
+ * scenes, which stress the parts of the renderer that are expensive in
+ * production scenes: heavy geometry, many lights, volumes and hair. They
+ * are generated in code since XML files have no hair, and so they don't
+ * need any files next to the benchmark.
+ */
+
+#include <stdio.h>
+
+#include "render/buffers.h"
+#include "render/camera.h"
+#include "device/device.h"
+#include "render/film.h"
+#include "render/graph.h"
+#include "render/integrator.h"
+#include "render/light.h"
+#include "render/mesh.h"
+#include "render/nodes.h"
+#include "render/object.h"
+#include "render/scene.h"
+#include "render/session.h"
+#include "render/shader.h"
+
+#include "util/util_args.h"
+#include "util/util_foreach.h"
+#include "util/util_guarded_allocator.h"
+#include "util/util_hash.h"
+#include "util/util_logging.h"
+#include "util/util_path.h"
+#include "util/util_progress.h"
+#include "util/util_string.h"
+#include "util/util_time.h"
+#include "util/util_transform.h"
+#include "util/util_version.h"
+
+#include "app/cycles_xml.h"
+
+CCL_NAMESPACE_BEGIN
+
+struct Options {
+	vector<string> scenes;
+	string output_path;
+	int width, height;
+	int detail;
+	bool light_tree;
+	bool quiet;
+	SceneParams scene_params;
+	SessionParams session_params;
+} options;
+
+/* Results of rendering one scene. Times are in seconds. */
+struct BenchResult {
+	string name;
+	string error;
+
+	int width, height;
+	size_t num_objects;
+	size_t num_triangles;
+	size_t num_curves;
+	size_t num_lights;
+
+	/* Reading the XML file or generating the scene, the equivalent of
+	 * syncing the scene from Blender. */
+	double sync_time;
+	SceneUpdateTimes update_times;
+	double render_time;
+	double total_time;
+
+	uint64_t pixel_samples;
+	size_t device_mem_peak;
+
+	BenchResult()
+	: width(0),
+	  height(0),
+	  num_objects(0),
+	  num_triangles(0),
+	  num_curves(0),
+	  num_lights(0),
+	  sync_time(0.0),
+	  render_time(0.0),
+	  total_time(0.0),
+	  pixel_samples(0),
+	  device_mem_peak(0)
+	{
+	}
+};
+
+/* Procedural Scenes */
+
+static Shader *bench_add_shader(Scene *scene, const char *name, ShaderGraph *graph)
+{
+	Shader *shader = new Shader();
+	shader->name = name;
+	shader->set_graph(graph);
+	shader->tag_update(scene);
+	scene->shaders.push_back(shader);
+
+	return shader;
+}
+
+static Shader *bench_add_diffuse_shader(Scene *scene, float3 color)
+{
+	ShaderGraph *graph = new ShaderGraph();
+
+	DiffuseBsdfNode *diffuse = new DiffuseBsdfNode();
+	diffuse->color = color;
+	graph->add(diffuse);
+
+	graph->connect(diffuse->output("BSDF"), graph->output()->input("Surface"));
+
+	return bench_add_shader(scene, "diffuse", graph);
+}
+
+static Shader *bench_add_emission_shader(Scene *scene, float3 color, float strength)
+{
+	ShaderGraph *graph = new ShaderGraph();
+
+	EmissionNode *emission = new EmissionNode();
+	emission->color = color;
+	emission->strength = strength;
+	graph->add(emission);
+
+	graph->connect(emission->output("Emission"), graph->output()->input("Surface"));
+
+	return bench_add_shader(scene, "emission", graph);
+}
+
+static Mesh *bench_add_mesh(Scene *scene, Shader *shader)
+{
+	Mesh *mesh = new Mesh();
+	mesh->used_shaders.push_back(shader);
+	scene->meshes.push_back(mesh);
+
+	Object *object = new Object();
+	object->mesh = mesh;
+	object->tfm = transform_identity();
+	scene->objects.push_back(object);
+
+	return mesh;
+}
+
+static void bench_add_light(Scene *scene, Shader *shader, float3 co, float size)
+{
+	Light *light = new Light();
+	light->type = LIGHT_POINT;
+	light->co = co;
+	light->size = size;
+	light->shader = shader;
+	light->use_mis = true;
+	scene->lights.push_back(light);
+}
+
+/* Quad with counter-clockwise vertices seen from the front. */
+static void bench_add_quad(Mesh *mesh, int v0, int v1, int v2, int v3)
+{
+	mesh->add_triangle(v0, v1, v2, 0, false);
+	mesh->add_triangle(v0, v2, v3, 0, false);
+}
+
+static void bench_add_ground(Scene *scene, Shader *shader)
+{
+	const float size = 50.0f;
+
+	Mesh *mesh = bench_add_mesh(scene, shader);
+	mesh->reserve_mesh(4, 2);
+
+	mesh->add_vertex(make_float3(-size, -1.0f, -size));
+	mesh->add_vertex(make_float3(-size, -1.0f, size));
+	mesh->add_vertex(make_float3(size, -1.0f, size));
+	mesh->add_vertex(make_float3(size, -1.0f, -size));
+	bench_add_quad(mesh, 0, 1, 2, 3);
+}
+
+static void bench_add_box(Scene *scene, Shader *shader, float3 bmin, float3 bmax)
+{
+	Mesh *mesh = bench_add_mesh(scene, shader);
+	mesh->reserve_mesh(8, 12);
+
+	for(int i = 0; i < 8; i++) {
+		mesh->add_vertex(make_float3((i & 1)? bmax.x: bmin.x,
+		                             (i & 2)? bmax.y: bmin.y,
+		                             (i & 4)? bmax.z: bmin.z));
+	}
+
+	/* Closed with outward normals, so it can hold a volume. */
+	bench_add_quad(mesh, 0, 4, 6, 2);
+	bench_add_quad(mesh, 1, 3, 7, 5);
+	bench_add_quad(mesh, 0, 1, 5, 4);
+	bench_add_quad(mesh, 2, 6, 7, 3);
+	bench_add_quad(mesh, 0, 2, 3, 1);
+	bench_add_quad(mesh, 4, 5, 7, 6);
+}
+
+static Mesh *bench_add_sphere(Scene *scene,
+                              Shader *shader,
+                              float3 center,
+                              float radius,
+                              int segments,
+                              int rings)
+{
+	Mesh *mesh = bench_add_mesh(scene, shader);
+	mesh->reserve_mesh((rings + 1) * segments, 2 * rings * segments);
+
+	for(int r = 0; r <= rings; r++) {
+		const float theta = M_PI_F * r / rings;
+
+		for(int s = 0; s < segments; s++) {
+			const float phi = M_2PI_F * s / segments;
+			const float3 N = make_float3(sinf(theta) * cosf(phi),
+			                             cosf(theta),
+			                             sinf(theta) * sinf(phi));
+			mesh->add_vertex(center + radius * N);
+		}
+	}
+
+	for(int r = 0; r < rings; r++) {
+		for(int s = 0; s < segments; s++) {
+			const int v00 = r * segments + s;
+			const int v01 = r * segments + (s + 1) % segments;
+			const int v10 = (r + 1) * segments + s;
+			const int v11 = (r + 1) * segments + (s + 1) % segments;
+
+			mesh->add_triangle(v00, v11, v10, 0, true);
+			mesh->add_triangle(v00, v01, v11, 0, true);
+		}
+	}
+
+	return mesh;
+}
+
+/* Grid of unique high resolution spheres, for BVH build and traversal. */
+static void bench_scene_geometry(Scene *scene)
+{
+	Shader *shader = scene->default_surface;
+	const int grid = 8;
+	const int segments = 256 * options.detail;
+	const int rings = 128 * options.detail;
+
+	bench_add_ground(scene, shader);
+
+	for(int y = 0; y < grid; y++) {
+		for(int x = 0; x < grid; x++) {
+			const float3 center = make_float3((x - 0.5f * (grid - 1)) * 0.8f,
+			                                  -0.6f,
+			                                  y * 0.8f - 1.0f);
+			bench_add_sphere(scene, shader, center, 0.4f, segments, rings);
+		}
+	}
+
+	bench_add_light(scene,
+	                bench_add_emission_shader(scene, make_float3(1.0f, 1.0f, 1.0f), 2000.0f),
+	                make_float3(4.0f, 8.0f, -4.0f),
+	                1.0f);
+}
+
+/* Many small colored lights over a few spheres, for light sampling. */
+static void bench_scene_lights(Scene *scene)
+{
+	Shader *shader = scene->default_surface;
+	const int grid = 32 * options.detail;
+	const int num_colors = 8;
+
+	bench_add_ground(scene, shader);
+
+	for(int y = 0; y < 5; y++) {
+		for(int x = 0; x < 5; x++) {
+			const float3 center = make_float3((x - 2) * 1.2f, -0.5f, y * 1.2f - 1.0f);
+			bench_add_sphere(scene, shader, center, 0.5f, 64, 32);
+		}
+	}
+
+	Shader *emission[num_colors];
+	for(int i = 0; i < num_colors; i++) {
+		const float3 color = make_float3(hash_int_01(3*i + 0),
+		                                 hash_int_01(3*i + 1),
+		                                 hash_int_01(3*i + 2));
+		emission[i] = bench_add_emission_shader(scene, color, 20.0f);
+	}
+
+	for(int i = 0; i < grid * grid; i++) {
+		const float3 co = make_float3((hash_int_2d(i, 0) / (float)0xFFFFFFFFu - 0.5f) * 12.0f,
+		                              -0.9f + 2.0f * hash_int_2d(i, 1) / (float)0xFFFFFFFFu,
+		                              (hash_int_2d(i, 2) / (float)0xFFFFFFFFu) * 10.0f - 2.0f);
+		bench_add_light(scene, emission[hash_int(i) % num_colors], co, 0.05f);
+	}
+}
+
+/* Scattering volume around a sphere. */
+static void bench_scene_volume(Scene *scene)
+{
+	bench_add_ground(scene, scene->default_surface);
+	bench_add_sphere(scene, scene->default_surface, make_float3(0.0f, 0.0f, 1.0f), 1.0f, 64, 32);
+
+	ShaderGraph *graph = new ShaderGraph();
+
+	ScatterVolumeNode *scatter = new ScatterVolumeNode();
+	scatter->color = make_float3(0.8f, 0.8f, 0.8f);
+	scatter->density = 0.3f;
+	scatter->anisotropy = 0.3f;
+	graph->add(scatter);
+
+	graph->connect(scatter->output("Volume"), graph->output()->input("Volume"));
+
+	Shader *volume = bench_add_shader(scene, "volume", graph);
+	bench_add_box(scene, volume, make_float3(-3.0f, -1.0f, -1.0f), make_float3(3.0f, 2.0f, 3.0f));
+
+	bench_add_light(scene,
+	                bench_add_emission_shader(scene, make_float3(1.0f, 1.0f, 1.0f), 1000.0f),
+	                make_float3(2.0f, 1.5f, 0.0f),
+	                0.5f);
+}
+
+/* Sphere covered with hair strands. */
+static void bench_scene_hair(Scene *scene)
+{
+	Shader *shader = bench_add_diffuse_shader(scene, make_float3(0.6f, 0.4f, 0.2f));
+	const int num_curves = 100000 * options.detail;
+	const int num_keys = 5;
+	const float radius = 1.0f;
+	const float length = 0.3f;
+
+	bench_add_ground(scene, scene->default_surface);
+	bench_add_sphere(scene, shader, make_float3(0.0f, 0.0f, 1.0f), radius, 64, 32);
+
+	Mesh *mesh = bench_add_mesh(scene, shader);
+	mesh->reserve_curves(num_curves, num_curves * num_keys);
+
+	for(int i = 0; i < num_curves; i++) {
+		/* Uniform point on the sphere. */
+		const float z = 1.0f - 2.0f * hash_int_2d(i, 0) / (float)0xFFFFFFFFu;
+		const float phi = M_2PI_F * hash_int_2d(i, 1) / (float)0xFFFFFFFFu;
+		const float r = safe_sqrtf(1.0f - z * z);
+		const float3 N = make_float3(r * cosf(phi), z, r * sinf(phi));
+		const float3 bend = make_float3(0.0f, -0.3f * length, 0.0f);
+		const float3 root = make_float3(0.0f, 0.0f, 1.0f) + radius * N;
+
+		for(int k = 0; k < num_keys; k++) {
+			const float t = k / (float)(num_keys - 1);
+			const float3 P = root + t * length * N + t * t * bend;
+			mesh->add_curve_key(P, 0.004f * (1.0f - 0.8f * t));
+		}
+		mesh->add_curve(i * num_keys, 0);
+	}
+
+	bench_add_light(scene,
+	                bench_add_emission_shader(scene, make_float3(1.0f, 1.0f, 1.0f), 1000.0f),
+	                make_float3(4.0f, 5.0f, -3.0f),
+	                0.5f);
+}
+
+typedef void (*BenchSceneFunc)(Scene *scene);
+
+static const struct BenchScene {
+	const char *name;
+	BenchSceneFunc func;
+} bench_scenes[] = {
+	{"geometry", bench_scene_geometry},
+	{"lights", bench_scene_lights},
+	{"volume", bench_scene_volume},
+	{"hair", bench_scene_hair},
+	{NULL, NULL},
+};
+
+static BenchSceneFunc bench_scene_find(const string& name)
+{
+	for(int i = 0; bench_scenes[i].name; i++) {
+		if(name == bench_scenes[i].name) {
+			return bench_scenes[i].func;
+		}
+	}
+	return NULL;
+}
+
+static void bench_scene_camera(Scene *scene)
+{
+	Camera *cam = scene->camera;
+
+	cam->width = 960;
+	cam->height = 540;
+	cam->full_width = cam->width;
+	cam->full_height = cam->height;
+	cam->matrix = transform_translate(make_float3(0.0f, 2.0f, -7.0f)) *
+	              transform_rotate(DEG2RADF(15.0f), make_float3(1.0f, 0.0f, 0.0f));
+
+	cam->need_update = true;
+	cam->update(scene);
+}
+
+/* Render */
+
+static BufferParams bench_buffer_params(Scene *scene)
+{
+	BufferParams buffer_params;
+	buffer_params.width = scene->camera->width;
+	buffer_params.height = scene->camera->height;
+	buffer_params.full_width = scene->camera->width;
+	buffer_params.full_height = scene->camera->height;
+
+	if(scene->integrator->use_adaptive_sampling) {
+		Pass::add(PASS_SAMPLE_COUNT, buffer_params.passes);
+		Pass::add(PASS_ADAPTIVE_AUX_BUFFER, buffer_params.passes);
+	}
+
+	return buffer_params;
+}
+
+static BenchResult bench_render(const string& name)
+{
+	BenchResult result;
+	result.name = name;
+
+	BenchSceneFunc scene_func = bench_scene_find(name);
+
+	if(scene_func == NULL && !path_exists(name)) {
+		result.error = "Unknown scene or file not found";
+		return result;
+	}
+
+	if(!options.quiet) {
+		fprintf(stderr, "Rendering %s\n", name.c_str());
+	}
+
+	Session *session = new Session(options.session_params);
+	Scene *scene = new Scene(options.scene_params, session->device);
+
+	/* Sync */
+	{
+		scoped_timer sync_timer(&result.sync_time);
+
+		if(scene_func) {
+			bench_scene_camera(scene);
+			scene_func(scene);
+		}
+		else {
+			xml_read_file(scene, name.c_str());
+		}
+	}
+
+	/* Camera width/height override? */
+	if(!(options.width == 0 || options.height == 0)) {
+		scene->camera->width = options.width;
+		scene->camera->height = options.height;
+		scene->camera->full_width = options.width;
+		scene->camera->full_height = options.height;
+	}
+	scene->camera->compute_auto_viewplane();
+
+	if(options.light_tree) {
+		scene->integrator->use_light_tree = true;
+		scene->integrator->tag_update(scene);
+	}
+
+	BufferParams buffer_params = bench_buffer_params(scene);
+	if(scene->integrator->use_adaptive_sampling) {
+		scene->film->tag_passes_update(scene, buffer_params.passes);
+	}
+
+	result.width = scene->camera->width;
+	result.height = scene->camera->height;
+	result.num_objects = scene->objects.size();
+	result.num_lights = scene->lights.size();
+	foreach(Mesh *mesh, scene->meshes) {
+		result.num_triangles += mesh->num_triangles();
+		result.num_curves += mesh->num_curves();
+	}
+
+	/* Render */
+	session->scene = scene;
+	session->reset(buffer_params, options.session_params.samples);
+	session->start();
+	session->wait();
+
+	Progress& progress = session->progress;
+
+	if(progress.get_error()) {
+		result.error = progress.get_error_message();
+	}
+	else if(progress.get_cancel()) {
+		result.error = progress.get_cancel_message();
+	}
+
+	progress.get_time(result.total_time, result.render_time);
+	result.update_times = scene->update_times;
+	result.pixel_samples = progress.get_pixel_samples();
+	result.device_mem_peak = session->stats.mem_peak;
+
+	/* Also frees the scene. */
+	delete session;
+
+	return result;
+}
+
+/* JSON */
+
+static string json_string(const string& str)
+{
+	string result = "\"";
+
+	foreach(char c, str) {
+		if(c == '"' || c == '\\') {
+			result += '\\';
+			result += c;
+		}
+		else if((unsigned char)c < 0x20) {
+			result += string_printf("\\u%04x", (int)c);
+		}
+		else {
+			result += c;
+		}
+	}
+
+	return result + "\"";
+}
+
+static string json_result(const BenchResult& result)
+{
+	const SceneUpdateTimes& times = result.update_times;
+	const double samples_per_second = (result.render_time > 0.0)?
+	                                  result.pixel_samples / result.render_time: 0.0;
+
+	string str = "\t\t{\n";
+	str += string_printf("\t\t\t\"name\": %s,\n", json_string(result.name).c_str());
+	str += string_printf("\t\t\t\"success\": %s,\n", (result.error == "")? "true": "false");
+	str += string_printf("\t\t\t\"error\": %s,\n", json_string(result.error).c_str());
+	str += string_printf("\t\t\t\"width\": %d,\n", result.width);
+	str += string_printf("\t\t\t\"height\": %d,\n", result.height);
+	str += string_printf("\t\t\t\"objects\": %zu,\n", result.num_objects);
+	str += string_printf("\t\t\t\"triangles\": %zu,\n", result.num_triangles);
+	str += string_printf("\t\t\t\"curves\": %zu,\n", result.num_curves);
+	str += string_printf("\t\t\t\"lights\": %zu,\n", result.num_lights);
+	str += "\t\t\t\"time\": {\n";
+	str += string_printf("\t\t\t\t\"sync\": %f,\n", result.sync_time);
+	str += string_printf("\t\t\t\t\"update\": %f,\n", times.total);
+	str += string_printf("\t\t\t\t\"update_shaders\": %f,\n", times.shaders);
+	str += string_printf("\t\t\t\t\"update_geometry\": %f,\n", times.geometry);
+	str += string_printf("\t\t\t\t\"update_bvh\": %f,\n", times.bvh);
+	str += string_printf("\t\t\t\t\"update_images\": %f,\n", times.images);
+	str += string_printf("\t\t\t\t\"update_lights\": %f,\n", times.lights);
+	str += string_printf("\t\t\t\t\"render\": %f,\n", result.render_time);
+	str += string_printf("\t\t\t\t\"total\": %f\n", result.sync_time + result.total_time);
+	str += "\t\t\t},\n";
+	str += string_printf("\t\t\t\"pixel_samples\": %llu,\n", (unsigned long long)result.pixel_samples);
+	str += string_printf("\t\t\t\"samples_per_second\": %f,\n", samples_per_second);
+	str += string_printf("\t\t\t\"device_memory_peak\": %zu\n", result.device_mem_peak);
+	str += "\t\t}";
+
+	return str;
+}
+
+static string json_results(const vector<BenchResult>& results)
+{
+	string str = "{\n";
+	str += string_printf("\t\"version\": %s,\n", json_string(CYCLES_VERSION_STRING).c_str());
+	str += string_printf("\t\"device\": %s,\n", json_string(options.session_params.device.description).c_str());
+	str += string_printf("\t\"threads\": %d,\n", options.session_params.threads);
+	str += string_printf("\t\"samples\": %d,\n", options.session_params.samples);
+	/* Process wide, includes all scenes. */
+	str += string_printf("\t\"system_memory_peak\": %zu,\n", util_guarded_get_mem_peak());
+	str += "\t\"scenes\": [\n";
+
+	for(size_t i = 0; i < results.size(); i++) {
+		str += json_result(results[i]);
+		str += (i + 1 < results.size())? ",\n": "\n";
+	}
+
+	str += "\t]\n";
+	str += "}\n";
+
+	return str;
+}
+
+/* Options */
+
+static int files_parse(int argc, const char *argv[])
+{
+	for(int i = 0; i < argc; i++) {
+		options.scenes.push_back(argv[i]);
+	}
+
+	return 0;
+}
+
+static void options_parse(int argc, const char **argv)
+{
+	options.width = 0;
+	options.height = 0;
+	options.detail = 1;
+	options.light_tree = false;
+	options.quiet = false;
+	options.session_params.samples = 16;
+
+	/* device names */
+	string device_names = "";
+	string devicename = "CPU";
+
+	vector<DeviceType>& types = Device::available_types();
+
+	foreach(DeviceType type, types) {
+		if(device_names != "")
+			device_names += ", ";
+
+		device_names += Device::string_from_type(type);
+	}
+
+	/* scene names */
+	string scene_names = "";
+
+	for(int i = 0; bench_scenes[i].name; i++) {
+		if(scene_names != "")
+			scene_names += ", ";
+
+		scene_names += bench_scenes[i].name;
+	}
+
+	string bvhname = "bvh2";
+
+	/* parse options */
+	ArgParse ap;
+	bool help = false, debug = false, version = false, all = false;
+	int verbosity = 1;
+
+	ap.options ("Usage: cycles_bench [options] scene.xml|scene_name ...",
+		"%*", files_parse, "",
+		"--all", &all, ("Render all built-in scenes: " + scene_names).c_str(),
+		"--device %s", &devicename, ("Devices to use: " + device_names).c_str(),
+		"--samples %d", &options.session_params.samples, "Number of samples to render",
+		"--threads %d", &options.session_params.threads, "CPU Rendering Threads",
+		"--output %s", &options.output_path, "File path to write JSON statistics to, instead of the standard output",
+		"--quiet", &options.quiet, "Don't print the scene being rendered",
+		"--detail %d", &options.detail, "Multiplier for the amount of geometry and lights in built-in scenes",
+		"--bvh-layout %s", &bvhname, "BVH layout to use on CPU: bvh2, bvh4, bvh8",
+		"--light-tree", &options.light_tree, "Sample lights with the light tree",
+		"--compact-geometry", &options.scene_params.use_compact_geometry, "Store vertex normals, UV maps and tangents with reduced precision",
+		"--width  %d", &options.width, "Image width in pixel",
+		"--height %d", &options.height, "Image height in pixel",
+		"--tile-width %d", &options.session_params.tile_size.x, "Tile width in pixels",
+		"--tile-height %d", &options.session_params.tile_size.y, "Tile height in pixels",
+#ifdef WITH_CYCLES_LOGGING
+		"--debug", &debug, "Enable debug logging",
+		"--verbose %d", &verbosity, "Set verbosity of the logger",
+#endif
+		"--help", &help, "Print help message",
+		"--version", &version, "Print version number",
+		NULL);
+
+	if(ap.parse(argc, argv) < 0) {
+		fprintf(stderr, "%s\n", ap.geterror().c_str());
+		ap.usage();
+		exit(EXIT_FAILURE);
+	}
+
+	if(debug) {
+		util_logging_start();
+		util_logging_verbosity_set(verbosity);
+	}
+
+	if(all) {
+		for(int i = 0; bench_scenes[i].name; i++) {
+			options.scenes.push_back(bench_scenes[i].name);
+		}
+	}
+
+	if(version) {
+		printf("%s\n", CYCLES_VERSION_STRING);
+		exit(EXIT_SUCCESS);
+	}
+	else if(help || options.scenes.empty()) {
+		ap.usage();
+		exit(EXIT_SUCCESS);
+	}
+
+	if(bvhname == "bvh2")
+		options.scene_params.bvh_layout = BVH_LAYOUT_BVH2;
+	else if(bvhname == "bvh4")
+		options.scene_params.bvh_layout = BVH_LAYOUT_BVH4;
+	else if(bvhname == "bvh8")
+		options.scene_params.bvh_layout = BVH_LAYOUT_BVH8;
+
+	/* Final render of whole tiles, as in Blender. */
+	options.session_params.background = true;
+	options.session_params.progressive = false;
+
+	/* find matching device */
+	DeviceType device_type = Device::type_from_string(devicename.c_str());
+	vector<DeviceInfo>& devices = Device::available_devices();
+	bool device_available = false;
+
+	foreach(DeviceInfo& device, devices) {
+		if(device_type == device.type) {
+			options.session_params.device = device;
+			device_available = true;
+			break;
+		}
+	}
+
+	/* handle invalid configurations */
+	if(options.session_params.device.type == DEVICE_NONE || !device_available) {
+		fprintf(stderr, "Unknown device: %s\n", devicename.c_str());
+		exit(EXIT_FAILURE);
+	}
+	else if(!(bvhname == "bvh2" || bvhname == "bvh4" || bvhname == "bvh8")) {
+		fprintf(stderr, "Unknown BVH layout: %s\n", bvhname.c_str());
+		exit(EXIT_FAILURE);
+	}
+	else if(options.session_params.samples <= 0) {
+		fprintf(stderr, "Invalid number of samples: %d\n", options.session_params.samples);
+		exit(EXIT_FAILURE);
+	}
+	else if(options.detail <= 0) {
+		fprintf(stderr, "Invalid detail: %d\n", options.detail);
+		exit(EXIT_FAILURE);
+	}
+}
+
+CCL_NAMESPACE_END
+
+using namespace ccl;
+
+int main(int argc, const char **argv)
+{
+	util_logging_init(argv[0]);
+	path_init();
+	options_parse(argc, argv);
+
+	vector<BenchResult> results;
+	bool success = true;
+
+	foreach(const string& name, options.scenes) {
+		results.push_back(bench_render(name));
+
+		if(results.back().error != "") {
+			fprintf(stderr, "%s: %s\n", name.c_str(), results.back().error.c_str());
+			success = false;
+		}
+	}
+
+	string json = json_results(results);
+
+	if(options.output_path != "") {
+		if(!path_write_text(options.output_path, json)) {
+			fprintf(stderr, "Failed to write %s\n", options.output_path.c_str());
+			return EXIT_FAILURE;
+		}
+	}
+	else {
+		printf("%s", json.c_str());
+	}
+
+	return (success)? EXIT_SUCCESS: EXIT_FAILURE;
+}
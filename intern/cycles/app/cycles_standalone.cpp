@@ -19,6 +19,7 @@
 #include "render/buffers.h"
 #include "render/camera.h"
 #include "device/device.h"
+#include "render/film.h"
 #include "render/scene.h"
 #include "render/session.h"
 #include "render/integrator.h"
@@ -52,6 +53,9 @@ struct Options {
 	bool quiet;
 	bool show_help, interactive, pause;
 	string output_path;
+	string ray_stream;
+	bool benchmark;
+	double render_time;
 } options;
 
 static void session_print(const string& str)
@@ -123,6 +127,11 @@ static BufferParams& session_buffer_params()
 	buffer_params.full_width = options.width;
 	buffer_params.full_height = options.height;
 
+	if(options.scene && options.scene->integrator->use_adaptive_sampling) {
+		Pass::add(PASS_SAMPLE_COUNT, buffer_params.passes);
+		Pass::add(PASS_ADAPTIVE_AUX_BUFFER, buffer_params.passes);
+	}
+
 	return buffer_params;
 }
 
@@ -143,8 +152,21 @@ static void scene_init()
 		options.height = options.scene->camera->height;
 	}
 
+	/* Ray streams override? */
+	if(options.ray_stream != "") {
+		options.scene->integrator->use_camera_ray_stream = (options.ray_stream == "camera" ||
+		                                                    options.ray_stream == "all");
+		options.scene->integrator->use_shadow_ray_stream = (options.ray_stream == "shadow" ||
+		                                                    options.ray_stream == "all");
+	}
+
 	/* Calculate Viewplane */
 	options.scene->camera->compute_auto_viewplane();
+
+	/* Adaptive sampling needs its passes in the film. */
+	if(options.scene->integrator->use_adaptive_sampling) {
+		options.scene->film->tag_passes_update(options.scene, session_buffer_params().passes);
+	}
 }
 
 static void session_init()
@@ -169,17 +191,49 @@ static void session_init()
 
 static void session_exit()
 {
+	double total_time = 0.0, sample_time = 0.0;
+
 	if(options.session) {
+		options.session->progress.get_time(total_time, sample_time);
 		delete options.session;
 		options.session = NULL;
 	}
 
+	options.render_time = sample_time;
+
 	if(options.session_params.background && !options.quiet) {
-		session_print("Finished Rendering.");
+		session_print(string_printf("Finished Rendering in %.2f seconds.", total_time));
 		printf("\n");
 	}
 }
 
+/* Render the scene without ray streams and then with them, to compare the
+ * render times. */
+static void benchmark_ray_stream()
+{
+	const string ray_stream = (options.ray_stream == "" || options.ray_stream == "none")?
+	                          "all": options.ray_stream;
+	const string modes[2] = {"none", ray_stream};
+	double render_time[2];
+
+	for(int i = 0; i < 2; i++) {
+		options.ray_stream = modes[i];
+
+		session_init();
+		options.session->wait();
+		session_exit();
+
+		render_time[i] = options.render_time;
+	}
+
+	for(int i = 0; i < 2; i++) {
+		printf("Ray streams %-6s: %.2f seconds\n", modes[i].c_str(), render_time[i]);
+	}
+	if(render_time[1] > 0.0) {
+		printf("Speedup: %.2fx\n", render_time[0] / render_time[1]);
+	}
+}
+
 #ifdef WITH_CYCLES_STANDALONE_GUI
 static void display_info(Progress& progress)
 {
@@ -357,6 +411,9 @@ static void options_parse(int argc, const char **argv)
 	options.filepath = "";
 	options.session = NULL;
 	options.quiet = false;
+	options.ray_stream = "";
+	options.benchmark = false;
+	options.render_time = 0.0;
 
 	/* device names */
 	string device_names = "";
@@ -380,6 +437,9 @@ static void options_parse(int argc, const char **argv)
 	/* shading system */
 	string ssname = "svm";
 
+	/* BVH layout, defaults to bvh2 or to bvh4 for ray streams */
+	string bvhname = "";
+
 	/* parse options */
 	ArgParse ap;
 	bool help = false, debug = false, version = false;
@@ -396,6 +456,12 @@ static void options_parse(int argc, const char **argv)
 		"--samples %d", &options.session_params.samples, "Number of samples to render",
 		"--output %s", &options.output_path, "File path to write output image",
 		"--threads %d", &options.session_params.threads, "CPU Rendering Threads",
+		"--bvh-layout %s", &bvhname, "BVH layout to use on CPU: bvh2, bvh4, bvh8",
+		"--ray-stream %s", &options.ray_stream, "Trace rays of the CPU path tracer in packets: none, camera, shadow, all",
+		"--benchmark", &options.benchmark, "Render in background without and with ray streams, and print the render times",
+		"--texture-cache %d", &options.scene_params.texture_cache_size, "Size of the texture cache in megabytes, images are read on demand from tiled, mipmapped files (CPU and SVM only)",
+		"--texture-cache-path %s", &options.scene_params.texture_cache_path, "Directory for .tx files generated for the texture cache",
+		"--compact-geometry", &options.scene_params.use_compact_geometry, "Store vertex normals, UV maps and tangents with reduced precision",
 		"--width  %d", &options.width, "Window width in pixel",
 		"--height %d", &options.height, "Window height in pixel",
 		"--tile-width %d", &options.session_params.tile_size.x, "Tile width in pixels",
@@ -447,10 +513,27 @@ static void options_parse(int argc, const char **argv)
 	else if(ssname == "svm")
 		options.scene_params.shadingsystem = SHADINGSYSTEM_SVM;
 
+	if(bvhname == "") {
+		const bool use_ray_stream = options.benchmark ||
+		                            (options.ray_stream != "" && options.ray_stream != "none");
+		bvhname = (use_ray_stream)? "bvh4": "bvh2";
+	}
+
+	if(bvhname == "bvh2")
+		options.scene_params.bvh_layout = BVH_LAYOUT_BVH2;
+	else if(bvhname == "bvh4")
+		options.scene_params.bvh_layout = BVH_LAYOUT_BVH4;
+	else if(bvhname == "bvh8")
+		options.scene_params.bvh_layout = BVH_LAYOUT_BVH8;
+
 #ifndef WITH_CYCLES_STANDALONE_GUI
 	options.session_params.background = true;
 #endif
 
+	if(options.benchmark) {
+		options.session_params.background = true;
+	}
+
 	/* Use progressive rendering */
 	options.session_params.progressive = true;
 
@@ -482,6 +565,20 @@ static void options_parse(int argc, const char **argv)
 		exit(EXIT_FAILURE);
 	}
 #endif
+	else if(!(bvhname == "bvh2" || bvhname == "bvh4" || bvhname == "bvh8")) {
+		fprintf(stderr, "Unknown BVH layout: %s\n", bvhname.c_str());
+		exit(EXIT_FAILURE);
+	}
+	else if(!(options.ray_stream == "" || options.ray_stream == "none" || options.ray_stream == "camera" ||
+	          options.ray_stream == "shadow" || options.ray_stream == "all"))
+	{
+		fprintf(stderr, "Unknown ray stream: %s\n", options.ray_stream.c_str());
+		exit(EXIT_FAILURE);
+	}
+	else if(options.scene_params.texture_cache_size < 0) {
+		fprintf(stderr, "Invalid texture cache size: %d\n", options.scene_params.texture_cache_size);
+		exit(EXIT_FAILURE);
+	}
 	else if(options.session_params.samples < 0) {
 		fprintf(stderr, "Invalid number of samples: %d\n", options.session_params.samples);
 		exit(EXIT_FAILURE);
@@ -505,6 +602,11 @@ int main(int argc, const char **argv)
 	path_init();
 	options_parse(argc, argv);
 
+	if(options.benchmark) {
+		benchmark_ray_stream();
+		return 0;
+	}
+
 #ifdef WITH_CYCLES_STANDALONE_GUI
 	if(options.session_params.background) {
 #endif
@@ -50,6 +50,7 @@ enum_displacement_methods = (
 enum_bvh_layouts = (
     ('BVH2', "BVH2", "", 1),
     ('BVH4', "BVH4", "", 2),
+    ('BVH8', "BVH8", "", 4),
     )
 
 enum_bvh_types = (
@@ -289,6 +290,31 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 min=0.0, max=1.0,
                 default=0.01,
                 )
+        cls.use_light_tree = BoolProperty(
+                name="Light Tree",
+                description="Pick lights by their estimated contribution to the shading point rather than by power, "
+                            "reduces noise in scenes with many lights (not used when sampling all lights)",
+                default=False,
+                )
+
+        cls.use_adaptive_sampling = BoolProperty(
+                name="Adaptive Sampling",
+                description="Automatically stop sampling pixels whose noise is below the threshold (CPU only)",
+                default=False,
+                )
+        cls.adaptive_threshold = FloatProperty(
+                name="Adaptive Threshold",
+                description="Noise level at which pixels stop receiving samples, lower values give less noise",
+                min=0.0, max=1.0,
+                default=0.01,
+                precision=4,
+                )
+        cls.adaptive_min_samples = IntProperty(
+                name="Adaptive Min Samples",
+                description="Minimum number of samples per pixel before adaptive sampling can stop it",
+                min=4, max=4096,
+                default=16,
+                )
 
         cls.caustics_reflective = BoolProperty(
                 name="Reflective Caustics",
@@ -644,6 +670,55 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
             items=enum_texture_limit
             )
 
+        cls.use_texture_cache = BoolProperty(
+            name="Texture Cache",
+            description="Read image textures on demand from tiled, mipmapped files instead of loading them fully "
+                        "into memory, files are converted on first use (CPU and SVM only)",
+            default=False,
+            )
+
+        cls.texture_cache_size = IntProperty(
+            name="Cache Size",
+            description="Maximum memory used by texture tiles, in megabytes",
+            default=4096,
+            min=16, max=1048576,
+            )
+
+        cls.texture_cache_path = StringProperty(
+            name="Cache Path",
+            description="Directory for tiled, mipmapped .tx files generated from image textures, "
+                        "the user cache directory is used when empty",
+            default="",
+            subtype='DIR_PATH',
+            )
+
+        cls.use_camera_ray_stream = BoolProperty(
+            name="Camera Rays",
+            description="Trace camera rays of neighboring pixels together in packets, "
+                        "faster for scenes without motion blur and hair (CPU path tracing only)",
+            default=False,
+            )
+        cls.use_shadow_ray_stream = BoolProperty(
+            name="Shadow Rays",
+            description="Queue opaque shadow rays and trace them together in packets (CPU path tracing only)",
+            default=False,
+            )
+
+        cls.use_persistent_bvh = BoolProperty(
+            name="Persistent BVH",
+            description="Keep the BVH of every mesh between frames of a final render with persistent data, "
+                        "only meshes which changed are updated. Faster updates of animations, "
+                        "but can render slower than a single BVH over the whole scene when objects overlap",
+            default=False,
+            )
+
+        cls.use_compact_geometry = BoolProperty(
+            name="Compact Geometry",
+            description="Store vertex normals, UV maps and tangents with reduced precision to use less memory, "
+                        "UV maps far outside of the 0..1 range may show texture artifacts",
+            default=False,
+            )
+
         cls.ao_bounces = IntProperty(
             name="AO Bounces",
             default=0,
@@ -1236,6 +1311,12 @@ class CyclesRenderLayerSettings(bpy.types.PropertyGroup):
                 default=False,
                 update=update_render_passes,
                 )
+        cls.pass_debug_sample_count = BoolProperty(
+                name="Debug Sample Count",
+                description="Number of samples per pixel taken with adaptive sampling, relative to the total samples",
+                default=False,
+                update=update_render_passes,
+                )
         cls.use_pass_volume_direct = BoolProperty(
                 name="Volume Direct",
                 description="Deliver direct volumetric scattering pass",
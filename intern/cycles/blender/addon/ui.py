@@ -203,7 +203,19 @@ class CYCLES_RENDER_PT_sampling(CyclesButtonsPanel, Panel):
             col.prop(cscene, "sample_all_lights_direct")
             col.prop(cscene, "sample_all_lights_indirect")
 
+        row = layout.row()
+        row.active = not (use_branched_path(context) and use_sample_all_lights(context))
+        row.prop(cscene, "use_light_tree")
+
         layout.row().prop(cscene, "sampling_pattern", text="Pattern")
+
+        row = layout.row(align=True)
+        row.prop(cscene, "use_adaptive_sampling", text="Adaptive")
+        sub = row.row(align=True)
+        sub.active = cscene.use_adaptive_sampling
+        sub.prop(cscene, "adaptive_threshold", text="Threshold")
+        sub.prop(cscene, "adaptive_min_samples", text="Min Samples")
+
         draw_samples_info(layout, context)
 
 
@@ -417,7 +429,10 @@ class CYCLES_RENDER_PT_performance(CyclesButtonsPanel, Panel):
 
         col.label(text="Final Render:")
         col.prop(rd, "use_save_buffers")
-        col.prop(rd, "use_persistent_data", text="Persistent Images")
+        col.prop(rd, "use_persistent_data", text="Persistent Data")
+        sub = col.column()
+        sub.active = rd.use_persistent_data
+        sub.prop(cscene, "use_persistent_bvh")
 
         col.separator()
 
@@ -429,6 +444,23 @@ class CYCLES_RENDER_PT_performance(CyclesButtonsPanel, Panel):
         row.active = not cscene.debug_use_spatial_splits
         row.prop(cscene, "debug_bvh_time_steps")
 
+        col.prop(cscene, "use_compact_geometry")
+
+        col = layout.column()
+        col.active = not cscene.shading_system and cscene.device == 'CPU'
+        col.prop(cscene, "use_texture_cache")
+        sub = col.column()
+        sub.active = cscene.use_texture_cache
+        sub.prop(cscene, "texture_cache_size")
+        sub.prop(cscene, "texture_cache_path", text="")
+
+        col = layout.column()
+        col.active = cscene.device == 'CPU' and cscene.progressive == 'PATH'
+        col.label(text="Ray Streams:")
+        row = col.row(align=True)
+        row.prop(cscene, "use_camera_ray_stream", toggle=True)
+        row.prop(cscene, "use_shadow_ray_stream", toggle=True)
+
         col = layout.column()
         col.label(text="Viewport Resolution:")
         split = col.split()
@@ -531,6 +563,7 @@ class CYCLES_RENDER_PT_layer_passes(CyclesButtonsPanel, Panel):
 
         col = layout.column()
         col.prop(cycles_view_layer, "pass_debug_render_time")
+        col.prop(cycles_view_layer, "pass_debug_sample_count")
         if _cycles.with_cycles_debug:
             col.prop(cycles_view_layer, "pass_debug_bvh_traversed_nodes")
             col.prop(cycles_view_layer, "pass_debug_bvh_traversed_instances")
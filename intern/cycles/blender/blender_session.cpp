@@ -115,7 +115,7 @@ void BlenderSession::create()
 void BlenderSession::create_session()
 {
 	SessionParams session_params = BlenderSync::get_session_params(b_engine, b_userpref, b_scene, background);
-	SceneParams scene_params = BlenderSync::get_scene_params(b_scene, background);
+	SceneParams scene_params = BlenderSync::get_scene_params(b_data, b_scene, background);
 	bool session_pause = BlenderSync::get_session_pause(b_scene, background);
 
 	/* reset status/progress */
@@ -173,7 +173,7 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 	b_scene = b_scene_;
 
 	SessionParams session_params = BlenderSync::get_session_params(b_engine, b_userpref, b_scene, background);
-	SceneParams scene_params = BlenderSync::get_scene_params(b_scene, background);
+	SceneParams scene_params = BlenderSync::get_scene_params(b_data, b_scene, background);
 
 	width = render_resolution_x(b_render);
 	height = render_resolution_y(b_render);
@@ -194,7 +194,6 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 	}
 
 	session->progress.reset();
-	scene->reset();
 
 	session->tile_manager.set_tile_order(session_params.tile_order);
 
@@ -206,8 +205,16 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 	/* There is no single depsgraph to use for the entire render.
 	 * See note on create_session().
 	 */
-	/* sync object should be re-created */
-	sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress);
+	if(sync == NULL) {
+		/* scene data was freed after baking, sync everything again */
+		scene->reset();
+		sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress);
+	}
+	else {
+		/* keep the scene and everything synced for previous frames, only
+		 * data tagged for update by the depsgraph is synced again, see render() */
+		sync->reset(b_data, b_scene);
+	}
 
 	BL::SpaceView3D b_null_space_view3d(PointerRNA_NULL);
 	BL::RegionView3D b_null_region_view3d(PointerRNA_NULL);
@@ -367,6 +374,12 @@ void BlenderSession::render(BL::Depsgraph& b_depsgraph)
 	SessionParams session_params = BlenderSync::get_session_params(b_engine, b_userpref, b_scene, background);
 	BufferParams buffer_params = BlenderSync::get_buffer_params(b_render, b_v3d, b_rv3d, scene->camera, width, height);
 
+	/* with persistent data the update tags of the frame are kept until it is
+	 * rendered, the depsgraph has been evaluated for the frame at this point */
+	if(scene->params.persistent_data) {
+		sync->sync_recalc();
+	}
+
 	/* render each layer */
 	BL::ViewLayer b_view_layer = b_depsgraph.view_layer();
 
@@ -727,7 +740,7 @@ void BlenderSession::synchronize(BL::Depsgraph& b_depsgraph)
 
 	/* on session/scene parameter changes, we recreate session entirely */
 	SessionParams session_params = BlenderSync::get_session_params(b_engine, b_userpref, b_scene, background);
-	SceneParams scene_params = BlenderSync::get_scene_params(b_scene, background);
+	SceneParams scene_params = BlenderSync::get_scene_params(b_data, b_scene, background);
 	bool session_pause = BlenderSync::get_session_pause(b_scene, background);
 
 	if(session->params.modified(session_params) ||
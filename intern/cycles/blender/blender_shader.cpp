@@ -1460,7 +1460,7 @@ void BlenderSync::sync_shaders(BL::Depsgraph& b_depsgraph)
 	/* for auto refresh images */
 	bool auto_refresh_update = false;
 
-	if(preview) {
+	if(preview || scene->params.persistent_data) {
 		ImageManager *image_manager = scene->image_manager;
 		int frame = b_scene.frame_current();
 		auto_refresh_update = image_manager->set_animation_frame_update(frame);
@@ -74,6 +74,14 @@ BlenderSync::~BlenderSync()
 {
 }
 
+void BlenderSync::reset(BL::BlendData& b_data, BL::Scene& b_scene)
+{
+	/* Pointers to data and scene may change between frames, the maps of
+	 * synced data are kept. */
+	this->b_data = b_data;
+	this->b_scene = b_scene;
+}
+
 /* Sync */
 
 bool BlenderSync::sync_recalc()
@@ -287,6 +295,14 @@ void BlenderSync::sync_integrator()
 	integrator->sample_all_lights_direct = get_boolean(cscene, "sample_all_lights_direct");
 	integrator->sample_all_lights_indirect = get_boolean(cscene, "sample_all_lights_indirect");
 	integrator->light_sampling_threshold = get_float(cscene, "light_sampling_threshold");
+	integrator->use_light_tree = get_boolean(cscene, "use_light_tree");
+
+	integrator->use_camera_ray_stream = get_boolean(cscene, "use_camera_ray_stream");
+	integrator->use_shadow_ray_stream = get_boolean(cscene, "use_shadow_ray_stream");
+
+	integrator->use_adaptive_sampling = get_boolean(cscene, "use_adaptive_sampling");
+	integrator->adaptive_threshold = get_float(cscene, "adaptive_threshold");
+	integrator->adaptive_min_samples = get_int(cscene, "adaptive_min_samples");
 
 	int diffuse_samples = get_int(cscene, "diffuse_samples");
 	int glossy_samples = get_int(cscene, "glossy_samples");
@@ -476,6 +492,7 @@ PassType BlenderSync::get_pass_type(BL::RenderPass& b_pass)
 	MAP_PASS("Debug Ray Bounces", PASS_RAY_BOUNCES);
 #endif
 	MAP_PASS("Debug Render Time", PASS_RENDER_TIME);
+	MAP_PASS("Debug Sample Count", PASS_SAMPLE_COUNT);
 #undef MAP_PASS
 
 	return PASS_NONE;
@@ -566,6 +583,15 @@ array<Pass> BlenderSync::sync_render_passes(BL::RenderLayer& b_rlay,
 		b_engine.add_pass("Debug Render Time", 1, "X", b_view_layer.name().c_str());
 		Pass::add(PASS_RENDER_TIME, passes);
 	}
+	if(get_boolean(crp, "pass_debug_sample_count")) {
+		b_engine.add_pass("Debug Sample Count", 1, "X", b_view_layer.name().c_str());
+		Pass::add(PASS_SAMPLE_COUNT, passes);
+	}
+	PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
+	if(get_boolean(cscene, "use_adaptive_sampling")) {
+		Pass::add(PASS_SAMPLE_COUNT, passes);
+		Pass::add(PASS_ADAPTIVE_AUX_BUFFER, passes);
+	}
 	if(get_boolean(crp, "use_pass_volume_direct")) {
 		b_engine.add_pass("VolumeDir", 3, "RGB", b_view_layer.name().c_str());
 		Pass::add(PASS_VOLUME_DIRECT, passes);
@@ -580,7 +606,8 @@ array<Pass> BlenderSync::sync_render_passes(BL::RenderLayer& b_rlay,
 
 /* Scene Parameters */
 
-SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
+SceneParams BlenderSync::get_scene_params(BL::BlendData& b_data,
+                                          BL::Scene& b_scene,
                                           bool background)
 {
 	BL::RenderSettings r = b_scene.render();
@@ -593,7 +620,19 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 	else if(shadingsystem == 1)
 		params.shadingsystem = SHADINGSYSTEM_OSL;
 	
-	if(background || DebugFlags().viewport_static_bvh)
+	if(background && params.shadingsystem != SHADINGSYSTEM_OSL)
+		params.persistent_data = r.use_persistent_data();
+	else
+		params.persistent_data = false;
+
+	/* With persistent data mesh BVHs can be kept between frames, so only the
+	 * meshes which changed need to be refitted or rebuilt and the scene BVH
+	 * only has to be built over the objects. The two level BVH can be slower
+	 * to render when objects overlap though, so this is optional.
+	 */
+	const bool persistent_bvh = params.persistent_data && get_boolean(cscene, "use_persistent_bvh");
+
+	if((background && !persistent_bvh) || DebugFlags().viewport_static_bvh)
 		params.bvh_type = SceneParams::BVH_STATIC;
 	else
 		params.bvh_type = SceneParams::BVH_DYNAMIC;
@@ -602,11 +641,6 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 	params.use_bvh_unaligned_nodes = RNA_boolean_get(&cscene, "debug_use_hair_bvh");
 	params.num_bvh_time_steps = RNA_int_get(&cscene, "debug_bvh_time_steps");
 
-	if(background && params.shadingsystem != SHADINGSYSTEM_OSL)
-		params.persistent_data = r.use_persistent_data();
-	else
-		params.persistent_data = false;
-
 	int texture_limit;
 	if(background) {
 		texture_limit = RNA_enum_get(&cscene, "texture_limit_render");
@@ -621,8 +655,24 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 		params.texture_limit = 0;
 	}
 
+	if(get_boolean(cscene, "use_texture_cache")) {
+		params.texture_cache_size = get_int(cscene, "texture_cache_size");
+		params.texture_cache_path = blender_absolute_path(b_data,
+		                                                  b_scene,
+		                                                  get_string(cscene, "texture_cache_path"));
+	}
+
+	params.use_compact_geometry = get_boolean(cscene, "use_compact_geometry");
+
 	params.bvh_layout = DebugFlags().cpu.bvh_layout;
 
+	/* Packets of ray streams traverse the 4-wide BVH. */
+	if(params.bvh_layout == BVH_LAYOUT_BVH8 &&
+	   (get_boolean(cscene, "use_camera_ray_stream") || get_boolean(cscene, "use_shadow_ray_stream")))
+	{
+		params.bvh_layout = BVH_LAYOUT_BVH4;
+	}
+
 	return params;
 }
 
@@ -58,6 +58,10 @@ public:
 	            Progress &progress);
 	~BlenderSync();
 
+	/* Use the data and scene of the next frame with persistent data, keeping
+	 * everything synced so far. */
+	void reset(BL::BlendData& b_data, BL::Scene& b_scene);
+
 	/* sync */
 	bool sync_recalc();
 	void sync_data(BL::RenderSettings& b_render,
@@ -82,7 +86,8 @@ public:
 	inline int get_layer_bound_samples() { return view_layer.bound_samples; }
 
 	/* get parameters */
-	static SceneParams get_scene_params(BL::Scene& b_scene,
+	static SceneParams get_scene_params(BL::BlendData& b_data,
+	                                    BL::Scene& b_scene,
 	                                    bool background);
 	static SessionParams get_session_params(BL::RenderEngine& b_engine,
 	                                        BL::UserPreferences& b_userpref,
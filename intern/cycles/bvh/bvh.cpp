@@ -22,6 +22,7 @@
 
 #include "bvh/bvh2.h"
 #include "bvh/bvh4.h"
+#include "bvh/bvh8.h"
 #include "bvh/bvh_build.h"
 #include "bvh/bvh_node.h"
 
@@ -38,6 +39,7 @@ const char *bvh_layout_name(BVHLayout layout)
 	switch(layout) {
 		case BVH_LAYOUT_BVH2: return "BVH2";
 		case BVH_LAYOUT_BVH4: return "BVH4";
+		case BVH_LAYOUT_BVH8: return "BVH8";
 		case BVH_LAYOUT_NONE: return "NONE";
 		case BVH_LAYOUT_ALL:  return "ALL";
 	}
@@ -81,7 +83,12 @@ int BVHStackEntry::encodeIdx() const
 /* BVH */
 
 BVH::BVH(const BVHParams& params_, const vector<Object*>& objects_)
-: params(params_), objects(objects_)
+: params(params_),
+  objects(objects_),
+  build_leaf_cost(0.0f),
+  leaf_cost(0.0f),
+  leaf_bounds(BoundBox::empty),
+  leaf_area(0.0f)
 {
 }
 
@@ -92,6 +99,8 @@ BVH *BVH::create(const BVHParams& params, const vector<Object*>& objects)
 			return new BVH2(params, objects);
 		case BVH_LAYOUT_BVH4:
 			return new BVH4(params, objects);
+		case BVH_LAYOUT_BVH8:
+			return new BVH8(params, objects);
 		case BVH_LAYOUT_NONE:
 		case BVH_LAYOUT_ALL:
 			break;
@@ -134,6 +143,16 @@ void BVH::build(Progress& progress)
 	progress.set_substatus("Packing BVH nodes");
 	pack_nodes(root);
 
+	/* Reference cost for deciding when refitting is no longer good enough,
+	 * measured the same way refit does so both are comparable.
+	 */
+	if(!params.top_level) {
+		leaf_cost_begin();
+		leaf_cost_accumulate(root);
+		leaf_cost_end();
+		build_leaf_cost = leaf_cost;
+	}
+
 	/* free build nodes */
 	root->deleteSubtree();
 }
@@ -148,11 +167,47 @@ void BVH::refit(Progress& progress)
 	if(progress.get_cancel()) return;
 
 	progress.set_substatus("Refitting BVH nodes");
+	leaf_cost_begin();
 	refit_nodes();
+	leaf_cost_end();
+}
+
+bool BVH::need_rebuild() const
+{
+	return leaf_cost > build_leaf_cost * params.max_refit_cost_ratio;
+}
+
+void BVH::leaf_cost_begin()
+{
+	leaf_bounds = BoundBox::empty;
+	leaf_area = 0.0f;
 }
 
-void BVH::refit_primitives(int start, int end, BoundBox& bbox, uint& visibility)
+void BVH::leaf_cost_end()
 {
+	const float area = leaf_bounds.safe_area();
+	leaf_cost = (area > 0.0f)? leaf_area / area: 0.0f;
+}
+
+void BVH::leaf_cost_accumulate(const BVHNode *node)
+{
+	if(node->is_leaf()) {
+		const LeafNode *leaf = (const LeafNode*)node;
+		BoundBox bbox = BoundBox::empty;
+		uint visibility = 0;
+		refit_primitives(leaf->lo, leaf->hi, bbox, visibility);
+	}
+	else {
+		for(int i = 0; i < node->num_children(); i++) {
+			leaf_cost_accumulate(node->get_child(i));
+		}
+	}
+}
+
+void BVH::refit_primitives(int start, int end, BoundBox& leaf_bbox, uint& visibility)
+{
+	BoundBox bbox = BoundBox::empty;
+
 	/* Refit range of primitives. */
 	for(int prim = start; prim < end; prim++) {
 		int pidx = pack.prim_index[prim];
@@ -216,6 +271,10 @@ void BVH::refit_primitives(int start, int end, BoundBox& bbox, uint& visibility)
 		}
 		visibility |= ob->visibility_for_tracing();
 	}
+
+	leaf_bbox.grow(bbox);
+	leaf_bounds.grow(bbox);
+	leaf_area += bbox.safe_area() * (end - start);
 }
 
 /* Triangles */
@@ -291,8 +350,8 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 	 * BVH's are stored in global arrays. This function merges them into the
 	 * top level BVH, adjusting indexes and offsets where appropriate.
 	 */
-	/* TODO(sergey): This code needs adjustment for wider BVH than 4. */
 	const bool use_qbvh = (params.bvh_layout == BVH_LAYOUT_BVH4);
+	const bool use_obvh = (params.bvh_layout == BVH_LAYOUT_BVH8);
 
 	/* Adjust primitive index to point to the triangle in the global array, for
 	 * meshes with transform applied and already in the top level BVH.
@@ -468,15 +527,29 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 
 			for(size_t i = 0, j = 0; i < bvh_nodes_size; j++) {
 				size_t nsize, nsize_bbox;
+				/* Wide nodes store 8 children in two int4. */
+				const size_t nsize_child = (use_obvh)? 2: 1;
 				if(bvh_nodes[i].x & PATH_RAY_NODE_UNALIGNED) {
-					nsize = use_qbvh
-					            ? BVH_UNALIGNED_QNODE_SIZE
-					            : BVH_UNALIGNED_NODE_SIZE;
-					nsize_bbox = (use_qbvh)? 13: 0;
+					if(use_obvh) {
+						nsize = BVH_UNALIGNED_ONODE_SIZE;
+						nsize_bbox = BVH_UNALIGNED_ONODE_CHILD_OFFSET;
+					}
+					else {
+						nsize = use_qbvh
+						            ? BVH_UNALIGNED_QNODE_SIZE
+						            : BVH_UNALIGNED_NODE_SIZE;
+						nsize_bbox = (use_qbvh)? 13: 0;
+					}
 				}
 				else {
-					nsize = (use_qbvh)? BVH_QNODE_SIZE: BVH_NODE_SIZE;
-					nsize_bbox = (use_qbvh)? 7: 0;
+					if(use_obvh) {
+						nsize = BVH_ONODE_SIZE;
+						nsize_bbox = BVH_ONODE_CHILD_OFFSET;
+					}
+					else {
+						nsize = (use_qbvh)? BVH_QNODE_SIZE: BVH_NODE_SIZE;
+						nsize_bbox = (use_qbvh)? 7: 0;
+					}
 				}
 
 				memcpy(pack_nodes + pack_nodes_offset,
@@ -484,24 +557,26 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 				       nsize_bbox*sizeof(int4));
 
 				/* Modify offsets into arrays */
-				int4 data = bvh_nodes[i + nsize_bbox];
+				for(size_t k = 0; k < nsize_child; k++) {
+					int4 data = bvh_nodes[i + nsize_bbox + k];
 
-				data.z += (data.z < 0)? -noffset_leaf: noffset;
-				data.w += (data.w < 0)? -noffset_leaf: noffset;
+					data.z += (data.z < 0)? -noffset_leaf: noffset;
+					data.w += (data.w < 0)? -noffset_leaf: noffset;
 
-				if(use_qbvh) {
-					data.x += (data.x < 0)? -noffset_leaf: noffset;
-					data.y += (data.y < 0)? -noffset_leaf: noffset;
-				}
+					if(use_qbvh || use_obvh) {
+						data.x += (data.x < 0)? -noffset_leaf: noffset;
+						data.y += (data.y < 0)? -noffset_leaf: noffset;
+					}
 
-				pack_nodes[pack_nodes_offset + nsize_bbox] = data;
+					pack_nodes[pack_nodes_offset + nsize_bbox + k] = data;
+				}
 
 				/* Usually this copies nothing, but we better
 				 * be prepared for possible node size extension.
 				 */
-				memcpy(&pack_nodes[pack_nodes_offset + nsize_bbox+1],
-				       &bvh_nodes[i + nsize_bbox+1],
-				       sizeof(int4) * (nsize - (nsize_bbox+1)));
+				memcpy(&pack_nodes[pack_nodes_offset + nsize_bbox + nsize_child],
+				       &bvh_nodes[i + nsize_bbox + nsize_child],
+				       sizeof(int4) * (nsize - (nsize_bbox + nsize_child)));
 
 				pack_nodes_offset += nsize;
 				i += nsize;
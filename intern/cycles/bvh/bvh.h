@@ -82,18 +82,36 @@ public:
 	BVHParams params;
 	vector<Object*> objects;
 
+	/* Surface area heuristic cost of the leaves relative to the bounds of
+	 * the whole tree, measured after build and after every refit. Refitting
+	 * deforming geometry makes leaves grow and overlap, which increases it.
+	 */
+	float build_leaf_cost;
+	float leaf_cost;
+
 	static BVH *create(const BVHParams& params, const vector<Object*>& objects);
 	virtual ~BVH() {}
 
 	void build(Progress& progress);
 	void refit(Progress& progress);
 
+	/* Whether refitting degraded the tree enough for a rebuild to pay off. */
+	bool need_rebuild() const;
+
 protected:
 	BVH(const BVHParams& params, const vector<Object*>& objects);
 
 	/* Refit range of primitives. */
 	void refit_primitives(int start, int end, BoundBox& bbox, uint& visibility);
 
+	/* Leaf cost accumulated by refit_primitives(). */
+	BoundBox leaf_bounds;
+	float leaf_area;
+
+	void leaf_cost_begin();
+	void leaf_cost_end();
+	void leaf_cost_accumulate(const BVHNode *node);
+
 	/* triangles and strands */
 	void pack_primitives();
 	void pack_triangle(int idx, float4 storage[3]);
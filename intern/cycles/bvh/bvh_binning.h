@@ -27,12 +27,15 @@ CCL_NAMESPACE_BEGIN
 
 class BVHBuild;
 
-/* Single threaded object binner. Finds the split with the best SAH heuristic
- * by testing for each dimension multiple partitionings for regular spaced
- * partition locations. A partitioning for a partition location is computed,
- * by putting primitives whose centroid is on the left and right of the split
- * location to different sets. The SAH is evaluated by computing the number of
- * blocks occupied by the primitives in the partitions. */
+/* Object binner. Finds the split with the best SAH heuristic by testing for
+ * each dimension multiple partitionings for regular spaced partition
+ * locations. A partitioning for a partition location is computed, by putting
+ * primitives whose centroid is on the left and right of the split location to
+ * different sets. The SAH is evaluated by computing the number of blocks
+ * occupied by the primitives in the partitions.
+ *
+ * Large ranges, like the root of the BVH, are binned by multiple threads which
+ * each fill their own bins, merged afterwards. */
 
 class BVHObjectBinning : public BVHRange
 {
@@ -69,6 +72,22 @@ protected:
 	enum { MAX_BINS = 32 };
 	enum { LOG_BLOCK_SIZE = 2 };
 
+	/* Number of primitives binned by a single thread. */
+	enum { THREAD_BINNING_SIZE = 65536 };
+
+	/* Bins of a range of primitives. */
+	struct Bins {
+		BoundBox bounds[MAX_BINS][4];  /* bounds for every bin in every dimension */
+		int4 count[MAX_BINS];          /* number of primitives mapped to bin */
+	};
+
+	void bins_init(Bins *bins) const;
+	void bins_merge(Bins *bins, const Bins *other) const;
+	void bin_primitives(const BVHReference *prims,
+	                    size_t begin,
+	                    size_t end,
+	                    Bins *bins) const;
+
 	/* computes the bin numbers for each dimension for a box. */
 	__forceinline int4 get_bin(const BoundBox& box) const
 	{
@@ -115,14 +115,19 @@ BVHBuild::~BVHBuild()
 
 /* Adding References */
 
-void BVHBuild::add_reference_triangles(BoundBox& root, BoundBox& center, Mesh *mesh, int i)
+void BVHBuild::add_reference_triangles(BVHReferenceChunk *chunk)
 {
+	Mesh *mesh = chunk->mesh;
+	const int i = chunk->object_index;
+	vector<BVHReference>& references = chunk->references;
+	BoundBox& root = chunk->bounds;
+	BoundBox& center = chunk->center;
+
 	const Attribute *attr_mP = NULL;
 	if(mesh->has_motion_blur()) {
 		attr_mP = mesh->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
 	}
-	const size_t num_triangles = mesh->num_triangles();
-	for(uint j = 0; j < num_triangles; j++) {
+	for(uint j = chunk->start; j < chunk->end; j++) {
 		Mesh::Triangle t = mesh->get_triangle(j);
 		const float3 *verts = &mesh->verts[0];
 		if(attr_mP == NULL) {
@@ -223,14 +228,19 @@ void BVHBuild::add_reference_triangles(BoundBox& root, BoundBox& center, Mesh *m
 	}
 }
 
-void BVHBuild::add_reference_curves(BoundBox& root, BoundBox& center, Mesh *mesh, int i)
+void BVHBuild::add_reference_curves(BVHReferenceChunk *chunk)
 {
+	Mesh *mesh = chunk->mesh;
+	const int i = chunk->object_index;
+	vector<BVHReference>& references = chunk->references;
+	BoundBox& root = chunk->bounds;
+	BoundBox& center = chunk->center;
+
 	const Attribute *curve_attr_mP = NULL;
 	if(mesh->has_motion_blur()) {
 		curve_attr_mP = mesh->curve_attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
 	}
-	const size_t num_curves = mesh->num_curves();
-	for(uint j = 0; j < num_curves; j++) {
+	for(uint j = chunk->start; j < chunk->end; j++) {
 		const Mesh::Curve curve = mesh->get_curve(j);
 		const float *curve_radius = &mesh->curve_radius[0];
 		for(int k = 0; k < curve.num_keys - 1; k++) {
@@ -336,88 +346,151 @@ void BVHBuild::add_reference_curves(BoundBox& root, BoundBox& center, Mesh *mesh
 	}
 }
 
-void BVHBuild::add_reference_mesh(BoundBox& root, BoundBox& center, Mesh *mesh, int i)
+void BVHBuild::add_reference_object(BVHReferenceChunk *chunk)
 {
-	if(params.primitive_mask & PRIMITIVE_ALL_TRIANGLE) {
-		add_reference_triangles(root, center, mesh, i);
+	Object *ob = objects[chunk->object_index];
+	chunk->references.push_back(BVHReference(ob->bounds, -1, chunk->object_index, 0));
+	chunk->bounds.grow(ob->bounds);
+	chunk->center.grow(ob->bounds.center2());
+}
+
+void BVHBuild::add_reference_chunk(BVHReferenceChunk *chunk)
+{
+	if(progress.get_cancel()) {
+		return;
 	}
-	if(params.primitive_mask & PRIMITIVE_ALL_CURVE) {
-		add_reference_curves(root, center, mesh, i);
+
+	switch(chunk->type) {
+		case BVHReferenceChunk::TRIANGLES:
+			chunk->references.reserve(chunk->end - chunk->start);
+			add_reference_triangles(chunk);
+			break;
+		case BVHReferenceChunk::CURVES:
+			add_reference_curves(chunk);
+			break;
+		case BVHReferenceChunk::OBJECT:
+			add_reference_object(chunk);
+			break;
 	}
 }
 
-void BVHBuild::add_reference_object(BoundBox& root, BoundBox& center, Object *ob, int i)
+static void add_reference_chunks(vector<BVHReferenceChunk>& chunks,
+                                 BVHReferenceChunk::Type type,
+                                 Mesh *mesh,
+                                 int object_index,
+                                 size_t num_primitives,
+                                 size_t chunk_size)
 {
-	references.push_back(BVHReference(ob->bounds, -1, i, 0));
-	root.grow(ob->bounds);
-	center.grow(ob->bounds.center2());
+	for(size_t start = 0; start < num_primitives; start += chunk_size) {
+		BVHReferenceChunk chunk;
+		chunk.type = type;
+		chunk.mesh = mesh;
+		chunk.object_index = object_index;
+		chunk.start = start;
+		chunk.end = min(start + chunk_size, num_primitives);
+		chunks.push_back(chunk);
+	}
 }
 
-static size_t count_curve_segments(Mesh *mesh)
+void BVHBuild::add_reference_mesh_chunks(vector<BVHReferenceChunk>& chunks,
+                                         Mesh *mesh,
+                                         int i)
 {
-	size_t num = 0, num_curves = mesh->num_curves();
-
-	for(size_t i = 0; i < num_curves; i++)
-		num += mesh->get_curve(i).num_keys - 1;
+	if(params.primitive_mask & PRIMITIVE_ALL_TRIANGLE) {
+		add_reference_chunks(chunks,
+		                     BVHReferenceChunk::TRIANGLES,
+		                     mesh,
+		                     i,
+		                     mesh->num_triangles(),
+		                     REFERENCE_TASK_SIZE);
+	}
+	if(params.primitive_mask & PRIMITIVE_ALL_CURVE) {
+		/* Curves add a reference per segment. */
+		add_reference_chunks(chunks,
+		                     BVHReferenceChunk::CURVES,
+		                     mesh,
+		                     i,
+		                     mesh->num_curves(),
+		                     REFERENCE_TASK_SIZE / 8);
+	}
+}
 
-	return num;
+void BVHBuild::copy_reference_chunk(BVHReferenceChunk *chunk, size_t offset)
+{
+	std::copy(chunk->references.begin(),
+	          chunk->references.end(),
+	          references.begin() + offset);
+	chunk->references.free_memory();
 }
 
 void BVHBuild::add_references(BVHRange& root)
 {
-	/* reserve space for references */
-	size_t num_alloc_references = 0;
+	/* Split primitives into chunks, references of every chunk are gathered
+	 * into its own buffer by a separate task. Chunks are merged in order, so
+	 * the result does not depend on the order tasks are executed in.
+	 */
+	vector<BVHReferenceChunk> chunks;
+	int i = 0;
 
 	foreach(Object *ob, objects) {
 		if(params.top_level) {
 			if(!ob->is_traceable()) {
+				++i;
 				continue;
 			}
 			if(!ob->mesh->is_instanced()) {
-				if(params.primitive_mask & PRIMITIVE_ALL_TRIANGLE) {
-					num_alloc_references += ob->mesh->num_triangles();
-				}
-				if(params.primitive_mask & PRIMITIVE_ALL_CURVE) {
-					num_alloc_references += count_curve_segments(ob->mesh);
-				}
+				add_reference_mesh_chunks(chunks, ob->mesh, i);
+			}
+			else {
+				BVHReferenceChunk chunk;
+				chunk.type = BVHReferenceChunk::OBJECT;
+				chunk.mesh = ob->mesh;
+				chunk.object_index = i;
+				chunk.start = 0;
+				chunk.end = 1;
+				chunks.push_back(chunk);
 			}
-			else
-				num_alloc_references++;
+		}
+		else
+			add_reference_mesh_chunks(chunks, ob->mesh, i);
+
+		i++;
+	}
+
+	TaskPool pool;
+	foreach(BVHReferenceChunk& chunk, chunks) {
+		if(chunk.type == BVHReferenceChunk::OBJECT) {
+			/* Not worth a task. */
+			add_reference_chunk(&chunk);
 		}
 		else {
-			if(params.primitive_mask & PRIMITIVE_ALL_TRIANGLE) {
-				num_alloc_references += ob->mesh->num_triangles();
-			}
-			if(params.primitive_mask & PRIMITIVE_ALL_CURVE) {
-				num_alloc_references += count_curve_segments(ob->mesh);
-			}
+			pool.push(function_bind(&BVHBuild::add_reference_chunk, this, &chunk));
 		}
 	}
+	pool.wait_work();
 
-	references.reserve(num_alloc_references);
+	if(progress.get_cancel()) return;
 
-	/* add references from objects */
+	/* Merge references of all chunks. */
 	BoundBox bounds = BoundBox::empty, center = BoundBox::empty;
-	int i = 0;
+	size_t num_references = 0;
 
-	foreach(Object *ob, objects) {
-		if(params.top_level) {
-			if(!ob->is_traceable()) {
-				++i;
-				continue;
-			}
-			if(!ob->mesh->is_instanced())
-				add_reference_mesh(bounds, center, ob->mesh, i);
-			else
-				add_reference_object(bounds, center, ob, i);
-		}
-		else
-			add_reference_mesh(bounds, center, ob->mesh, i);
+	foreach(BVHReferenceChunk& chunk, chunks) {
+		bounds.grow(chunk.bounds);
+		center.grow(chunk.center);
+		num_references += chunk.references.size();
+	}
 
-		i++;
+	references.resize(num_references);
 
-		if(progress.get_cancel()) return;
+	size_t offset = 0;
+	foreach(BVHReferenceChunk& chunk, chunks) {
+		/* The task frees the chunk buffer, it may run before the next iteration. */
+		const size_t num_chunk_references = chunk.references.size();
+		pool.push(function_bind(&BVHBuild::copy_reference_chunk, this, &chunk, offset));
+		offset += num_chunk_references;
 	}
+	pool.wait_work();
 
 	/* happens mostly on empty meshes */
 	if(!bounds.valid())
@@ -38,6 +38,38 @@ class Mesh;
 class Object;
 class Progress;
 
+/* Range of primitives of one object, the references for them are gathered
+ * by a single task into its own buffer.
+ */
+struct BVHReferenceChunk {
+	enum Type {
+		TRIANGLES,
+		CURVES,
+		OBJECT,
+	};
+
+	Type type;
+	Mesh *mesh;
+	int object_index;
+	/* Range of triangles or curves of the mesh. */
+	size_t start, end;
+
+	vector<BVHReference> references;
+	BoundBox bounds;
+	BoundBox center;
+
+	BVHReferenceChunk()
+	: type(TRIANGLES),
+	  mesh(NULL),
+	  object_index(0),
+	  start(0),
+	  end(0),
+	  bounds(BoundBox::empty),
+	  center(BoundBox::empty)
+	{
+	}
+};
+
 /* BVH Builder */
 
 class BVHBuild
@@ -64,10 +96,13 @@ protected:
 	friend class BVHObjectBinning;
 
 	/* Adding references. */
-	void add_reference_triangles(BoundBox& root, BoundBox& center, Mesh *mesh, int i);
-	void add_reference_curves(BoundBox& root, BoundBox& center, Mesh *mesh, int i);
-	void add_reference_mesh(BoundBox& root, BoundBox& center, Mesh *mesh, int i);
-	void add_reference_object(BoundBox& root, BoundBox& center, Object *ob, int i);
+	enum { REFERENCE_TASK_SIZE = 65536 };
+	void add_reference_triangles(BVHReferenceChunk *chunk);
+	void add_reference_curves(BVHReferenceChunk *chunk);
+	void add_reference_object(BVHReferenceChunk *chunk);
+	void add_reference_chunk(BVHReferenceChunk *chunk);
+	void add_reference_mesh_chunks(vector<BVHReferenceChunk>& chunks, Mesh *mesh, int i);
+	void copy_reference_chunk(BVHReferenceChunk *chunk, size_t offset);
 	void add_references(BVHRange& root);
 
 	/* Building. */
@@ -90,6 +90,11 @@ public:
 	/* Same as above, but for triangle primitives. */
 	int num_motion_triangle_steps;
 
+	/* Refitted BVH is rebuilt once its leaf cost grows by this factor
+	 * compared to the freshly built one.
+	 */
+	float max_refit_cost_ratio;
+
 	/* fixed parameters */
 	enum {
 		MAX_DEPTH = 64,
@@ -123,6 +128,8 @@ public:
 
 		num_motion_curve_steps = 0;
 		num_motion_triangle_steps = 0;
+
+		max_refit_cost_ratio = 1.5f;
 	}
 
 	/* SAH costs */
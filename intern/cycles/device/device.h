@@ -36,6 +36,7 @@ CCL_NAMESPACE_BEGIN
 
 class Progress;
 class RenderTile;
+class TextureCache;
 
 /* Device Types */
 
@@ -307,6 +308,9 @@ public:
 	/* open shading language, only for CPU device */
 	virtual void *osl_memory() { return NULL; }
 
+	/* image texture cache, only for CPU device */
+	virtual void set_texture_cache(TextureCache * /*texture_cache*/) {}
+
 	/* load/compile kernels, must be called before adding tasks */ 
 	virtual bool load_kernels(
 	        const DeviceRequestedFeatures& /*requested_features*/)
@@ -175,6 +175,11 @@ public:
 	DeviceRequestedFeatures requested_features;
 
 	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int, int)>             path_trace_kernel;
+	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int, int, int)>        path_trace_stream_kernel;
+	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int)>                  adaptive_stopping_kernel;
+	KernelFunctions<bool(*)(KernelGlobals *, float *, int, int, int, int, int)>             adaptive_filter_x_kernel;
+	KernelFunctions<bool(*)(KernelGlobals *, float *, int, int, int, int, int)>             adaptive_filter_y_kernel;
+	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int, float, int)>      adaptive_adjust_samples_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uchar4 *, float *, float, int, int, int, int)> convert_to_half_float_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uchar4 *, float *, float, int, int, int, int)> convert_to_byte_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uint4 *, float4 *, int, int, int, int, int)>   shader_kernel;
@@ -212,6 +217,11 @@ public:
 	  texture_info(this, "__texture_info", MEM_TEXTURE),
 #define REGISTER_KERNEL(name) name ## _kernel(KERNEL_FUNCTIONS(name))
 	  REGISTER_KERNEL(path_trace),
+	  REGISTER_KERNEL(path_trace_stream),
+	  REGISTER_KERNEL(adaptive_stopping),
+	  REGISTER_KERNEL(adaptive_filter_x),
+	  REGISTER_KERNEL(adaptive_filter_y),
+	  REGISTER_KERNEL(adaptive_adjust_samples),
 	  REGISTER_KERNEL(convert_to_half_float),
 	  REGISTER_KERNEL(convert_to_byte),
 	  REGISTER_KERNEL(shader),
@@ -234,9 +244,17 @@ public:
 			info.cpu_threads = TaskScheduler::num_threads();
 		}
 
+		/* Only the AVX2 kernel can traverse the 8-wide BVH, which might not be
+		 * used when disabled by the debug flags. */
+		if(!(DebugFlags().cpu.has_avx2() && system_cpu_support_avx2())) {
+			info.bvh_layout_mask &= ~BVH_LAYOUT_BVH8;
+		}
+
 #ifdef WITH_OSL
 		kernel_globals.osl = &osl_globals;
 #endif
+		kernel_globals.texture_cache = NULL;
+		kernel_globals.path_stream = NULL;
 		use_split_kernel = DebugFlags().cpu.split_kernel;
 		if(use_split_kernel) {
 			VLOG(1) << "Will be using split kernel.";
@@ -439,6 +457,11 @@ public:
 #endif
 	}
 
+	void set_texture_cache(TextureCache *texture_cache)
+	{
+		kernel_globals.texture_cache = texture_cache;
+	}
+
 	void thread_run(DeviceTask *task)
 	{
 		if(task->type == DeviceTask::RENDER) {
@@ -684,6 +707,75 @@ public:
 		return true;
 	}
 
+	/* Marks converged pixels, returns true when all pixels of the tile have converged. */
+	bool adaptive_sampling_filter(KernelGlobals *kg, RenderTile &tile)
+	{
+		float *render_buffer = (float*)tile.buffer;
+
+		for(int y = tile.y; y < tile.y + tile.h; y++) {
+			for(int x = tile.x; x < tile.x + tile.w; x++) {
+				adaptive_stopping_kernel()(kg, render_buffer, x, y, tile.offset, tile.stride);
+			}
+		}
+
+		bool any = false;
+		for(int y = tile.y; y < tile.y + tile.h; y++) {
+			any |= adaptive_filter_x_kernel()(kg, render_buffer, y, tile.x, tile.w, tile.offset, tile.stride);
+		}
+		for(int x = tile.x; x < tile.x + tile.w; x++) {
+			any |= adaptive_filter_y_kernel()(kg, render_buffer, x, tile.y, tile.h, tile.offset, tile.stride);
+		}
+
+		return !any;
+	}
+
+	/* Sample counts of the pixels before path tracing the tile. */
+	void adaptive_sampling_pre(RenderTile &tile, KernelGlobals *kg, vector<float> &start_num_samples)
+	{
+		const float *render_buffer = (float*)tile.buffer;
+		const int pass_stride = kg->__data.film.pass_stride;
+		const int pass_sample_count = kg->__data.film.pass_sample_count;
+
+		start_num_samples.resize(tile.w*tile.h);
+		for(int y = tile.y; y < tile.y + tile.h; y++) {
+			for(int x = tile.x; x < tile.x + tile.w; x++) {
+				const float *pixel = render_buffer + (tile.offset + x + y*tile.stride)*pass_stride;
+				start_num_samples[(y - tile.y)*tile.w + (x - tile.x)] = pixel[pass_sample_count];
+			}
+		}
+	}
+
+	/* Rescale pixels which stopped early and report the skipped samples. */
+	void adaptive_sampling_post(DeviceTask &task, RenderTile &tile, KernelGlobals *kg,
+	                            const vector<float> &start_num_samples)
+	{
+		float *render_buffer = (float*)tile.buffer;
+		const int pass_stride = kg->__data.film.pass_stride;
+		const int pass_sample_count = kg->__data.film.pass_sample_count;
+		uint64_t num_pixel_samples = 0;
+
+		for(int y = tile.y; y < tile.y + tile.h; y++) {
+			for(int x = tile.x; x < tile.x + tile.w; x++) {
+				const float *pixel = render_buffer + (tile.offset + x + y*tile.stride)*pass_stride;
+				const float num_new_samples = pixel[pass_sample_count] -
+				                              start_num_samples[(y - tile.y)*tile.w + (x - tile.x)];
+				num_pixel_samples += (uint64_t)num_new_samples;
+
+				/* Passes of all pixels hold start_sample samples before path tracing,
+				 * either taken or rescaled by the previous call. */
+				adaptive_adjust_samples_kernel()(kg, render_buffer, x, y,
+				                                 tile.offset, tile.stride,
+				                                 (float)tile.start_sample + num_new_samples,
+				                                 tile.sample);
+			}
+		}
+
+		const uint64_t total_pixel_samples = (uint64_t)tile.w*tile.h*(tile.sample - tile.start_sample);
+		if(task.update_skipped_samples && total_pixel_samples > num_pixel_samples) {
+			task.update_skipped_samples(total_pixel_samples - num_pixel_samples);
+		}
+	}
+
 	void path_trace(DeviceTask &task, RenderTile &tile, KernelGlobals *kg)
 	{
 		scoped_timer timer(&tile.buffers->render_time);
@@ -691,6 +783,13 @@ public:
 		float *render_buffer = (float*)tile.buffer;
 		int start_sample = tile.start_sample;
 		int end_sample = tile.start_sample + tile.num_samples;
+		const bool use_ray_stream = kg->__data.integrator.use_camera_ray_stream ||
+		                            kg->__data.integrator.use_shadow_ray_stream;
+
+		vector<float> start_num_samples;
+		if(task.adaptive_sampling.use) {
+			adaptive_sampling_pre(tile, kg, start_num_samples);
+		}
 
 		for(int sample = start_sample; sample < end_sample; sample++) {
 			if(task.get_cancel() || task_pool.canceled()) {
@@ -699,16 +798,34 @@ public:
 			}
 
 			for(int y = tile.y; y < tile.y + tile.h; y++) {
-				for(int x = tile.x; x < tile.x + tile.w; x++) {
-					path_trace_kernel()(kg, render_buffer,
-					                    sample, x, y, tile.offset, tile.stride);
+				if(use_ray_stream) {
+					path_trace_stream_kernel()(kg, render_buffer,
+					                           sample, tile.x, y, tile.w, tile.offset, tile.stride);
+				}
+				else {
+					for(int x = tile.x; x < tile.x + tile.w; x++) {
+						path_trace_kernel()(kg, render_buffer,
+						                    sample, x, y, tile.offset, tile.stride);
+					}
 				}
 			}
 
 			tile.sample = sample + 1;
 
+			if(task.adaptive_sampling.need_filter(sample) && adaptive_sampling_filter(kg, tile)) {
+				/* All pixels converged, count the remaining samples as done so
+				 * progress stays correct, and stop the tile. */
+				task.update_progress(&tile, tile.w*tile.h*(end_sample - sample));
+				tile.sample = end_sample;
+				break;
+			}
+
 			task.update_progress(&tile, tile.w*tile.h);
 		}
+
+		if(task.adaptive_sampling.use) {
+			adaptive_sampling_post(task, tile, kg, start_num_samples);
+		}
 	}
 
 	void denoise(DeviceTask &task, DenoisingTask& denoising, RenderTile &tile)
@@ -891,6 +1008,7 @@ protected:
 			kg.decoupled_volume_steps[i] = NULL;
 		}
 		kg.decoupled_volume_steps_index = 0;
+		kg.path_stream = NULL;
 #ifdef WITH_OSL
 		OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
 #endif
@@ -913,6 +1031,9 @@ protected:
 				free(kg->decoupled_volume_steps[i]);
 			}
 		}
+		if(kg->path_stream != NULL) {
+			free(kg->path_stream);
+		}
 #ifdef WITH_OSL
 		OSLShader::thread_free(kg);
 #endif
@@ -1050,6 +1171,9 @@ void device_cpu_info(vector<DeviceInfo>& devices)
 	if (system_cpu_support_sse2()) {
 		info.bvh_layout_mask |= BVH_LAYOUT_BVH4;
 	}
+	if (system_cpu_support_avx2()) {
+		info.bvh_layout_mask |= BVH_LAYOUT_BVH8;
+	}
 	info.has_volume_decoupled = true;
 	info.has_osl = true;
 	info.has_half_images = true;
@@ -26,6 +26,25 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Adaptive Sampling */
+
+AdaptiveSampling::AdaptiveSampling()
+: use(false), adaptive_step(4), min_samples(0)
+{
+}
+
+/* Convergence is checked every adaptive_step samples, once the minimum
+ * number of samples is reached. sample is the index of the sample that
+ * was just rendered. */
+bool AdaptiveSampling::need_filter(int sample) const
+{
+	if(!use) {
+		return false;
+	}
+	const int num_samples = sample + 1;
+	return num_samples >= min_samples && (num_samples % adaptive_step) == 0;
+}
+
 /* Device Task */
 
 DeviceTask::DeviceTask(Type type_)
@@ -25,6 +25,21 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Adaptive Sampling */
+
+class AdaptiveSampling {
+public:
+	AdaptiveSampling();
+
+	bool need_filter(int sample) const;
+
+	bool use;
+	/* Number of samples between convergence checks. */
+	int adaptive_step;
+	/* No pixel stops before this many samples. */
+	int min_samples;
+};
+
 /* Device Task */
 
 class Device;
@@ -62,6 +77,7 @@ public:
 
 	function<bool(Device *device, RenderTile&)> acquire_tile;
 	function<void(long, int)> update_progress_sample;
+	function<void(uint64_t)> update_skipped_samples;
 	function<void(RenderTile&)> update_tile_sample;
 	function<void(RenderTile&)> release_tile;
 	function<bool(void)> get_cancel;
@@ -78,6 +94,7 @@ public:
 
 	bool need_finish_queue;
 	bool integrator_branched;
+	AdaptiveSampling adaptive_sampling;
 	int2 requested_tile_size;
 protected:
 	double last_update_time;
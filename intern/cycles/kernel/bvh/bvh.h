@@ -34,6 +34,11 @@ CCL_NAMESPACE_BEGIN
 #  include "kernel/bvh/qbvh_nodes.h"
 #endif
 
+/* Common OBVH functions. */
+#ifdef __OBVH__
+#  include "kernel/bvh/obvh_nodes.h"
+#endif
+
 /* Regular BVH traversal */
 
 #include "kernel/bvh/bvh_nodes.h"
@@ -152,6 +157,12 @@ CCL_NAMESPACE_BEGIN
 #  endif
 #endif  /* __VOLUME_RECORD_ALL__ */
 
+/* Packet traversal for ray streams */
+
+#if defined(__RAY_STREAM__)
+#  include "kernel/bvh/qbvh_packet.h"
+#endif
+
 #undef BVH_FEATURE
 #undef BVH_NAME_JOIN
 #undef BVH_NAME_EVAL
@@ -201,6 +212,37 @@ ccl_device_intersect bool scene_intersect(KernelGlobals *kg,
 #endif /* __KERNEL_CPU__ */
 }
 
+#ifdef __RAY_STREAM__
+/* Packets are traced with SIMD over the rays in a QBVH without motion blur
+ * and hair, and one ray at a time otherwise. */
+ccl_device_inline bool scene_intersect_packet_use_qbvh(KernelGlobals *kg)
+{
+	return kernel_data.bvh.bvh_layout == BVH_LAYOUT_BVH4 &&
+	       !kernel_data.bvh.have_motion &&
+	       !kernel_data.bvh.have_curves;
+}
+
+/* Intersects a packet of coherent rays, lanes with a NULL ray are skipped.
+ * Returns the mask of lanes which hit something. */
+ccl_device_intersect int scene_intersect_packet(KernelGlobals *kg,
+                                                const Ray *const rays[QBVH_PACKET_SIZE],
+                                                const uint visibility,
+                                                Intersection isects[QBVH_PACKET_SIZE])
+{
+	if(scene_intersect_packet_use_qbvh(kg)) {
+		return qbvh_intersect_packet(kg, rays, isects, visibility);
+	}
+
+	int hit_lanes = 0;
+	for(int i = 0; i < QBVH_PACKET_SIZE; i++) {
+		if(rays[i] != NULL && scene_intersect(kg, *rays[i], visibility, &isects[i], NULL, 0.0f, 0.0f)) {
+			hit_lanes |= (1 << i);
+		}
+	}
+	return hit_lanes;
+}
+#endif  /* __RAY_STREAM__ */
+
 #ifdef __BVH_LOCAL__
 /* Note: ray is passed by value to work around a possible CUDA compiler bug. */
 ccl_device_intersect void scene_intersect_local(KernelGlobals *kg,
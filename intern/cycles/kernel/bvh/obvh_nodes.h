@@ -0,0 +1,319 @@
+/*
+ * Copyright 2011-2018, Blender Foundation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Nodes of the 8-wide BVH. Every row of a node holds one value for all eight
+ * children and takes two float4, so row r starts at node_addr + 2*r:
+ *
+ *   aligned:   header, min.x, max.x, min.y, max.y, min.z, max.z, children
+ *   unaligned: header, 9 rows of transform, 3 rows of translation, children
+ *
+ * Intersection only uses AVX2 code, OBVH is not compiled in otherwise.
+ */
+
+struct OBVHStackItem {
+	int addr;
+	float dist;
+};
+
+/* Sort the num topmost stack items, with s pointing to the bottom one, so
+ * that the closest item ends up on the top of the stack.
+ */
+ccl_device_inline void obvh_stack_sort(OBVHStackItem *ccl_restrict s,
+                                       const int num)
+{
+	for(int i = 1; i < num; i++) {
+		const OBVHStackItem item = s[i];
+		int j = i - 1;
+		while(j >= 0 && s[j].dist < item.dist) {
+			s[j + 1] = s[j];
+			j--;
+		}
+		s[j + 1] = item;
+	}
+}
+
+ccl_device_inline avxf obvh_node_row(KernelGlobals *ccl_restrict kg,
+                                     const int node_addr,
+                                     const int row)
+{
+	return kernel_tex_fetch_avxf(__bvh_nodes, node_addr + row*2);
+}
+
+/* Axis-aligned nodes intersection */
+
+ccl_device_inline int obvh_aligned_node_intersect(KernelGlobals *ccl_restrict kg,
+                                                  const avxf& isect_near,
+                                                  const avxf& isect_far,
+                                                  const avx3f& org_idir,
+                                                  const avx3f& idir,
+                                                  const int near_x,
+                                                  const int near_y,
+                                                  const int near_z,
+                                                  const int far_x,
+                                                  const int far_y,
+                                                  const int far_z,
+                                                  const int node_addr,
+                                                  avxf *ccl_restrict dist)
+{
+	const avxf tnear_x = msub(obvh_node_row(kg, node_addr, near_x + 1), idir.x, org_idir.x);
+	const avxf tnear_y = msub(obvh_node_row(kg, node_addr, near_y + 1), idir.y, org_idir.y);
+	const avxf tnear_z = msub(obvh_node_row(kg, node_addr, near_z + 1), idir.z, org_idir.z);
+	const avxf tfar_x = msub(obvh_node_row(kg, node_addr, far_x + 1), idir.x, org_idir.x);
+	const avxf tfar_y = msub(obvh_node_row(kg, node_addr, far_y + 1), idir.y, org_idir.y);
+	const avxf tfar_z = msub(obvh_node_row(kg, node_addr, far_z + 1), idir.z, org_idir.z);
+
+	const avxf tnear = max(max(tnear_x, tnear_y), max(tnear_z, isect_near));
+	const avxf tfar = min(min(tfar_x, tfar_y), min(tfar_z, isect_far));
+	const avxb vmask = tnear <= tfar;
+	*dist = tnear;
+	return movemask(vmask);
+}
+
+ccl_device_inline int obvh_aligned_node_intersect_robust(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& P_idir,
+        const avx3f& idir,
+        const int near_x,
+        const int near_y,
+        const int near_z,
+        const int far_x,
+        const int far_y,
+        const int far_z,
+        const int node_addr,
+        const float difl,
+        avxf *ccl_restrict dist)
+{
+	const avxf tnear_x = msub(obvh_node_row(kg, node_addr, near_x + 1), idir.x, P_idir.x);
+	const avxf tnear_y = msub(obvh_node_row(kg, node_addr, near_y + 1), idir.y, P_idir.y);
+	const avxf tnear_z = msub(obvh_node_row(kg, node_addr, near_z + 1), idir.z, P_idir.z);
+	const avxf tfar_x = msub(obvh_node_row(kg, node_addr, far_x + 1), idir.x, P_idir.x);
+	const avxf tfar_y = msub(obvh_node_row(kg, node_addr, far_y + 1), idir.y, P_idir.y);
+	const avxf tfar_z = msub(obvh_node_row(kg, node_addr, far_z + 1), idir.z, P_idir.z);
+
+	const float round_down = 1.0f - difl;
+	const float round_up = 1.0f + difl;
+	const avxf tnear = max(max(tnear_x, tnear_y), max(tnear_z, isect_near));
+	const avxf tfar = min(min(tfar_x, tfar_y), min(tfar_z, isect_far));
+	const avxb vmask = avxf(round_down)*tnear <= avxf(round_up)*tfar;
+	*dist = tnear;
+	return movemask(vmask);
+}
+
+/* Unaligned nodes intersection */
+
+ccl_device_inline void obvh_unaligned_node_slabs(KernelGlobals *ccl_restrict kg,
+                                                 const avx3f& org,
+                                                 const avx3f& dir,
+                                                 const int node_addr,
+                                                 avxf *ccl_restrict tnear,
+                                                 avxf *ccl_restrict tfar)
+{
+	const avxf tfm_x_x = obvh_node_row(kg, node_addr, 1);
+	const avxf tfm_x_y = obvh_node_row(kg, node_addr, 2);
+	const avxf tfm_x_z = obvh_node_row(kg, node_addr, 3);
+
+	const avxf tfm_y_x = obvh_node_row(kg, node_addr, 4);
+	const avxf tfm_y_y = obvh_node_row(kg, node_addr, 5);
+	const avxf tfm_y_z = obvh_node_row(kg, node_addr, 6);
+
+	const avxf tfm_z_x = obvh_node_row(kg, node_addr, 7);
+	const avxf tfm_z_y = obvh_node_row(kg, node_addr, 8);
+	const avxf tfm_z_z = obvh_node_row(kg, node_addr, 9);
+
+	const avxf tfm_t_x = obvh_node_row(kg, node_addr, 10);
+	const avxf tfm_t_y = obvh_node_row(kg, node_addr, 11);
+	const avxf tfm_t_z = obvh_node_row(kg, node_addr, 12);
+
+	const avxf aligned_dir_x = dir.x*tfm_x_x + dir.y*tfm_x_y + dir.z*tfm_x_z,
+	           aligned_dir_y = dir.x*tfm_y_x + dir.y*tfm_y_y + dir.z*tfm_y_z,
+	           aligned_dir_z = dir.x*tfm_z_x + dir.y*tfm_z_y + dir.z*tfm_z_z;
+
+	const avxf aligned_P_x = org.x*tfm_x_x + org.y*tfm_x_y + org.z*tfm_x_z + tfm_t_x,
+	           aligned_P_y = org.x*tfm_y_x + org.y*tfm_y_y + org.z*tfm_y_z + tfm_t_y,
+	           aligned_P_z = org.x*tfm_z_x + org.y*tfm_z_y + org.z*tfm_z_z + tfm_t_z;
+
+	const avxf neg_one(-1.0f);
+	const avxf nrdir_x = neg_one / aligned_dir_x,
+	           nrdir_y = neg_one / aligned_dir_y,
+	           nrdir_z = neg_one / aligned_dir_z;
+
+	const avxf tlower_x = aligned_P_x * nrdir_x,
+	           tlower_y = aligned_P_y * nrdir_y,
+	           tlower_z = aligned_P_z * nrdir_z;
+
+	const avxf tupper_x = tlower_x - nrdir_x,
+	           tupper_y = tlower_y - nrdir_y,
+	           tupper_z = tlower_z - nrdir_z;
+
+	*tnear = max(max(min(tlower_x, tupper_x), min(tlower_y, tupper_y)),
+	             min(tlower_z, tupper_z));
+	*tfar = min(min(max(tlower_x, tupper_x), max(tlower_y, tupper_y)),
+	            max(tlower_z, tupper_z));
+}
+
+ccl_device_inline int obvh_unaligned_node_intersect(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& org_idir,
+        const avx3f& org,
+        const avx3f& dir,
+        const avx3f& idir,
+        const int near_x,
+        const int near_y,
+        const int near_z,
+        const int far_x,
+        const int far_y,
+        const int far_z,
+        const int node_addr,
+        avxf *ccl_restrict dist)
+{
+	avxf tnear, tfar;
+	obvh_unaligned_node_slabs(kg, org, dir, node_addr, &tnear, &tfar);
+	/* Empty children have NaN transforms, keep the slabs as the second
+	 * operand so the NaN is returned and they are never hit. */
+	tnear = max(isect_near, tnear);
+	tfar = min(isect_far, tfar);
+	const avxb vmask = tnear <= tfar;
+	*dist = tnear;
+	return movemask(vmask);
+}
+
+ccl_device_inline int obvh_unaligned_node_intersect_robust(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& P_idir,
+        const avx3f& P,
+        const avx3f& dir,
+        const avx3f& idir,
+        const int near_x,
+        const int near_y,
+        const int near_z,
+        const int far_x,
+        const int far_y,
+        const int far_z,
+        const int node_addr,
+        const float difl,
+        avxf *ccl_restrict dist)
+{
+	avxf tnear, tfar;
+	obvh_unaligned_node_slabs(kg, P, dir, node_addr, &tnear, &tfar);
+	tnear = max(isect_near, tnear);
+	tfar = min(isect_far, tfar);
+	const float round_down = 1.0f - difl;
+	const float round_up = 1.0f + difl;
+	const avxb vmask = avxf(round_down)*tnear <= avxf(round_up)*tfar;
+	*dist = tnear;
+	return movemask(vmask);
+}
+
+/* Intersectors wrappers.
+ *
+ * They'll check node type and call appropriate intersection code.
+ */
+
+ccl_device_inline int obvh_node_intersect(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& org_idir,
+        const avx3f& org,
+        const avx3f& dir,
+        const avx3f& idir,
+        const int near_x,
+        const int near_y,
+        const int near_z,
+        const int far_x,
+        const int far_y,
+        const int far_z,
+        const int node_addr,
+        avxf *ccl_restrict dist)
+{
+	const float4 node = kernel_tex_fetch(__bvh_nodes, node_addr);
+	if(__float_as_uint(node.x) & PATH_RAY_NODE_UNALIGNED) {
+		return obvh_unaligned_node_intersect(kg,
+		                                     isect_near,
+		                                     isect_far,
+		                                     org_idir,
+		                                     org,
+		                                     dir,
+		                                     idir,
+		                                     near_x, near_y, near_z,
+		                                     far_x, far_y, far_z,
+		                                     node_addr,
+		                                     dist);
+	}
+	else {
+		return obvh_aligned_node_intersect(kg,
+		                                   isect_near,
+		                                   isect_far,
+		                                   org_idir,
+		                                   idir,
+		                                   near_x, near_y, near_z,
+		                                   far_x, far_y, far_z,
+		                                   node_addr,
+		                                   dist);
+	}
+}
+
+ccl_device_inline int obvh_node_intersect_robust(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& P_idir,
+        const avx3f& P,
+        const avx3f& dir,
+        const avx3f& idir,
+        const int near_x,
+        const int near_y,
+        const int near_z,
+        const int far_x,
+        const int far_y,
+        const int far_z,
+        const int node_addr,
+        const float difl,
+        avxf *ccl_restrict dist)
+{
+	const float4 node = kernel_tex_fetch(__bvh_nodes, node_addr);
+	if(__float_as_uint(node.x) & PATH_RAY_NODE_UNALIGNED) {
+		return obvh_unaligned_node_intersect_robust(kg,
+		                                            isect_near,
+		                                            isect_far,
+		                                            P_idir,
+		                                            P,
+		                                            dir,
+		                                            idir,
+		                                            near_x, near_y, near_z,
+		                                            far_x, far_y, far_z,
+		                                            node_addr,
+		                                            difl,
+		                                            dist);
+	}
+	else {
+		return obvh_aligned_node_intersect_robust(kg,
+		                                          isect_near,
+		                                          isect_far,
+		                                          P_idir,
+		                                          idir,
+		                                          near_x, near_y, near_z,
+		                                          far_x, far_y, far_z,
+		                                          node_addr,
+		                                          difl,
+		                                          dist);
+	}
+}
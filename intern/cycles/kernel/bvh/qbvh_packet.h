@@ -0,0 +1,348 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Packet traversal of the QBVH, which traces four rays at once with the rays
+ * in the SIMD lanes rather than the children of a node. Rays of a packet are
+ * expected to be coherent, like camera rays of neighbouring pixels, so that
+ * they visit mostly the same nodes and share the cost of fetching them.
+ *
+ * Only triangles and instancing are supported, scenes with motion blur or
+ * hair are traced one ray at a time by scene_intersect_packet(). Primitives
+ * are intersected one ray at a time with the same functions as the regular
+ * traversal, so a packet finds exactly the same intersections.
+ */
+
+#define QBVH_PACKET_SIZE 4
+
+struct QBVHPacketStackItem {
+	ssef dist;
+	int addr;
+	/* Lanes which visit the node. */
+	int lanes;
+};
+
+ccl_device_inline void qbvh_packet_load(const float3 P[QBVH_PACKET_SIZE],
+                                        const float3 idir[QBVH_PACKET_SIZE],
+                                        const Intersection isects[QBVH_PACKET_SIZE],
+                                        sse3f *org4,
+                                        sse3f *idir4,
+                                        ssef *isect_t)
+{
+	*org4 = sse3f(ssef(P[0].x, P[1].x, P[2].x, P[3].x),
+	              ssef(P[0].y, P[1].y, P[2].y, P[3].y),
+	              ssef(P[0].z, P[1].z, P[2].z, P[3].z));
+	*idir4 = sse3f(ssef(idir[0].x, idir[1].x, idir[2].x, idir[3].x),
+	               ssef(idir[0].y, idir[1].y, idir[2].y, idir[3].y),
+	               ssef(idir[0].z, idir[1].z, idir[2].z, idir[3].z));
+	*isect_t = ssef(isects[0].t, isects[1].t, isects[2].t, isects[3].t);
+}
+
+/* Intersects the lanes with the bounds of all children of the node. Lanes
+ * can have directions in different octants inside of instances, so the near
+ * and far planes are selected per lane. */
+ccl_device_inline void qbvh_packet_node_intersect(KernelGlobals *kg,
+                                                  const sse3f& org,
+                                                  const sse3f& idir,
+                                                  const ssef& isect_far,
+                                                  const int lanes,
+                                                  const int node_addr,
+                                                  ssef dist[4],
+                                                  int child_lanes[4])
+{
+	const int offset = node_addr + 1;
+	const float4 bmin_x = kernel_tex_fetch(__bvh_nodes, offset+0);
+	const float4 bmax_x = kernel_tex_fetch(__bvh_nodes, offset+1);
+	const float4 bmin_y = kernel_tex_fetch(__bvh_nodes, offset+2);
+	const float4 bmax_y = kernel_tex_fetch(__bvh_nodes, offset+3);
+	const float4 bmin_z = kernel_tex_fetch(__bvh_nodes, offset+4);
+	const float4 bmax_z = kernel_tex_fetch(__bvh_nodes, offset+5);
+
+	const sseb neg_x = idir.x < ssef(0.0f);
+	const sseb neg_y = idir.y < ssef(0.0f);
+	const sseb neg_z = idir.z < ssef(0.0f);
+
+	for(int c = 0; c < 4; c++) {
+		const ssef tnear_x = (select(neg_x, ssef(bmax_x[c]), ssef(bmin_x[c])) - org.x) * idir.x;
+		const ssef tnear_y = (select(neg_y, ssef(bmax_y[c]), ssef(bmin_y[c])) - org.y) * idir.y;
+		const ssef tnear_z = (select(neg_z, ssef(bmax_z[c]), ssef(bmin_z[c])) - org.z) * idir.z;
+		const ssef tfar_x = (select(neg_x, ssef(bmin_x[c]), ssef(bmax_x[c])) - org.x) * idir.x;
+		const ssef tfar_y = (select(neg_y, ssef(bmin_y[c]), ssef(bmax_y[c])) - org.y) * idir.y;
+		const ssef tfar_z = (select(neg_z, ssef(bmin_z[c]), ssef(bmax_z[c])) - org.z) * idir.z;
+
+		const ssef tnear = max(max(tnear_x, tnear_y), max(tnear_z, ssef(0.0f)));
+		const ssef tfar = min(min(tfar_x, tfar_y), min(tfar_z, isect_far));
+
+		dist[c] = tnear;
+		child_lanes[c] = lanes & (int)movemask(tnear <= tfar);
+	}
+}
+
+/* Rays are NULL for unused lanes. Returns the mask of lanes which hit
+ * something, shadow rays stop at the first hit like the regular traversal. */
+ccl_device int qbvh_intersect_packet(KernelGlobals *kg,
+                                     const Ray *const rays[QBVH_PACKET_SIZE],
+                                     Intersection isects[QBVH_PACKET_SIZE],
+                                     const uint visibility)
+{
+	/* Traversal stack in thread-local memory. */
+	QBVHPacketStackItem traversal_stack[BVH_QSTACK_SIZE];
+	traversal_stack[0].addr = ENTRYPOINT_SENTINEL;
+	traversal_stack[0].dist = ssef(-FLT_MAX);
+	traversal_stack[0].lanes = 0;
+
+	/* Traversal variables. */
+	int stack_ptr = 0;
+	int node_addr = kernel_data.bvh.root;
+	int node_lanes = 0;
+	ssef node_dist = ssef(-FLT_MAX);
+
+	/* Ray parameters of the lanes, in object space inside of an instance. */
+	float3 P[QBVH_PACKET_SIZE];
+	float3 dir[QBVH_PACKET_SIZE];
+	float3 idir[QBVH_PACKET_SIZE];
+	int object = OBJECT_NONE;
+
+	for(int i = 0; i < QBVH_PACKET_SIZE; i++) {
+		Intersection *isect = &isects[i];
+
+		isect->t = 0.0f;
+		isect->u = 0.0f;
+		isect->v = 0.0f;
+		isect->prim = PRIM_NONE;
+		isect->object = OBJECT_NONE;
+
+		BVH_DEBUG_INIT();
+
+		if(rays[i] == NULL || !isfinite(rays[i]->P.x)) {
+			P[i] = make_float3(0.0f, 0.0f, 0.0f);
+			dir[i] = make_float3(1.0f, 1.0f, 1.0f);
+			idir[i] = make_float3(1.0f, 1.0f, 1.0f);
+			continue;
+		}
+
+		isect->t = rays[i]->t;
+		P[i] = rays[i]->P;
+		dir[i] = bvh_clamp_direction(rays[i]->D);
+		idir[i] = bvh_inverse_direction(dir[i]);
+		node_lanes |= (1 << i);
+	}
+
+	const int active_lanes = node_lanes;
+	/* Lanes of shadow rays which are blocked. */
+	int done_lanes = 0;
+
+	if(active_lanes == 0) {
+		return 0;
+	}
+
+	sse3f org4, idir4;
+	ssef isect_t;
+	qbvh_packet_load(P, idir, isects, &org4, &idir4, &isect_t);
+
+	/* Traversal loop. */
+	do {
+		do {
+			/* Traverse internal nodes. */
+			while(node_addr >= 0 && node_addr != ENTRYPOINT_SENTINEL) {
+				float4 inodes = kernel_tex_fetch(__bvh_nodes, node_addr+0);
+				(void)inodes;
+
+				/* Lanes which can still find a closer hit in the node. */
+				const int lanes = node_lanes & ~done_lanes & (int)movemask(node_dist <= isect_t);
+
+				if(lanes == 0
+#ifdef __VISIBILITY_FLAG__
+				   || (__float_as_uint(inodes.x) & visibility) == 0
+#endif
+				 )
+				{
+					/* Pop. */
+					node_addr = traversal_stack[stack_ptr].addr;
+					node_dist = traversal_stack[stack_ptr].dist;
+					node_lanes = traversal_stack[stack_ptr].lanes;
+					--stack_ptr;
+					continue;
+				}
+
+				ssef dist[4];
+				int child_lanes[4];
+				qbvh_packet_node_intersect(kg,
+				                           org4,
+				                           idir4,
+				                           isect_t,
+				                           lanes,
+				                           node_addr,
+				                           dist,
+				                           child_lanes);
+
+				const float4 cnodes = kernel_tex_fetch(__bvh_nodes, node_addr+7);
+
+				/* Sort the hit children by the closest hit of any lane,
+				 * farthest first. */
+				QBVHPacketStackItem children[4];
+				float children_dist[4];
+				int num_children = 0;
+
+				for(int c = 0; c < 4; c++) {
+					if(child_lanes[c] == 0) {
+						continue;
+					}
+
+					const float d = reduce_min(select(sseb(child_lanes[c]), dist[c], ssef(FLT_MAX)));
+
+					int k = num_children++;
+					for(; k > 0 && children_dist[k - 1] < d; k--) {
+						children[k] = children[k - 1];
+						children_dist[k] = children_dist[k - 1];
+					}
+
+					children[k].addr = __float_as_int(cnodes[c]);
+					children[k].dist = dist[c];
+					children[k].lanes = child_lanes[c];
+					children_dist[k] = d;
+				}
+
+				if(num_children == 0) {
+					/* Pop. */
+					node_addr = traversal_stack[stack_ptr].addr;
+					node_dist = traversal_stack[stack_ptr].dist;
+					node_lanes = traversal_stack[stack_ptr].lanes;
+					--stack_ptr;
+					continue;
+				}
+
+				/* Push the farther children, continue with the closest. */
+				for(int k = 0; k < num_children - 1; k++) {
+					++stack_ptr;
+					kernel_assert(stack_ptr < BVH_QSTACK_SIZE);
+					traversal_stack[stack_ptr] = children[k];
+				}
+
+				node_addr = children[num_children - 1].addr;
+				node_dist = children[num_children - 1].dist;
+				node_lanes = children[num_children - 1].lanes;
+			}
+
+			/* If node is leaf, fetch triangle list. */
+			if(node_addr < 0) {
+				float4 leaf = kernel_tex_fetch(__bvh_leaf_nodes, (-node_addr-1));
+				const int lanes = node_lanes & ~done_lanes & (int)movemask(node_dist <= isect_t);
+
+#ifdef __VISIBILITY_FLAG__
+				if(lanes == 0 || (__float_as_uint(leaf.z) & visibility) == 0)
+#else
+				if(lanes == 0)
+#endif
+				{
+					/* Pop. */
+					node_addr = traversal_stack[stack_ptr].addr;
+					node_dist = traversal_stack[stack_ptr].dist;
+					node_lanes = traversal_stack[stack_ptr].lanes;
+					--stack_ptr;
+					continue;
+				}
+
+				int prim_addr = __float_as_int(leaf.x);
+
+				if(prim_addr >= 0) {
+					const int prim_addr2 = __float_as_int(leaf.y);
+
+					/* Pop. */
+					node_addr = traversal_stack[stack_ptr].addr;
+					node_dist = traversal_stack[stack_ptr].dist;
+					node_lanes = traversal_stack[stack_ptr].lanes;
+					--stack_ptr;
+
+					/* Primitive intersection, one lane at a time. */
+					for(; prim_addr < prim_addr2; prim_addr++) {
+						kernel_assert(kernel_tex_fetch(__prim_type, prim_addr) == PRIMITIVE_TRIANGLE);
+
+						int prim_lanes = lanes & ~done_lanes;
+						while(prim_lanes != 0) {
+							const int i = __bscf(prim_lanes);
+							if(triangle_intersect(kg,
+							                      &isects[i],
+							                      P[i],
+							                      dir[i],
+							                      visibility,
+							                      object,
+							                      prim_addr))
+							{
+								isect_t[i] = isects[i].t;
+								/* Shadow ray early termination. */
+								if(visibility & PATH_RAY_SHADOW_OPAQUE) {
+									done_lanes |= (1 << i);
+								}
+							}
+						}
+					}
+
+					if(done_lanes == active_lanes) {
+						return active_lanes;
+					}
+				}
+				else {
+					/* Instance push, the lanes continue in object space. */
+					object = kernel_tex_fetch(__prim_object, -prim_addr-1);
+
+					int instance_lanes = lanes;
+					while(instance_lanes != 0) {
+						const int i = __bscf(instance_lanes);
+						isects[i].t = bvh_instance_push(kg, object, rays[i], &P[i], &dir[i], &idir[i], isects[i].t);
+					}
+					qbvh_packet_load(P, idir, isects, &org4, &idir4, &isect_t);
+
+					++stack_ptr;
+					kernel_assert(stack_ptr < BVH_QSTACK_SIZE);
+					traversal_stack[stack_ptr].addr = ENTRYPOINT_SENTINEL;
+					traversal_stack[stack_ptr].dist = ssef(-FLT_MAX);
+					traversal_stack[stack_ptr].lanes = lanes;
+
+					node_addr = kernel_tex_fetch(__object_node, object);
+					node_dist = ssef(-FLT_MAX);
+					node_lanes = lanes;
+				}
+			}
+		} while(node_addr != ENTRYPOINT_SENTINEL);
+
+		if(stack_ptr >= 0) {
+			kernel_assert(object != OBJECT_NONE);
+
+			/* Instance pop, the sentinel holds the lanes of the instance. */
+			int instance_lanes = node_lanes;
+			while(instance_lanes != 0) {
+				const int i = __bscf(instance_lanes);
+				isects[i].t = bvh_instance_pop(kg, object, rays[i], &P[i], &dir[i], &idir[i], isects[i].t);
+			}
+			qbvh_packet_load(P, idir, isects, &org4, &idir4, &isect_t);
+
+			object = OBJECT_NONE;
+			node_addr = traversal_stack[stack_ptr].addr;
+			node_dist = traversal_stack[stack_ptr].dist;
+			node_lanes = traversal_stack[stack_ptr].lanes;
+			--stack_ptr;
+		}
+	} while(node_addr != ENTRYPOINT_SENTINEL);
+
+	int hit_lanes = 0;
+	for(int i = 0; i < QBVH_PACKET_SIZE; i++) {
+		if(isects[i].prim != PRIM_NONE) {
+			hit_lanes |= (1 << i);
+		}
+	}
+
+	return hit_lanes;
+}
@@ -74,15 +74,50 @@ ccl_device_inline void triangle_vertices(KernelGlobals *kg, int prim, float3 P[3
 	P[2] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+2));
 }
 
+/* Compact geometry storage */
+
+ccl_device_inline float3 triangle_vertex_normal(KernelGlobals *kg, uint vert)
+{
+	if(kernel_data.bvh.use_compact_geometry) {
+		return octahedral_to_float3(kernel_tex_fetch(__tri_vnormal_oct, vert));
+	}
+	else {
+		return float4_to_float3(kernel_tex_fetch(__tri_vnormal, vert));
+	}
+}
+
+/* Half float bits to float. Denormals were flushed to zero and values were
+ * clamped to the largest finite half when storing. */
+ccl_device_inline float triangle_half_to_float(uint h)
+{
+	const uint sign = (h & 0x8000) << 16;
+	const uint exponent = h & 0x7C00;
+
+	if(exponent == 0) {
+		return __uint_as_float(sign);
+	}
+
+	return __uint_as_float(sign | ((exponent + 0x1C000) << 13) | ((h & 0x03FF) << 13));
+}
+
+ccl_device_inline float3 triangle_attribute_half3(KernelGlobals *kg, int index)
+{
+	const uint2 h = kernel_tex_fetch(__attributes_half3, index);
+
+	return make_float3(triangle_half_to_float(h.x & 0xFFFF),
+	                   triangle_half_to_float(h.x >> 16),
+	                   triangle_half_to_float(h.y & 0xFFFF));
+}
+
 /* Interpolate smooth vertex normal from vertices */
 
 ccl_device_inline float3 triangle_smooth_normal(KernelGlobals *kg, float3 Ng, int prim, float u, float v)
 {
 	/* load triangle vertices */
 	const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
-	float3 n0 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.x));
-	float3 n1 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.y));
-	float3 n2 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.z));
+	float3 n0 = triangle_vertex_normal(kg, tri_vindex.x);
+	float3 n1 = triangle_vertex_normal(kg, tri_vindex.y);
+	float3 n2 = triangle_vertex_normal(kg, tri_vindex.z);
 
 	float3 N = safe_normalize((1.0f - u - v)*n2 + u*n0 + v*n1);
 
@@ -171,7 +206,10 @@ ccl_device float3 triangle_attribute_float3(KernelGlobals *kg, const ShaderData
 
 		return sd->u*f0 + sd->v*f1 + (1.0f - sd->u - sd->v)*f2;
 	}
-	else if(desc.element == ATTR_ELEMENT_CORNER || desc.element == ATTR_ELEMENT_CORNER_BYTE) {
+	else if(desc.element == ATTR_ELEMENT_CORNER ||
+	        desc.element == ATTR_ELEMENT_CORNER_BYTE ||
+	        desc.element == ATTR_ELEMENT_CORNER_HALF)
+	{
 		int tri = desc.offset + sd->prim*3;
 		float3 f0, f1, f2;
 
@@ -180,6 +218,11 @@ ccl_device float3 triangle_attribute_float3(KernelGlobals *kg, const ShaderData
 			f1 = float4_to_float3(kernel_tex_fetch(__attributes_float3, tri + 1));
 			f2 = float4_to_float3(kernel_tex_fetch(__attributes_float3, tri + 2));
 		}
+		else if(desc.element == ATTR_ELEMENT_CORNER_HALF) {
+			f0 = triangle_attribute_half3(kg, tri + 0);
+			f1 = triangle_attribute_half3(kg, tri + 1);
+			f2 = triangle_attribute_half3(kg, tri + 2);
+		}
 		else {
 			f0 = color_byte_to_float(kernel_tex_fetch(__attributes_uchar4, tri + 0));
 			f1 = color_byte_to_float(kernel_tex_fetch(__attributes_uchar4, tri + 1));
@@ -0,0 +1,264 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KERNEL_ADAPTIVE_SAMPLING_H__
+#define __KERNEL_ADAPTIVE_SAMPLING_H__
+
+CCL_NAMESPACE_BEGIN
+
+/* Adaptive sampling
+ *
+ * Pixels stop receiving samples once their error estimate drops below the
+ * threshold. The error is the difference between the combined pass and the
+ * auxiliary buffer, which accumulates every other sample (see
+ * kernel_write_adaptive_buffer). The w component of the auxiliary buffer is
+ * non-zero for converged pixels, the sample count pass holds the number of
+ * samples each pixel actually received. The device keeps track of how many
+ * samples the other passes of a pixel hold once they have been rescaled (see
+ * kernel_adaptive_adjust_samples).
+ */
+
+#ifdef __ADAPTIVE_SAMPLING__
+
+ccl_device_inline ccl_global float *kernel_adaptive_pixel_buffer(KernelGlobals *kg,
+                                                                 ccl_global float *buffer,
+                                                                 int x, int y,
+                                                                 int offset, int stride)
+{
+	return buffer + (offset + x + y*stride) * kernel_data.film.pass_stride;
+}
+
+ccl_device_inline bool kernel_adaptive_pixel_is_converged(KernelGlobals *kg,
+                                                          ccl_global float *buffer)
+{
+	return buffer[kernel_data.film.pass_adaptive_aux_buffer + 3] != 0.0f;
+}
+
+/* Called before path tracing a pixel: returns true when the pixel has
+ * converged, otherwise counts the sample. The sample count pass may also be
+ * used without adaptive sampling, as a debug pass. */
+ccl_device_inline bool kernel_adaptive_sample_skip(KernelGlobals *kg,
+                                                   ccl_global float *buffer)
+{
+	if(kernel_data.film.pass_adaptive_aux_buffer && kernel_adaptive_pixel_is_converged(kg, buffer)) {
+		return true;
+	}
+	if(kernel_data.film.pass_sample_count) {
+		buffer[kernel_data.film.pass_sample_count] += 1.0f;
+	}
+	return false;
+}
+
+/* Per pixel error from section 2.1 of "A Hierarchical Automatic Stopping
+ * Condition for Monte Carlo Global Illumination", Dammertz et al. 2010.
+ * Both buffers hold sums, so the threshold is scaled by the sample count. */
+ccl_device void kernel_adaptive_stopping(KernelGlobals *kg,
+                                         ccl_global float *buffer,
+                                         int x, int y,
+                                         int offset, int stride)
+{
+	buffer = kernel_adaptive_pixel_buffer(kg, buffer, x, y, offset, stride);
+
+	if(kernel_adaptive_pixel_is_converged(kg, buffer)) {
+		return;
+	}
+
+	const float num_samples = buffer[kernel_data.film.pass_sample_count];
+	ccl_global float *aux = buffer + kernel_data.film.pass_adaptive_aux_buffer;
+
+	const float3 I = make_float3(buffer[0], buffer[1], buffer[2]);
+	const float3 A = make_float3(aux[0], aux[1], aux[2]);
+
+	/* Small epsilon avoids division by zero for black pixels. */
+	const float error = (fabsf(I.x - A.x) + fabsf(I.y - A.y) + fabsf(I.z - A.z)) /
+	                    (num_samples * 0.0001f + sqrtf(max(I.x + I.y + I.z, 0.0f)));
+
+	if(error < kernel_data.integrator.adaptive_threshold * num_samples) {
+		aux[3] = 1.0f;
+	}
+}
+
+/* Converged pixels next to unconverged ones get more samples too, which avoids
+ * isolated pixels stopping early due to an unlucky error estimate. The filter
+ * is separable, run over all rows of the tile and then over all columns.
+ * Returns true if any pixel in the row is unconverged. */
+ccl_device bool kernel_adaptive_filter_x(KernelGlobals *kg,
+                                         ccl_global float *buffer,
+                                         int y, int tile_x, int tile_w,
+                                         int offset, int stride)
+{
+	const int aux_w = kernel_data.film.pass_adaptive_aux_buffer + 3;
+	bool any = false;
+	bool prev = false;
+
+	for(int x = tile_x; x < tile_x + tile_w; x++) {
+		ccl_global float *pixel = kernel_adaptive_pixel_buffer(kg, buffer, x, y, offset, stride);
+
+		if(pixel[aux_w] == 0.0f) {
+			any = true;
+			if(x > tile_x && !prev) {
+				kernel_adaptive_pixel_buffer(kg, buffer, x - 1, y, offset, stride)[aux_w] = 0.0f;
+			}
+			prev = true;
+		}
+		else {
+			if(prev) {
+				pixel[aux_w] = 0.0f;
+			}
+			prev = false;
+		}
+	}
+
+	return any;
+}
+
+ccl_device bool kernel_adaptive_filter_y(KernelGlobals *kg,
+                                         ccl_global float *buffer,
+                                         int x, int tile_y, int tile_h,
+                                         int offset, int stride)
+{
+	const int aux_w = kernel_data.film.pass_adaptive_aux_buffer + 3;
+	bool any = false;
+	bool prev = false;
+
+	for(int y = tile_y; y < tile_y + tile_h; y++) {
+		ccl_global float *pixel = kernel_adaptive_pixel_buffer(kg, buffer, x, y, offset, stride);
+
+		if(pixel[aux_w] == 0.0f) {
+			any = true;
+			if(y > tile_y && !prev) {
+				kernel_adaptive_pixel_buffer(kg, buffer, x, y - 1, offset, stride)[aux_w] = 0.0f;
+			}
+			prev = true;
+		}
+		else {
+			if(prev) {
+				pixel[aux_w] = 0.0f;
+			}
+			prev = false;
+		}
+	}
+
+	return any;
+}
+
+ccl_device_inline void kernel_adaptive_scale(ccl_global float *buffer, int num, float scale)
+{
+	for(int i = 0; i < num; i++) {
+		buffer[i] *= scale;
+	}
+}
+
+/* Film conversion divides all pixels by the same sample count, so scale the
+ * accumulated passes of pixels that stopped early as if they had received
+ * all samples. num_samples is the number of samples the passes of the pixel
+ * hold, which differs from the sample count pass once they were rescaled by an
+ * earlier call. The sample count pass itself keeps the real number of samples.
+ * Passes which are only written for the first sample are left alone. */
+ccl_device void kernel_adaptive_adjust_samples(KernelGlobals *kg,
+                                               ccl_global float *buffer,
+                                               int x, int y,
+                                               int offset, int stride,
+                                               float num_samples,
+                                               int sample)
+{
+	if(num_samples <= 0.0f || num_samples == (float)sample) {
+		return;
+	}
+
+	buffer = kernel_adaptive_pixel_buffer(kg, buffer, x, y, offset, stride);
+
+	const float scale = (float)sample / num_samples;
+
+	kernel_adaptive_scale(buffer, 4, scale);
+	kernel_adaptive_scale(buffer + kernel_data.film.pass_adaptive_aux_buffer, 3, scale);
+
+#ifdef __PASSES__
+	const int flag = kernel_data.film.pass_flag;
+	const int light_flag = kernel_data.film.light_pass_flag;
+
+	if(flag & PASSMASK(NORMAL))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_normal, 3, scale);
+	if(flag & PASSMASK(UV))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_uv, 3, scale);
+	if(flag & PASSMASK(MOTION)) {
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_motion, 4, scale);
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_motion_weight, 1, scale);
+	}
+
+	if(light_flag & PASSMASK(MIST))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_mist, 1, scale);
+	if(light_flag & PASSMASK(EMISSION))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_emission, 3, scale);
+	if(light_flag & PASSMASK(BACKGROUND))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_background, 3, scale);
+	if(light_flag & PASSMASK(AO))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_ao, 3, scale);
+	if(light_flag & PASSMASK(SHADOW))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_shadow, 4, scale);
+
+	if(light_flag & PASSMASK(DIFFUSE_COLOR))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_diffuse_color, 3, scale);
+	if(light_flag & PASSMASK(GLOSSY_COLOR))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_glossy_color, 3, scale);
+	if(light_flag & PASSMASK(TRANSMISSION_COLOR))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_transmission_color, 3, scale);
+	if(light_flag & PASSMASK(SUBSURFACE_COLOR))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_subsurface_color, 3, scale);
+
+	if(light_flag & PASSMASK(DIFFUSE_DIRECT))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_diffuse_direct, 3, scale);
+	if(light_flag & PASSMASK(GLOSSY_DIRECT))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_glossy_direct, 3, scale);
+	if(light_flag & PASSMASK(TRANSMISSION_DIRECT))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_transmission_direct, 3, scale);
+	if(light_flag & PASSMASK(SUBSURFACE_DIRECT))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_subsurface_direct, 3, scale);
+	if(light_flag & PASSMASK(VOLUME_DIRECT))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_volume_direct, 3, scale);
+
+	if(light_flag & PASSMASK(DIFFUSE_INDIRECT))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_diffuse_indirect, 3, scale);
+	if(light_flag & PASSMASK(GLOSSY_INDIRECT))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_glossy_indirect, 3, scale);
+	if(light_flag & PASSMASK(TRANSMISSION_INDIRECT))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_transmission_indirect, 3, scale);
+	if(light_flag & PASSMASK(SUBSURFACE_INDIRECT))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_subsurface_indirect, 3, scale);
+	if(light_flag & PASSMASK(VOLUME_INDIRECT))
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_volume_indirect, 3, scale);
+#endif  /* __PASSES__ */
+
+#ifdef __DENOISING_FEATURES__
+	/* Means and variances are both accumulated per sample. */
+	if(kernel_data.film.pass_denoising_data) {
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_denoising_data,
+		                      DENOISING_PASS_SIZE_BASE,
+		                      scale);
+	}
+	if(kernel_data.film.pass_denoising_clean) {
+		kernel_adaptive_scale(buffer + kernel_data.film.pass_denoising_clean,
+		                      DENOISING_PASS_SIZE_CLEAN,
+		                      scale);
+	}
+#endif  /* __DENOISING_FEATURES__ */
+}
+
+#endif  /* __ADAPTIVE_SAMPLING__ */
+
+CCL_NAMESPACE_END
+
+#endif  /* __KERNEL_ADAPTIVE_SAMPLING_H__ */
@@ -44,6 +44,8 @@ struct OSLShadingSystem;
 
 struct Intersection;
 struct VolumeStep;
+struct PathStream;
+class TextureCache;
 
 typedef struct KernelGlobals {
 #  define KERNEL_TEX(type, name) texture<type> name;
@@ -59,6 +61,10 @@ typedef struct KernelGlobals {
 	OSLThreadData *osl_tdata;
 #  endif
 
+	/* Image textures which are read on demand, NULL if all images are
+	 * loaded into memory. */
+	TextureCache *texture_cache;
+
 	/* **** Run-time data ****  */
 
 	/* Heap-allocated storage for transparent shadows intersections. */
@@ -68,6 +74,9 @@ typedef struct KernelGlobals {
 	VolumeStep *decoupled_volume_steps[2];
 	int decoupled_volume_steps_index;
 
+	/* Storage for paths and shadow rays of ray streams. */
+	PathStream *path_stream;
+
 	/* split kernel */
 	SplitData split_data;
 	SplitParams split_param_data;
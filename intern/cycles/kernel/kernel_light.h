@@ -33,6 +33,45 @@ typedef struct LightSample {
 	LightType type;		/* type of light */
 } LightSample;
 
+/* Light selection
+ *
+ * Probability of picking a light for shading point P, either from the light
+ * tree or proportional to triangle area with an equal share for each lamp. */
+
+ccl_device_inline float light_select_lamp_pdf(KernelGlobals *kg, int lamp, float3 P)
+{
+	if(kernel_data.integrator.use_light_tree) {
+		const int num_triangles = kernel_data.integrator.num_distribution -
+		                          kernel_data.integrator.num_all_lights;
+		return light_tree_pdf(kg, num_triangles + lamp, P);
+	}
+	return kernel_data.integrator.pdf_lights;
+}
+
+/* There is at most one background light. */
+ccl_device_inline float light_select_background_pdf(KernelGlobals *kg)
+{
+	if(kernel_data.integrator.use_light_tree) {
+		return kernel_data.integrator.light_tree_pdf_infinite /
+		       kernel_data.integrator.light_tree_num_infinite;
+	}
+	return kernel_data.integrator.pdf_lights;
+}
+
+/* Area is the one at the center of the motion blur shutter, which is what the
+ * light distribution was computed from. */
+ccl_device_inline float light_select_triangle_pdf(KernelGlobals *kg,
+                                                  int object,
+                                                  int prim,
+                                                  float area,
+                                                  float3 P)
+{
+	if(kernel_data.integrator.use_light_tree) {
+		return light_tree_pdf(kg, light_distribution_triangle_index(kg, object, prim), P);
+	}
+	return area * kernel_data.integrator.pdf_triangles;
+}
+
 /* Area light sampling */
 
 /* Uses the following paper:
@@ -440,7 +479,7 @@ ccl_device float background_light_pdf(KernelGlobals *kg, float3 P, float3 direct
 			/* Portal sampling is not possible here because all portals point to the wrong side.
 			 * If map sampling is possible, it would be used instead, otherwise fallback sampling is used. */
 			if(portal_sampling_pdf == 1.0f) {
-				return kernel_data.integrator.pdf_lights / M_4PI_F;
+				return light_select_background_pdf(kg) / M_4PI_F;
 			}
 			else {
 				/* Force map sampling. */
@@ -452,7 +491,7 @@ ccl_device float background_light_pdf(KernelGlobals *kg, float3 P, float3 direct
 		/* Evaluate PDF of sampling this direction by map sampling. */
 		map_pdf = background_map_pdf(kg, direction) * (1.0f - portal_sampling_pdf);
 	}
-	return (portal_pdf + map_pdf) * kernel_data.integrator.pdf_lights;
+	return (portal_pdf + map_pdf) * light_select_background_pdf(kg);
 }
 #endif
 
@@ -624,7 +663,7 @@ ccl_device_inline bool lamp_light_sample(KernelGlobals *kg,
 		}
 	}
 
-	ls->pdf *= kernel_data.integrator.pdf_lights;
+	ls->pdf *= light_select_lamp_pdf(kg, lamp, P);
 
 	return (ls->pdf > 0.0f);
 }
@@ -768,7 +807,7 @@ ccl_device bool lamp_light_eval(KernelGlobals *kg, int lamp, float3 P, float3 D,
 		return false;
 	}
 
-	ls->pdf *= kernel_data.integrator.pdf_lights;
+	ls->pdf *= light_select_lamp_pdf(kg, lamp, P);
 
 	return true;
 }
@@ -806,9 +845,9 @@ ccl_device_inline bool triangle_world_space_vertices(KernelGlobals *kg, int obje
 	return has_motion;
 }
 
-ccl_device_inline float triangle_light_pdf_area(KernelGlobals *kg, const float3 Ng, const float3 I, float t)
+/* Convert pdf over the triangle area to solid angle. */
+ccl_device_inline float triangle_light_pdf_area(const float3 Ng, const float3 I, float t, float pdf)
 {
-	float pdf = kernel_data.integrator.pdf_triangles;
 	float cos_pi = fabsf(dot(Ng, I));
 
 	if(cos_pi == 0.0f)
@@ -850,7 +889,7 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
 		const float gamma = fast_acosf(dot(u02, u12));
 		const float solid_angle =  alpha + beta + gamma - M_PI_F;
 
-		/* pdf_triangles is calculated over triangle area, but we're not sampling over its area */
+		/* the light selection pdf is for the whole triangle, but we're sampling over solid angle */
 		if(UNLIKELY(solid_angle == 0.0f)) {
 			return 0.0f;
 		}
@@ -864,25 +903,25 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
 			else {
 				area = 0.5f * len(N);
 			}
-			const float pdf = area * kernel_data.integrator.pdf_triangles;
+			const float pdf = light_select_triangle_pdf(kg, sd->object, sd->prim, area, Px);
 			return pdf / solid_angle;
 		}
 	}
 	else {
-		float pdf = triangle_light_pdf_area(kg, sd->Ng, sd->I, t);
+		const float area = 0.5f * len(N);
+		if(UNLIKELY(area == 0.0f)) {
+			return 0.0f;
+		}
+		/* area = the area the sample was taken from
+		 * area_pre = the area from which the selection pdf was calculated */
+		float area_pre = area;
 		if(has_motion) {
-			const float	area = 0.5f * len(N);
-			if(UNLIKELY(area == 0.0f)) {
-				return 0.0f;
-			}
-			/* scale the PDF.
-			 * area = the area the sample was taken from
-			 * area_pre = the are from which pdf_triangles was calculated from */
 			triangle_world_space_vertices(kg, sd->object, sd->prim, -1.0f, V);
-			const float area_pre = triangle_area(V[0], V[1], V[2]);
-			pdf = pdf * area_pre / area;
+			area_pre = triangle_area(V[0], V[1], V[2]);
 		}
-		return pdf;
+		const float3 Px = sd->P + sd->I * t;
+		const float pdf = light_select_triangle_pdf(kg, sd->object, sd->prim, area_pre, Px) / area;
+		return triangle_light_pdf_area(sd->Ng, sd->I, t, pdf);
 	}
 }
 
@@ -994,7 +1033,7 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg, int prim, i
 
 		ls->P = P + ls->D * ls->t;
 
-		/* pdf_triangles is calculated over triangle area, but we're sampling over solid angle */
+		/* the light selection pdf is for the whole triangle, but we're sampling over solid angle */
 		if(UNLIKELY(solid_angle == 0.0f)) {
 			ls->pdf = 0.0f;
 			return;
@@ -1005,7 +1044,7 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg, int prim, i
 				triangle_world_space_vertices(kg, object, prim, -1.0f, V);
 				area = triangle_area(V[0], V[1], V[2]);
 			}
-			const float pdf = area * kernel_data.integrator.pdf_triangles;
+			const float pdf = light_select_triangle_pdf(kg, object, prim, area, P);
 			ls->pdf = pdf / solid_angle;
 		}
 	}
@@ -1019,15 +1058,19 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg, int prim, i
 		ls->P = u * V[0] + v * V[1] + t * V[2];
 		/* compute incoming direction, distance and pdf */
 		ls->D = normalize_len(ls->P - P, &ls->t);
-		ls->pdf = triangle_light_pdf_area(kg, ls->Ng, -ls->D, ls->t);
-		if(has_motion && area != 0.0f) {
-			/* scale the PDF.
-			 * area = the area the sample was taken from
-			 * area_pre = the are from which pdf_triangles was calculated from */
+		if(UNLIKELY(area == 0.0f)) {
+			ls->pdf = 0.0f;
+			return;
+		}
+		/* area = the area the sample was taken from
+		 * area_pre = the area from which the selection pdf was calculated */
+		float area_pre = area;
+		if(has_motion) {
 			triangle_world_space_vertices(kg, object, prim, -1.0f, V);
-			const float area_pre = triangle_area(V[0], V[1], V[2]);
-			ls->pdf = ls->pdf * area_pre / area;
+			area_pre = triangle_area(V[0], V[1], V[2]);
 		}
+		const float pdf = light_select_triangle_pdf(kg, object, prim, area_pre, P) / area;
+		ls->pdf = triangle_light_pdf_area(ls->Ng, -ls->D, ls->t, pdf);
 		ls->u = u;
 		ls->v = v;
 	}
@@ -1087,7 +1130,9 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
                                       LightSample *ls)
 {
 	/* sample index */
-	int index = light_distribution_sample(kg, &randu);
+	int index = (kernel_data.integrator.use_light_tree)?
+	        light_tree_sample(kg, P, &randu):
+	        light_distribution_sample(kg, &randu);
 
 	/* fetch light data */
 	const ccl_global KernelLightDistribution *kdistribution = &kernel_tex_fetch(__light_distribution, index);
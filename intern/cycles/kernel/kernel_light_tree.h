@@ -0,0 +1,198 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KERNEL_LIGHT_TREE_H__
+#define __KERNEL_LIGHT_TREE_H__
+
+CCL_NAMESPACE_BEGIN
+
+/* Light Tree
+ *
+ * Picks a light by its estimated contribution to the shading point, see
+ * render/light_tree.h. The probability of a light is the product of the
+ * probabilities of choosing its ancestors at every level of the tree. It only
+ * depends on the position of the shading point and not on its normal, so the
+ * same probability can be found again for multiple importance sampling from
+ * the origin of a ray which hit the light.
+ *
+ * Distant and background lights are leaves after the tree, one of them is
+ * picked uniformly with probability light_tree_pdf_infinite.
+ */
+
+/* Estimated contribution of the lights in the node to shading point P, from
+ * section 4.3 of "Importance Sampling of Many Lights with Adaptive Tree
+ * Splitting", Estevez and Kulla, 2018. Zero only if none of the lights can
+ * illuminate P. */
+ccl_device float light_tree_node_importance(KernelGlobals *kg, int index, float3 P)
+{
+	const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, index);
+
+	const float3 bbox_min = make_float3(knode->bounds_min[0],
+	                                    knode->bounds_min[1],
+	                                    knode->bounds_min[2]);
+	const float3 bbox_max = make_float3(knode->bounds_max[0],
+	                                    knode->bounds_max[1],
+	                                    knode->bounds_max[2]);
+	const float3 centroid = 0.5f*(bbox_min + bbox_max);
+	const float radius_sq = len_squared(bbox_max - centroid);
+
+	float distance;
+	const float3 omega = normalize_len(P - centroid, &distance);
+	const float distance_sq = max(distance*distance, 1e-10f);
+
+	/* Inside of the bounding sphere the lights can be in any direction. */
+	if(distance_sq <= radius_sq) {
+		return knode->energy / max(radius_sq, 1e-10f);
+	}
+
+	const float3 axis = make_float3(knode->axis[0], knode->axis[1], knode->axis[2]);
+	float cos_theta = dot(axis, omega);
+	if(knode->two_sided) {
+		cos_theta = fabsf(cos_theta);
+	}
+
+	/* Smallest angle between the emission cone and any point of the bounds. */
+	const float theta = safe_acosf(cos_theta);
+	const float theta_u = safe_asinf(sqrtf(radius_sq / distance_sq));
+	const float theta_min = max(theta - knode->theta_o - theta_u, 0.0f);
+
+	if(theta_min >= knode->theta_e) {
+		return 0.0f;
+	}
+
+	return knode->energy * cosf(theta_min) / distance_sq;
+}
+
+/* Probability of choosing the first child of the inner node. */
+ccl_device_inline float light_tree_node_left_pdf(KernelGlobals *kg, int index, int child, float3 P)
+{
+	const float importance_left = light_tree_node_importance(kg, index + 1, P);
+	const float importance_right = light_tree_node_importance(kg, child, P);
+	const float importance = importance_left + importance_right;
+
+	/* Neither child can illuminate P, any choice is fine. */
+	if(importance == 0.0f) {
+		return 0.5f;
+	}
+
+	return importance_left / importance;
+}
+
+/* Returns the light distribution index of the picked light, and rescales
+ * randu to be used again for sampling the light. */
+ccl_device int light_tree_sample(KernelGlobals *kg, float3 P, float *randu)
+{
+	const float pdf_infinite = kernel_data.integrator.light_tree_pdf_infinite;
+	float r = *randu;
+	int index;
+
+	if(r < pdf_infinite) {
+		const int num_infinite = kernel_data.integrator.light_tree_num_infinite;
+		r = r * num_infinite / pdf_infinite;
+		const int i = clamp((int)r, 0, num_infinite - 1);
+
+		index = kernel_data.integrator.light_tree_num_nodes + i;
+		r = r - i;
+	}
+	else {
+		r = (r - pdf_infinite) / (1.0f - pdf_infinite);
+		index = 0;
+
+		for(;;) {
+			const int child = kernel_tex_fetch(__light_tree_nodes, index).child;
+			if(child < 0) {
+				break;
+			}
+
+			const float pdf_left = light_tree_node_left_pdf(kg, index, child, P);
+
+			if(r < pdf_left) {
+				r = r / pdf_left;
+				index = index + 1;
+			}
+			else {
+				r = (r - pdf_left) / (1.0f - pdf_left);
+				index = child;
+			}
+
+			/* Float rounding could make the next level pick a child with
+			 * zero probability. */
+			r = min(r, 0.99999994f);
+		}
+	}
+
+	*randu = clamp(r, 0.0f, 1.0f);
+
+	return ~kernel_tex_fetch(__light_tree_nodes, index).child;
+}
+
+/* Probability of light_tree_sample() picking the light at shading point P. */
+ccl_device float light_tree_pdf(KernelGlobals *kg, int distribution_index, float3 P)
+{
+	int index = kernel_tex_fetch(__light_tree_leaves, distribution_index);
+
+	if(index < 0) {
+		return 0.0f;
+	}
+	else if(index >= kernel_data.integrator.light_tree_num_nodes) {
+		return kernel_data.integrator.light_tree_pdf_infinite /
+		       kernel_data.integrator.light_tree_num_infinite;
+	}
+
+	float pdf = 1.0f - kernel_data.integrator.light_tree_pdf_infinite;
+	int parent = kernel_tex_fetch(__light_tree_nodes, index).parent;
+
+	while(parent >= 0) {
+		const ccl_global KernelLightTreeNode *kparent = &kernel_tex_fetch(__light_tree_nodes, parent);
+		const float pdf_left = light_tree_node_left_pdf(kg, parent, kparent->child, P);
+
+		pdf *= (index == parent + 1)? pdf_left: 1.0f - pdf_left;
+
+		index = parent;
+		parent = kparent->parent;
+	}
+
+	return pdf;
+}
+
+/* Light distribution index of an emissive triangle. Triangles are at the
+ * start of the distribution, sorted by object and then by primitive. */
+ccl_device int light_distribution_triangle_index(KernelGlobals *kg, int object, int prim)
+{
+	int first = 0;
+	int len = kernel_data.integrator.num_distribution - kernel_data.integrator.num_all_lights;
+
+	while(len > 0) {
+		int half_len = len >> 1;
+		int middle = first + half_len;
+		const ccl_global KernelLightDistribution *kdistribution = &kernel_tex_fetch(__light_distribution, middle);
+		const int middle_object = kdistribution->mesh_light.object_id;
+
+		if(middle_object < object || (middle_object == object && kdistribution->prim < prim)) {
+			first = middle + 1;
+			len = len - half_len - 1;
+		}
+		else {
+			len = half_len;
+		}
+	}
+
+	return first;
+}
+
+CCL_NAMESPACE_END
+
+#endif /* __KERNEL_LIGHT_TREE_H__ */
@@ -332,6 +332,25 @@ ccl_device_inline void kernel_write_light_passes(KernelGlobals *kg, ccl_global f
 #endif
 }
 
+#ifdef __ADAPTIVE_SAMPLING__
+/* Every other sample is also accumulated into the auxiliary buffer, at double
+ * weight so both buffers estimate the same sum. Their difference is the error
+ * estimate used for adaptive sampling. */
+ccl_device_inline void kernel_write_adaptive_buffer(KernelGlobals *kg,
+                                                    ccl_global float *buffer,
+                                                    float3 L_sum,
+                                                    int sample)
+{
+	if(kernel_data.film.pass_adaptive_aux_buffer && (sample & 1) == 0) {
+		/* Write components separately, the w component holds the convergence flag. */
+		ccl_global float *aux = buffer + kernel_data.film.pass_adaptive_aux_buffer;
+		kernel_write_pass_float(aux + 0, L_sum.x * 2.0f);
+		kernel_write_pass_float(aux + 1, L_sum.y * 2.0f);
+		kernel_write_pass_float(aux + 2, L_sum.z * 2.0f);
+	}
+}
+#endif  /* __ADAPTIVE_SAMPLING__ */
+
 ccl_device_inline void kernel_write_result(KernelGlobals *kg,
                                            ccl_global float *buffer,
                                            int sample,
@@ -342,6 +361,10 @@ ccl_device_inline void kernel_write_result(KernelGlobals *kg,
 
 	kernel_write_pass_float4(buffer, make_float4(L_sum.x, L_sum.y, L_sum.z, alpha));
 
+#ifdef __ADAPTIVE_SAMPLING__
+	kernel_write_adaptive_buffer(kg, buffer, L_sum, sample);
+#endif
+
 	kernel_write_light_passes(kg, buffer, L);
 
 #ifdef __DENOISING_FEATURES__
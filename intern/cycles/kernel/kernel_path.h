@@ -29,8 +29,10 @@
 
 #include "kernel/kernel_accumulate.h"
 #include "kernel/kernel_shader.h"
+#include "kernel/kernel_light_tree.h"
 #include "kernel/kernel_light.h"
 #include "kernel/kernel_passes.h"
+#include "kernel/kernel_adaptive_sampling.h"
 
 #if defined(__VOLUME__) || defined(__SUBSURFACE__)
 #  include "kernel/kernel_volume.h"
@@ -42,6 +44,7 @@
 
 #include "kernel/kernel_path_state.h"
 #include "kernel/kernel_shadow.h"
+#include "kernel/kernel_path_stream.h"
 #include "kernel/kernel_emission.h"
 #include "kernel/kernel_path_common.h"
 #include "kernel/kernel_path_surface.h"
@@ -566,7 +569,8 @@ ccl_device_forceinline void kernel_path_integrate(
 	Ray *ray,
 	PathRadiance *L,
 	ccl_global float *buffer,
-	ShaderData *emission_sd)
+	ShaderData *emission_sd,
+	const Intersection *isect_camera)
 {
 	/* Shader data memory used for both volumes and surfaces, saves stack space. */
 	ShaderData sd;
@@ -582,7 +586,23 @@ ccl_device_forceinline void kernel_path_integrate(
 	for(;;) {
 		/* Find intersection with objects in scene. */
 		Intersection isect;
-		bool hit = kernel_path_scene_intersect(kg, state, ray, &isect, L);
+		bool hit;
+
+		if(isect_camera != NULL) {
+			/* Camera ray traced in advance by a ray stream. */
+			isect = *isect_camera;
+			hit = (isect.prim != PRIM_NONE);
+			isect_camera = NULL;
+#ifdef __KERNEL_DEBUG__
+			L->debug_data.num_bvh_traversed_nodes += isect.num_traversed_nodes;
+			L->debug_data.num_bvh_traversed_instances += isect.num_traversed_instances;
+			L->debug_data.num_bvh_intersections += isect.num_intersections;
+			L->debug_data.num_ray_bounces++;
+#endif  /* __KERNEL_DEBUG__ */
+		}
+		else {
+			hit = kernel_path_scene_intersect(kg, state, ray, &isect, L);
+		}
 
 		/* Find intersection with lamps and compute emission for MIS. */
 		kernel_path_lamp_emission(kg, state, ray, throughput, &isect, &sd, L);
@@ -725,6 +745,12 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 
 	buffer += index*pass_stride;
 
+#ifdef __ADAPTIVE_SAMPLING__
+	if(kernel_adaptive_sample_skip(kg, buffer)) {
+		return;
+	}
+#endif
+
 	/* Initialize random numbers and sample ray. */
 	uint rng_hash;
 	Ray ray;
@@ -754,11 +780,107 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 	                      &ray,
 	                      &L,
 	                      buffer,
-	                      emission_sd);
+	                      emission_sd,
+	                      NULL);
 
 	kernel_write_result(kg, buffer, sample, &L);
 }
 
+#ifdef __RAY_STREAM__
+
+/* Path trace w pixels of row y as ray streams, see kernel_path_stream.h. */
+ccl_device void kernel_path_trace_stream(KernelGlobals *kg,
+	ccl_global float *buffer,
+	int sample, int x, int y, int w, int offset, int stride)
+{
+	PathStream *stream = path_stream_get(kg);
+	int pass_stride = kernel_data.film.pass_stride;
+
+	/* Camera rays with hair need the pixel footprint for the minimum width,
+	 * trace those one path at a time. */
+	const bool use_camera_stream = kernel_data.integrator.use_camera_ray_stream &&
+	                               scene_intersect_packet_use_qbvh(kg);
+	const bool use_shadow_stream = kernel_data.integrator.use_shadow_ray_stream;
+
+	ShaderDataTinyStorage emission_sd_storage;
+	ShaderData *emission_sd = AS_SHADER_DATA(&emission_sd_storage);
+
+	for(int stream_x = x; stream_x < x + w; stream_x += PATH_STREAM_SIZE) {
+		int stream_w = min(x + w - stream_x, PATH_STREAM_SIZE);
+		int paths[PATH_STREAM_SIZE];
+		int num_paths = 0;
+
+		/* Initialize random numbers, states and camera rays of all paths. */
+		for(int i = 0; i < stream_w; i++) {
+			int index = offset + stream_x + i + y*stride;
+			ccl_global float *path_buffer = buffer + index*pass_stride;
+
+#ifdef __ADAPTIVE_SAMPLING__
+			if(kernel_adaptive_sample_skip(kg, path_buffer)) {
+				continue;
+			}
+#endif
+
+			int p = num_paths;
+			uint rng_hash;
+			Ray *ray = &stream->ray[p];
+
+			kernel_path_trace_setup(kg, sample, stream_x + i, y, &rng_hash, ray);
+
+			if(ray->t == 0.0f) {
+				continue;
+			}
+
+			stream->buffer[p] = path_buffer;
+			path_radiance_init(&stream->L[p], kernel_data.film.use_light_pass);
+			path_state_init(kg, emission_sd, &stream->state[p], rng_hash, sample, ray);
+
+			paths[num_paths++] = p;
+		}
+
+		if(num_paths == 0) {
+			continue;
+		}
+
+		/* Trace camera rays in packets. */
+		if(use_camera_stream) {
+			path_stream_intersect(kg,
+			                      stream->ray,
+			                      stream->isect,
+			                      paths,
+			                      num_paths,
+			                      path_state_ray_visibility(kg, &stream->state[0]));
+		}
+
+		/* Integrate, queueing shadow rays. */
+		for(int p = 0; p < num_paths; p++) {
+			stream->queue_path = (use_shadow_stream)? p: -1;
+
+			kernel_path_integrate(kg,
+			                      &stream->state[p],
+			                      make_float3(1.0f, 1.0f, 1.0f),
+			                      &stream->ray[p],
+			                      &stream->L[p],
+			                      stream->buffer[p],
+			                      emission_sd,
+			                      (use_camera_stream)? &stream->isect[p]: NULL);
+		}
+
+		stream->queue_path = -1;
+
+		/* Trace remaining shadow rays before writing the results. */
+		if(stream->num_shadow_rays > 0) {
+			path_stream_trace_shadow(kg, stream);
+		}
+
+		for(int p = 0; p < num_paths; p++) {
+			kernel_write_result(kg, stream->buffer[p], sample, &stream->L[p]);
+		}
+	}
+}
+
+#endif  /* __RAY_STREAM__ */
+
 #endif  /* __SPLIT_KERNEL__ */
 
 CCL_NAMESPACE_END
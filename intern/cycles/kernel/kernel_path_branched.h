@@ -599,6 +599,12 @@ ccl_device void kernel_branched_path_trace(KernelGlobals *kg,
 
 	buffer += index*pass_stride;
 
+#ifdef __ADAPTIVE_SAMPLING__
+	if(kernel_adaptive_sample_skip(kg, buffer)) {
+		return;
+	}
+#endif
+
 	/* initialize random numbers and ray */
 	uint rng_hash;
 	Ray ray;
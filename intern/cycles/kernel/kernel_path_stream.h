@@ -0,0 +1,237 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+CCL_NAMESPACE_BEGIN
+
+#ifdef __RAY_STREAM__
+
+/* Ray Streams
+ *
+ * The CPU can path trace a row of pixels at once rather than one pixel at a
+ * time. Camera rays of all pixels are generated first, sorted by the octant of
+ * their direction and traced through the BVH in packets. The paths then
+ * continue one at a time, with their opaque shadow rays queued instead of
+ * traced. Queued shadow rays are sorted and traced in packets as well when
+ * the queue is full or all paths are done, and the light they carry is added
+ * to the radiance of their path afterwards. Shadow rays never change the path
+ * itself, so only the order in which light is accumulated changes.
+ */
+
+/* Number of paths traced together, and of shadow rays queued at once. */
+#define PATH_STREAM_SIZE 64
+#define PATH_STREAM_SHADOW_SIZE 256
+
+/* Light of a queued shadow ray, added to the path if the ray is not blocked. */
+typedef struct PathStreamShadowLight {
+	BsdfEval L_light;
+	float3 throughput;
+	int path;
+	/* State of the path when queueing, used for accumulating the light. */
+	int bounce;
+	int flag;
+	int is_lamp;
+} PathStreamShadowLight;
+
+typedef struct PathStream {
+	PathState state[PATH_STREAM_SIZE];
+	PathRadiance L[PATH_STREAM_SIZE];
+	Ray ray[PATH_STREAM_SIZE];
+	Intersection isect[PATH_STREAM_SIZE];
+	ccl_global float *buffer[PATH_STREAM_SIZE];
+
+	/* Path whose shadow rays are queued, -1 to trace them immediately. */
+	int queue_path;
+
+	Ray shadow_ray[PATH_STREAM_SHADOW_SIZE];
+	Intersection shadow_isect[PATH_STREAM_SHADOW_SIZE];
+	PathStreamShadowLight shadow_light[PATH_STREAM_SHADOW_SIZE];
+	int num_shadow_rays;
+} PathStream;
+
+/* The stream is allocated on first use and kept for the lifetime of the
+ * thread, freed by the device together with the kernel globals. */
+ccl_device_inline PathStream *path_stream_get(KernelGlobals *kg)
+{
+	if(kg->path_stream == NULL) {
+		kg->path_stream = (PathStream*)malloc(sizeof(PathStream));
+		kg->path_stream->queue_path = -1;
+		kg->path_stream->num_shadow_rays = 0;
+	}
+	return kg->path_stream;
+}
+
+ccl_device_inline int path_stream_ray_octant(const float3 D)
+{
+	return (D.x < 0.0f) | ((D.y < 0.0f) << 1) | ((D.z < 0.0f) << 2);
+}
+
+/* Traces rays[indices[i]] for all i and writes the result to the intersection
+ * with the same index. Rays are sorted by octant and traced in packets which
+ * don't mix octants, so the lanes of a packet have similar directions. */
+ccl_device void path_stream_intersect(KernelGlobals *kg,
+                                      const Ray *rays,
+                                      Intersection *isects,
+                                      const int *indices,
+                                      int num,
+                                      uint visibility)
+{
+	kernel_assert(num <= PATH_STREAM_SHADOW_SIZE);
+
+	int octant[PATH_STREAM_SHADOW_SIZE];
+	int sorted[PATH_STREAM_SHADOW_SIZE];
+	int octant_start[9] = {0};
+	int octant_end[8];
+
+	/* Counting sort by octant. */
+	for(int i = 0; i < num; i++) {
+		octant[i] = path_stream_ray_octant(rays[indices[i]].D);
+		octant_start[octant[i] + 1]++;
+	}
+	for(int o = 0; o < 8; o++) {
+		octant_start[o + 1] += octant_start[o];
+		octant_end[o] = octant_start[o];
+	}
+	for(int i = 0; i < num; i++) {
+		sorted[octant_end[octant[i]]++] = indices[i];
+	}
+
+	for(int o = 0; o < 8; o++) {
+		for(int start = octant_start[o]; start < octant_end[o]; start += QBVH_PACKET_SIZE) {
+			const int num_lanes = min(octant_end[o] - start, QBVH_PACKET_SIZE);
+			const Ray *packet_rays[QBVH_PACKET_SIZE];
+			Intersection packet_isects[QBVH_PACKET_SIZE];
+
+			for(int i = 0; i < QBVH_PACKET_SIZE; i++) {
+				packet_rays[i] = (i < num_lanes)? &rays[sorted[start + i]]: NULL;
+			}
+
+			const int hit_lanes = scene_intersect_packet(kg, packet_rays, visibility, packet_isects);
+
+			for(int i = 0; i < num_lanes; i++) {
+				Intersection *isect = &isects[sorted[start + i]];
+				*isect = packet_isects[i];
+				if(!(hit_lanes & (1 << i))) {
+					isect->prim = PRIM_NONE;
+				}
+			}
+		}
+	}
+}
+
+/* Traces all queued shadow rays and adds the light of unblocked ones to
+ * their path. */
+ccl_device void path_stream_trace_shadow(KernelGlobals *kg, PathStream *stream)
+{
+	const int num = stream->num_shadow_rays;
+	int indices[PATH_STREAM_SHADOW_SIZE];
+
+	for(int i = 0; i < num; i++) {
+		indices[i] = i;
+	}
+
+	path_stream_intersect(kg,
+	                      stream->shadow_ray,
+	                      stream->shadow_isect,
+	                      indices,
+	                      num,
+	                      PATH_RAY_SHADOW_OPAQUE);
+
+	/* Accumulating only needs the bounce and flags of the path. */
+	PathState state;
+
+	for(int i = 0; i < num; i++) {
+		PathStreamShadowLight *light = &stream->shadow_light[i];
+		PathRadiance *L = &stream->L[light->path];
+
+		state.bounce = light->bounce;
+		state.flag = light->flag;
+
+		if(stream->shadow_isect[i].prim == PRIM_NONE) {
+			path_radiance_accum_light(L,
+			                          &state,
+			                          light->throughput,
+			                          &light->L_light,
+			                          make_float3(1.0f, 1.0f, 1.0f),
+			                          1.0f,
+			                          light->is_lamp);
+		}
+		else {
+			path_radiance_accum_total_light(L, &state, light->throughput, &light->L_light);
+		}
+	}
+
+	stream->num_shadow_rays = 0;
+}
+
+/* Queues the shadow ray of the path being traced by the stream, returns false
+ * if it has to be traced immediately. Shadows which need shading, like
+ * transparent shadows and volumes, are not queued. */
+ccl_device_inline bool path_stream_queue_shadow(KernelGlobals *kg,
+                                                ccl_addr_space PathState *state,
+                                                Ray *ray,
+                                                BsdfEval *L_light,
+                                                float3 throughput,
+                                                bool is_lamp)
+{
+	PathStream *stream = kg->path_stream;
+
+	if(stream == NULL || stream->queue_path == -1 || ray->t == 0.0f) {
+		return false;
+	}
+#ifdef __TRANSPARENT_SHADOWS__
+	if(kernel_data.integrator.transparent_shadows) {
+		return false;
+	}
+#endif
+#ifdef __VOLUME__
+	if(state->volume_stack[0].shader != SHADER_NONE) {
+		return false;
+	}
+#endif
+#ifdef __SHADOW_TRICKS__
+	if(state->flag & PATH_RAY_SHADOW_CATCHER) {
+		return false;
+	}
+#endif
+#ifdef __PASSES__
+	/* Indirect light passes are weighted by the BSDF of the first bounce,
+	 * which changes for indirect subsurface rays. */
+	if(stream->L[stream->queue_path].use_light_pass && state->bounce > 0) {
+		return false;
+	}
+#endif
+
+	if(stream->num_shadow_rays == PATH_STREAM_SHADOW_SIZE) {
+		path_stream_trace_shadow(kg, stream);
+	}
+
+	const int i = stream->num_shadow_rays++;
+	PathStreamShadowLight *light = &stream->shadow_light[i];
+
+	stream->shadow_ray[i] = *ray;
+	light->L_light = *L_light;
+	light->throughput = throughput;
+	light->path = stream->queue_path;
+	light->bounce = state->bounce;
+	light->flag = state->flag;
+	light->is_lamp = is_lamp;
+
+	return true;
+}
+
+#endif  /* __RAY_STREAM__ */
+
+CCL_NAMESPACE_END
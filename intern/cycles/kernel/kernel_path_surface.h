@@ -251,6 +251,13 @@ ccl_device_inline void kernel_path_surface_connect_light(KernelGlobals *kg,
 	if(light_sample(kg, light_u, light_v, sd->time, sd->P, state->bounce, &ls)) {
 		float terminate = path_state_rng_light_termination(kg, state);
 		if(direct_emission(kg, sd, emission_sd, &ls, state, &light_ray, &L_light, &is_lamp, terminate)) {
+#ifdef __RAY_STREAM__
+			/* queue shadow ray to trace it together with others */
+			if(path_stream_queue_shadow(kg, state, &light_ray, &L_light, throughput, is_lamp)) {
+				return;
+			}
+#endif
+
 			/* trace shadow ray */
 			float3 shadow;
 
@@ -81,6 +81,12 @@ CCL_NAMESPACE_BEGIN
 #ifdef __KERNEL_CPU__
 #  ifdef __KERNEL_SSE2__
 #    define __QBVH__
+#    ifndef __SPLIT_KERNEL__
+#      define __RAY_STREAM__
+#    endif
+#  endif
+#  ifdef __KERNEL_AVX2__
+#    define __OBVH__
 #  endif
 #  define __KERNEL_SHADING__
 #  define __KERNEL_ADV_SHADING__
@@ -96,6 +102,7 @@ CCL_NAMESPACE_BEGIN
 #  define __SHADOW_RECORD_ALL__
 #  define __VOLUME_DECOUPLED__
 #  define __VOLUME_RECORD_ALL__
+#  define __ADAPTIVE_SAMPLING__
 #endif  /* __KERNEL_CPU__ */
 
 #ifdef __KERNEL_CUDA__
@@ -415,6 +422,8 @@ typedef enum PassType {
 	PASS_RAY_BOUNCES,
 #endif
 	PASS_RENDER_TIME,
+	PASS_SAMPLE_COUNT,
+	PASS_ADAPTIVE_AUX_BUFFER,
 	PASS_CATEGORY_MAIN_END = 31,
 
 	PASS_MIST = 32,
@@ -769,6 +778,7 @@ typedef enum AttributeElement {
 	ATTR_ELEMENT_VERTEX_MOTION,
 	ATTR_ELEMENT_CORNER,
 	ATTR_ELEMENT_CORNER_BYTE,
+	ATTR_ELEMENT_CORNER_HALF,
 	ATTR_ELEMENT_CURVE,
 	ATTR_ELEMENT_CURVE_KEY,
 	ATTR_ELEMENT_CURVE_KEY_MOTION,
@@ -1273,7 +1283,9 @@ typedef struct KernelFilm {
 	int pass_denoising_clean;
 	int denoising_flags;
 
-	int pad1, pad2, pad3;
+	int pass_sample_count;
+	int pass_adaptive_aux_buffer;
+	int pad1;
 
 #ifdef __KERNEL_DEBUG__
 	int pass_bvh_traversed_nodes;
@@ -1369,6 +1381,20 @@ typedef struct KernelIntegrator {
 	int start_sample;
 
 	int max_closures;
+
+	/* adaptive sampling */
+	int adaptive_min_samples;
+	float adaptive_threshold;
+
+	/* light tree */
+	int use_light_tree;
+	int light_tree_num_nodes;
+	int light_tree_num_infinite;
+	float light_tree_pdf_infinite;
+
+	/* ray streams */
+	int use_camera_ray_stream;
+	int use_shadow_ray_stream;
 } KernelIntegrator;
 static_assert_align(KernelIntegrator, 16);
 
@@ -1377,7 +1403,10 @@ typedef enum KernelBVHLayout {
 
 	BVH_LAYOUT_BVH2 = (1 << 0),
 	BVH_LAYOUT_BVH4 = (1 << 1),
+	BVH_LAYOUT_BVH8 = (1 << 2),
 
+	/* BVH8 traverses triangles faster, but hair slower since unaligned nodes
+	 * transform the ray for all eight children, so it is not the default. */
 	BVH_LAYOUT_DEFAULT = BVH_LAYOUT_BVH4,
 	BVH_LAYOUT_ALL = (unsigned int)(-1),
 } KernelBVHLayout;
@@ -1390,7 +1419,9 @@ typedef struct KernelBVH {
 	int have_instancing;
 	int bvh_layout;
 	int use_bvh_steps;
-	int pad1, pad2;
+	/* vertex normals are octahedral encoded */
+	int use_compact_geometry;
+	int pad1;
 } KernelBVH;
 static_assert_align(KernelBVH, 16);
 
@@ -1512,6 +1543,23 @@ typedef struct KernelLightDistribution {
 } KernelLightDistribution;
 static_assert_align(KernelLightDistribution, 16);
 
+/* Light tree node, see render/light_tree.h. The first child of an inner node
+ * directly follows it. */
+typedef struct KernelLightTreeNode {
+	float bounds_min[3];
+	float energy;
+	float bounds_max[3];
+	/* Second child for inner nodes, ~index into the light distribution for leaves. */
+	int child;
+	float axis[3];
+	int parent;
+	float theta_o;
+	float theta_e;
+	int two_sided;
+	int pad;
+} KernelLightTreeNode;
+static_assert_align(KernelLightTreeNode, 16);
+
 typedef struct KernelParticle {
 	int index;
 	float age;
@@ -17,6 +17,8 @@
 #ifndef __KERNEL_CPU_IMAGE_H__
 #define __KERNEL_CPU_IMAGE_H__
 
+#include "util/util_texture_cache.h"
+
 CCL_NAMESPACE_BEGIN
 
 template<typename T> struct TextureInterpolator  {
@@ -474,6 +476,10 @@ template<typename T> struct TextureInterpolator  {
 
 ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, float y)
 {
+	if(kg->texture_cache != NULL && kg->texture_cache->has_image(id)) {
+		return kg->texture_cache->lookup(id, x, y, make_float2(0.0f, 0.0f), make_float2(0.0f, 0.0f));
+	}
+
 	const TextureInfo& info = kernel_tex_fetch(__texture_info, id);
 
 	switch(kernel_tex_type(id)) {
@@ -493,6 +499,18 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, fl
 	}
 }
 
+/* Lookup with the derivatives of the texture coordinate, which select the
+ * mipmap level for images in the texture cache. Images loaded into memory
+ * have no mipmaps and ignore them. */
+ccl_device float4 kernel_tex_image_interp_deriv(KernelGlobals *kg, int id, float x, float y, float2 dx, float2 dy)
+{
+	if(kg->texture_cache != NULL && kg->texture_cache->has_image(id)) {
+		return kg->texture_cache->lookup(id, x, y, dx, dy);
+	}
+
+	return kernel_tex_image_interp(kg, id, x, y);
+}
+
 ccl_device float4 kernel_tex_image_interp_3d(KernelGlobals *kg, int id, float x, float y, float z, InterpolationType interp)
 {
 	const TextureInfo& info = kernel_tex_fetch(__texture_info, id);
@@ -99,6 +99,94 @@ void KERNEL_FUNCTION_FULL_NAME(path_trace)(KernelGlobals *kg,
 #endif /* KERNEL_STUB */
 }
 
+void KERNEL_FUNCTION_FULL_NAME(path_trace_stream)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int sample,
+                                                  int x, int y, int w,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, path_trace_stream);
+#else
+#  ifdef __BRANCHED_PATH__
+	if(kernel_data.integrator.branched) {
+		for(int i = x; i < x + w; i++) {
+			kernel_branched_path_trace(kg, buffer, sample, i, y, offset, stride);
+		}
+	}
+	else
+#  endif
+	{
+#  ifdef __RAY_STREAM__
+		kernel_path_trace_stream(kg, buffer, sample, x, y, w, offset, stride);
+#  else
+		for(int i = x; i < x + w; i++) {
+			kernel_path_trace(kg, buffer, sample, i, y, offset, stride);
+		}
+#  endif
+	}
+#endif /* KERNEL_STUB */
+}
+
+/* Adaptive Sampling */
+
+void KERNEL_FUNCTION_FULL_NAME(adaptive_stopping)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int x, int y,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_stopping);
+#else
+	kernel_adaptive_stopping(kg, buffer, x, y, offset, stride);
+#endif /* KERNEL_STUB */
+}
+
+bool KERNEL_FUNCTION_FULL_NAME(adaptive_filter_x)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int y, int tile_x, int tile_w,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_filter_x);
+	return false;
+#else
+	return kernel_adaptive_filter_x(kg, buffer, y, tile_x, tile_w, offset, stride);
+#endif /* KERNEL_STUB */
+}
+
+bool KERNEL_FUNCTION_FULL_NAME(adaptive_filter_y)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int x, int tile_y, int tile_h,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_filter_y);
+	return false;
+#else
+	return kernel_adaptive_filter_y(kg, buffer, x, tile_y, tile_h, offset, stride);
+#endif /* KERNEL_STUB */
+}
+
+void KERNEL_FUNCTION_FULL_NAME(adaptive_adjust_samples)(KernelGlobals *kg,
+                                                        float *buffer,
+                                                        int x, int y,
+                                                        int offset,
+                                                        int stride,
+                                                        float num_samples,
+                                                        int sample)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_adjust_samples);
+#else
+	kernel_adaptive_adjust_samples(kg, buffer, x, y, offset, stride, num_samples, sample);
+#endif /* KERNEL_STUB */
+}
+
 /* Film */
 
 void KERNEL_FUNCTION_FULL_NAME(convert_to_byte)(KernelGlobals *kg,
@@ -16,9 +16,14 @@
 
 CCL_NAMESPACE_BEGIN
 
-ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, uint srgb, uint use_alpha)
+ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, float2 dx, float2 dy, uint srgb, uint use_alpha)
 {
+#ifdef __KERNEL_CPU__
+	/* Derivatives are only used by the texture cache. */
+	float4 r = kernel_tex_image_interp_deriv(kg, id, x, y, dx, dy);
+#else
 	float4 r = kernel_tex_image_interp(kg, id, x, y);
+#endif
 	const float alpha = r.w;
 
 	if(use_alpha && alpha != 1.0f && alpha != 0.0f) {
@@ -45,28 +50,53 @@ ccl_device_inline float3 texco_remap_square(float3 co)
 	return (co - make_float3(0.5f, 0.5f, 0.5f)) * 2.0f;
 }
 
-ccl_device void svm_node_tex_image(KernelGlobals *kg, ShaderData *sd, float *stack, uint4 node)
+ccl_device_inline float2 svm_image_projection(float3 co, uint projection)
+{
+	if(projection == NODE_IMAGE_PROJ_SPHERE) {
+		return map_to_sphere(texco_remap_square(co));
+	}
+	else if(projection == NODE_IMAGE_PROJ_TUBE) {
+		return map_to_tube(texco_remap_square(co));
+	}
+	else {
+		return make_float2(co.x, co.y);
+	}
+}
+
+/* Difference of the projected texture coordinate to the one of a neighboring
+ * shading point, sphere and tube projections wrap around horizontally. */
+ccl_device_inline float2 svm_image_projection_delta(float3 co, float2 tex_co, uint projection)
+{
+	float2 delta = svm_image_projection(co, projection) - tex_co;
+
+	if(projection == NODE_IMAGE_PROJ_SPHERE || projection == NODE_IMAGE_PROJ_TUBE) {
+		delta.x -= floorf(delta.x + 0.5f);
+	}
+
+	return delta;
+}
+
+ccl_device void svm_node_tex_image(KernelGlobals *kg, ShaderData *sd, float *stack, uint4 node, int *offset)
 {
 	uint id = node.y;
 	uint co_offset, out_offset, alpha_offset, srgb;
+	uint4 node2 = read_node(kg, offset);
 
 	decode_node_uchar4(node.z, &co_offset, &out_offset, &alpha_offset, &srgb);
 
 	float3 co = stack_load_float3(stack, co_offset);
-	float2 tex_co;
+	float2 tex_co = svm_image_projection(co, node.w);
 	uint use_alpha = stack_valid(alpha_offset);
-	if(node.w == NODE_IMAGE_PROJ_SPHERE) {
-		co = texco_remap_square(co);
-		tex_co = map_to_sphere(co);
-	}
-	else if(node.w == NODE_IMAGE_PROJ_TUBE) {
-		co = texco_remap_square(co);
-		tex_co = map_to_tube(co);
-	}
-	else {
-		tex_co = make_float2(co.x, co.y);
+
+	/* Texture coordinates evaluated at the ray differential offsets. */
+	float2 dx = make_float2(0.0f, 0.0f);
+	float2 dy = make_float2(0.0f, 0.0f);
+	if(stack_valid(node2.x)) {
+		dx = svm_image_projection_delta(stack_load_float3(stack, node2.x), tex_co, node.w);
+		dy = svm_image_projection_delta(stack_load_float3(stack, node2.y), tex_co, node.w);
 	}
-	float4 f = svm_image_texture(kg, id, tex_co.x, tex_co.y, srgb, use_alpha);
+
+	float4 f = svm_image_texture(kg, id, tex_co.x, tex_co.y, dx, dy, srgb, use_alpha);
 
 	if(stack_valid(out_offset))
 		stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -74,8 +104,10 @@ ccl_device void svm_node_tex_image(KernelGlobals *kg, ShaderData *sd, float *sta
 		stack_store_float(stack, alpha_offset, f.w);
 }
 
-ccl_device void svm_node_tex_image_box(KernelGlobals *kg, ShaderData *sd, float *stack, uint4 node)
+ccl_device void svm_node_tex_image_box(KernelGlobals *kg, ShaderData *sd, float *stack, uint4 node, int *offset)
 {
+	uint4 node2 = read_node(kg, offset);
+
 	/* get object space normal */
 	float3 N = sd->N;
 
@@ -154,18 +186,33 @@ ccl_device void svm_node_tex_image_box(KernelGlobals *kg, ShaderData *sd, float
 	float4 f = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
 	uint use_alpha = stack_valid(alpha_offset);
 
+	/* Texture coordinates evaluated at the ray differential offsets, the sign
+	 * of the derivatives doesn't matter when the projection is flipped. */
+	float3 dco_dx = make_float3(0.0f, 0.0f, 0.0f);
+	float3 dco_dy = make_float3(0.0f, 0.0f, 0.0f);
+	if(stack_valid(node2.x)) {
+		dco_dx = stack_load_float3(stack, node2.x) - co;
+		dco_dy = stack_load_float3(stack, node2.y) - co;
+	}
+
 	/* Map so that no textures are flipped, rotation is somewhat arbitrary. */
 	if(weight.x > 0.0f) {
 		float2 uv = make_float2((signed_N.x < 0.0f)? 1.0f - co.y: co.y, co.z);
-		f += weight.x*svm_image_texture(kg, id, uv.x, uv.y, srgb, use_alpha);
+		float2 dx = make_float2(dco_dx.y, dco_dx.z);
+		float2 dy = make_float2(dco_dy.y, dco_dy.z);
+		f += weight.x*svm_image_texture(kg, id, uv.x, uv.y, dx, dy, srgb, use_alpha);
 	}
 	if(weight.y > 0.0f) {
 		float2 uv = make_float2((signed_N.y > 0.0f)? 1.0f - co.x: co.x, co.z);
-		f += weight.y*svm_image_texture(kg, id, uv.x, uv.y, srgb, use_alpha);
+		float2 dx = make_float2(dco_dx.x, dco_dx.z);
+		float2 dy = make_float2(dco_dy.x, dco_dy.z);
+		f += weight.y*svm_image_texture(kg, id, uv.x, uv.y, dx, dy, srgb, use_alpha);
 	}
 	if(weight.z > 0.0f) {
 		float2 uv = make_float2((signed_N.z > 0.0f)? 1.0f - co.y: co.y, co.x);
-		f += weight.z*svm_image_texture(kg, id, uv.x, uv.y, srgb, use_alpha);
+		float2 dx = make_float2(dco_dx.y, dco_dx.x);
+		float2 dy = make_float2(dco_dy.y, dco_dy.x);
+		f += weight.z*svm_image_texture(kg, id, uv.x, uv.y, dx, dy, srgb, use_alpha);
 	}
 
 	if(stack_valid(out_offset))
@@ -193,7 +240,7 @@ ccl_device void svm_node_tex_environment(KernelGlobals *kg, ShaderData *sd, floa
 		uv = direction_to_mirrorball(co);
 
 	uint use_alpha = stack_valid(alpha_offset);
-	float4 f = svm_image_texture(kg, id, uv.x, uv.y, srgb, use_alpha);
+	float4 f = svm_image_texture(kg, id, uv.x, uv.y, make_float2(0.0f, 0.0f), make_float2(0.0f, 0.0f), srgb, use_alpha);
 
 	if(stack_valid(out_offset))
 		stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -16,6 +16,7 @@
 
 #include "render/attribute.h"
 #include "render/graph.h"
+#include "render/image.h"
 #include "render/nodes.h"
 #include "render/scene.h"
 #include "render/shader.h"
@@ -325,6 +326,9 @@ void ShaderGraph::finalize(Scene *scene,
 		if(do_bump)
 			bump_from_displacement(bump_in_object_space);
 
+		if(scene->image_manager->has_texture_cache())
+			image_differentials();
+
 		ShaderInput *surface_in = output()->input("Surface");
 		ShaderInput *volume_in = output()->input("Volume");
 
@@ -869,6 +873,54 @@ void ShaderGraph::refine_bump_nodes()
 	}
 }
 
+void ShaderGraph::image_differentials()
+{
+	/* image textures read from the texture cache choose the mipmap level from
+	 * the derivatives of the texture coordinate. like for bump mapping, we make
+	 * 2 extra copies of the subgraph defining the texture coordinate, shifted
+	 * by the ray differentials, and connect them to the "Vector dX" and
+	 * "Vector dY" inputs of the image texture node. */
+
+	vector<ShaderNode*> image_nodes;
+
+	/* nodes which are already copies for bump mapping are skipped, they
+	 * would only multiply the size of the graph */
+	foreach(ShaderNode *node, nodes) {
+		if(node->type == ImageTextureNode::node_type &&
+		   node->bump == SHADER_BUMP_NONE &&
+		   node->input("Vector")->link)
+		{
+			image_nodes.push_back(node);
+		}
+	}
+
+	foreach(ShaderNode *node, image_nodes) {
+		ShaderInput *vector_input = node->input("Vector");
+		ShaderNodeSet nodes_vector;
+		ShaderNodeMap nodes_dx;
+		ShaderNodeMap nodes_dy;
+
+		find_dependencies(nodes_vector, vector_input);
+
+		copy_nodes(nodes_vector, nodes_dx);
+		copy_nodes(nodes_vector, nodes_dy);
+
+		foreach(NodePair& pair, nodes_dx)
+			pair.second->bump = SHADER_BUMP_DX;
+		foreach(NodePair& pair, nodes_dy)
+			pair.second->bump = SHADER_BUMP_DY;
+
+		ShaderOutput *out = vector_input->link;
+		connect(nodes_dx[out->parent]->output(out->name()), node->input("Vector dX"));
+		connect(nodes_dy[out->parent]->output(out->name()), node->input("Vector dY"));
+
+		foreach(NodePair& pair, nodes_dx)
+			add(pair.second);
+		foreach(NodePair& pair, nodes_dy)
+			add(pair.second);
+	}
+}
+
 void ShaderGraph::bump_from_displacement(bool use_object_space)
 {
 	/* generate bump mapping automatically from displacement. bump mapping is
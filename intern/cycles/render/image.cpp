@@ -23,6 +23,7 @@
 #include "util/util_path.h"
 #include "util/util_progress.h"
 #include "util/util_texture.h"
+#include "util/util_texture_cache.h"
 
 #ifdef WITH_OSL
 #include <OSL/oslexec.h>
@@ -44,6 +45,7 @@ ImageManager::ImageManager(const DeviceInfo& info)
 {
 	need_update = true;
 	osl_texture_system = NULL;
+	texture_cache = NULL;
 	animation_frame = 0;
 
 	/* Set image limits */
@@ -61,6 +63,8 @@ ImageManager::~ImageManager()
 		for(size_t slot = 0; slot < images[type].size(); slot++)
 			assert(!images[type][slot]);
 	}
+
+	delete texture_cache;
 }
 
 void ImageManager::set_osl_texture_system(void *texture_system)
@@ -68,6 +72,16 @@ void ImageManager::set_osl_texture_system(void *texture_system)
 	osl_texture_system = texture_system;
 }
 
+void ImageManager::set_texture_cache(int max_memory_mb, const string& tx_path)
+{
+	delete texture_cache;
+	texture_cache = new TextureCache(max_memory_mb, tx_path);
+
+	VLOG(1) << "Using texture cache of " << max_memory_mb << " MB.";
+
+	need_update = true;
+}
+
 bool ImageManager::set_animation_frame_update(int frame)
 {
 	if(frame != animation_frame) {
@@ -712,6 +726,22 @@ void ImageManager::device_load_image(Device *device,
 		img->mem = NULL;
 	}
 
+	/* Read tiles on demand from the texture cache, images it can't handle
+	 * are loaded into memory as usual. */
+	if(texture_cache && !img->builtin_data) {
+		if(texture_cache->add_image(flat_slot,
+		                            img->filename,
+		                            img->interpolation,
+		                            img->extension,
+		                            img->use_alpha))
+		{
+			img->need_load = false;
+			return;
+		}
+
+		texture_cache->remove_image(flat_slot);
+	}
+
 	/* Create new texture. */
 	if(type == IMAGE_DATA_TYPE_FLOAT4) {
 		device_vector<float4> *tex_img
@@ -873,6 +903,10 @@ void ImageManager::device_free_image(Device *, ImageDataType type, int slot)
 #endif
 		}
 
+		if(texture_cache) {
+			texture_cache->remove_image(type_index_to_flattened_slot(slot, type));
+		}
+
 		if(img->mem) {
 			thread_scoped_lock device_lock(device_mutex);
 			delete img->mem;
@@ -888,6 +922,10 @@ void ImageManager::device_update(Device *device,
                                  Scene *scene,
                                  Progress& progress)
 {
+	if(texture_cache) {
+		device->set_texture_cache(texture_cache);
+	}
+
 	if(!need_update) {
 		return;
 	}
@@ -955,6 +993,11 @@ void ImageManager::device_free_builtin(Device *device)
 
 void ImageManager::device_free(Device *device)
 {
+	if(texture_cache) {
+		VLOG(1) << texture_cache->get_stats().full_report();
+		device->set_texture_cache(NULL);
+	}
+
 	for(int type = 0; type < IMAGE_DATA_NUM_TYPES; type++) {
 		for(size_t slot = 0; slot < images[type].size(); slot++) {
 			device_free_image(device, (ImageDataType)type, slot);
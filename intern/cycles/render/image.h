@@ -30,6 +30,7 @@ CCL_NAMESPACE_BEGIN
 class Device;
 class Progress;
 class Scene;
+class TextureCache;
 
 class ImageMetaData {
 public:
@@ -85,6 +86,11 @@ public:
 	void set_osl_texture_system(void *texture_system);
 	bool set_animation_frame_update(int frame);
 
+	/* Read image files on demand through a texture cache of the given size
+	 * in megabytes, instead of loading them fully. CPU and SVM only. */
+	void set_texture_cache(int max_memory_mb, const string& tx_path);
+	bool has_texture_cache() const { return texture_cache != NULL; }
+
 	device_memory *image_memory(int flat_slot);
 
 	bool need_update;
@@ -135,6 +141,7 @@ private:
 
 	vector<Image*> images[IMAGE_DATA_NUM_TYPES];
 	void *osl_texture_system;
+	TextureCache *texture_cache;
 
 	bool file_load_image_generic(Image *img,
 	                             ImageInput **in,
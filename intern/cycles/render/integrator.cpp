@@ -67,6 +67,14 @@ NODE_DEFINE(Integrator)
 	SOCKET_BOOLEAN(sample_all_lights_direct, "Sample All Lights Direct", true);
 	SOCKET_BOOLEAN(sample_all_lights_indirect, "Sample All Lights Indirect", true);
 	SOCKET_FLOAT(light_sampling_threshold, "Light Sampling Threshold", 0.05f);
+	SOCKET_BOOLEAN(use_light_tree, "Use Light Tree", false);
+
+	SOCKET_BOOLEAN(use_camera_ray_stream, "Use Camera Ray Stream", false);
+	SOCKET_BOOLEAN(use_shadow_ray_stream, "Use Shadow Ray Stream", false);
+
+	SOCKET_BOOLEAN(use_adaptive_sampling, "Use Adaptive Sampling", false);
+	SOCKET_FLOAT(adaptive_threshold, "Adaptive Threshold", 0.01f);
+	SOCKET_INT(adaptive_min_samples, "Adaptive Min Samples", 16);
 
 	static NodeEnum method_enum;
 	method_enum.insert("path", PATH);
@@ -175,6 +183,14 @@ void Integrator::device_update(Device *device, DeviceScene *dscene, Scene *scene
 		kintegrator->light_inv_rr_threshold = 0.0f;
 	}
 
+	/* Stopping only happens when the film has the adaptive sampling passes. */
+	kintegrator->adaptive_threshold = use_adaptive_sampling? adaptive_threshold: 0.0f;
+	kintegrator->adaptive_min_samples = max(adaptive_min_samples, 4);
+
+	/* Ray streams are only traced by the CPU kernel, with path tracing. */
+	kintegrator->use_camera_ray_stream = (method == PATH) && use_camera_ray_stream;
+	kintegrator->use_shadow_ray_stream = (method == PATH) && use_shadow_ray_stream;
+
 	/* sobol directions table */
 	int max_samples = 1;
 
@@ -232,8 +248,19 @@ void Integrator::tag_update(Scene *scene)
 			break;
 		}
 	}
+	if(use_light_tree_sampling() != scene->light_manager->use_light_tree) {
+		scene->light_manager->tag_update(scene);
+	}
 	need_update = true;
 }
 
+bool Integrator::use_light_tree_sampling() const
+{
+	if(method == BRANCHED_PATH && (sample_all_lights_direct || sample_all_lights_indirect)) {
+		return false;
+	}
+	return use_light_tree;
+}
+
 CCL_NAMESPACE_END
 
@@ -68,6 +68,14 @@ public:
 	bool sample_all_lights_direct;
 	bool sample_all_lights_indirect;
 	float light_sampling_threshold;
+	bool use_light_tree;
+
+	bool use_camera_ray_stream;
+	bool use_shadow_ray_stream;
+
+	bool use_adaptive_sampling;
+	float adaptive_threshold;
+	int adaptive_min_samples;
 
 	enum Method {
 		BRANCHED_PATH = 0,
@@ -90,6 +98,10 @@ public:
 
 	bool modified(const Integrator& integrator);
 	void tag_update(Scene *scene);
+
+	/* The light tree picks a single light per sample, sampling all lights
+	 * with branched path tracing uses the flat light distribution. */
+	bool use_light_tree_sampling() const;
 };
 
 CCL_NAMESPACE_END
@@ -19,6 +19,7 @@
 #include "render/integrator.h"
 #include "render/film.h"
 #include "render/light.h"
+#include "render/light_tree.h"
 #include "render/mesh.h"
 #include "render/object.h"
 #include "render/scene.h"
@@ -171,6 +172,7 @@ LightManager::LightManager()
 {
 	need_update = true;
 	use_light_visibility = false;
+	use_light_tree = false;
 }
 
 LightManager::~LightManager()
@@ -242,6 +244,54 @@ bool LightManager::object_usable_as_light(Object *object) {
 	return false;
 }
 
+/* Strength of constant emission shaders, other shaders are assumed to have
+ * unit strength for the light tree. */
+static float light_tree_shader_strength(Shader *shader)
+{
+	float3 emission;
+	if(shader->is_constant_emission(&emission)) {
+		return average(fabs(emission));
+	}
+	return 1.0f;
+}
+
+/* Bounds and estimated power of lamps with a position. The power follows
+ * from the emission of each lamp type in the kernel. */
+static LightTreePrimitive light_tree_lamp_primitive(Scene *scene, Light *light, int distribution_index)
+{
+	Shader *shader = (light->shader)? light->shader: scene->default_light;
+	const float strength = light_tree_shader_strength(shader);
+	const float3 dir = safe_normalize(light->dir);
+
+	LightTreePrimitive prim;
+	prim.bounds = BoundBox::empty;
+	prim.distribution_index = distribution_index;
+
+	if(light->type == LIGHT_AREA) {
+		const float3 axisu = light->axisu*(light->sizeu*light->size);
+		const float3 axisv = light->axisv*(light->sizev*light->size);
+
+		prim.bounds.grow(light->co - 0.5f*axisu - 0.5f*axisv);
+		prim.bounds.grow(light->co + 0.5f*axisu - 0.5f*axisv);
+		prim.bounds.grow(light->co - 0.5f*axisu + 0.5f*axisv);
+		prim.bounds.grow(light->co + 0.5f*axisu + 0.5f*axisv);
+		prim.cone = LightTreeCone(dir, 0.0f, M_PI_2_F, false);
+		prim.energy = M_PI_F*0.25f*strength;
+	}
+	else if(light->type == LIGHT_SPOT) {
+		prim.bounds.grow(light->co, light->size);
+		prim.cone = LightTreeCone(dir, 0.0f, min(light->spot_angle*0.5f, M_PI_2_F), false);
+		prim.energy = strength;
+	}
+	else {
+		prim.bounds.grow(light->co, light->size);
+		prim.cone = LightTreeCone(make_float3(0.0f, 0.0f, 1.0f), M_PI_F, M_PI_2_F, false);
+		prim.energy = strength;
+	}
+
+	return prim;
+}
+
 void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Scene *scene, Progress& progress)
 {
 	progress.set_status("Updating Lights", "Computing distribution");
@@ -254,6 +304,8 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 
 	bool background_mis = false;
 
+	use_light_tree = scene->integrator->use_light_tree_sampling();
+
 	foreach(Light *light, scene->lights) {
 		if(light->is_enabled) {
 			num_lights++;
@@ -291,6 +343,10 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 	KernelLightDistribution *distribution = dscene->light_distribution.alloc(num_distribution + 1);
 	float totarea = 0.0f;
 
+	/* light tree primitives, and lights which are not in the tree */
+	vector<LightTreePrimitive> tree_prims;
+	vector<int> tree_infinite;
+
 	/* triangles */
 	size_t offset = 0;
 	int j = 0;
@@ -326,6 +382,13 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 			use_light_visibility = true;
 		}
 
+		vector<float> shader_strength;
+		if(use_light_tree) {
+			foreach(Shader *shader, mesh->used_shaders) {
+				shader_strength.push_back(light_tree_shader_strength(shader));
+			}
+		}
+
 		size_t mesh_num_triangles = mesh->num_triangles();
 		for(size_t i = 0; i < mesh_num_triangles; i++) {
 			int shader_index = mesh->shader[i];
@@ -354,7 +417,24 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 					p3 = transform_point(&tfm, p3);
 				}
 
-				totarea += triangle_area(p1, p2, p3);
+				const float area = triangle_area(p1, p2, p3);
+				totarea += area;
+
+				if(use_light_tree) {
+					/* Emission is two sided, with a radiance of the strength. */
+					const float strength = ((size_t)shader_index < shader_strength.size())
+					                               ? shader_strength[shader_index]
+					                               : light_tree_shader_strength(scene->default_surface);
+					LightTreePrimitive prim;
+					prim.bounds = BoundBox::empty;
+					prim.bounds.grow(p1);
+					prim.bounds.grow(p2);
+					prim.bounds.grow(p3);
+					prim.cone = LightTreeCone(safe_normalize(cross(p2 - p1, p3 - p1)), 0.0f, M_PI_2_F, true);
+					prim.energy = M_2PI_F*area*strength;
+					prim.distribution_index = offset - 1;
+					tree_prims.push_back(prim);
+				}
 			}
 		}
 
@@ -378,6 +458,15 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 		distribution[offset].lamp.size = light->size;
 		totarea += lightarea;
 
+		if(use_light_tree) {
+			if(light->type == LIGHT_DISTANT || light->type == LIGHT_BACKGROUND) {
+				tree_infinite.push_back(offset);
+			}
+			else {
+				tree_prims.push_back(light_tree_lamp_primitive(scene, light, offset));
+			}
+		}
+
 		if(light->size > 0.0f && light->use_mis)
 			use_lamp_mis = true;
 		if(light->type == LIGHT_BACKGROUND) {
@@ -446,6 +535,54 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 		/* CDF */
 		dscene->light_distribution.copy_to_device();
 
+		/* Light tree */
+		kintegrator->use_light_tree = false;
+		kintegrator->light_tree_num_nodes = 0;
+		kintegrator->light_tree_num_infinite = 0;
+		kintegrator->light_tree_pdf_infinite = 0.0f;
+
+		if(use_light_tree) {
+			progress.set_status("Updating Lights", "Building light tree");
+
+			LightTree tree(tree_prims, progress);
+			if(progress.get_cancel()) return;
+
+			if(tree.num_nodes() > 0 || tree_infinite.size() > 0) {
+				vector<KernelLightTreeNode> nodes;
+				vector<int> leaves(num_distribution, -1);
+				tree.pack(nodes, leaves);
+
+				/* Distant and background lights are leaves after the tree, they
+				 * are picked uniformly with the same probability as the tree. */
+				foreach(int index, tree_infinite) {
+					KernelLightTreeNode knode;
+					memset(&knode, 0, sizeof(knode));
+					knode.child = ~index;
+					knode.parent = -1;
+					leaves[index] = nodes.size();
+					nodes.push_back(knode);
+				}
+
+				kintegrator->use_light_tree = true;
+				kintegrator->light_tree_num_nodes = tree.num_nodes();
+				kintegrator->light_tree_num_infinite = tree_infinite.size();
+				if(tree_infinite.size() > 0) {
+					kintegrator->light_tree_pdf_infinite = (tree.num_nodes() > 0)? 0.5f: 1.0f;
+				}
+
+				KernelLightTreeNode *knodes = dscene->light_tree_nodes.alloc(nodes.size());
+				memcpy(knodes, &nodes[0], sizeof(KernelLightTreeNode)*nodes.size());
+				dscene->light_tree_nodes.copy_to_device();
+
+				int *kleaves = dscene->light_tree_leaves.alloc(leaves.size());
+				memcpy(kleaves, &leaves[0], sizeof(int)*leaves.size());
+				dscene->light_tree_leaves.copy_to_device();
+
+				VLOG(1) << "Light tree with " << tree.num_nodes() << " nodes, "
+				        << tree_infinite.size() << " lights outside of the tree.";
+			}
+		}
+
 		/* Portals */
 		if(num_portals > 0) {
 			kintegrator->portal_offset = light_index;
@@ -469,6 +606,10 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 		kintegrator->num_portals = 0;
 		kintegrator->portal_offset = 0;
 		kintegrator->portal_pdf = 0.0f;
+		kintegrator->use_light_tree = false;
+		kintegrator->light_tree_num_nodes = 0;
+		kintegrator->light_tree_num_infinite = 0;
+		kintegrator->light_tree_pdf_infinite = 0.0f;
 
 		kfilm->pass_shadow_scale = 1.0f;
 	}
@@ -872,6 +1013,8 @@ void LightManager::device_free(Device *, DeviceScene *dscene)
 	dscene->lights.free();
 	dscene->light_background_marginal_cdf.free();
 	dscene->light_background_conditional_cdf.free();
+	dscene->light_tree_nodes.free();
+	dscene->light_tree_leaves.free();
 }
 
 void LightManager::tag_update(Scene * /*scene*/)
@@ -81,6 +81,8 @@ public:
 class LightManager {
 public:
 	bool use_light_visibility;
+	/* Light tree was requested by the integrator at the last update. */
+	bool use_light_tree;
 	bool need_update;
 
 	LightManager();
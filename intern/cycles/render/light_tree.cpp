@@ -0,0 +1,369 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/light_tree.h"
+
+#include "util/util_algorithm.h"
+#include "util/util_foreach.h"
+#include "util/util_math.h"
+#include "util/util_progress.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Number of bins per axis to find splits. */
+#define LIGHT_TREE_NUM_BINS 12
+/* Ranges with fewer primitives are built in the current task. */
+#define LIGHT_TREE_THREAD_TASK_SIZE 4096
+/* Deeper nodes are split in the middle, which bounds the depth of the tree
+ * for degenerate distributions of lights. */
+#define LIGHT_TREE_MAX_SAH_DEPTH 48
+
+static inline int light_tree_bin(const LightTreePrimitive& prim,
+                                  int axis,
+                                  float centroid_min,
+                                  float inv_size)
+{
+	const float centroid = prim.bounds.center()[axis];
+	return clamp((int)((centroid - centroid_min) * inv_size), 0, LIGHT_TREE_NUM_BINS - 1);
+}
+
+struct LightTreeBinLess {
+	LightTreeBinLess(int axis, int bin, float centroid_min, float centroid_size)
+	: axis(axis),
+	  bin(bin),
+	  centroid_min(centroid_min),
+	  inv_size(LIGHT_TREE_NUM_BINS / centroid_size)
+	{
+	}
+
+	bool operator()(const LightTreePrimitive& prim) const
+	{
+		return light_tree_bin(prim, axis, centroid_min, inv_size) < bin;
+	}
+
+	int axis;
+	int bin;
+	float centroid_min;
+	float inv_size;
+};
+
+struct LightTreeCentroidLess {
+	explicit LightTreeCentroidLess(int axis) : axis(axis) {}
+
+	bool operator()(const LightTreePrimitive& a, const LightTreePrimitive& b) const
+	{
+		return a.bounds.center()[axis] < b.bounds.center()[axis];
+	}
+
+	int axis;
+};
+
+/* Cone */
+
+void LightTreeCone::grow(const LightTreeCone& other)
+{
+	LightTreeCone a = *this;
+	LightTreeCone b = other;
+	const bool is_two_sided = a.two_sided || b.two_sided;
+
+	/* Either direction of the normal of two sided lights works. */
+	if(is_two_sided && dot(a.axis, b.axis) < 0.0f) {
+		b.axis = -b.axis;
+	}
+	if(b.theta_o > a.theta_o) {
+		swap(a, b);
+	}
+
+	const float theta_d = safe_acosf(dot(a.axis, b.axis));
+	const float theta_e_new = max(a.theta_e, b.theta_e);
+
+	/* b is inside of a. */
+	if(min(theta_d + b.theta_o, M_PI_F) <= a.theta_o) {
+		*this = LightTreeCone(a.axis, a.theta_o, theta_e_new, is_two_sided);
+		return;
+	}
+
+	const float theta_o_new = 0.5f*(a.theta_o + theta_d + b.theta_o);
+	float3 ortho = b.axis - a.axis*dot(a.axis, b.axis);
+	float ortho_len;
+	ortho = normalize_len(ortho, &ortho_len);
+
+	if(theta_o_new >= M_PI_F || ortho_len == 0.0f) {
+		*this = LightTreeCone(a.axis, M_PI_F, theta_e_new, is_two_sided);
+		return;
+	}
+
+	/* Rotate the axis of a towards b. */
+	const float theta_r = theta_o_new - a.theta_o;
+	const float3 axis_new = normalize(a.axis*cosf(theta_r) + ortho*sinf(theta_r));
+
+	*this = LightTreeCone(axis_new, theta_o_new, theta_e_new, is_two_sided);
+}
+
+float LightTreeCone::measure() const
+{
+	/* Section 4.1 of "Importance Sampling of Many Lights with Adaptive
+	 * Tree Splitting". */
+	const float theta_w = min(theta_o + theta_e, M_PI_F);
+	const float cos_theta_o = cosf(theta_o);
+	const float sin_theta_o = sinf(theta_o);
+	const float measure = M_2PI_F*(1.0f - cos_theta_o) +
+	                      M_PI_2_F*(2.0f*theta_w*sin_theta_o -
+	                                cosf(theta_o - 2.0f*theta_w) -
+	                                2.0f*theta_o*sin_theta_o +
+	                                cos_theta_o);
+
+	return (two_sided)? 2.0f*measure: measure;
+}
+
+/* Bounds */
+
+void LightTreeBounds::grow(const LightTreePrimitive& prim)
+{
+	bbox.grow(prim.bounds);
+	centroid.grow(prim.bounds.center());
+	if(num == 0) {
+		cone = prim.cone;
+	}
+	else {
+		cone.grow(prim.cone);
+	}
+	energy += prim.energy;
+	num++;
+}
+
+void LightTreeBounds::grow(const LightTreeBounds& other)
+{
+	if(other.num == 0) {
+		return;
+	}
+
+	bbox.grow(other.bbox);
+	centroid.grow(other.centroid);
+	if(num == 0) {
+		cone = other.cone;
+	}
+	else {
+		cone.grow(other.cone);
+	}
+	energy += other.energy;
+	num += other.num;
+}
+
+float LightTreeBounds::cost() const
+{
+	if(num == 0) {
+		return 0.0f;
+	}
+	return energy * cone.measure() * bbox.safe_area();
+}
+
+/* Tree */
+
+LightTree::LightTree(const vector<LightTreePrimitive>& all_prims, Progress& progress)
+: root(NULL),
+  num_nodes_(0),
+  progress(progress)
+{
+	foreach(const LightTreePrimitive& prim, all_prims) {
+		if(prim.energy > 0.0f && prim.bounds.valid()) {
+			prims.push_back(prim);
+		}
+	}
+
+	if(prims.empty()) {
+		return;
+	}
+
+	root = build_node(0, prims.size(), 0);
+	task_pool.wait_work();
+
+	/* Every leaf has one primitive. */
+	num_nodes_ = 2*prims.size() - 1;
+}
+
+LightTree::~LightTree()
+{
+	delete root;
+}
+
+LightTree::BuildNode *LightTree::build_node(int start, int end, int level)
+{
+	BuildNode *node = new BuildNode();
+
+	for(int i = start; i < end; i++) {
+		node->bounds.grow(prims[i]);
+	}
+
+	if(end - start == 1) {
+		node->prim = start;
+		return node;
+	}
+
+	const int mid = split(start, end, node->bounds, level);
+
+	if(end - start < LIGHT_TREE_THREAD_TASK_SIZE) {
+		node->children[0] = build_node(start, mid, level + 1);
+		node->children[1] = build_node(mid, end, level + 1);
+	}
+	else {
+		task_pool.push(function_bind(&LightTree::thread_build_node,
+		                             this, node, 0, start, mid, level + 1), true);
+		task_pool.push(function_bind(&LightTree::thread_build_node,
+		                             this, node, 1, mid, end, level + 1), true);
+	}
+
+	return node;
+}
+
+void LightTree::thread_build_node(BuildNode *parent, int child, int start, int end, int level)
+{
+	if(progress.get_cancel()) {
+		return;
+	}
+
+	parent->children[child] = build_node(start, end, level);
+}
+
+int LightTree::split(int start, int end, const LightTreeBounds& bounds, int level)
+{
+	const float3 centroid_min = bounds.centroid.min;
+	const float3 centroid_size = bounds.centroid.size();
+	const float3 bbox_size = bounds.bbox.size();
+	const float max_size = max3(bbox_size);
+
+	int best_axis = -1;
+	int best_bin = 0;
+	float best_cost = FLT_MAX;
+
+	if(level < LIGHT_TREE_MAX_SAH_DEPTH) {
+		for(int axis = 0; axis < 3; axis++) {
+			if(centroid_size[axis] <= 0.0f) {
+				continue;
+			}
+
+			const float inv_size = LIGHT_TREE_NUM_BINS / centroid_size[axis];
+			LightTreeBounds bins[LIGHT_TREE_NUM_BINS];
+
+			for(int i = start; i < end; i++) {
+				bins[light_tree_bin(prims[i], axis, centroid_min[axis], inv_size)].grow(prims[i]);
+			}
+
+			/* Sweep from the right, then evaluate splits from the left. */
+			LightTreeBounds right[LIGHT_TREE_NUM_BINS];
+			right[LIGHT_TREE_NUM_BINS - 1] = bins[LIGHT_TREE_NUM_BINS - 1];
+			for(int bin = LIGHT_TREE_NUM_BINS - 2; bin > 0; bin--) {
+				right[bin] = right[bin + 1];
+				right[bin].grow(bins[bin]);
+			}
+
+			/* Penalize splits along short axes, these tend to give thin
+			 * nodes with poor bounds on the distance. */
+			const float regularization = (bbox_size[axis] > 0.0f)? max_size / bbox_size[axis]: 1.0f;
+
+			LightTreeBounds left;
+			for(int bin = 1; bin < LIGHT_TREE_NUM_BINS; bin++) {
+				left.grow(bins[bin - 1]);
+
+				if(left.num == 0 || right[bin].num == 0) {
+					continue;
+				}
+
+				const float cost = regularization * (left.cost() + right[bin].cost());
+				if(cost < best_cost) {
+					best_cost = cost;
+					best_axis = axis;
+					best_bin = bin;
+				}
+			}
+		}
+	}
+
+	LightTreePrimitive *first = &prims[0] + start;
+	LightTreePrimitive *last = &prims[0] + end;
+
+	if(best_axis != -1) {
+		LightTreePrimitive *mid = std::partition(first, last,
+		                                         LightTreeBinLess(best_axis,
+		                                                          best_bin,
+		                                                          centroid_min[best_axis],
+		                                                          centroid_size[best_axis]));
+		return start + (int)(mid - first);
+	}
+
+	/* No split found, split the primitives in the middle of the longest
+	 * axis instead. */
+	int axis = 0;
+	if(centroid_size.y > centroid_size[axis]) axis = 1;
+	if(centroid_size.z > centroid_size[axis]) axis = 2;
+
+	LightTreePrimitive *mid = first + (end - start)/2;
+	std::nth_element(first, mid, last, LightTreeCentroidLess(axis));
+
+	return start + (end - start)/2;
+}
+
+int LightTree::pack_node(const BuildNode *node,
+                         int parent,
+                         vector<KernelLightTreeNode>& nodes,
+                         vector<int>& leaves) const
+{
+	const int index = nodes.size();
+	const LightTreeBounds& bounds = node->bounds;
+
+	KernelLightTreeNode knode;
+	knode.bounds_min[0] = bounds.bbox.min.x;
+	knode.bounds_min[1] = bounds.bbox.min.y;
+	knode.bounds_min[2] = bounds.bbox.min.z;
+	knode.energy = bounds.energy;
+	knode.bounds_max[0] = bounds.bbox.max.x;
+	knode.bounds_max[1] = bounds.bbox.max.y;
+	knode.bounds_max[2] = bounds.bbox.max.z;
+	knode.child = -1;
+	knode.axis[0] = bounds.cone.axis.x;
+	knode.axis[1] = bounds.cone.axis.y;
+	knode.axis[2] = bounds.cone.axis.z;
+	knode.parent = parent;
+	knode.theta_o = bounds.cone.theta_o;
+	knode.theta_e = bounds.cone.theta_e;
+	knode.two_sided = bounds.cone.two_sided;
+	knode.pad = 0;
+	nodes.push_back(knode);
+
+	if(node->prim != -1) {
+		const int distribution_index = prims[node->prim].distribution_index;
+		nodes[index].child = ~distribution_index;
+		leaves[distribution_index] = index;
+	}
+	else {
+		pack_node(node->children[0], index, nodes, leaves);
+		nodes[index].child = pack_node(node->children[1], index, nodes, leaves);
+	}
+
+	return index;
+}
+
+void LightTree::pack(vector<KernelLightTreeNode>& nodes, vector<int>& leaves) const
+{
+	nodes.clear();
+	nodes.reserve(num_nodes_);
+
+	if(root != NULL) {
+		pack_node(root, -1, nodes, leaves);
+	}
+}
+
+CCL_NAMESPACE_END
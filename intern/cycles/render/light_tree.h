@@ -0,0 +1,151 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+/* Light Tree
+ *
+ * Hierarchy over emissive triangles and lamps, which picks a light by its
+ * estimated contribution to the shading point rather than by power alone.
+ * Every node bounds the positions, emission directions and power of the
+ * lights below it, as described in "Importance Sampling of Many Lights with
+ * Adaptive Tree Splitting", Estevez and Kulla, 2018.
+ *
+ * Distant and background lights have no position and are not in the tree.
+ */
+
+#include "kernel/kernel_types.h"
+
+#include "util/util_boundbox.h"
+#include "util/util_task.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+class Progress;
+
+/* Bounding cone of emission directions. Normals of the lights are within
+ * theta_o of the axis, and they emit within theta_e of their normal. Two
+ * sided lights emit along the negated normal as well. */
+struct LightTreeCone {
+	float3 axis;
+	float theta_o;
+	float theta_e;
+	bool two_sided;
+
+	LightTreeCone()
+	: axis(make_float3(0.0f, 0.0f, 1.0f)),
+	  theta_o(0.0f),
+	  theta_e(0.0f),
+	  two_sided(false)
+	{
+	}
+
+	LightTreeCone(const float3& axis, float theta_o, float theta_e, bool two_sided)
+	: axis(axis),
+	  theta_o(theta_o),
+	  theta_e(theta_e),
+	  two_sided(two_sided)
+	{
+	}
+
+	/* Smallest cone containing both, not necessarily the tightest one. */
+	void grow(const LightTreeCone& other);
+
+	/* Solid angle measure of the cone, used for the cost of splits. */
+	float measure() const;
+};
+
+/* Light distribution primitive to build the tree from. */
+struct LightTreePrimitive {
+	BoundBox bounds;
+	LightTreeCone cone;
+	/* Estimate of the emitted power. */
+	float energy;
+	int distribution_index;
+};
+
+/* Bounds of a set of primitives. */
+struct LightTreeBounds {
+	BoundBox bbox;
+	BoundBox centroid;
+	LightTreeCone cone;
+	float energy;
+	int num;
+
+	LightTreeBounds()
+	: bbox(BoundBox::empty),
+	  centroid(BoundBox::empty),
+	  energy(0.0f),
+	  num(0)
+	{
+	}
+
+	void grow(const LightTreePrimitive& prim);
+	void grow(const LightTreeBounds& other);
+
+	/* Surface area orientation heuristic. */
+	float cost() const;
+};
+
+class LightTree {
+public:
+	/* Builds the tree using all threads of the task scheduler. Primitives
+	 * with zero energy are never sampled and left out of the tree. */
+	LightTree(const vector<LightTreePrimitive>& prims, Progress& progress);
+	~LightTree();
+
+	/* Nodes in depth first order with the root first, so the first child of
+	 * an inner node follows it. The leaf node of every light distribution
+	 * primitive in the tree is written to leaves, other entries are left
+	 * unchanged. */
+	void pack(vector<KernelLightTreeNode>& nodes, vector<int>& leaves) const;
+
+	size_t num_nodes() const { return num_nodes_; }
+
+protected:
+	struct BuildNode {
+		BuildNode() : prim(-1) { children[0] = children[1] = NULL; }
+		~BuildNode() { delete children[0]; delete children[1]; }
+
+		LightTreeBounds bounds;
+		BuildNode *children[2];
+		/* Index of the primitive for leaves. */
+		int prim;
+	};
+
+	BuildNode *build_node(int start, int end, int level);
+	void thread_build_node(BuildNode *parent, int child, int start, int end, int level);
+	int split(int start, int end, const LightTreeBounds& bounds, int level);
+
+	int pack_node(const BuildNode *node,
+	              int parent,
+	              vector<KernelLightTreeNode>& nodes,
+	              vector<int>& leaves) const;
+
+	vector<LightTreePrimitive> prims;
+	BuildNode *root;
+	size_t num_nodes_;
+
+	Progress& progress;
+	TaskPool task_pool;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __LIGHT_TREE_H__ */
@@ -34,9 +34,11 @@
 #include "subd/subd_patch_table.h"
 
 #include "util/util_foreach.h"
+#include "util/util_half.h"
 #include "util/util_logging.h"
 #include "util/util_progress.h"
 #include "util/util_set.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -899,7 +901,7 @@ void Mesh::pack_shaders(Scene *scene, uint *tri_shader)
 	}
 }
 
-void Mesh::pack_normals(float4 *vnormal)
+void Mesh::pack_normals(float4 *vnormal, uint *vnormal_oct)
 {
 	Attribute *attr_vN = attributes.find(ATTR_STD_VERTEX_NORMAL);
 	if(attr_vN == NULL) {
@@ -919,7 +921,10 @@ void Mesh::pack_normals(float4 *vnormal)
 		if(do_transform)
 			vNi = safe_normalize(transform_direction(&ntfm, vNi));
 
-		vnormal[i] = make_float4(vNi.x, vNi.y, vNi.z, 0.0f);
+		if(vnormal_oct)
+			vnormal_oct[i] = float3_to_octahedral(vNi);
+		else
+			vnormal[i] = make_float4(vNi.x, vNi.y, vNi.z, 0.0f);
 	}
 }
 
@@ -1055,12 +1060,25 @@ void Mesh::compute_bvh(Device *device,
 		vector<Object*> objects;
 		objects.push_back(&object);
 
-		if(bvh && !need_update_rebuild) {
+		bool rebuild = (bvh == NULL || need_update_rebuild);
+
+		if(!rebuild) {
 			progress->set_status(msg, "Refitting BVH");
 			bvh->objects = objects;
 			bvh->refit(*progress);
+
+			/* Deformation can make the refitted tree much slower to
+			 * traverse, build it from scratch in that case.
+			 */
+			if(bvh->need_rebuild()) {
+				VLOG(2) << "Rebuilding BVH of mesh " << name
+				        << ", leaf cost grew from " << bvh->build_leaf_cost
+				        << " to " << bvh->leaf_cost << ".";
+				rebuild = true;
+			}
 		}
-		else {
+
+		if(rebuild) {
 			progress->set_status(msg, "Building BVH");
 
 			BVHParams bparams;
@@ -1392,12 +1410,26 @@ void MeshManager::update_svm_attributes(Device *, DeviceScene *dscene, Scene *sc
 	dscene->attributes_map.copy_to_device();
 }
 
+/* With compact geometry float3 corner attributes of triangles are stored as
+ * half floats, these are mostly UV maps and tangents. Subdivision patches
+ * evaluate attributes with full precision. */
+static bool attribute_use_half3(Attribute *mattr, AttributePrimitive prim, bool use_compact_geometry)
+{
+	return use_compact_geometry &&
+	       prim == ATTR_PRIM_TRIANGLE &&
+	       mattr->element == ATTR_ELEMENT_CORNER &&
+	       mattr->type != TypeDesc::TypeFloat &&
+	       mattr->type != TypeDesc::TypeMatrix;
+}
+
 static void update_attribute_element_size(Mesh *mesh,
                                           Attribute *mattr,
                                           AttributePrimitive prim,
+                                          bool use_compact_geometry,
                                           size_t *attr_float_size,
                                           size_t *attr_float3_size,
-                                          size_t *attr_uchar4_size)
+                                          size_t *attr_uchar4_size,
+                                          size_t *attr_half3_size)
 {
 	if(mattr) {
 		size_t size = mattr->element_size(mesh, prim);
@@ -1408,6 +1440,9 @@ static void update_attribute_element_size(Mesh *mesh,
 		else if(mattr->element == ATTR_ELEMENT_CORNER_BYTE) {
 			*attr_uchar4_size += size;
 		}
+		else if(attribute_use_half3(mattr, prim, use_compact_geometry)) {
+			*attr_half3_size += size;
+		}
 		else if(mattr->type == TypeDesc::TypeFloat) {
 			*attr_float_size += size;
 		}
@@ -1421,12 +1456,15 @@ static void update_attribute_element_size(Mesh *mesh,
 }
 
 static void update_attribute_element_offset(Mesh *mesh,
+                                            bool use_compact_geometry,
                                             device_vector<float>& attr_float,
                                             size_t& attr_float_offset,
                                             device_vector<float4>& attr_float3,
                                             size_t& attr_float3_offset,
                                             device_vector<uchar4>& attr_uchar4,
                                             size_t& attr_uchar4_offset,
+                                            device_vector<uint2>& attr_half3,
+                                            size_t& attr_half3_offset,
                                             Attribute *mattr,
                                             AttributePrimitive prim,
                                             TypeDesc& type,
@@ -1459,6 +1497,19 @@ static void update_attribute_element_offset(Mesh *mesh,
 			}
 			attr_uchar4_offset += size;
 		}
+		else if(attribute_use_half3(mattr, prim, use_compact_geometry)) {
+			float4 *data = mattr->data_float4();
+			offset = attr_half3_offset;
+			element = ATTR_ELEMENT_CORNER_HALF;
+
+			assert(attr_half3.size() >= offset + size);
+			for(size_t k = 0; k < size; k++) {
+				const float4 f = data[k];
+				attr_half3[offset+k] = make_uint2((uint)float_to_half(f.x) | ((uint)float_to_half(f.y) << 16),
+				                                  float_to_half(f.z));
+			}
+			attr_half3_offset += size;
+		}
 		else if(mattr->type == TypeDesc::TypeFloat) {
 			float *data = mattr->data_float();
 			offset = attr_float_offset;
@@ -1506,7 +1557,10 @@ static void update_attribute_element_offset(Mesh *mesh,
 			else
 				offset -= mesh->face_offset;
 		}
-		else if(element == ATTR_ELEMENT_CORNER || element == ATTR_ELEMENT_CORNER_BYTE) {
+		else if(element == ATTR_ELEMENT_CORNER ||
+		        element == ATTR_ELEMENT_CORNER_BYTE ||
+		        element == ATTR_ELEMENT_CORNER_HALF)
+		{
 			if(prim == ATTR_PRIM_TRIANGLE)
 				offset -= 3*mesh->tri_offset;
 			else
@@ -1555,6 +1609,8 @@ void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene,
 	size_t attr_float_size = 0;
 	size_t attr_float3_size = 0;
 	size_t attr_uchar4_size = 0;
+	size_t attr_half3_size = 0;
+	const bool use_compact_geometry = scene->params.use_compact_geometry;
 	for(size_t i = 0; i < scene->meshes.size(); i++) {
 		Mesh *mesh = scene->meshes[i];
 		AttributeRequestSet& attributes = mesh_attributes[i];
@@ -1566,31 +1622,39 @@ void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene,
 			update_attribute_element_size(mesh,
 			                              triangle_mattr,
 			                              ATTR_PRIM_TRIANGLE,
+			                              use_compact_geometry,
 			                              &attr_float_size,
 			                              &attr_float3_size,
-			                              &attr_uchar4_size);
+			                              &attr_uchar4_size,
+			                              &attr_half3_size);
 			update_attribute_element_size(mesh,
 			                              curve_mattr,
 			                              ATTR_PRIM_CURVE,
+			                              use_compact_geometry,
 			                              &attr_float_size,
 			                              &attr_float3_size,
-			                              &attr_uchar4_size);
+			                              &attr_uchar4_size,
+			                              &attr_half3_size);
 			update_attribute_element_size(mesh,
 			                              subd_mattr,
 			                              ATTR_PRIM_SUBD,
+			                              use_compact_geometry,
 			                              &attr_float_size,
 			                              &attr_float3_size,
-			                              &attr_uchar4_size);
+			                              &attr_uchar4_size,
+			                              &attr_half3_size);
 		}
 	}
 
 	dscene->attributes_float.alloc(attr_float_size);
 	dscene->attributes_float3.alloc(attr_float3_size);
 	dscene->attributes_uchar4.alloc(attr_uchar4_size);
+	dscene->attributes_half3.alloc(attr_half3_size);
 
 	size_t attr_float_offset = 0;
 	size_t attr_float3_offset = 0;
 	size_t attr_uchar4_offset = 0;
+	size_t attr_half3_offset = 0;
 
 	/* Fill in attributes. */
 	for(size_t i = 0; i < scene->meshes.size(); i++) {
@@ -1605,27 +1669,33 @@ void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene,
 			Attribute *subd_mattr = mesh->subd_attributes.find(req);
 
 			update_attribute_element_offset(mesh,
+			                                use_compact_geometry,
 			                                dscene->attributes_float, attr_float_offset,
 			                                dscene->attributes_float3, attr_float3_offset,
 			                                dscene->attributes_uchar4, attr_uchar4_offset,
+			                                dscene->attributes_half3, attr_half3_offset,
 			                                triangle_mattr,
 			                                ATTR_PRIM_TRIANGLE,
 			                                req.triangle_type,
 			                                req.triangle_desc);
 
 			update_attribute_element_offset(mesh,
+			                                use_compact_geometry,
 			                                dscene->attributes_float, attr_float_offset,
 			                                dscene->attributes_float3, attr_float3_offset,
 			                                dscene->attributes_uchar4, attr_uchar4_offset,
+			                                dscene->attributes_half3, attr_half3_offset,
 			                                curve_mattr,
 			                                ATTR_PRIM_CURVE,
 			                                req.curve_type,
 			                                req.curve_desc);
 
 			update_attribute_element_offset(mesh,
+			                                use_compact_geometry,
 			                                dscene->attributes_float, attr_float_offset,
 			                                dscene->attributes_float3, attr_float3_offset,
 			                                dscene->attributes_uchar4, attr_uchar4_offset,
+			                                dscene->attributes_half3, attr_half3_offset,
 			                                subd_mattr,
 			                                ATTR_PRIM_SUBD,
 			                                req.subd_type,
@@ -1655,6 +1725,13 @@ void MeshManager::device_update_attributes(Device *device, DeviceScene *dscene,
 	if(dscene->attributes_uchar4.size()) {
 		dscene->attributes_uchar4.copy_to_device();
 	}
+	if(dscene->attributes_half3.size()) {
+		dscene->attributes_half3.copy_to_device();
+		VLOG(1) << "Compact corner attributes use "
+		        << string_human_readable_size(dscene->attributes_half3.memory_size())
+		        << " instead of "
+		        << string_human_readable_size(attr_half3_size * sizeof(float4)) << ".";
+	}
 
 	if(progress.get_cancel()) return;
 
@@ -1768,16 +1845,22 @@ void MeshManager::device_update_mesh(Device *,
 		/* normals */
 		progress.set_status("Updating Mesh", "Computing normals");
 
+		const bool use_compact_geometry = scene->params.use_compact_geometry;
+
 		uint *tri_shader = dscene->tri_shader.alloc(tri_size);
-		float4 *vnormal = dscene->tri_vnormal.alloc(vert_size);
+		float4 *vnormal = (use_compact_geometry)? NULL: dscene->tri_vnormal.alloc(vert_size);
+		uint *vnormal_oct = (use_compact_geometry)? dscene->tri_vnormal_oct.alloc(vert_size): NULL;
 		uint4 *tri_vindex = dscene->tri_vindex.alloc(tri_size);
 		uint *tri_patch = dscene->tri_patch.alloc(tri_size);
 		float2 *tri_patch_uv = dscene->tri_patch_uv.alloc(vert_size);
 
+		dscene->data.bvh.use_compact_geometry = use_compact_geometry;
+
 		foreach(Mesh *mesh, scene->meshes) {
 			mesh->pack_shaders(scene,
 			                   &tri_shader[mesh->tri_offset]);
-			mesh->pack_normals(&vnormal[mesh->vert_offset]);
+			mesh->pack_normals((vnormal)? &vnormal[mesh->vert_offset]: NULL,
+			                   (vnormal_oct)? &vnormal_oct[mesh->vert_offset]: NULL);
 			mesh->pack_verts(tri_prim_index,
 			                 &tri_vindex[mesh->tri_offset],
 			                 &tri_patch[mesh->tri_offset],
@@ -1791,7 +1874,16 @@ void MeshManager::device_update_mesh(Device *,
 		progress.set_status("Updating Mesh", "Copying Mesh to device");
 
 		dscene->tri_shader.copy_to_device();
-		dscene->tri_vnormal.copy_to_device();
+		if(use_compact_geometry) {
+			dscene->tri_vnormal_oct.copy_to_device();
+			VLOG(1) << "Compact vertex normals use "
+			        << string_human_readable_size(dscene->tri_vnormal_oct.memory_size())
+			        << " instead of "
+			        << string_human_readable_size(vert_size * sizeof(float4)) << ".";
+		}
+		else {
+			dscene->tri_vnormal.copy_to_device();
+		}
 		dscene->tri_vindex.copy_to_device();
 		dscene->tri_patch.copy_to_device();
 		dscene->tri_patch_uv.copy_to_device();
@@ -1864,6 +1956,7 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 	VLOG(1) << "Using " << bvh_layout_name(bparams.bvh_layout)
 	        << " layout.";
 
+	scoped_timer timer;
 	BVH *bvh = BVH::create(bparams, scene->objects);
 	bvh->build(progress);
 
@@ -1872,6 +1965,9 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 		return;
 	}
 
+	VLOG(1) << "Built scene BVH in " << timer.get_time() << " seconds.";
+	scene->update_times.bvh += timer.get_time();
+
 	/* copy to device */
 	progress.set_status("Updating Scene BVH", "Copying BVH to device");
 
@@ -2174,6 +2270,7 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 		if(progress.get_cancel()) return;
 	}
 
+	scoped_timer bvh_timer;
 	TaskPool pool;
 
 	size_t i = 0;
@@ -2197,6 +2294,9 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	pool.wait_work(&summary);
 	VLOG(2) << "Objects BVH build pool statistics:\n"
 	        << summary.full_report();
+	VLOG(1) << "Updated " << num_bvh << " mesh BVHs in "
+	        << bvh_timer.get_time() << " seconds.";
+	scene->update_times.bvh += bvh_timer.get_time();
 
 	foreach(Shader *shader, scene->shaders) {
 		shader->need_update_mesh = false;
@@ -2246,6 +2346,7 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 	dscene->prim_time.free();
 	dscene->tri_shader.free();
 	dscene->tri_vnormal.free();
+	dscene->tri_vnormal_oct.free();
 	dscene->tri_vindex.free();
 	dscene->tri_patch.free();
 	dscene->tri_patch_uv.free();
@@ -2256,6 +2357,7 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 	dscene->attributes_float.free();
 	dscene->attributes_float3.free();
 	dscene->attributes_uchar4.free();
+	dscene->attributes_half3.free();
 
 #ifdef WITH_OSL
 	OSLGlobals *og = (OSLGlobals*)device->osl_memory();
@@ -280,7 +280,8 @@ public:
 	void add_undisplaced();
 
 	void pack_shaders(Scene *scene, uint *shader);
-	void pack_normals(float4 *vnormal);
+	/* Writes to vnormal_oct octahedral encoded if not NULL, or to vnormal. */
+	void pack_normals(float4 *vnormal, uint *vnormal_oct);
 	void pack_verts(const vector<uint>& tri_prim_index,
 	                uint4 *tri_vindex,
 	                uint *tri_patch,
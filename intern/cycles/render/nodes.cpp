@@ -236,6 +236,8 @@ NODE_DEFINE(ImageTextureNode)
 	SOCKET_FLOAT(projection_blend, "Projection Blend", 0.0f);
 
 	SOCKET_IN_POINT(vector, "Vector", make_float3(0.0f, 0.0f, 0.0f), SocketType::LINK_TEXTURE_UV);
+	SOCKET_IN_POINT(vector_dx, "Vector dX", make_float3(0.0f, 0.0f, 0.0f), SocketType::SVM_INTERNAL);
+	SOCKET_IN_POINT(vector_dy, "Vector dY", make_float3(0.0f, 0.0f, 0.0f), SocketType::SVM_INTERNAL);
 
 	SOCKET_OUT_COLOR(color, "Color");
 	SOCKET_OUT_FLOAT(alpha, "Alpha");
@@ -293,6 +295,8 @@ void ImageTextureNode::attributes(Shader *shader, AttributeRequestSet *attribute
 void ImageTextureNode::compile(SVMCompiler& compiler)
 {
 	ShaderInput *vector_in = input("Vector");
+	ShaderInput *vector_dx_in = input("Vector dX");
+	ShaderInput *vector_dy_in = input("Vector dY");
 	ShaderOutput *color_out = output("Color");
 	ShaderOutput *alpha_out = output("Alpha");
 
@@ -315,6 +319,14 @@ void ImageTextureNode::compile(SVMCompiler& compiler)
 		int srgb = (is_linear || color_space != NODE_COLOR_SPACE_COLOR)? 0: 1;
 		int vector_offset = tex_mapping.compile_begin(compiler, vector_in);
 
+		/* Texture coordinate derivatives, only linked when using the texture cache. */
+		int vector_dx_offset = SVM_STACK_INVALID;
+		int vector_dy_offset = SVM_STACK_INVALID;
+		if(vector_dx_in->link && vector_dy_in->link) {
+			vector_dx_offset = tex_mapping.compile_begin(compiler, vector_dx_in);
+			vector_dy_offset = tex_mapping.compile_begin(compiler, vector_dy_in);
+		}
+
 		if(projection != NODE_IMAGE_PROJ_BOX) {
 			compiler.add_node(NODE_TEX_IMAGE,
 				slot,
@@ -335,7 +347,12 @@ void ImageTextureNode::compile(SVMCompiler& compiler)
 					srgb),
 				__float_as_int(projection_blend));
 		}
+		compiler.add_node(vector_dx_offset, vector_dy_offset);
 
+		if(vector_dx_offset != SVM_STACK_INVALID) {
+			tex_mapping.compile_end(compiler, vector_dx_in, vector_dx_offset);
+			tex_mapping.compile_end(compiler, vector_dy_in, vector_dy_offset);
+		}
 		tex_mapping.compile_end(compiler, vector_in, vector_offset);
 	}
 	else {
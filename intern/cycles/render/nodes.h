@@ -97,6 +97,8 @@ public:
 	float projection_blend;
 	bool animated;
 	float3 vector;
+	/* Texture coordinate shifted by the ray differentials, for the texture cache. */
+	float3 vector_dx, vector_dy;
 
 	virtual bool equals(const ShaderNode& other)
 	{
@@ -37,6 +37,7 @@
 #include "util/util_guarded_allocator.h"
 #include "util/util_logging.h"
 #include "util/util_progress.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -53,6 +54,7 @@ DeviceScene::DeviceScene(Device *device)
   prim_time(device, "__prim_time", MEM_TEXTURE),
   tri_shader(device, "__tri_shader", MEM_TEXTURE),
   tri_vnormal(device, "__tri_vnormal", MEM_TEXTURE),
+  tri_vnormal_oct(device, "__tri_vnormal_oct", MEM_TEXTURE),
   tri_vindex(device, "__tri_vindex", MEM_TEXTURE),
   tri_patch(device, "__tri_patch", MEM_TEXTURE),
   tri_patch_uv(device, "__tri_patch_uv", MEM_TEXTURE),
@@ -68,10 +70,13 @@ DeviceScene::DeviceScene(Device *device)
   attributes_float(device, "__attributes_float", MEM_TEXTURE),
   attributes_float3(device, "__attributes_float3", MEM_TEXTURE),
   attributes_uchar4(device, "__attributes_uchar4", MEM_TEXTURE),
+  attributes_half3(device, "__attributes_half3", MEM_TEXTURE),
   light_distribution(device, "__light_distribution", MEM_TEXTURE),
   lights(device, "__lights", MEM_TEXTURE),
   light_background_marginal_cdf(device, "__light_background_marginal_cdf", MEM_TEXTURE),
   light_background_conditional_cdf(device, "__light_background_conditional_cdf", MEM_TEXTURE),
+  light_tree_nodes(device, "__light_tree_nodes", MEM_TEXTURE),
+  light_tree_leaves(device, "__light_tree_leaves", MEM_TEXTURE),
   particles(device, "__particles", MEM_TEXTURE),
   svm_nodes(device, "__svm_nodes", MEM_TEXTURE),
   shaders(device, "__shaders", MEM_TEXTURE),
@@ -105,6 +110,14 @@ Scene::Scene(const SceneParams& params_, Device *device)
 		shader_manager = ShaderManager::create(this, params.shadingsystem);
 	else
 		shader_manager = ShaderManager::create(this, SHADINGSYSTEM_SVM);
+
+	/* Texture cache only works with SVM on the CPU */
+	if(params.texture_cache_size > 0 &&
+	   device->info.type == DEVICE_CPU &&
+	   !shader_manager->use_osl())
+	{
+		image_manager->set_texture_cache(params.texture_cache_size, params.texture_cache_path);
+	}
 }
 
 Scene::~Scene()
@@ -180,6 +193,9 @@ void Scene::device_update(Device *device_, Progress& progress)
 
 	bool print_stats = need_data_update();
 
+	update_times.reset();
+	scoped_timer total_timer(&update_times.total);
+
 	/* The order of updates is important, because there's dependencies between
 	 * the different managers, using data computed by previous managers.
 	 *
@@ -191,8 +207,10 @@ void Scene::device_update(Device *device_, Progress& progress)
 	 * - Lookup tables are done a second time to handle film tables
 	 */
 
+	scoped_timer shaders_timer;
 	progress.set_status("Updating Shaders");
 	shader_manager->device_update(device, &dscene, this, progress);
+	update_times.shaders = shaders_timer.get_time();
 
 	if(progress.get_cancel() || device->have_error()) return;
 
@@ -206,6 +224,7 @@ void Scene::device_update(Device *device_, Progress& progress)
 
 	if(progress.get_cancel() || device->have_error()) return;
 
+	scoped_timer geometry_timer;
 	mesh_manager->device_update_preprocess(device, this, progress);
 
 	if(progress.get_cancel() || device->have_error()) return;
@@ -227,11 +246,14 @@ void Scene::device_update(Device *device_, Progress& progress)
 
 	progress.set_status("Updating Objects Flags");
 	object_manager->device_update_flags(device, &dscene, this, progress);
+	update_times.geometry = geometry_timer.get_time();
 
 	if(progress.get_cancel() || device->have_error()) return;
 
+	scoped_timer images_timer;
 	progress.set_status("Updating Images");
 	image_manager->device_update(device, this, progress);
+	update_times.images = images_timer.get_time();
 
 	if(progress.get_cancel() || device->have_error()) return;
 
@@ -250,8 +272,10 @@ void Scene::device_update(Device *device_, Progress& progress)
 
 	if(progress.get_cancel() || device->have_error()) return;
 
+	scoped_timer lights_timer;
 	progress.set_status("Updating Lights");
 	light_manager->device_update(device, &dscene, this, progress);
+	update_times.lights = lights_timer.get_time();
 
 	if(progress.get_cancel() || device->have_error()) return;
 
@@ -76,6 +76,7 @@ public:
 	/* mesh */
 	device_vector<uint> tri_shader;
 	device_vector<float4> tri_vnormal;
+	device_vector<uint> tri_vnormal_oct;
 	device_vector<uint4> tri_vindex;
 	device_vector<uint> tri_patch;
 	device_vector<float2> tri_patch_uv;
@@ -99,12 +100,15 @@ public:
 	device_vector<float> attributes_float;
 	device_vector<float4> attributes_float3;
 	device_vector<uchar4> attributes_uchar4;
+	device_vector<uint2> attributes_half3;
 
 	/* lights */
 	device_vector<KernelLightDistribution> light_distribution;
 	device_vector<KernelLight> lights;
 	device_vector<float2> light_background_marginal_cdf;
 	device_vector<float2> light_background_conditional_cdf;
+	device_vector<KernelLightTreeNode> light_tree_nodes;
+	device_vector<int> light_tree_leaves;
 
 	/* particles */
 	device_vector<KernelParticle> particles;
@@ -134,8 +138,9 @@ public:
 	enum BVHType {
 		/* BVH supports dynamic updates of geometry.
 		 *
-		 * Faster for updating BVH tree when doing modifications in viewport,
-		 * but slower for rendering.
+		 * Faster for updating BVH tree when doing modifications in viewport
+		 * or rendering animations with persistent data, but slower for
+		 * rendering.
 		 */
 		BVH_DYNAMIC = 0,
 		/* BVH tree is calculated for specific scene, updates in geometry
@@ -166,6 +171,15 @@ public:
 	bool persistent_data;
 	int texture_limit;
 
+	/* Texture cache size in megabytes, zero to load images fully. */
+	int texture_cache_size;
+	/* Directory for generated .tx files, the user cache directory when empty. */
+	string texture_cache_path;
+
+	/* Store vertex normals octahedral encoded and UV maps and other float3
+	 * corner attributes of triangles as half floats. */
+	bool use_compact_geometry;
+
 	SceneParams()
 	{
 		shadingsystem = SHADINGSYSTEM_SVM;
@@ -176,6 +190,8 @@ public:
 		num_bvh_time_steps = 0;
 		persistent_data = false;
 		texture_limit = 0;
+		texture_cache_size = 0;
+		use_compact_geometry = false;
 	}
 
 	bool modified(const SceneParams& params)
@@ -186,7 +202,39 @@ public:
 		&& use_bvh_unaligned_nodes == params.use_bvh_unaligned_nodes
 		&& num_bvh_time_steps == params.num_bvh_time_steps
 		&& persistent_data == params.persistent_data
-		&& texture_limit == params.texture_limit); }
+		&& texture_limit == params.texture_limit
+		&& texture_cache_size == params.texture_cache_size
+		&& texture_cache_path == params.texture_cache_path
+		&& use_compact_geometry == params.use_compact_geometry); }
+};
+
+/* Scene Update Times
+ *
+ * Time spent in the phases of the last device update, in seconds. Geometry
+ * includes the BVH build, which is also reported separately. */
+
+struct SceneUpdateTimes {
+	double shaders;
+	double geometry;
+	double bvh;
+	double images;
+	double lights;
+	double total;
+
+	SceneUpdateTimes()
+	{
+		reset();
+	}
+
+	void reset()
+	{
+		shaders = 0.0;
+		geometry = 0.0;
+		bvh = 0.0;
+		images = 0.0;
+		lights = 0.0;
+		total = 0.0;
+	}
 };
 
 /* Scene */
@@ -231,6 +279,9 @@ public:
 	/* parameters */
 	SceneParams params;
 
+	/* statistics */
+	SceneUpdateTimes update_times;
+
 	/* mutex must be locked manually by callers */
 	thread_mutex mutex;
 
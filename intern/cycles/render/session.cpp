@@ -926,6 +926,14 @@ void Session::update_status_time(bool show_pause, bool show_done)
 		substatus.clear();
 	}
 
+	const uint64_t skipped_samples = progress.get_skipped_samples();
+	if(skipped_samples > 0) {
+		const uint64_t pixel_samples = max(progress.get_pixel_samples(), (uint64_t)1);
+		string adaptive = string_printf("Adaptive sampling saved %.1f%%",
+		                                100.0 * (double)skipped_samples / (double)pixel_samples);
+		substatus = substatus.empty()? adaptive: substatus + ", " + adaptive;
+	}
+
 	progress.set_status(status, substatus);
 }
 
@@ -951,6 +959,14 @@ void Session::render()
 	task.requested_tile_size = params.tile_size;
 	task.passes_size = tile_manager.params.get_passes_size();
 
+	if(scene->integrator->use_adaptive_sampling &&
+	   Pass::contains(scene->film->passes, PASS_ADAPTIVE_AUX_BUFFER))
+	{
+		task.adaptive_sampling.use = true;
+		task.adaptive_sampling.min_samples = scene->integrator->adaptive_min_samples;
+		task.update_skipped_samples = function_bind(&Progress::add_skipped_samples, &this->progress, _1);
+	}
+
 	if(params.use_denoising) {
 		task.denoising_radius = params.denoising_radius;
 		task.denoising_strength = params.denoising_strength;
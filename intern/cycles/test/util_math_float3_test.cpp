@@ -0,0 +1,80 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* ******** Tests for float3_to_octahedral() ******** */
+
+static void expect_octahedral_round_trip(float3 v)
+{
+	const uint encoded = float3_to_octahedral(v);
+	EXPECT_NE(encoded, 0u) << v.x << " " << v.y << " " << v.z;
+
+	/* 16 bits per component, the error is largest along the folded diagonals. */
+	const float3 n = normalize(v);
+	const float3 decoded = octahedral_to_float3(encoded);
+	EXPECT_NEAR(n.x, decoded.x, 1e-4f);
+	EXPECT_NEAR(n.y, decoded.y, 1e-4f);
+	EXPECT_NEAR(n.z, decoded.z, 1e-4f);
+}
+
+TEST(util_octahedral, zero)
+{
+	EXPECT_EQ(float3_to_octahedral(make_float3(0.0f, 0.0f, 0.0f)), 0u);
+	const float3 decoded = octahedral_to_float3(0);
+	EXPECT_EQ(decoded.x, 0.0f);
+	EXPECT_EQ(decoded.y, 0.0f);
+	EXPECT_EQ(decoded.z, 0.0f);
+}
+
+TEST(util_octahedral, axes)
+{
+	expect_octahedral_round_trip(make_float3(1.0f, 0.0f, 0.0f));
+	expect_octahedral_round_trip(make_float3(-1.0f, 0.0f, 0.0f));
+	expect_octahedral_round_trip(make_float3(0.0f, 1.0f, 0.0f));
+	expect_octahedral_round_trip(make_float3(0.0f, -1.0f, 0.0f));
+	expect_octahedral_round_trip(make_float3(0.0f, 0.0f, 1.0f));
+	expect_octahedral_round_trip(make_float3(0.0f, 0.0f, -1.0f));
+}
+
+/* Directions close to -Z with negative x and y fold onto the corner
+ * which encodes to zero, that must not turn them into zero normals. */
+TEST(util_octahedral, negative_z)
+{
+	expect_octahedral_round_trip(make_float3(-1e-6f, -1e-6f, -1.0f));
+	expect_octahedral_round_trip(make_float3(-1e-5f, -1e-7f, -1.0f));
+	expect_octahedral_round_trip(make_float3(-0.0f, -0.0f, -1.0f));
+	expect_octahedral_round_trip(make_float3(1e-6f, -1e-6f, -1.0f));
+}
+
+TEST(util_octahedral, sphere)
+{
+	for(int i = 0; i < 64; i++) {
+		for(int j = 0; j <= 32; j++) {
+			const float phi = i * (M_2PI_F / 64.0f);
+			const float theta = j * (M_PI_F / 32.0f);
+			expect_octahedral_round_trip(make_float3(sinf(theta) * cosf(phi),
+			                                         sinf(theta) * sinf(phi),
+			                                         cosf(theta)));
+		}
+	}
+}
+
+CCL_NAMESPACE_END
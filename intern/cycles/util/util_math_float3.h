@@ -390,6 +390,55 @@ ccl_device_inline float3 ensure_finite3(float3 v)
 	return v;
 }
 
+/* Octahedral mapping of directions to 2x16 bits, see "A Survey of Efficient
+ * Representations for Independent Unit Vectors", Cigolle et al. 2014. The
+ * lower hemisphere is folded over the diagonals of the square. Zero vectors
+ * map to 0, which no direction maps to. */
+ccl_device_inline uint float3_to_octahedral(float3 v)
+{
+	const float len = fabsf(v.x) + fabsf(v.y) + fabsf(v.z);
+
+	if(len == 0.0f) {
+		return 0;
+	}
+
+	float x = v.x / len;
+	float y = v.y / len;
+
+	if(v.z < 0.0f) {
+		const float fold_x = (1.0f - fabsf(y)) * signf(x);
+		y = (1.0f - fabsf(x)) * signf(y);
+		x = fold_x;
+	}
+
+	const uint ux = (uint)(clamp(x*0.5f + 0.5f, 0.0f, 1.0f)*65535.0f + 0.5f);
+	const uint uy = (uint)(clamp(y*0.5f + 0.5f, 0.0f, 1.0f)*65535.0f + 0.5f);
+	const uint encoded = ux | (uy << 16);
+
+	/* Zero is reserved for zero length vectors, directions close to -Z with
+	 * negative x and y fold onto it. Use the neighboring value instead. */
+	return (encoded != 0) ? encoded : 1;
+}
+
+ccl_device_inline float3 octahedral_to_float3(uint v)
+{
+	if(v == 0) {
+		return make_float3(0.0f, 0.0f, 0.0f);
+	}
+
+	float x = (float)(v & 0xFFFF)*(2.0f/65535.0f) - 1.0f;
+	float y = (float)(v >> 16)*(2.0f/65535.0f) - 1.0f;
+	const float z = 1.0f - fabsf(x) - fabsf(y);
+
+	if(z < 0.0f) {
+		const float fold_x = (1.0f - fabsf(y)) * signf(x);
+		y = (1.0f - fabsf(x)) * signf(y);
+		x = fold_x;
+	}
+
+	return normalize(make_float3(x, y, z));
+}
+
 CCL_NAMESPACE_END
 
 #endif /* __UTIL_MATH_FLOAT3_H__ */
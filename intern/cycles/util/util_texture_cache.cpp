@@ -0,0 +1,289 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "util/util_texture_cache.h"
+
+#include "util/util_logging.h"
+#include "util/util_md5.h"
+#include "util/util_path.h"
+
+#include <OpenImageIO/imagebufalgo.h>
+#include <OpenImageIO/texture.h>
+
+#include <cstdio>
+#include <sstream>
+
+OIIO_NAMESPACE_USING
+
+CCL_NAMESPACE_BEGIN
+
+/* Tile size of generated .tx files and of files tiled in memory. */
+#define TEXTURE_CACHE_TILE_SIZE 64
+
+/* Stats */
+
+TextureCache::Stats::Stats()
+: tile_lookups(0),
+  tile_misses(0),
+  mem_used(0),
+  tiles_peak(0),
+  bytes_read(0),
+  num_converted(0)
+{
+}
+
+float TextureCache::Stats::hit_rate() const
+{
+	if(tile_lookups == 0) {
+		return 1.0f;
+	}
+	return 1.0f - (float)((double)tile_misses / (double)tile_lookups);
+}
+
+string TextureCache::Stats::full_report() const
+{
+	return string_printf("Texture cache: %.2f%% tile hit rate (%llu lookups, %llu misses), "
+	                     "%s in memory, %d tiles peak, %s read, %d files converted to .tx",
+	                     (double)hit_rate() * 100.0,
+	                     (unsigned long long)tile_lookups,
+	                     (unsigned long long)tile_misses,
+	                     string_human_readable_size(mem_used).c_str(),
+	                     tiles_peak,
+	                     string_human_readable_size(bytes_read).c_str(),
+	                     num_converted);
+}
+
+/* Texture Cache */
+
+TextureCache::TextureCache(int max_memory_mb, const string& path)
+: tx_path(path),
+  num_converted(0)
+{
+	TextureSystem *ts = TextureSystem::create(false);
+
+	ts->attribute("max_memory_MB", (float)max_memory_mb);
+	/* Files which could not be converted are tiled and mipmapped in memory. */
+	ts->attribute("autotile", TEXTURE_CACHE_TILE_SIZE);
+	ts->attribute("automip", 1);
+	ts->attribute("gray_to_rgb", 1);
+
+	texture_system = ts;
+}
+
+TextureCache::~TextureCache()
+{
+	TextureSystem *ts = (TextureSystem*)texture_system;
+
+	VLOG(2) << ts->getstats(2);
+
+	ts->invalidate_all(true);
+	TextureSystem::destroy(ts);
+}
+
+string TextureCache::tx_filename(const string& filename) const
+{
+	const string dir = (tx_path.empty())? path_cache_get("textures"): tx_path;
+
+	/* Hash of the full path, different directories may contain files with the same name. */
+	return path_join(dir, string_printf("%s.%s.tx",
+	                                    path_filename(filename).c_str(),
+	                                    util_md5_string(filename).substr(0, 16).c_str()));
+}
+
+/* Returns the file to read tiles from, an empty string when the cache can't be used. */
+string TextureCache::prepare_file(const string& filename, int slot)
+{
+	ImageInput *in = ImageInput::open(filename);
+
+	if(!in) {
+		return "";
+	}
+
+	ImageSpec spec = in->spec();
+	const bool is_volume = (spec.depth > 1);
+	const bool is_tx = (spec.tile_width > 0 && in->seek_subimage(0, 1, spec));
+
+	in->close();
+	delete in;
+
+	if(is_volume) {
+		return "";
+	}
+	else if(is_tx) {
+		return filename;
+	}
+
+	const string tx = tx_filename(filename);
+
+	if(path_exists(tx) && path_modified_time(tx) >= path_modified_time(filename)) {
+		return tx;
+	}
+
+	/* Write to a temporary file first, the same file can be used by multiple
+	 * slots which are loaded in parallel. */
+	const string tx_tmp = string_printf("%s.%d.tmp", tx.c_str(), slot);
+
+	ImageSpec config;
+	config.tile_width = TEXTURE_CACHE_TILE_SIZE;
+	config.tile_height = TEXTURE_CACHE_TILE_SIZE;
+
+	std::stringstream errors;
+	path_create_directories(tx);
+
+	if(!ImageBufAlgo::make_texture(ImageBufAlgo::MakeTxTexture, filename, tx_tmp, config, &errors) ||
+	   (std::rename(tx_tmp.c_str(), tx.c_str()) != 0 && !path_exists(tx)))
+	{
+		VLOG(1) << "Failed to convert " << filename << " to " << tx << ": " << errors.str();
+		std::remove(tx_tmp.c_str());
+
+		return filename;
+	}
+
+	VLOG(1) << "Converted " << filename << " to " << tx << ".";
+
+	thread_scoped_lock lock(images_mutex);
+	num_converted++;
+
+	return tx;
+}
+
+bool TextureCache::add_image(int slot,
+                             const string& filename,
+                             InterpolationType interpolation,
+                             ExtensionType extension,
+                             bool use_alpha)
+{
+	const string cache_filename = prepare_file(filename, slot);
+
+	if(cache_filename.empty()) {
+		return false;
+	}
+
+	TextureSystem *ts = (TextureSystem*)texture_system;
+	TextureSystem::TextureHandle *handle = ts->get_texture_handle(ustring(cache_filename));
+
+	if(handle == NULL) {
+		return false;
+	}
+
+	thread_scoped_lock lock(images_mutex);
+
+	if((size_t)slot >= images.size()) {
+		images.resize(slot + 1);
+	}
+
+	Image& image = images[slot];
+
+	/* Reloaded image, the file may have been modified. */
+	if(image.handle != NULL) {
+		ts->invalidate(ustring(cache_filename));
+	}
+	image.handle = handle;
+	image.interpolation = interpolation;
+	image.extension = extension;
+	image.use_alpha = use_alpha;
+
+	return true;
+}
+
+void TextureCache::remove_image(int slot)
+{
+	thread_scoped_lock lock(images_mutex);
+
+	if((size_t)slot < images.size()) {
+		images[slot] = Image();
+	}
+}
+
+float4 TextureCache::lookup(int slot, float x, float y, float2 dx, float2 dy) const
+{
+	TextureSystem *ts = (TextureSystem*)texture_system;
+	const Image& image = images[slot];
+	TextureOpt options;
+
+	switch(image.extension) {
+		case EXTENSION_EXTEND:
+			options.swrap = options.twrap = TextureOpt::WrapClamp;
+			break;
+		case EXTENSION_CLIP:
+			options.swrap = options.twrap = TextureOpt::WrapBlack;
+			break;
+		case EXTENSION_REPEAT:
+		default:
+			options.swrap = options.twrap = TextureOpt::WrapPeriodic;
+			break;
+	}
+
+	switch(image.interpolation) {
+		case INTERPOLATION_CLOSEST:
+			options.interpmode = TextureOpt::InterpClosest;
+			break;
+		case INTERPOLATION_CUBIC:
+			options.interpmode = TextureOpt::InterpBicubic;
+			break;
+		case INTERPOLATION_SMART:
+			options.interpmode = TextureOpt::InterpSmartBicubic;
+			break;
+		case INTERPOLATION_LINEAR:
+		default:
+			options.interpmode = TextureOpt::InterpBilinear;
+			break;
+	}
+
+	/* Alpha for images without alpha channel. */
+	options.fill = 1.0f;
+
+	/* Image rows are stored top to bottom, Cycles has the origin at the bottom. */
+	float result[4];
+	if(!ts->texture((TextureSystem::TextureHandle*)image.handle, NULL, options,
+	                x, 1.0f - y,
+	                dx.x, -dx.y,
+	                dy.x, -dy.y,
+	                4, result))
+	{
+		return make_float4(TEX_IMAGE_MISSING_R,
+		                   TEX_IMAGE_MISSING_G,
+		                   TEX_IMAGE_MISSING_B,
+		                   TEX_IMAGE_MISSING_A);
+	}
+
+	return make_float4(result[0], result[1], result[2], (image.use_alpha)? result[3]: 1.0f);
+}
+
+TextureCache::Stats TextureCache::get_stats() const
+{
+	TextureSystem *ts = (TextureSystem*)texture_system;
+	long long tile_lookups = 0, tile_misses = 0, mem_used = 0, bytes_read = 0;
+	int tiles_peak = 0;
+
+	ts->getattribute("stat:find_tile_calls", TypeDesc::INT64, &tile_lookups);
+	ts->getattribute("stat:find_tile_cache_misses", TypeDesc::INT64, &tile_misses);
+	ts->getattribute("stat:cache_memory_used", TypeDesc::INT64, &mem_used);
+	ts->getattribute("stat:bytes_read", TypeDesc::INT64, &bytes_read);
+	ts->getattribute("stat:tiles_peak", TypeDesc::INT, &tiles_peak);
+
+	Stats stats;
+	stats.tile_lookups = tile_lookups;
+	stats.tile_misses = tile_misses;
+	stats.mem_used = mem_used;
+	stats.tiles_peak = tiles_peak;
+	stats.bytes_read = bytes_read;
+	stats.num_converted = num_converted;
+
+	return stats;
+}
+
+CCL_NAMESPACE_END
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2011-2018 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __UTIL_TEXTURE_CACHE_H__
+#define __UTIL_TEXTURE_CACHE_H__
+
+/* Texture Cache
+ *
+ * Image textures that are read on demand from tiled, mipmapped files instead
+ * of being loaded fully into memory. Tiles are kept in a cache of bounded
+ * size, least recently used tiles are evicted first. Files which are not
+ * tiled and mipmapped yet are converted to .tx files on first use.
+ *
+ * OpenImageIO's TextureSystem does the actual work, it is kept out of this
+ * header so the CPU kernel can do lookups without including it. */
+
+#include "util/util_string.h"
+#include "util/util_texture.h"
+#include "util/util_thread.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+class TextureCache {
+public:
+	struct Stats {
+		Stats();
+
+		/* Number of tile lookups, and how many of them had to read from disk. */
+		uint64_t tile_lookups;
+		uint64_t tile_misses;
+		/* Memory used by tiles currently in the cache, and the peak number of tiles. */
+		size_t mem_used;
+		int tiles_peak;
+		/* Bytes read from files. */
+		size_t bytes_read;
+		/* Number of files converted to .tx files. */
+		int num_converted;
+
+		float hit_rate() const;
+		string full_report() const;
+	};
+
+	/* Cache size in megabytes, and directory for generated .tx files.
+	 * An empty path uses the user cache directory. */
+	TextureCache(int max_memory_mb, const string& tx_path);
+	~TextureCache();
+
+	/* Register file image for the flattened image slot, returns false if
+	 * the image can't be used from the cache. Thread safe. */
+	bool add_image(int slot,
+	               const string& filename,
+	               InterpolationType interpolation,
+	               ExtensionType extension,
+	               bool use_alpha);
+	void remove_image(int slot);
+
+	bool has_image(int slot) const
+	{
+		return (size_t)slot < images.size() && images[slot].handle != NULL;
+	}
+
+	/* Filtered lookup, the derivatives of the texture coordinate in screen
+	 * space choose the mipmap level. Zero derivatives sample the full
+	 * resolution image. */
+	float4 lookup(int slot, float x, float y, float2 dx, float2 dy) const;
+
+	Stats get_stats() const;
+
+protected:
+	struct Image {
+		Image() : handle(NULL) {}
+
+		void *handle;
+		InterpolationType interpolation;
+		ExtensionType extension;
+		bool use_alpha;
+	};
+
+	string tx_filename(const string& filename) const;
+	string prepare_file(const string& filename, int slot);
+
+	vector<Image> images;
+	thread_mutex images_mutex;
+
+	/* OIIO::TextureSystem */
+	void *texture_system;
+	string tx_path;
+	int num_converted;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __UTIL_TEXTURE_CACHE_H__ */
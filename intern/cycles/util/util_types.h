@@ -146,6 +146,7 @@ CCL_NAMESPACE_END
 #  include "util/util_sseb.h"
 #  include "util/util_ssei.h"
 #  include "util/util_ssef.h"
+#  include "util/util_avxb.h"
 #  include "util/util_avxf.h"
 #endif
 
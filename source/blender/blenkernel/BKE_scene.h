@@ -151,6 +151,12 @@ void BKE_scene_graph_update_for_newframe(struct EvaluationContext *eval_ctx,
                                          struct Scene *scene,
                                          struct ViewLayer *view_layer);
 
+void BKE_scene_graph_update_for_render_frame(struct EvaluationContext *eval_ctx,
+                                             struct Depsgraph *depsgraph,
+                                             struct Main *bmain,
+                                             struct Scene *scene,
+                                             struct ViewLayer *view_layer);
+
 struct SceneRenderView *BKE_scene_add_render_view(struct Scene *sce, const char *name);
 bool BKE_scene_remove_render_view(struct Scene *scene, struct SceneRenderView *srv);
 
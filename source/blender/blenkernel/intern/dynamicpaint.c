@@ -615,16 +615,15 @@ static void grid_bound_insert_cb_ex(void *__restrict userdata,
 	boundInsert(grid_bound, bData->realCoord[bData->s_pos[i]].v);
 }
 
-static void grid_bound_insert_finalize(void *__restrict userdata,
-                                       void *__restrict userdata_chunk)
+static void grid_bound_insert_reduce(void *__restrict UNUSED(userdata),
+                                     void *__restrict chunk_join,
+                                     void *__restrict chunk)
 {
-	PaintBakeData *bData = userdata;
-	VolumeGrid *grid = bData->grid;
-
-	Bounds3D *grid_bound = userdata_chunk;
+	Bounds3D *join = chunk_join;
+	Bounds3D *grid_bound = chunk;
 
-	boundInsert(&grid->grid_bounds, grid_bound->min);
-	boundInsert(&grid->grid_bounds, grid_bound->max);
+	boundInsert(join, grid_bound->min);
+	boundInsert(join, grid_bound->max);
 }
 
 static void grid_cell_points_cb_ex(void *__restrict userdata,
@@ -648,18 +647,20 @@ static void grid_cell_points_cb_ex(void *__restrict userdata,
 	s_num[temp_t_index[i]]++;
 }
 
-static void grid_cell_points_finalize(void *__restrict userdata,
-                                      void *__restrict userdata_chunk)
+static void grid_cell_points_reduce(void *__restrict userdata,
+                                    void *__restrict chunk_join,
+                                    void *__restrict chunk)
 {
 	PaintBakeData *bData = userdata;
 	VolumeGrid *grid = bData->grid;
 	const int grid_cells = grid->dim[0] * grid->dim[1] * grid->dim[2];
 
-	int *s_num = userdata_chunk;
+	int *join_s_num = chunk_join;
+	int *s_num = chunk;
 
 	/* calculate grid indexes */
 	for (int i = 0; i < grid_cells; i++) {
-		grid->s_num[i] += s_num[i];
+		join_s_num[i] += s_num[i];
 	}
 }
 
@@ -716,7 +717,7 @@ static void surfaceGenerateGrid(struct DynamicPaintSurface *surface)
 			settings.use_threading = (sData->total_points > 1000);
 			settings.userdata_chunk = &grid->grid_bounds;
 			settings.userdata_chunk_size = sizeof(grid->grid_bounds);
-			settings.func_finalize = grid_bound_insert_finalize;
+			settings.func_reduce = grid_bound_insert_reduce;
 			BLI_task_parallel_range(
 			        0, sData->total_points,
 			        bData,
@@ -777,7 +778,7 @@ static void surfaceGenerateGrid(struct DynamicPaintSurface *surface)
 				settings.use_threading = (sData->total_points > 1000);
 				settings.userdata_chunk = grid->s_num;
 				settings.userdata_chunk_size = sizeof(*grid->s_num) * grid_cells;
-				settings.func_finalize = grid_cell_points_finalize;
+				settings.func_reduce = grid_cell_points_reduce;
 				BLI_task_parallel_range(
 				        0, sData->total_points,
 				        bData,
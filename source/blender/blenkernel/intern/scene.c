@@ -1464,6 +1464,30 @@ void BKE_scene_graph_update_for_newframe(EvaluationContext *eval_ctx,
 	DEG_ids_clear_recalc(bmain);
 }
 
+/* Evaluation for render engines which keep their data between the frames of
+ * an animation, using the same dependency graph for every frame. Only data
+ * which changed since the previous frame is evaluated, and the recalc flags
+ * are kept so the engine can find it. The caller clears them with
+ * DEG_ids_clear_recalc() once the engine is done with the frame. */
+void BKE_scene_graph_update_for_render_frame(EvaluationContext *eval_ctx,
+                                             Depsgraph *depsgraph,
+                                             Main *bmain,
+                                             Scene *scene,
+                                             ViewLayer *view_layer)
+{
+	const float ctime = BKE_scene_frame_get(scene);
+	/* (Re-)build dependency graph if needed, everything is tagged for
+	 * update when it's built for the first frame. */
+	DEG_graph_relations_update(depsgraph, bmain, scene, view_layer);
+	/* Update animated cache files for modifiers. */
+	BKE_cachefile_update_frame(bmain, scene, ctime,
+	                           (((double)scene->r.frs_sec) / (double)scene->r.frs_sec_base));
+	/* Tag time dependent data for update, flush and evaluate. */
+	DEG_evaluate_on_framechange(eval_ctx, bmain, depsgraph, ctime);
+	/* Inform editors about possible changes. */
+	DEG_ids_check_recalc(bmain, depsgraph, scene, view_layer, true);
+}
+
 /* return default view */
 SceneRenderView *BKE_scene_add_render_view(Scene *sce, const char *name)
 {
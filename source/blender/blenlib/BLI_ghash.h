@@ -56,6 +56,7 @@ typedef void          (*GHashKeyFreeFP)  (void *key);
 typedef void          (*GHashValFreeFP)  (void *val);
 typedef void         *(*GHashKeyCopyFP)  (const void *key);
 typedef void         *(*GHashValCopyFP)  (const void *val);
+typedef void         *(*GHashValCreateFP)(const void *key, void *userdata);
 
 typedef struct GHash GHash;
 
@@ -74,6 +75,12 @@ typedef struct GHashIterState {
 enum {
 	GHASH_FLAG_ALLOW_DUPES  = (1 << 0),  /* Only checked for in debug mode */
 	GHASH_FLAG_ALLOW_SHRINK = (1 << 1),  /* Allow to shrink buckets' size. */
+	/* Store entries in a single array using open addressing (robin-hood linear probing),
+	 * instead of chaining separately allocated entries in buckets.
+	 * Only valid when creating the hash (see #BLI_ghash_new_flag_ex).
+	 * Faster for small keys and lookup-heavy usage, but pointers returned by
+	 * #BLI_ghash_lookup_p, #BLI_ghash_ensure_p & co are only valid until the next insertion or removal. */
+	GHASH_FLAG_OPEN_ADDRESSING = (1 << 2),
 
 #ifdef GHASH_INTERNAL_API
 	/* Internal usage only */
@@ -89,6 +96,9 @@ enum {
 GHash *BLI_ghash_new_ex(
         GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
         const unsigned int nentries_reserve) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+GHash *BLI_ghash_new_flag_ex(
+        GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
+        const unsigned int nentries_reserve, const unsigned int flag) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
 GHash *BLI_ghash_new(
         GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
 GHash *BLI_ghash_copy(
@@ -177,6 +187,9 @@ typedef GHashIterState GSetIterState;
 GSet  *BLI_gset_new_ex(
         GSetHashFP hashfp, GSetCmpFP cmpfp, const char *info,
         const unsigned int nentries_reserve) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+GSet  *BLI_gset_new_flag_ex(
+        GSetHashFP hashfp, GSetCmpFP cmpfp, const char *info,
+        const unsigned int nentries_reserve, const unsigned int flag) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
 GSet  *BLI_gset_new(GSetHashFP hashfp, GSetCmpFP cmpfp, const char *info) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
 GSet  *BLI_gset_copy(GSet *gs, GSetKeyCopyFP keycopyfp) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
 unsigned int BLI_gset_len(GSet *gs) ATTR_WARN_UNUSED_RESULT;
@@ -234,6 +247,50 @@ BLI_INLINE bool BLI_gsetIterator_done(GSetIterator *gsi) { return BLI_ghashItera
 
 /** \} */
 
+/** \name Concurrent GHash API
+ *
+ * A GHash which can be filled and queried from several threads at once
+ * (e.g. from #BLI_task_parallel_range callbacks).
+ *
+ * Defined in ``BLI_ghash_concurrent.c``
+ * \{ */
+
+typedef struct GHashConcurrent GHashConcurrent;
+
+GHashConcurrent *BLI_ghash_concurrent_new(
+        GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
+        const unsigned int nentries_reserve) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+void   BLI_ghash_concurrent_free(GHashConcurrent *cgh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+void   BLI_ghash_concurrent_insert(GHashConcurrent *cgh, void *key, void *val);
+void  *BLI_ghash_concurrent_lookup(GHashConcurrent *cgh, const void *key) ATTR_WARN_UNUSED_RESULT;
+bool   BLI_ghash_concurrent_haskey(GHashConcurrent *cgh, const void *key) ATTR_WARN_UNUSED_RESULT;
+bool   BLI_ghash_concurrent_ensure_p(GHashConcurrent *cgh, void *key, void ***r_val) ATTR_WARN_UNUSED_RESULT;
+void  *BLI_ghash_concurrent_ensure(
+        GHashConcurrent *cgh, void *key, GHashValCreateFP createfp, void *userdata);
+bool   BLI_ghash_concurrent_remove(
+        GHashConcurrent *cgh, const void *key, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+unsigned int BLI_ghash_concurrent_len(GHashConcurrent *cgh) ATTR_WARN_UNUSED_RESULT;
+GHash *BLI_ghash_concurrent_to_ghash(GHashConcurrent *cgh, const char *info) ATTR_WARN_UNUSED_RESULT;
+
+/** \} */
+
+/** \name GHash Hashed Key API
+ *
+ * For callers which already hashed the key with the hash function of the GHash,
+ * only for chained storage.
+ *
+ * Defined in ``BLI_ghash.c``
+ * \{ */
+
+#ifdef GHASH_INTERNAL_API
+void   BLI_ghash_insert_with_hash(GHash *gh, void *key, void *val, const unsigned int hash);
+void **BLI_ghash_lookup_p_with_hash(GHash *gh, const void *key, const unsigned int hash) ATTR_WARN_UNUSED_RESULT;
+bool   BLI_ghash_ensure_p_with_hash(GHash *gh, void *key, const unsigned int hash, void ***r_val) ATTR_WARN_UNUSED_RESULT;
+bool   BLI_ghash_remove_with_hash(
+        GHash *gh, const void *key, const unsigned int hash, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+#endif  /* GHASH_INTERNAL_API */
+/** \} */
+
 /** \name GHash/GSet Debugging API's
  * \{ */
 
@@ -0,0 +1,52 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __BLI_GZIP_READER_H__
+#define __BLI_GZIP_READER_H__
+
+/** \file BLI_gzip_reader.h
+ *  \ingroup bli
+ *
+ * Reader for files written by #GzipWriter.
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "BLI_sys_types.h"
+#include "BLI_compiler_attrs.h"
+
+struct TaskScheduler;
+
+typedef struct GzipReader GzipReader;
+
+GzipReader *BLI_gzip_reader_new(int file, struct TaskScheduler *scheduler) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(2);
+int         BLI_gzip_reader_read(GzipReader *gr, void *buffer, unsigned int size) ATTR_NONNULL(1);
+bool        BLI_gzip_reader_seek(GzipReader *gr, size_t offset) ATTR_NONNULL(1);
+size_t      BLI_gzip_reader_size(const GzipReader *gr) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+void        BLI_gzip_reader_free(GzipReader *gr) ATTR_NONNULL(1);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __BLI_GZIP_READER_H__ */
@@ -0,0 +1,66 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __BLI_GZIP_WRITER_H__
+#define __BLI_GZIP_WRITER_H__
+
+/** \file BLI_gzip_writer.h
+ *  \ingroup bli
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "BLI_sys_types.h"
+#include "BLI_compiler_attrs.h"
+
+struct TaskScheduler;
+
+/* 1mb, large enough so splitting the stream has no noticeable effect on compression ratio. */
+#define BLI_GZIP_WRITER_BLOCK_SIZE (1 << 20)
+
+/**
+ * Every block is a gzip member with an extra field, so the file can be indexed
+ * by reading member headers only (same idea as BGZF):
+ *
+ * - Bytes 0..11: gzip header with FEXTRA flag, XLEN = 12.
+ * - Bytes 12..15: extra subfield 'B' 'L', subfield length 8.
+ * - Bytes 16..19: size of the whole member in the file, little endian.
+ * - Bytes 20..23: size of the uncompressed data, little endian.
+ * - Raw deflate data, followed by the usual CRC32 and size trailer.
+ */
+#define BLI_GZIP_BLOCK_HEADER_SIZE 24
+#define BLI_GZIP_BLOCK_TRAILER_SIZE 8
+
+typedef struct GzipWriter GzipWriter;
+
+GzipWriter *BLI_gzip_writer_new(
+        int file, int level, size_t block_size,
+        struct TaskScheduler *scheduler) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(4);
+bool        BLI_gzip_writer_write(GzipWriter *gw, const void *data, size_t data_len) ATTR_NONNULL(1);
+bool        BLI_gzip_writer_free(GzipWriter *gw) ATTR_NONNULL(1);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __BLI_GZIP_WRITER_H__ */
@@ -84,6 +84,11 @@ enum {
 	 * \note order of iteration is only assured to be the order of allocation when no chunks have been freed.
 	 */
 	BLI_MEMPOOL_ALLOW_ITER = (1 << 0),
+	/** allow using this mempool through #BLI_mempool_local caches from multiple threads.
+	 *
+	 * \note only these pools have a lock, the regular API never takes it.
+	 */
+	BLI_MEMPOOL_ALLOW_LOCAL = (1 << 1),
 };
 
 void  BLI_mempool_iternew(BLI_mempool *pool, BLI_mempool_iter *iter) ATTR_NONNULL();
@@ -92,6 +97,26 @@ void *BLI_mempool_iterstep(BLI_mempool_iter *iter) ATTR_WARN_UNUSED_RESULT ATTR_
 BLI_mempool_iter *BLI_mempool_iter_threadsafe_create(BLI_mempool *pool, const size_t num_iter) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
 void  BLI_mempool_iter_threadsafe_free(BLI_mempool_iter *iter_arr) ATTR_NONNULL();
 
+/**
+ * Thread local cache of a #BLI_mempool, so several threads can allocate & free elements of the same pool
+ * at once, each one using its own cache (e.g. stored in #ParallelRangeSettings.userdata_chunk).
+ *
+ * Elements are exchanged with the pool by batches, the pool must not be used through the regular API
+ * until all caches have been flushed. The pool must be created with #BLI_MEMPOOL_ALLOW_LOCAL.
+ */
+typedef struct BLI_mempool_local {
+	BLI_mempool *pool;
+	/* Free elements owned by this cache. */
+	void *free;
+	unsigned int free_len;
+} BLI_mempool_local;
+
+void  BLI_mempool_local_init(BLI_mempool *pool, BLI_mempool_local *local) ATTR_NONNULL();
+void *BLI_mempool_local_alloc(BLI_mempool_local *local) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+void *BLI_mempool_local_calloc(BLI_mempool_local *local) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+void  BLI_mempool_local_free(BLI_mempool_local *local, void *addr) ATTR_NONNULL(1, 2);
+void  BLI_mempool_local_flush(BLI_mempool_local *local) ATTR_NONNULL(1);
+
 #ifdef __cplusplus
 }
 #endif
@@ -42,7 +42,8 @@ struct BLI_mempool;
 /* Task Scheduler
  * 
  * Central scheduler that holds running threads ready to execute tasks. A single
- * queue holds the task from all pools.
+ * queue holds the task from all pools. With TASK_SCHEDULER_WORK_STEALING tasks
+ * pushed from worker threads are kept in per-thread deques instead.
  *
  * Init/exit must be called before/after any task pools are created/freed, and
  * must be called from the main threads. All other scheduler and pool functions
@@ -55,7 +56,16 @@ enum {
 	TASK_SCHEDULER_SINGLE_THREAD = 1
 };
 
+typedef enum eTaskSchedulerFlag {
+	/* Every worker thread gets its own lock-free deque. Tasks pushed from a
+	 * worker thread go to its deque, idle workers steal tasks from the other
+	 * deques instead of contending on the single global queue.
+	 */
+	TASK_SCHEDULER_WORK_STEALING = (1 << 0),
+} eTaskSchedulerFlag;
+
 TaskScheduler *BLI_task_scheduler_create(int num_threads);
+TaskScheduler *BLI_task_scheduler_create_ex(int num_threads, int flag);
 void BLI_task_scheduler_free(TaskScheduler *scheduler);
 
 int BLI_task_scheduler_num_threads(TaskScheduler *scheduler);
@@ -117,6 +127,29 @@ ThreadMutex *BLI_task_pool_user_mutex(TaskPool *pool);
 void BLI_task_pool_delayed_push_begin(TaskPool *pool, int thread_id);
 void BLI_task_pool_delayed_push_end(TaskPool *pool, int thread_id);
 
+/* Task Graph
+ *
+ * Nodes with dependencies between them. Node is scheduled as soon as all its
+ * predecessors are finished, one of the ready successors is executed directly
+ * by the thread which finished the node.
+ *
+ * Graph can be executed multiple times without being re-created, which makes
+ * it suitable for repetitive evaluation (e.g. every frame of an animation).
+ */
+
+typedef struct TaskGraph TaskGraph;
+typedef struct TaskNode TaskNode;
+typedef void (*TaskGraphNodeFreeFunction)(void *taskdata);
+
+TaskGraph *BLI_task_graph_create(void);
+void BLI_task_graph_free(TaskGraph *graph);
+TaskNode *BLI_task_graph_node_create(TaskGraph *graph,
+                                     TaskRunFunction run,
+                                     void *taskdata,
+                                     TaskGraphNodeFreeFunction free_taskdata);
+void BLI_task_graph_edge_create(TaskGraph *graph, TaskNode *from_node, TaskNode *to_node);
+void BLI_task_graph_work_and_wait(TaskGraph *graph, TaskScheduler *scheduler, void *userdata);
+
 /* Parallel for routines */
 
 typedef enum eTaskSchedulingMode {
@@ -131,6 +164,12 @@ typedef enum eTaskSchedulingMode {
 	 * part of the work requires totally different amount of compute power.
 	 */
 	TASK_SCHEDULING_DYNAMIC,
+	/* Task scheduler will schedule chunks proportional to the amount of work
+	 * which is left, decreasing down to min_iter_per_thread. Less overhead
+	 * than dynamic scheduling for big ranges, while still balancing the load
+	 * in the end of the range.
+	 */
+	TASK_SCHEDULING_GUIDED,
 } eTaskSchedulingMode;
 
 /* Per-thread specific data passed to the callback. */
@@ -148,6 +187,9 @@ typedef void (*TaskParallelRangeFunc)(void *__restrict userdata,
                                       const ParallelRangeTLS *__restrict tls);
 typedef void (*TaskParallelRangeFuncFinalize)(void *__restrict userdata,
                                               void *__restrict userdata_chunk);
+typedef void (*TaskParallelRangeFuncReduce)(void *__restrict userdata,
+                                            void *__restrict chunk_join,
+                                            void *__restrict chunk);
 
 typedef struct ParallelRangeSettings {
 	/* Whether caller allows to do threading of the particular range.
@@ -168,6 +210,15 @@ typedef struct ParallelRangeSettings {
 	 * processed.
 	 */
 	TaskParallelRangeFuncFinalize func_finalize;
+	/* Function called to join data of one chunk into another one. Chunks are
+	 * joined as a binary tree from worker threads in parallel, and the result
+	 * is finally joined into the original userdata_chunk.
+	 * Called before func_finalize, which is still called for every chunk
+	 * (including those which were joined into others).
+	 * NOTE: Every chunk starts as a copy of userdata_chunk, so it is expected
+	 * to hold identity of the reduction (i.e. zero for a sum).
+	 */
+	TaskParallelRangeFuncReduce func_reduce;
 	/* Minimum allowed number of range iterators to be handled by a single
 	 * thread. This allows to achieve following:
 	 * - Reduce amount of threading overhead.
@@ -179,6 +230,10 @@ typedef struct ParallelRangeSettings {
 	 * having a global use_threading switch based on just range size.
 	 */
 	int min_iter_per_thread;
+	/* Scheduler running the range, NULL for the global task scheduler.
+	 * Allows callers using their own number of threads to run ranges on them.
+	 */
+	TaskScheduler *scheduler;
 } ParallelRangeSettings;
 
 BLI_INLINE void BLI_parallel_range_settings_defaults(
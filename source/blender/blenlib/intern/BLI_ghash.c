@@ -31,6 +31,9 @@
  * A general (pointer -> pointer) chaining hash table
  * for 'Abstract Data Types' (known as an ADT Hash Table).
  *
+ * Optionally (#GHASH_FLAG_OPEN_ADDRESSING), entries can be stored in a flat array of slots
+ * using open addressing instead, see the 'Open Addressing' section below.
+ *
  * \note edgehash.c is based on this, make sure they stay in sync.
  */
 
@@ -121,10 +124,415 @@ struct GHash {
 
 	uint nentries;
 	uint flag;
+
+	/* Open addressing storage (#GHASH_FLAG_OPEN_ADDRESSING), 'nbuckets' is the number of slots. */
+	char *slots;
+	uint slot_size;
+	uint slot_bit, slot_bit_min;
 };
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Open Addressing Internal API
+ *
+ * Used instead of buckets when #GHASH_FLAG_OPEN_ADDRESSING is set.
+ *
+ * Entries are stored directly in a power of two sized array of slots, using linear probing
+ * with robin-hood insertion (an entry never stays further from its home slot than the one it
+ * would displace), and backward-shift deletion (no tombstones). Lookups can hence stop as soon
+ * as they meet an entry closer to its home slot than the probed distance.
+ *
+ * Slots have the same layout as #Entry/#GHashEntry, only the 'next' pointer is replaced by
+ * the scrambled hash of the key, so the inline iterator accessors from the header work as-is.
+ * Storing the hash also avoids calling the comparison callback on mismatches,
+ * and hashing keys again on resize.
+ * \{ */
+
+#define GHASH_OA_BIT_MIN 3
+#define GHASH_OA_BIT_MAX 30
+
+typedef struct OAEntry {
+	/* Zero for an empty slot, else #ghash_oa_hash of the key (always odd). */
+	uintptr_t hash;
+
+	void *key;
+} OAEntry;
+
+typedef struct OAGHashEntry {
+	OAEntry e;
+
+	void *val;
+} OAGHashEntry;
+
+BLI_STATIC_ASSERT(sizeof(OAEntry) == sizeof(Entry), "OAEntry must match Entry layout");
+BLI_STATIC_ASSERT(sizeof(OAGHashEntry) == sizeof(GHashEntry), "OAGHashEntry must match GHashEntry layout");
+
+/**
+ * Scramble the user hash (Fibonacci hashing), since we use its highest bits as slot index,
+ * and many of our hash functions are mere identities.
+ */
+BLI_INLINE uint ghash_oa_hash(GHash *gh, const void *key)
+{
+	return (gh->hashfp(key) * 2654435769u) | 1u;
+}
+
+BLI_INLINE uint ghash_oa_home_index(GHash *gh, const uint hash)
+{
+	return hash >> (32 - gh->slot_bit);
+}
+
+BLI_INLINE OAEntry *ghash_oa_slot(GHash *gh, const uint index)
+{
+	return (OAEntry *)(gh->slots + (size_t)index * gh->slot_size);
+}
+
+BLI_INLINE uint ghash_oa_slot_index(GHash *gh, const OAEntry *e)
+{
+	return (uint)((size_t)((const char *)e - gh->slots) / gh->slot_size);
+}
+
+BLI_INLINE void ghash_oa_entry_copy(GHash *gh, void *dst, const void *src)
+{
+	if (gh->flag & GHASH_FLAG_IS_GSET) {
+		*(OAEntry *)dst = *(const OAEntry *)src;
+	}
+	else {
+		*(OAGHashEntry *)dst = *(const OAGHashEntry *)src;
+	}
+}
+
+/**
+ * Distance from its home slot of the entry stored at \a index.
+ */
+BLI_INLINE uint ghash_oa_probe_dist(GHash *gh, const OAEntry *e, const uint index)
+{
+	return (index - ghash_oa_home_index(gh, (uint)e->hash)) & (gh->nbuckets - 1);
+}
+
+/**
+ * Store the content of \a e_src in the slots, there must be at least one free slot.
+ * \a e_src is used as scratch storage for displaced entries.
+ *
+ * \return the slot where the entry from \a e_src has been stored.
+ */
+static OAEntry *ghash_oa_place(GHash *gh, OAGHashEntry *e_src)
+{
+	const uint mask = gh->nbuckets - 1;
+	OAGHashEntry e_tmp;
+	OAEntry *e_ret = NULL;
+	uint index = ghash_oa_home_index(gh, (uint)e_src->e.hash);
+	uint dist = 0;
+
+	for (;; index = (index + 1) & mask, dist++) {
+		OAEntry *e = ghash_oa_slot(gh, index);
+		uint e_dist;
+
+		if (e->hash == 0) {
+			ghash_oa_entry_copy(gh, e, e_src);
+			return e_ret ? e_ret : e;
+		}
+
+		e_dist = ghash_oa_probe_dist(gh, e, index);
+		if (e_dist < dist) {
+			/* Take the slot of the 'richer' entry, and go on placing that one instead. */
+			ghash_oa_entry_copy(gh, &e_tmp, e);
+			ghash_oa_entry_copy(gh, e, e_src);
+			ghash_oa_entry_copy(gh, e_src, &e_tmp);
+			if (e_ret == NULL) {
+				e_ret = e;
+			}
+			dist = e_dist;
+		}
+	}
+}
+
+static void ghash_oa_resize(GHash *gh, const uint slot_bit)
+{
+	char *slots_old = gh->slots;
+	const uint nslots_old = gh->nbuckets;
+	const uint slot_size = gh->slot_size;
+	uint i;
+
+	BLI_assert((gh->slot_bit != slot_bit) || !gh->slots);
+
+	gh->slot_bit = slot_bit;
+	gh->nbuckets = 1u << slot_bit;
+	gh->limit_grow   = GHASH_LIMIT_GROW(gh->nbuckets);
+	gh->limit_shrink = GHASH_LIMIT_SHRINK(gh->nbuckets);
+	gh->slots = MEM_callocN((size_t)gh->nbuckets * slot_size, __func__);
+
+	if (slots_old) {
+		for (i = 0; i < nslots_old; i++) {
+			OAEntry *e = (OAEntry *)(slots_old + (size_t)i * slot_size);
+			if (e->hash != 0) {
+				OAGHashEntry e_tmp;
+				ghash_oa_entry_copy(gh, &e_tmp, e);
+				ghash_oa_place(gh, &e_tmp);
+			}
+		}
+		MEM_freeN(slots_old);
+	}
+}
+
+/**
+ * Open addressing counterpart of #ghash_buckets_expand.
+ *
+ * \note Unlike with buckets this has to be done before inserting, so slots never get full.
+ */
+static void ghash_oa_expand(GHash *gh, const uint nentries, const bool user_defined)
+{
+	uint slot_bit = gh->slot_bit;
+
+	if (LIKELY(gh->slots && (nentries <= gh->limit_grow) && !user_defined)) {
+		return;
+	}
+
+	while ((nentries > GHASH_LIMIT_GROW(1u << slot_bit)) &&
+	       (slot_bit < GHASH_OA_BIT_MAX))
+	{
+		slot_bit++;
+	}
+
+	if (user_defined) {
+		gh->slot_bit_min = slot_bit;
+	}
+
+	if ((slot_bit == gh->slot_bit) && gh->slots) {
+		return;
+	}
+
+	ghash_oa_resize(gh, slot_bit);
+}
+
+/**
+ * Open addressing counterpart of #ghash_buckets_contract.
+ */
+static void ghash_oa_contract(
+        GHash *gh, const uint nentries, const bool user_defined, const bool force_shrink)
+{
+	uint slot_bit = gh->slot_bit;
+
+	if (!(force_shrink || (gh->flag & GHASH_FLAG_ALLOW_SHRINK))) {
+		return;
+	}
+
+	if (LIKELY(gh->slots && (nentries > gh->limit_shrink))) {
+		return;
+	}
+
+	while ((nentries < GHASH_LIMIT_SHRINK(1u << slot_bit)) &&
+	       (slot_bit > gh->slot_bit_min))
+	{
+		slot_bit--;
+	}
+
+	if (user_defined) {
+		gh->slot_bit_min = slot_bit;
+	}
+
+	if ((slot_bit == gh->slot_bit) && gh->slots) {
+		return;
+	}
+
+	ghash_oa_resize(gh, slot_bit);
+}
+
+/**
+ * Clear and reset \a gh slots, reserve again slots for given number of entries.
+ */
+BLI_INLINE void ghash_oa_reset(GHash *gh, const uint nentries)
+{
+	MEM_SAFE_FREE(gh->slots);
+
+	gh->slot_bit = GHASH_OA_BIT_MIN;
+	gh->slot_bit_min = GHASH_OA_BIT_MIN;
+	gh->nbuckets = 1u << gh->slot_bit;
+	gh->limit_grow   = GHASH_LIMIT_GROW(gh->nbuckets);
+	gh->limit_shrink = GHASH_LIMIT_SHRINK(gh->nbuckets);
+
+	gh->nentries = 0;
+
+	ghash_oa_expand(gh, nentries, (nentries != 0));
+}
+
+/**
+ * Internal lookup function, \a hash is the result of #ghash_oa_hash for \a key.
+ */
+BLI_INLINE OAEntry *ghash_oa_lookup_ex(GHash *gh, const void *key, const uint hash)
+{
+	const uint mask = gh->nbuckets - 1;
+	uint index = ghash_oa_home_index(gh, hash);
+	uint dist = 0;
+
+	for (;; index = (index + 1) & mask, dist++) {
+		OAEntry *e = ghash_oa_slot(gh, index);
+		if ((e->hash == 0) || (ghash_oa_probe_dist(gh, e, index) < dist)) {
+			return NULL;
+		}
+		if ((e->hash == hash) && (gh->cmpfp(key, e->key) == false)) {
+			return e;
+		}
+	}
+}
+
+/**
+ * Insert a new entry (no check for existing key), \a val is ignored for GSet.
+ *
+ * \return the slot of the new entry, valid until next insertion or removal.
+ */
+BLI_INLINE OAEntry *ghash_oa_insert_ex(GHash *gh, void *key, void *val, const uint hash)
+{
+	OAGHashEntry e_new;
+
+	BLI_assert((gh->flag & GHASH_FLAG_ALLOW_DUPES) || (BLI_ghash_haskey(gh, key) == 0));
+
+	ghash_oa_expand(gh, gh->nentries + 1, false);
+
+	e_new.e.hash = hash;
+	e_new.e.key = key;
+	e_new.val = val;
+	gh->nentries++;
+
+	return ghash_oa_place(gh, &e_new);
+}
+
+/**
+ * Find \a key, inserting it if needed (value is left uninitialized then).
+ */
+BLI_INLINE OAEntry *ghash_oa_ensure(GHash *gh, void *key, bool *r_haskey)
+{
+	const uint hash = ghash_oa_hash(gh, key);
+	OAEntry *e = ghash_oa_lookup_ex(gh, key, hash);
+
+	*r_haskey = (e != NULL);
+	if (e == NULL) {
+		e = ghash_oa_insert_ex(gh, key, NULL, hash);
+	}
+	return e;
+}
+
+static bool ghash_oa_insert_safe(
+        GHash *gh, void *key, void *val, const bool override,
+        GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	const uint hash = ghash_oa_hash(gh, key);
+	OAEntry *e = ghash_oa_lookup_ex(gh, key, hash);
+
+	if (e) {
+		if (override) {
+			if (keyfreefp) {
+				keyfreefp(e->key);
+			}
+			e->key = key;
+			if ((gh->flag & GHASH_FLAG_IS_GSET) == 0) {
+				if (valfreefp) {
+					valfreefp(((OAGHashEntry *)e)->val);
+				}
+				((OAGHashEntry *)e)->val = val;
+			}
+		}
+		return false;
+	}
+	else {
+		ghash_oa_insert_ex(gh, key, val, hash);
+		return true;
+	}
+}
+
+/**
+ * Remove the entry stored at \a index, moving back following entries of the cluster.
+ */
+static void ghash_oa_remove_index(GHash *gh, uint index)
+{
+	const uint mask = gh->nbuckets - 1;
+	OAEntry *e = ghash_oa_slot(gh, index);
+
+	for (;;) {
+		const uint index_next = (index + 1) & mask;
+		OAEntry *e_next = ghash_oa_slot(gh, index_next);
+		if ((e_next->hash == 0) || (ghash_oa_probe_dist(gh, e_next, index_next) == 0)) {
+			break;
+		}
+		ghash_oa_entry_copy(gh, e, e_next);
+		e = e_next;
+		index = index_next;
+	}
+	e->hash = 0;
+	gh->nentries--;
+}
+
+/**
+ * Remove \a key, copying the removed entry into \a r_e if found.
+ */
+static bool ghash_oa_remove_ex(
+        GHash *gh, const void *key,
+        GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp,
+        OAGHashEntry *r_e)
+{
+	OAEntry *e = ghash_oa_lookup_ex(gh, key, ghash_oa_hash(gh, key));
+
+	BLI_assert(!valfreefp || !(gh->flag & GHASH_FLAG_IS_GSET));
+
+	if (e == NULL) {
+		return false;
+	}
+
+	if (keyfreefp) {
+		keyfreefp(e->key);
+	}
+	if (valfreefp) {
+		valfreefp(((OAGHashEntry *)e)->val);
+	}
+	ghash_oa_entry_copy(gh, r_e, e);
+
+	ghash_oa_remove_index(gh, ghash_oa_slot_index(gh, e));
+	ghash_oa_contract(gh, gh->nentries, false, false);
+	return true;
+}
+
+/**
+ * Remove a random entry, copying it into \a r_e, return false if empty.
+ */
+static bool ghash_oa_pop(GHash *gh, GHashIterState *state, OAGHashEntry *r_e)
+{
+	uint index = state->curr_bucket;
+
+	if (gh->nentries == 0) {
+		return false;
+	}
+
+	if (index >= gh->nbuckets) {
+		index = 0;
+	}
+	while (ghash_oa_slot(gh, index)->hash == 0) {
+		index = (index + 1) & (gh->nbuckets - 1);
+	}
+
+	ghash_oa_entry_copy(gh, r_e, ghash_oa_slot(gh, index));
+	ghash_oa_remove_index(gh, index);
+	ghash_oa_contract(gh, gh->nentries, false, false);
+
+	state->curr_bucket = index;
+	return true;
+}
+
+/**
+ * Find the first used slot from \a index (included), or NULL.
+ */
+BLI_INLINE Entry *ghash_oa_find_next_entry(GHash *gh, uint *index)
+{
+	for (; *index < gh->nbuckets; (*index)++) {
+		OAEntry *e = ghash_oa_slot(gh, *index);
+		if (e->hash != 0) {
+			return (Entry *)e;
+		}
+	}
+	return NULL;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Internal Utility API
  * \{ */
@@ -431,6 +839,10 @@ BLI_INLINE Entry *ghash_lookup_entry_prev_ex(
  */
 BLI_INLINE Entry *ghash_lookup_entry(GHash *gh, const void *key)
 {
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		return (Entry *)ghash_oa_lookup_ex(gh, key, ghash_oa_hash(gh, key));
+	}
+
 	const uint hash = ghash_keyhash(gh, key);
 	const uint bucket_index = ghash_bucket_index(gh, hash);
 	return ghash_lookup_entry_ex(gh, key, bucket_index);
@@ -446,10 +858,18 @@ static GHash *ghash_new(
 	gh->cmpfp = cmpfp;
 
 	gh->buckets = NULL;
+	gh->slots = NULL;
 	gh->flag = flag;
+	gh->slot_size = (uint)GHASH_ENTRY_SIZE(flag & GHASH_FLAG_IS_GSET);
 
-	ghash_buckets_reset(gh, nentries_reserve);
-	gh->entrypool = BLI_mempool_create(GHASH_ENTRY_SIZE(flag & GHASH_FLAG_IS_GSET), 64, 64, BLI_MEMPOOL_NOP);
+	if (flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		ghash_oa_reset(gh, nentries_reserve);
+		gh->entrypool = NULL;
+	}
+	else {
+		ghash_buckets_reset(gh, nentries_reserve);
+		gh->entrypool = BLI_mempool_create(gh->slot_size, 64, 64, BLI_MEMPOOL_NOP);
+	}
 
 	return gh;
 }
@@ -510,6 +930,11 @@ BLI_INLINE void ghash_insert_ex_keyonly(
 
 BLI_INLINE void ghash_insert(GHash *gh, void *key, void *val)
 {
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		ghash_oa_insert_ex(gh, key, val, ghash_oa_hash(gh, key));
+		return;
+	}
+
 	const uint hash = ghash_keyhash(gh, key);
 	const uint bucket_index = ghash_bucket_index(gh, hash);
 
@@ -520,12 +945,16 @@ BLI_INLINE bool ghash_insert_safe(
         GHash *gh, void *key, void *val, const bool override,
         GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
 {
+	BLI_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
+
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		return ghash_oa_insert_safe(gh, key, val, override, keyfreefp, valfreefp);
+	}
+
 	const uint hash = ghash_keyhash(gh, key);
 	const uint bucket_index = ghash_bucket_index(gh, hash);
 	GHashEntry *e = (GHashEntry *)ghash_lookup_entry_ex(gh, key, bucket_index);
 
-	BLI_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
-
 	if (e) {
 		if (override) {
 			if (keyfreefp) {
@@ -549,12 +978,16 @@ BLI_INLINE bool ghash_insert_safe_keyonly(
         GHash *gh, void *key, const bool override,
         GHashKeyFreeFP keyfreefp)
 {
+	BLI_assert((gh->flag & GHASH_FLAG_IS_GSET) != 0);
+
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		return ghash_oa_insert_safe(gh, key, NULL, override, keyfreefp, NULL);
+	}
+
 	const uint hash = ghash_keyhash(gh, key);
 	const uint bucket_index = ghash_bucket_index(gh, hash);
 	Entry *e = ghash_lookup_entry_ex(gh, key, bucket_index);
 
-	BLI_assert((gh->flag & GHASH_FLAG_IS_GSET) != 0);
-
 	if (e) {
 		if (override) {
 			if (keyfreefp) {
@@ -639,6 +1072,19 @@ static void ghash_free_cb(
 	BLI_assert(keyfreefp  || valfreefp);
 	BLI_assert(!valfreefp || !(gh->flag & GHASH_FLAG_IS_GSET));
 
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		i = 0;
+		for (Entry *e; (e = ghash_oa_find_next_entry(gh, &i)); i++) {
+			if (keyfreefp) {
+				keyfreefp(e->key);
+			}
+			if (valfreefp) {
+				valfreefp(((GHashEntry *)e)->val);
+			}
+		}
+		return;
+	}
+
 	for (i = 0; i < gh->nbuckets; i++) {
 		Entry *e;
 
@@ -666,6 +1112,23 @@ static GHash *ghash_copy(GHash *gh, GHashKeyCopyFP keycopyfp, GHashValCopyFP val
 	BLI_assert(!valcopyfp || !(gh->flag & GHASH_FLAG_IS_GSET));
 
 	gh_new = ghash_new(gh->hashfp, gh->cmpfp, __func__, 0, gh->flag);
+
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		/* Same number of slots, so entries can keep their position. */
+		if (gh_new->slot_bit != gh->slot_bit) {
+			ghash_oa_resize(gh_new, gh->slot_bit);
+		}
+		memcpy(gh_new->slots, gh->slots, (size_t)gh->nbuckets * gh->slot_size);
+		if (keycopyfp || valcopyfp) {
+			i = 0;
+			for (Entry *e; (e = ghash_oa_find_next_entry(gh_new, &i)); i++) {
+				ghash_entry_copy(gh_new, e, gh, e, keycopyfp, valcopyfp);
+			}
+		}
+		gh_new->nentries = gh->nentries;
+		return gh_new;
+	}
+
 	ghash_buckets_expand(gh_new, reserve_nentries_new, false);
 
 	BLI_assert(gh_new->nbuckets == gh->nbuckets);
@@ -714,6 +1177,19 @@ GHash *BLI_ghash_new_ex(
 	return ghash_new(hashfp, cmpfp, info, nentries_reserve, 0);
 }
 
+/**
+ * A version of #BLI_ghash_new_ex which takes creation flags.
+ *
+ * \param flag  Any of #GHASH_FLAG_ALLOW_DUPES, #GHASH_FLAG_ALLOW_SHRINK, #GHASH_FLAG_OPEN_ADDRESSING.
+ */
+GHash *BLI_ghash_new_flag_ex(
+        GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
+        const uint nentries_reserve, const uint flag)
+{
+	BLI_assert((flag & GHASH_FLAG_IS_GSET) == 0);
+	return ghash_new(hashfp, cmpfp, info, nentries_reserve, flag);
+}
+
 /**
  * Wraps #BLI_ghash_new_ex with zero entries reserved.
  */
@@ -735,6 +1211,11 @@ GHash *BLI_ghash_copy(GHash *gh, GHashKeyCopyFP keycopyfp, GHashValCopyFP valcop
  */
 void BLI_ghash_reserve(GHash *gh, const uint nentries_reserve)
 {
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		ghash_oa_expand(gh, nentries_reserve, true);
+		ghash_oa_contract(gh, nentries_reserve, true, false);
+		return;
+	}
 	ghash_buckets_expand(gh, nentries_reserve, true);
 	ghash_buckets_contract(gh, nentries_reserve, true, false);
 }
@@ -780,9 +1261,7 @@ bool BLI_ghash_reinsert(GHash *gh, void *key, void *val, GHashKeyFreeFP keyfreef
  */
 void *BLI_ghash_replace_key(GHash *gh, void *key)
 {
-	const uint hash = ghash_keyhash(gh, key);
-	const uint bucket_index = ghash_bucket_index(gh, hash);
-	GHashEntry *e = (GHashEntry *)ghash_lookup_entry_ex(gh, key, bucket_index);
+	GHashEntry *e = (GHashEntry *)ghash_lookup_entry(gh, key);
 	if (e != NULL) {
 		void *key_prev = e->e.key;
 		e->e.key = key;
@@ -828,6 +1307,8 @@ void *BLI_ghash_lookup_default(GHash *gh, const void *key, void *val_default)
  * \note This has 2 main benefits over #BLI_ghash_lookup.
  * - A NULL return always means that \a key isn't in \a gh.
  * - The value can be modified in-place without further function calls (faster).
+ *
+ * \warning With #GHASH_FLAG_OPEN_ADDRESSING the pointer is only valid until next insertion or removal.
  */
 void **BLI_ghash_lookup_p(GHash *gh, const void *key)
 {
@@ -849,9 +1330,18 @@ void **BLI_ghash_lookup_p(GHash *gh, const void *key)
  *
  * \returns true when the value didn't need to be added.
  * (when false, the caller _must_ initialize the value).
+ *
+ * \warning With #GHASH_FLAG_OPEN_ADDRESSING the pointer is only valid until next insertion or removal.
  */
 bool BLI_ghash_ensure_p(GHash *gh, void *key, void ***r_val)
 {
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		bool haskey;
+		OAGHashEntry *e = (OAGHashEntry *)ghash_oa_ensure(gh, key, &haskey);
+		*r_val = &e->val;
+		return haskey;
+	}
+
 	const uint hash = ghash_keyhash(gh, key);
 	const uint bucket_index = ghash_bucket_index(gh, hash);
 	GHashEntry *e = (GHashEntry *)ghash_lookup_entry_ex(gh, key, bucket_index);
@@ -875,6 +1365,17 @@ bool BLI_ghash_ensure_p(GHash *gh, void *key, void ***r_val)
 bool BLI_ghash_ensure_p_ex(
         GHash *gh, const void *key, void ***r_key, void ***r_val)
 {
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		bool haskey;
+		OAGHashEntry *e = (OAGHashEntry *)ghash_oa_ensure(gh, (void *)key, &haskey);
+		if (!haskey) {
+			e->e.key = NULL;  /* caller must re-assign */
+		}
+		*r_key = &e->e.key;
+		*r_val = &e->val;
+		return haskey;
+	}
+
 	const uint hash = ghash_keyhash(gh, key);
 	const uint bucket_index = ghash_bucket_index(gh, hash);
 	GHashEntry *e = (GHashEntry *)ghash_lookup_entry_ex(gh, key, bucket_index);
@@ -902,6 +1403,11 @@ bool BLI_ghash_ensure_p_ex(
  */
 bool BLI_ghash_remove(GHash *gh, const void *key, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
 {
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		OAGHashEntry e_removed;
+		return ghash_oa_remove_ex(gh, key, keyfreefp, valfreefp, &e_removed);
+	}
+
 	const uint hash = ghash_keyhash(gh, key);
 	const uint bucket_index = ghash_bucket_index(gh, hash);
 	Entry *e = ghash_remove_ex(gh, key, keyfreefp, valfreefp, bucket_index);
@@ -925,6 +1431,12 @@ bool BLI_ghash_remove(GHash *gh, const void *key, GHashKeyFreeFP keyfreefp, GHas
  */
 void *BLI_ghash_popkey(GHash *gh, const void *key, GHashKeyFreeFP keyfreefp)
 {
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		OAGHashEntry e_removed;
+		BLI_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
+		return ghash_oa_remove_ex(gh, key, keyfreefp, NULL, &e_removed) ? e_removed.val : NULL;
+	}
+
 	const uint hash = ghash_keyhash(gh, key);
 	const uint bucket_index = ghash_bucket_index(gh, hash);
 	GHashEntry *e = (GHashEntry *)ghash_remove_ex(gh, key, keyfreefp, NULL, bucket_index);
@@ -959,10 +1471,21 @@ bool BLI_ghash_pop(
         GHash *gh, GHashIterState *state,
         void **r_key, void **r_val)
 {
-	GHashEntry *e = (GHashEntry *)ghash_pop(gh, state);
-
 	BLI_assert(!(gh->flag & GHASH_FLAG_IS_GSET));
 
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		OAGHashEntry e_removed;
+		if (ghash_oa_pop(gh, state, &e_removed)) {
+			*r_key = e_removed.e.key;
+			*r_val = e_removed.val;
+			return true;
+		}
+		*r_key = *r_val = NULL;
+		return false;
+	}
+
+	GHashEntry *e = (GHashEntry *)ghash_pop(gh, state);
+
 	if (e) {
 		*r_key = e->e.key;
 		*r_val = e->val;
@@ -990,6 +1513,11 @@ void BLI_ghash_clear_ex(
 	if (keyfreefp || valfreefp)
 		ghash_free_cb(gh, keyfreefp, valfreefp);
 
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		ghash_oa_reset(gh, nentries_reserve);
+		return;
+	}
+
 	ghash_buckets_reset(gh, nentries_reserve);
 	BLI_mempool_clear_ex(gh->entrypool, nentries_reserve ? (int)nentries_reserve : -1);
 }
@@ -1011,12 +1539,17 @@ void BLI_ghash_clear(GHash *gh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfree
  */
 void BLI_ghash_free(GHash *gh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
 {
-	BLI_assert((int)gh->nentries == BLI_mempool_len(gh->entrypool));
+	BLI_assert(!gh->entrypool || (int)gh->nentries == BLI_mempool_len(gh->entrypool));
 	if (keyfreefp || valfreefp)
 		ghash_free_cb(gh, keyfreefp, valfreefp);
 
-	MEM_freeN(gh->buckets);
-	BLI_mempool_destroy(gh->entrypool);
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		MEM_freeN(gh->slots);
+	}
+	else {
+		MEM_freeN(gh->buckets);
+		BLI_mempool_destroy(gh->entrypool);
+	}
 	MEM_freeN(gh);
 }
 
@@ -1025,6 +1558,7 @@ void BLI_ghash_free(GHash *gh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreef
  */
 void BLI_ghash_flag_set(GHash *gh, uint flag)
 {
+	BLI_assert((flag & GHASH_FLAG_OPEN_ADDRESSING) == 0);
 	gh->flag |= flag;
 }
 
@@ -1033,6 +1567,7 @@ void BLI_ghash_flag_set(GHash *gh, uint flag)
  */
 void BLI_ghash_flag_clear(GHash *gh, uint flag)
 {
+	BLI_assert((flag & GHASH_FLAG_OPEN_ADDRESSING) == 0);
 	gh->flag &= ~flag;
 }
 
@@ -1069,6 +1604,13 @@ void BLI_ghashIterator_init(GHashIterator *ghi, GHash *gh)
 {
 	ghi->gh = gh;
 	ghi->curEntry = NULL;
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		ghi->curBucket = 0;
+		if (gh->nentries) {
+			ghi->curEntry = ghash_oa_find_next_entry(gh, &ghi->curBucket);
+		}
+		return;
+	}
 	ghi->curBucket = UINT_MAX;  /* wraps to zero */
 	if (gh->nentries) {
 		do {
@@ -1087,7 +1629,11 @@ void BLI_ghashIterator_init(GHashIterator *ghi, GHash *gh)
  */
 void BLI_ghashIterator_step(GHashIterator *ghi)
 {
-	if (ghi->curEntry) {
+	if (ghi->curEntry && (ghi->gh->flag & GHASH_FLAG_OPEN_ADDRESSING)) {
+		ghi->curBucket++;
+		ghi->curEntry = ghash_oa_find_next_entry(ghi->gh, &ghi->curBucket);
+	}
+	else if (ghi->curEntry) {
 		ghi->curEntry = ghi->curEntry->next;
 		while (!ghi->curEntry) {
 			ghi->curBucket++;
@@ -1173,6 +1719,17 @@ GSet *BLI_gset_new_ex(
 	return (GSet *)ghash_new(hashfp, cmpfp, info, nentries_reserve, GHASH_FLAG_IS_GSET);
 }
 
+/**
+ * A version of #BLI_gset_new_ex which takes creation flags, see #BLI_ghash_new_flag_ex.
+ */
+GSet *BLI_gset_new_flag_ex(
+        GSetHashFP hashfp, GSetCmpFP cmpfp, const char *info,
+        const uint nentries_reserve, const uint flag)
+{
+	BLI_assert((flag & GHASH_FLAG_IS_GSET) == 0);
+	return (GSet *)ghash_new(hashfp, cmpfp, info, nentries_reserve, flag | GHASH_FLAG_IS_GSET);
+}
+
 GSet *BLI_gset_new(GSetHashFP hashfp, GSetCmpFP cmpfp, const char *info)
 {
 	return BLI_gset_new_ex(hashfp, cmpfp, info, 0);
@@ -1197,6 +1754,11 @@ uint BLI_gset_len(GSet *gs)
  */
 void BLI_gset_insert(GSet *gs, void *key)
 {
+	if (((GHash *)gs)->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		ghash_oa_insert_ex((GHash *)gs, key, NULL, ghash_oa_hash((GHash *)gs, key));
+		return;
+	}
+
 	const uint hash = ghash_keyhash((GHash *)gs, key);
 	const uint bucket_index = ghash_bucket_index((GHash *)gs, hash);
 	ghash_insert_ex_keyonly((GHash *)gs, key, bucket_index);
@@ -1221,6 +1783,16 @@ bool BLI_gset_add(GSet *gs, void *key)
  */
 bool BLI_gset_ensure_p_ex(GSet *gs, const void *key, void ***r_key)
 {
+	if (((GHash *)gs)->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		bool haskey;
+		OAEntry *e = ghash_oa_ensure((GHash *)gs, (void *)key, &haskey);
+		if (!haskey) {
+			e->key = NULL;  /* caller must re-assign */
+		}
+		*r_key = &e->key;
+		return haskey;
+	}
+
 	const uint hash = ghash_keyhash((GHash *)gs, key);
 	const uint bucket_index = ghash_bucket_index((GHash *)gs, hash);
 	GSetEntry *e = (GSetEntry *)ghash_lookup_entry_ex((GHash *)gs, key, bucket_index);
@@ -1282,6 +1854,16 @@ bool BLI_gset_pop(
         GSet *gs, GSetIterState *state,
         void **r_key)
 {
+	if (((GHash *)gs)->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		OAGHashEntry e_removed;
+		if (ghash_oa_pop((GHash *)gs, (GHashIterState *)state, &e_removed)) {
+			*r_key = e_removed.e.key;
+			return true;
+		}
+		*r_key = NULL;
+		return false;
+	}
+
 	GSetEntry *e = (GSetEntry *)ghash_pop((GHash *)gs, (GHashIterState *)state);
 
 	if (e) {
@@ -1317,12 +1899,12 @@ void BLI_gset_free(GSet *gs, GSetKeyFreeFP keyfreefp)
 
 void BLI_gset_flag_set(GSet *gs, uint flag)
 {
-	((GHash *)gs)->flag |= flag;
+	BLI_ghash_flag_set((GHash *)gs, flag);
 }
 
 void BLI_gset_flag_clear(GSet *gs, uint flag)
 {
-	((GHash *)gs)->flag &= ~flag;
+	BLI_ghash_flag_clear((GHash *)gs, flag);
 }
 
 /** \} */
@@ -1349,6 +1931,11 @@ void *BLI_gset_lookup(GSet *gs, const void *key)
  */
 void *BLI_gset_pop_key(GSet *gs, const void *key)
 {
+	if (((GHash *)gs)->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		OAGHashEntry e_removed;
+		return ghash_oa_remove_ex((GHash *)gs, key, NULL, NULL, &e_removed) ? e_removed.e.key : NULL;
+	}
+
 	const uint hash = ghash_keyhash((GHash *)gs, key);
 	const uint bucket_index = ghash_bucket_index((GHash *)gs, hash);
 	Entry *e = ghash_remove_ex((GHash *)gs, key, NULL, NULL, bucket_index);
@@ -1364,6 +1951,58 @@ void *BLI_gset_pop_key(GSet *gs, const void *key)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Internal Hashed Key API
+ *
+ * Versions of the functions above taking the hash of \a key, as returned by the hash function of \a gh,
+ * for callers which already hashed it (see ``BLI_ghash_concurrent.c``). Only for chained storage.
+ * \{ */
+
+void BLI_ghash_insert_with_hash(GHash *gh, void *key, void *val, const uint hash)
+{
+	BLI_assert(!(gh->flag & GHASH_FLAG_OPEN_ADDRESSING));
+	ghash_insert_ex(gh, key, val, ghash_bucket_index(gh, hash));
+}
+
+void **BLI_ghash_lookup_p_with_hash(GHash *gh, const void *key, const uint hash)
+{
+	BLI_assert(!(gh->flag & (GHASH_FLAG_OPEN_ADDRESSING | GHASH_FLAG_IS_GSET)));
+	GHashEntry *e = (GHashEntry *)ghash_lookup_entry_ex(gh, key, ghash_bucket_index(gh, hash));
+	return e ? &e->val : NULL;
+}
+
+bool BLI_ghash_ensure_p_with_hash(GHash *gh, void *key, const uint hash, void ***r_val)
+{
+	BLI_assert(!(gh->flag & GHASH_FLAG_OPEN_ADDRESSING));
+	const uint bucket_index = ghash_bucket_index(gh, hash);
+	GHashEntry *e = (GHashEntry *)ghash_lookup_entry_ex(gh, key, bucket_index);
+	const bool haskey = (e != NULL);
+
+	if (!haskey) {
+		e = BLI_mempool_alloc(gh->entrypool);
+		ghash_insert_ex_keyonly_entry(gh, key, bucket_index, (Entry *)e);
+	}
+
+	*r_val = &e->val;
+	return haskey;
+}
+
+bool BLI_ghash_remove_with_hash(
+        GHash *gh, const void *key, const uint hash, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	BLI_assert(!(gh->flag & GHASH_FLAG_OPEN_ADDRESSING));
+	Entry *e = ghash_remove_ex(gh, key, keyfreefp, valfreefp, ghash_bucket_index(gh, hash));
+	if (e) {
+		BLI_mempool_free(gh->entrypool, e);
+		return true;
+	}
+	else {
+		return false;
+	}
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name Debugging & Introspection
  * \{ */
@@ -1382,6 +2021,52 @@ int BLI_gset_buckets_len(GSet *gs)
 	return BLI_ghash_buckets_len((GHash *)gs);
 }
 
+/**
+ * Open addressing version of #BLI_ghash_calc_quality_ex, based on probe lengths instead of buckets sizes:
+ * returns the average number of slots visited to find an entry (1.0 is perfect),
+ * variance and biggest bucket are those of the probe lengths,
+ * overloaded slots are the ones holding an entry not in its home slot.
+ */
+static double ghash_oa_calc_quality_ex(
+        GHash *gh, double *r_load, double *r_variance,
+        double *r_prop_empty_buckets, double *r_prop_overloaded_buckets, int *r_biggest_bucket)
+{
+	uint64_t sum = 0, sum_overloaded = 0;
+	double mean, sum_sq = 0.0;
+	int biggest = 0;
+	uint i = 0;
+
+	for (Entry *e; (e = ghash_oa_find_next_entry(gh, &i)); i++) {
+		const uint probe_len = ghash_oa_probe_dist(gh, (OAEntry *)e, i) + 1;
+		sum += probe_len;
+		sum_overloaded += (probe_len > 1);
+		biggest = max_ii(biggest, (int)probe_len);
+	}
+	mean = (double)sum / (double)gh->nentries;
+
+	if (r_variance) {
+		i = 0;
+		for (Entry *e; (e = ghash_oa_find_next_entry(gh, &i)); i++) {
+			const double probe_len = (double)(ghash_oa_probe_dist(gh, (OAEntry *)e, i) + 1);
+			sum_sq += (probe_len - mean) * (probe_len - mean);
+		}
+		*r_variance = (gh->nentries > 1) ? sum_sq / (double)(gh->nentries - 1) : 0.0;
+	}
+	if (r_load) {
+		*r_load = (double)gh->nentries / (double)gh->nbuckets;
+	}
+	if (r_prop_empty_buckets) {
+		*r_prop_empty_buckets = (double)(gh->nbuckets - gh->nentries) / (double)gh->nbuckets;
+	}
+	if (r_prop_overloaded_buckets) {
+		*r_prop_overloaded_buckets = (double)sum_overloaded / (double)gh->nbuckets;
+	}
+	if (r_biggest_bucket) {
+		*r_biggest_bucket = biggest;
+	}
+	return mean;
+}
+
 /**
  * Measure how well the hash function performs (1.0 is approx as good as random distribution),
  * and return a few other stats like load, variance of the distribution of the entries in the buckets, etc.
@@ -1415,6 +2100,11 @@ double BLI_ghash_calc_quality_ex(
 		return 0.0;
 	}
 
+	if (gh->flag & GHASH_FLAG_OPEN_ADDRESSING) {
+		return ghash_oa_calc_quality_ex(
+		        gh, r_load, r_variance, r_prop_empty_buckets, r_prop_overloaded_buckets, r_biggest_bucket);
+	}
+
 	mean = (double)gh->nentries / (double)gh->nbuckets;
 	if (r_load) {
 		*r_load = mean;
@@ -0,0 +1,263 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenlib/intern/BLI_ghash_concurrent.c
+ *  \ingroup bli
+ *
+ * A #GHash which can be filled and queried from several threads at once.
+ *
+ * Entries are spread over shards using the highest bits of the scrambled hash,
+ * each shard being a regular GHash protected by its own mutex, so threads only
+ * wait on each other when they access the same shard at the same time.
+ *
+ * Shards always use chained storage, its entries never move in memory,
+ * so pointers returned by #BLI_ghash_concurrent_ensure_p stay valid.
+ *
+ * \note Kept apart from ``BLI_ghash.c``, which makesdna and makesrna build without threads.
+ */
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_threads.h"
+
+#define GHASH_INTERNAL_API
+#include "BLI_ghash.h"  /* own include */
+
+#include "BLI_strict_flags.h"
+
+#define GHASH_CONCURRENT_SHARD_BIT_MIN 4
+#define GHASH_CONCURRENT_SHARD_BIT_MAX 10
+
+typedef struct GHashConcurrentShard {
+	ThreadMutex lock;
+	GHash *gh;
+	/* Avoid false sharing between locks of neighbor shards. */
+	char _pad[64];
+} GHashConcurrentShard;
+
+struct GHashConcurrent {
+	GHashHashFP hashfp;
+	GHashCmpFP cmpfp;
+
+	GHashConcurrentShard *shards;
+	uint shard_bit;
+};
+
+BLI_INLINE GHashConcurrentShard *ghash_concurrent_shard(GHashConcurrent *cgh, const uint hash)
+{
+	return &cgh->shards[(hash * 2654435769u) >> (32 - cgh->shard_bit)];
+}
+
+/**
+ * Creates a new, empty concurrent GHash.
+ * Parameters are the same as for #BLI_ghash_new_ex.
+ */
+GHashConcurrent *BLI_ghash_concurrent_new(
+        GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
+        const uint nentries_reserve)
+{
+	GHashConcurrent *cgh = MEM_mallocN(sizeof(*cgh), info);
+	/* Enough shards to make contention unlikely. */
+	const uint nshards_min = 4 * (uint)BLI_system_thread_count();
+	uint shard_bit = GHASH_CONCURRENT_SHARD_BIT_MIN;
+	uint nshards, i;
+
+	while (((1u << shard_bit) < nshards_min) && (shard_bit < GHASH_CONCURRENT_SHARD_BIT_MAX)) {
+		shard_bit++;
+	}
+	nshards = 1u << shard_bit;
+
+	cgh->hashfp = hashfp;
+	cgh->cmpfp = cmpfp;
+	cgh->shard_bit = shard_bit;
+	cgh->shards = MEM_mallocN(sizeof(*cgh->shards) * nshards, info);
+
+	for (i = 0; i < nshards; i++) {
+		BLI_mutex_init(&cgh->shards[i].lock);
+		cgh->shards[i].gh = BLI_ghash_new_ex(hashfp, cmpfp, info, nentries_reserve / nshards);
+	}
+
+	return cgh;
+}
+
+/**
+ * Frees the concurrent GHash and its members, must not be used by other threads anymore.
+ */
+void BLI_ghash_concurrent_free(GHashConcurrent *cgh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	const uint nshards = 1u << cgh->shard_bit;
+	uint i;
+
+	for (i = 0; i < nshards; i++) {
+		BLI_ghash_free(cgh->shards[i].gh, keyfreefp, valfreefp);
+		BLI_mutex_end(&cgh->shards[i].lock);
+	}
+	MEM_freeN(cgh->shards);
+	MEM_freeN(cgh);
+}
+
+/**
+ * Thread-safe version of #BLI_ghash_insert, the caller is expected to ensure keys are unique.
+ */
+void BLI_ghash_concurrent_insert(GHashConcurrent *cgh, void *key, void *val)
+{
+	const uint hash = cgh->hashfp(key);
+	GHashConcurrentShard *shard = ghash_concurrent_shard(cgh, hash);
+
+	BLI_mutex_lock(&shard->lock);
+	BLI_ghash_insert_with_hash(shard->gh, key, val, hash);
+	BLI_mutex_unlock(&shard->lock);
+}
+
+/**
+ * Thread-safe version of #BLI_ghash_lookup.
+ */
+void *BLI_ghash_concurrent_lookup(GHashConcurrent *cgh, const void *key)
+{
+	const uint hash = cgh->hashfp(key);
+	GHashConcurrentShard *shard = ghash_concurrent_shard(cgh, hash);
+	void **val_p;
+	void *val;
+
+	BLI_mutex_lock(&shard->lock);
+	val_p = BLI_ghash_lookup_p_with_hash(shard->gh, key, hash);
+	val = val_p ? *val_p : NULL;
+	BLI_mutex_unlock(&shard->lock);
+
+	return val;
+}
+
+/**
+ * Thread-safe version of #BLI_ghash_haskey.
+ */
+bool BLI_ghash_concurrent_haskey(GHashConcurrent *cgh, const void *key)
+{
+	const uint hash = cgh->hashfp(key);
+	GHashConcurrentShard *shard = ghash_concurrent_shard(cgh, hash);
+	bool haskey;
+
+	BLI_mutex_lock(&shard->lock);
+	haskey = (BLI_ghash_lookup_p_with_hash(shard->gh, key, hash) != NULL);
+	BLI_mutex_unlock(&shard->lock);
+
+	return haskey;
+}
+
+/**
+ * Thread-safe version of #BLI_ghash_ensure_p.
+ *
+ * Only one of the threads ensuring the same key gets false as return value
+ * (and _must_ initialize the value then).
+ *
+ * \warning The value is NULL until initialized by that thread, other threads may see it in that state,
+ * use #BLI_ghash_concurrent_ensure when they need to get the initialized value.
+ */
+bool BLI_ghash_concurrent_ensure_p(GHashConcurrent *cgh, void *key, void ***r_val)
+{
+	const uint hash = cgh->hashfp(key);
+	GHashConcurrentShard *shard = ghash_concurrent_shard(cgh, hash);
+	bool haskey;
+
+	BLI_mutex_lock(&shard->lock);
+	haskey = BLI_ghash_ensure_p_with_hash(shard->gh, key, hash, r_val);
+	if (!haskey) {
+		**r_val = NULL;
+	}
+	BLI_mutex_unlock(&shard->lock);
+
+	return haskey;
+}
+
+/**
+ * Return the value of \a key, creating it with \a createfp if it's not in \a cgh yet.
+ *
+ * Unlike #BLI_ghash_concurrent_ensure_p, the value is created while the shard is locked,
+ * so all threads get the initialized value. \a createfp is expected to be quick, since it blocks
+ * other threads accessing the same shard.
+ */
+void *BLI_ghash_concurrent_ensure(
+        GHashConcurrent *cgh, void *key, GHashValCreateFP createfp, void *userdata)
+{
+	const uint hash = cgh->hashfp(key);
+	GHashConcurrentShard *shard = ghash_concurrent_shard(cgh, hash);
+	void **val_p;
+	void *val;
+
+	BLI_mutex_lock(&shard->lock);
+	if (!BLI_ghash_ensure_p_with_hash(shard->gh, key, hash, &val_p)) {
+		*val_p = createfp(key, userdata);
+	}
+	val = *val_p;
+	BLI_mutex_unlock(&shard->lock);
+
+	return val;
+}
+
+/**
+ * Thread-safe version of #BLI_ghash_remove.
+ */
+bool BLI_ghash_concurrent_remove(
+        GHashConcurrent *cgh, const void *key, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	const uint hash = cgh->hashfp(key);
+	GHashConcurrentShard *shard = ghash_concurrent_shard(cgh, hash);
+	bool removed;
+
+	BLI_mutex_lock(&shard->lock);
+	removed = BLI_ghash_remove_with_hash(shard->gh, key, hash, keyfreefp, valfreefp);
+	BLI_mutex_unlock(&shard->lock);
+
+	return removed;
+}
+
+/**
+ * \return size of the concurrent GHash, only exact when no other thread modifies it.
+ */
+uint BLI_ghash_concurrent_len(GHashConcurrent *cgh)
+{
+	const uint nshards = 1u << cgh->shard_bit;
+	uint i, nentries = 0;
+
+	for (i = 0; i < nshards; i++) {
+		nentries += BLI_ghash_len(cgh->shards[i].gh);
+	}
+	return nentries;
+}
+
+/**
+ * Move all entries into a regular GHash (e.g. once parallel filling is done), freeing \a cgh.
+ */
+GHash *BLI_ghash_concurrent_to_ghash(GHashConcurrent *cgh, const char *info)
+{
+	GHash *gh = BLI_ghash_new_ex(cgh->hashfp, cgh->cmpfp, info, BLI_ghash_concurrent_len(cgh));
+	const uint nshards = 1u << cgh->shard_bit;
+	uint i;
+
+	for (i = 0; i < nshards; i++) {
+		GHashIterator gh_iter;
+		GHASH_ITER (gh_iter, cgh->shards[i].gh) {
+			BLI_ghash_insert(gh, BLI_ghashIterator_getKey(&gh_iter), BLI_ghashIterator_getValue(&gh_iter));
+		}
+	}
+
+	BLI_ghash_concurrent_free(cgh, NULL, NULL);
+	return gh;
+}
@@ -162,6 +162,46 @@ void *BLI_memarena_calloc(MemArena *ma, size_t size)
 	return ptr;
 }
 
+/**
+ * Move all memory of \a ma_src into \a ma_dst, so it's freed along with \a ma_dst.
+ * \a ma_src is left empty, and can still be used.
+ *
+ * Allows each thread of a parallel section to use its own arena (e.g. stored in
+ * #ParallelRangeSettings.userdata_chunk, created on first use), merging them all into a single
+ * arena when done (e.g. from #ParallelRangeSettings.func_reduce).
+ */
+void BLI_memarena_merge(MemArena *ma_dst, MemArena *ma_src)
+{
+	BLI_assert(ma_dst != ma_src);
+
+	if (ma_src->bufs == NULL) {
+		return;
+	}
+
+	if (ma_dst->bufs == NULL) {
+		/* Continue allocating from the current buffer of the source. */
+		unsigned char *curbuf = (unsigned char *)PADUP((intptr_t)ma_src->curbuf, (int)ma_dst->align);
+		const size_t offset = (size_t)(curbuf - ma_src->curbuf);
+
+		ma_dst->bufs = ma_src->bufs;
+		ma_dst->curbuf = curbuf;
+		ma_dst->cursize = (ma_src->cursize > offset) ? ma_src->cursize - offset : 0;
+	}
+	else {
+		/* Keep the current buffer of the destination first, it's the one kept by #BLI_memarena_clear. */
+		LinkNode *buf_last = ma_src->bufs;
+		while (buf_last->next) {
+			buf_last = buf_last->next;
+		}
+		buf_last->next = ma_dst->bufs->next;
+		ma_dst->bufs->next = ma_src->bufs;
+	}
+
+	ma_src->bufs = NULL;
+	ma_src->curbuf = NULL;
+	ma_src->cursize = 0;
+}
+
 /**
  * Clear for reuse, avoids re-allocation when an arena may
  * otherwise be free'd and recreated.
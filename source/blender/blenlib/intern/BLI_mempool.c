@@ -36,6 +36,8 @@
  * - Freeing chunks.
  * - Iterating over allocated chunks
  *   (optionally when using the #BLI_MEMPOOL_ALLOW_ITER flag).
+ * - Allocating and freeing from multiple threads at once, using a #BLI_mempool_local per thread
+ *   (when using the #BLI_MEMPOOL_ALLOW_LOCAL flag).
  */
 
 #include <string.h>
@@ -44,6 +46,9 @@
 #include "atomic_ops.h"
 
 #include "BLI_utildefines.h"
+#ifdef WITH_MEMPOOL_LOCAL
+#  include "BLI_threads.h"
+#endif
 
 #include "BLI_mempool.h" /* own include */
 
@@ -141,6 +146,12 @@ struct BLI_mempool {
 #ifdef USE_TOTALLOC
 	uint totalloc;          /* number of elements allocated in total */
 #endif
+
+#ifdef WITH_MEMPOOL_LOCAL
+	/* Protects chunks, free list and counters when used through #BLI_mempool_local,
+	 * only initialized with #BLI_MEMPOOL_ALLOW_LOCAL. */
+	SpinLock lock;
+#endif
 };
 
 #define MEMPOOL_ELEM_SIZE_MIN (sizeof(void *) * 2)
@@ -208,22 +219,10 @@ static BLI_mempool_chunk *mempool_chunk_alloc(BLI_mempool *pool)
 }
 
 /**
- * Initialize a chunk and add into \a pool->chunks
- *
- * \param pool  The pool to add the chunk into.
- * \param mpchunk  The new uninitialized chunk (can be malloc'd)
- * \param lasttail  The last element of the previous chunk
- * (used when building free chunks initially)
- * \return The last chunk,
+ * Append \a mpchunk at the end of \a pool->chunks.
  */
-static BLI_freenode *mempool_chunk_add(BLI_mempool *pool, BLI_mempool_chunk *mpchunk,
-                                       BLI_freenode *lasttail)
+static void mempool_chunk_append(BLI_mempool *pool, BLI_mempool_chunk *mpchunk)
 {
-	const uint esize = pool->esize;
-	BLI_freenode *curnode = CHUNK_DATA(mpchunk);
-	uint j;
-
-	/* append */
 	if (pool->chunk_tail) {
 		pool->chunk_tail->next = mpchunk;
 	}
@@ -235,9 +234,21 @@ static BLI_freenode *mempool_chunk_add(BLI_mempool *pool, BLI_mempool_chunk *mpc
 	mpchunk->next = NULL;
 	pool->chunk_tail = mpchunk;
 
-	if (UNLIKELY(pool->free == NULL)) {
-		pool->free = curnode;
-	}
+#ifdef USE_TOTALLOC
+	pool->totalloc += pool->pchunk;
+#endif
+}
+
+/**
+ * Link all elements of \a mpchunk as a list of free elements (not touching \a pool).
+ *
+ * \return The last element of the chunk, terminating the list.
+ */
+static BLI_freenode *mempool_chunk_nodes_init(BLI_mempool *pool, BLI_mempool_chunk *mpchunk)
+{
+	const uint esize = pool->esize;
+	BLI_freenode *curnode = CHUNK_DATA(mpchunk);
+	uint j;
 
 	/* loop through the allocated data, building the pointer structures */
 	j = pool->pchunk;
@@ -260,9 +271,30 @@ static BLI_freenode *mempool_chunk_add(BLI_mempool *pool, BLI_mempool_chunk *mpc
 	curnode = NODE_STEP_PREV(curnode);
 	curnode->next = NULL;
 
-#ifdef USE_TOTALLOC
-	pool->totalloc += pool->pchunk;
-#endif
+	return curnode;
+}
+
+/**
+ * Initialize a chunk and add into \a pool->chunks
+ *
+ * \param pool  The pool to add the chunk into.
+ * \param mpchunk  The new uninitialized chunk (can be malloc'd)
+ * \param lasttail  The last element of the previous chunk
+ * (used when building free chunks initially)
+ * \return The last chunk,
+ */
+static BLI_freenode *mempool_chunk_add(BLI_mempool *pool, BLI_mempool_chunk *mpchunk,
+                                       BLI_freenode *lasttail)
+{
+	BLI_freenode *curnode;
+
+	mempool_chunk_append(pool, mpchunk);
+
+	if (UNLIKELY(pool->free == NULL)) {
+		pool->free = CHUNK_DATA(mpchunk);
+	}
+
+	curnode = mempool_chunk_nodes_init(pool, mpchunk);
 
 	/* final pointer in the previously allocated chunk is wrong */
 	if (lasttail) {
@@ -336,6 +368,13 @@ BLI_mempool *BLI_mempool_create(uint esize, uint totelem,
 	pool->totalloc = 0;
 #endif
 	pool->totused = 0;
+#ifdef WITH_MEMPOOL_LOCAL
+	if (flag & BLI_MEMPOOL_ALLOW_LOCAL) {
+		BLI_spin_init(&pool->lock);
+	}
+#else
+	BLI_assert(!(flag & BLI_MEMPOOL_ALLOW_LOCAL));
+#endif
 
 	if (totelem) {
 		/* allocate the actual chunks */
@@ -474,6 +513,187 @@ void BLI_mempool_free(BLI_mempool *pool, void *addr)
 	}
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Thread Local Cache
+ *
+ * Each thread allocates from and frees to its own list of free elements,
+ * which is refilled from (or given back to) the pool by batches of a chunk worth of elements,
+ * so the pool lock is rarely taken. New chunks are initialized outside of the lock.
+ *
+ * Only built into bf_blenlib (#WITH_MEMPOOL_LOCAL), makesdna and makesrna don't link threads.
+ * \{ */
+
+#ifdef WITH_MEMPOOL_LOCAL
+
+/**
+ * Initialize a thread local cache of \a pool.
+ *
+ * \note The cache has no allocated data, it can be copied before use (e.g. for each thread).
+ */
+void BLI_mempool_local_init(BLI_mempool *pool, BLI_mempool_local *local)
+{
+	BLI_assert(pool->flag & BLI_MEMPOOL_ALLOW_LOCAL);
+
+	local->pool = pool;
+	local->free = NULL;
+	local->free_len = 0;
+}
+
+static void mempool_local_refill(BLI_mempool_local *local)
+{
+	BLI_mempool *pool = local->pool;
+	BLI_freenode *head = NULL, *tail;
+	uint len = 0;
+
+	BLI_spin_lock(&pool->lock);
+	if (pool->free) {
+		/* Take a batch of elements from the pool. */
+		head = tail = pool->free;
+		len = 1;
+		while ((len < pool->pchunk) && tail->next) {
+			tail = tail->next;
+			len++;
+		}
+		pool->free = tail->next;
+		tail->next = NULL;
+		pool->totused += len;
+	}
+	BLI_spin_unlock(&pool->lock);
+
+	if (head == NULL) {
+		/* Pool is empty, take a whole new chunk. */
+		BLI_mempool_chunk *mpchunk = mempool_chunk_alloc(pool);
+		mempool_chunk_nodes_init(pool, mpchunk);
+		head = CHUNK_DATA(mpchunk);
+		len = pool->pchunk;
+
+		BLI_spin_lock(&pool->lock);
+		mempool_chunk_append(pool, mpchunk);
+		pool->totused += len;
+		BLI_spin_unlock(&pool->lock);
+	}
+
+	local->free = head;
+	local->free_len = len;
+}
+
+/**
+ * Give back the first \a len elements of the local free list to the pool.
+ */
+static void mempool_local_return(BLI_mempool_local *local, const uint len)
+{
+	BLI_mempool *pool = local->pool;
+	BLI_freenode *head = local->free, *tail = head;
+	uint i;
+
+	BLI_assert(len > 0 && len <= local->free_len);
+
+	for (i = 1; i < len; i++) {
+		tail = tail->next;
+	}
+	local->free = tail->next;
+	local->free_len -= len;
+
+	BLI_spin_lock(&pool->lock);
+	tail->next = pool->free;
+	pool->free = head;
+	pool->totused -= len;
+	BLI_spin_unlock(&pool->lock);
+}
+
+/**
+ * Thread-safe version of #BLI_mempool_alloc, as long as each thread uses its own \a local.
+ */
+void *BLI_mempool_local_alloc(BLI_mempool_local *local)
+{
+	BLI_freenode *free_pop;
+
+	if (UNLIKELY(local->free == NULL)) {
+		mempool_local_refill(local);
+	}
+
+	free_pop = local->free;
+
+	if (local->pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+		free_pop->freeword = USEDWORD;
+	}
+
+	local->free = free_pop->next;
+	local->free_len--;
+
+#ifdef WITH_MEM_VALGRIND
+	VALGRIND_MEMPOOL_ALLOC(local->pool, free_pop, local->pool->esize);
+#endif
+
+	return (void *)free_pop;
+}
+
+void *BLI_mempool_local_calloc(BLI_mempool_local *local)
+{
+	void *retval = BLI_mempool_local_alloc(local);
+	memset(retval, 0, (size_t)local->pool->esize);
+	return retval;
+}
+
+/**
+ * Thread-safe version of #BLI_mempool_free, \a addr may have been allocated from any thread.
+ *
+ * \note Unlike #BLI_mempool_free, chunks are never freed here.
+ */
+void BLI_mempool_local_free(BLI_mempool_local *local, void *addr)
+{
+	BLI_mempool *pool = local->pool;
+	BLI_freenode *newhead = addr;
+
+	if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+#ifndef NDEBUG
+		/* this will detect double free's */
+		BLI_assert(newhead->freeword != FREEWORD);
+#endif
+		newhead->freeword = FREEWORD;
+	}
+
+#ifndef NDEBUG
+	if (UNLIKELY(mempool_debug_memset)) {
+		memset(addr, 255, pool->esize);
+		if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+			newhead->freeword = FREEWORD;
+		}
+	}
+#endif
+
+	newhead->next = local->free;
+	local->free = newhead;
+	local->free_len++;
+
+#ifdef WITH_MEM_VALGRIND
+	VALGRIND_MEMPOOL_FREE(pool, addr);
+#endif
+
+	/* Avoid hoarding elements when a thread frees much more than it allocates. */
+	if (UNLIKELY(local->free_len >= 2 * pool->pchunk)) {
+		mempool_local_return(local, pool->pchunk);
+	}
+}
+
+/**
+ * Give back all cached free elements to the pool.
+ *
+ * \note Must be called for all thread local caches before the pool is used again through
+ * regular (non thread-safe) functions, #BLI_mempool_len is only exact after that too.
+ */
+void BLI_mempool_local_flush(BLI_mempool_local *local)
+{
+	if (local->free_len != 0) {
+		mempool_local_return(local, local->free_len);
+	}
+	BLI_assert(local->free == NULL);
+}
+
+#endif  /* WITH_MEMPOOL_LOCAL */
+
+/** \} */
+
 int BLI_mempool_len(BLI_mempool *pool)
 {
 	return (int)pool->totused;
@@ -771,6 +991,11 @@ void BLI_mempool_clear(BLI_mempool *pool)
 void BLI_mempool_destroy(BLI_mempool *pool)
 {
 	mempool_chunk_free_all(pool->chunks);
+#ifdef WITH_MEMPOOL_LOCAL
+	if (pool->flag & BLI_MEMPOOL_ALLOW_LOCAL) {
+		BLI_spin_end(&pool->lock);
+	}
+#endif
 
 #ifdef WITH_MEM_VALGRIND
 	VALGRIND_DESTROY_MEMPOOL(pool);
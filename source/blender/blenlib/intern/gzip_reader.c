@@ -0,0 +1,443 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenlib/intern/gzip_reader.c
+ *  \ingroup bli
+ *
+ * Parallel reader of gzip files written by #GzipWriter.
+ *
+ * Opening the file builds an index of all blocks from the member headers,
+ * without decompressing anything. Blocks ahead of the read position are then
+ * decompressed in tasks, and seeking skips blocks which are not needed.
+ *
+ * The reading thread never waits for a block which no thread started yet:
+ * it claims and decompresses such block itself, so the reader also works
+ * when the scheduler has no worker threads.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "zlib.h"
+
+#ifdef WIN32
+#  include <io.h>
+#  include "BLI_winstuff.h"
+#else
+#  include <unistd.h>
+#endif
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_gzip_reader.h"
+#include "BLI_gzip_writer.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+
+#include "atomic_ops.h"
+
+#include "BLI_strict_flags.h"
+
+/* Number of blocks decompressed ahead of the read position, per thread. */
+#define GZIP_READER_AHEAD_PER_THREAD 2
+
+enum {
+	GZIP_BLOCK_PENDING = 0,
+	GZIP_BLOCK_RUNNING,
+	GZIP_BLOCK_DONE,
+	/* Data was freed by the reading thread. Read-ahead tasks which are still queued
+	 * for the block skip it, only the reading thread decompresses it again. */
+	GZIP_BLOCK_RELEASED,
+};
+
+typedef struct GzipReadBlock {
+	int64_t file_offset;
+	uint file_len;
+
+	size_t data_offset;
+	uint data_len;
+	char *data;
+
+	/* One of GZIP_BLOCK_* values, changed atomically. */
+	uint32_t state;
+	bool error;
+} GzipReadBlock;
+
+struct GzipReader {
+	int file;
+
+	GzipReadBlock *blocks;
+	uint blocks_len;
+	size_t size;
+
+	/* Current read position. */
+	uint block_index;
+	uint block_pos;
+
+	/* Blocks before this index are pushed to the pool. */
+	uint ahead_index;
+	uint ahead_max;
+
+	TaskPool *pool;
+
+	/* Protects file position. */
+	ThreadMutex file_mutex;
+	/* Signaled when a block running in some task is done. */
+	ThreadMutex mutex;
+	ThreadCondition cond;
+};
+
+/* -------------------------------------------------------------------- */
+/** \name Internal Block API
+ * \{ */
+
+static uint gzip_read_uint32_le(const unsigned char *buf)
+{
+	return (uint)buf[0] | ((uint)buf[1] << 8) | ((uint)buf[2] << 16) | ((uint)buf[3] << 24);
+}
+
+static bool gzip_file_read_at(int file, int64_t offset, void *buf, uint len)
+{
+	if (lseek(file, offset, SEEK_SET) != offset) {
+		return false;
+	}
+	return read(file, buf, len) == (int)len;
+}
+
+/**
+ * Build the index of blocks from member headers.
+ *
+ * \return false when the file is not entirely made of #GzipWriter blocks.
+ */
+static bool gzip_reader_index_build(GzipReader *gr)
+{
+	const int64_t file_len = lseek(gr->file, 0, SEEK_END);
+	int64_t offset = 0;
+	uint blocks_alloc = 64;
+
+	if (file_len <= 0) {
+		return false;
+	}
+
+	gr->blocks = MEM_mallocN(sizeof(*gr->blocks) * blocks_alloc, "GzipReader blocks");
+
+	while (offset < file_len) {
+		unsigned char header[BLI_GZIP_BLOCK_HEADER_SIZE];
+
+		if (!gzip_file_read_at(gr->file, offset, header, sizeof(header)) ||
+		    memcmp(header, "\x1f\x8b\x08\x04", 4) != 0 ||
+		    memcmp(header + 10, "\x0c\x00" "BL" "\x08\x00", 6) != 0)
+		{
+			return false;
+		}
+
+		const uint member_len = gzip_read_uint32_le(header + 16);
+		if (member_len < BLI_GZIP_BLOCK_HEADER_SIZE + BLI_GZIP_BLOCK_TRAILER_SIZE ||
+		    offset + member_len > file_len)
+		{
+			return false;
+		}
+
+		if (gr->blocks_len == blocks_alloc) {
+			blocks_alloc *= 2;
+			gr->blocks = MEM_reallocN(gr->blocks, sizeof(*gr->blocks) * blocks_alloc);
+		}
+
+		GzipReadBlock *block = &gr->blocks[gr->blocks_len++];
+		memset(block, 0, sizeof(*block));
+		block->file_offset = offset;
+		block->file_len = member_len;
+		block->data_offset = gr->size;
+		block->data_len = gzip_read_uint32_le(header + 20);
+
+		gr->size += block->data_len;
+		offset += member_len;
+	}
+
+	return true;
+}
+
+static bool gzip_block_decompress(GzipReader *gr, GzipReadBlock *block)
+{
+	unsigned char *member = MEM_mallocN(block->file_len, "GzipReadBlock member");
+	z_stream strm = {NULL};
+	bool ok = false;
+
+	BLI_mutex_lock(&gr->file_mutex);
+	const bool read_ok = gzip_file_read_at(gr->file, block->file_offset, member, block->file_len);
+	BLI_mutex_unlock(&gr->file_mutex);
+
+	/* Avoid zero sized allocation for empty blocks. */
+	block->data = MEM_mallocN(MAX2(block->data_len, 1u), "GzipReadBlock data");
+
+	if (read_ok && inflateInit2(&strm, -MAX_WBITS) == Z_OK) {
+		const unsigned char *trailer = member + block->file_len - BLI_GZIP_BLOCK_TRAILER_SIZE;
+
+		strm.next_in = member + BLI_GZIP_BLOCK_HEADER_SIZE;
+		strm.avail_in = block->file_len - BLI_GZIP_BLOCK_HEADER_SIZE - BLI_GZIP_BLOCK_TRAILER_SIZE;
+		strm.next_out = (Bytef *)block->data;
+		strm.avail_out = block->data_len;
+
+		if (inflate(&strm, Z_FINISH) == Z_STREAM_END &&
+		    strm.total_out == block->data_len &&
+		    gzip_read_uint32_le(trailer + 4) == block->data_len &&
+		    gzip_read_uint32_le(trailer) == (uint)crc32(0, (const Bytef *)block->data, block->data_len))
+		{
+			ok = true;
+		}
+		inflateEnd(&strm);
+	}
+
+	MEM_freeN(member);
+	return ok;
+}
+
+/**
+ * Decompress the block if it's in \a state, so nobody else started it yet.
+ *
+ * \return false when some other thread is decompressing or decompressed it.
+ */
+static bool gzip_block_claim_and_run(GzipReader *gr, GzipReadBlock *block, uint32_t state)
+{
+	if (atomic_cas_uint32(&block->state, state, GZIP_BLOCK_RUNNING) != state) {
+		return false;
+	}
+
+	block->error = !gzip_block_decompress(gr, block);
+
+	BLI_mutex_lock(&gr->mutex);
+	block->state = GZIP_BLOCK_DONE;
+	BLI_condition_notify_all(&gr->cond);
+	BLI_mutex_unlock(&gr->mutex);
+
+	return true;
+}
+
+static void gzip_reader_decompress_func(TaskPool *__restrict pool, void *taskdata, int UNUSED(thread_id))
+{
+	GzipReader *gr = BLI_task_pool_userdata(pool);
+	gzip_block_claim_and_run(gr, taskdata, GZIP_BLOCK_PENDING);
+}
+
+/**
+ * Make sure the block at the read position is decompressed,
+ * and schedule blocks after it.
+ */
+static bool gzip_reader_block_ensure(GzipReader *gr)
+{
+	GzipReadBlock *block = &gr->blocks[gr->block_index];
+
+	const uint ahead_end = MIN2(gr->block_index + 1 + gr->ahead_max, gr->blocks_len);
+	for (uint i = MAX2(gr->ahead_index, gr->block_index + 1); i < ahead_end; i++) {
+		/* Blocks discarded by an earlier seek are wanted again. */
+		atomic_cas_uint32(&gr->blocks[i].state, GZIP_BLOCK_RELEASED, GZIP_BLOCK_PENDING);
+		BLI_task_pool_push(gr->pool, gzip_reader_decompress_func, &gr->blocks[i], false, TASK_PRIORITY_HIGH);
+	}
+	gr->ahead_index = MAX2(gr->ahead_index, ahead_end);
+
+	if (!gzip_block_claim_and_run(gr, block, GZIP_BLOCK_PENDING) &&
+	    !gzip_block_claim_and_run(gr, block, GZIP_BLOCK_RELEASED))
+	{
+		BLI_mutex_lock(&gr->mutex);
+		while (block->state != GZIP_BLOCK_DONE) {
+			BLI_condition_wait(&gr->cond, &gr->mutex);
+		}
+		BLI_mutex_unlock(&gr->mutex);
+	}
+
+	return !block->error;
+}
+
+/* Free memory of the block at read position, once it's not needed anymore. */
+static void gzip_reader_block_release(GzipReader *gr)
+{
+	GzipReadBlock *block = &gr->blocks[gr->block_index];
+
+	/* Released blocks are decompressed again when seeking back to them,
+	 * never by read-ahead tasks queued earlier. */
+	BLI_mutex_lock(&gr->mutex);
+	if (block->state == GZIP_BLOCK_DONE) {
+		MEM_freeN(block->data);
+		block->data = NULL;
+		block->state = GZIP_BLOCK_RELEASED;
+	}
+	BLI_mutex_unlock(&gr->mutex);
+}
+
+/* Free or cancel read-ahead of a block which the read position moved away from. */
+static void gzip_reader_block_discard(GzipReader *gr, GzipReadBlock *block)
+{
+	/* Queued tasks skip released blocks. */
+	if (atomic_cas_uint32(&block->state, GZIP_BLOCK_PENDING, GZIP_BLOCK_RELEASED) == GZIP_BLOCK_PENDING) {
+		return;
+	}
+
+	BLI_mutex_lock(&gr->mutex);
+	while (block->state == GZIP_BLOCK_RUNNING) {
+		BLI_condition_wait(&gr->cond, &gr->mutex);
+	}
+	if (block->state == GZIP_BLOCK_DONE) {
+		MEM_freeN(block->data);
+		block->data = NULL;
+		block->state = GZIP_BLOCK_RELEASED;
+	}
+	BLI_mutex_unlock(&gr->mutex);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Public API
+ * \{ */
+
+/**
+ * Create a reader for an open file.
+ *
+ * \param file: File descriptor, it's not closed by the reader.
+ * \return NULL when the file wasn't written by #GzipWriter,
+ * the caller can fall back to regular gzip reading then.
+ */
+GzipReader *BLI_gzip_reader_new(int file, TaskScheduler *scheduler)
+{
+	GzipReader *gr = MEM_callocN(sizeof(*gr), __func__);
+
+	gr->file = file;
+
+	if (!gzip_reader_index_build(gr)) {
+		if (gr->blocks) {
+			MEM_freeN(gr->blocks);
+		}
+		MEM_freeN(gr);
+		return NULL;
+	}
+
+	gr->ahead_max = (uint)BLI_task_scheduler_num_threads(scheduler) * GZIP_READER_AHEAD_PER_THREAD;
+
+	BLI_mutex_init(&gr->file_mutex);
+	BLI_mutex_init(&gr->mutex);
+	BLI_condition_init(&gr->cond);
+
+	gr->pool = BLI_task_pool_create(scheduler, gr);
+
+	return gr;
+}
+
+/**
+ * Read uncompressed data, same semantic as `gzread`.
+ *
+ * \return number of bytes read, less than \a size at the end of the file, -1 on error.
+ */
+int BLI_gzip_reader_read(GzipReader *gr, void *buffer, unsigned int size)
+{
+	char *buffer_p = buffer;
+	uint read_len = 0;
+
+	while (read_len < size && gr->block_index < gr->blocks_len) {
+		GzipReadBlock *block = &gr->blocks[gr->block_index];
+
+		if (!gzip_reader_block_ensure(gr)) {
+			return -1;
+		}
+
+		const uint len = MIN2(size - read_len, block->data_len - gr->block_pos);
+		memcpy(buffer_p + read_len, block->data + gr->block_pos, len);
+		read_len += len;
+		gr->block_pos += len;
+
+		if (gr->block_pos == block->data_len) {
+			gzip_reader_block_release(gr);
+			gr->block_index++;
+			gr->block_pos = 0;
+		}
+	}
+
+	return (int)read_len;
+}
+
+/**
+ * Move read position to an offset in the uncompressed data.
+ * Blocks in between are skipped without decompressing them.
+ */
+bool BLI_gzip_reader_seek(GzipReader *gr, size_t offset)
+{
+	if (offset > gr->size) {
+		return false;
+	}
+
+	/* Binary search for the block containing the offset, empty blocks are skipped over. */
+	uint low = 0, high = gr->blocks_len;
+	while (low < high) {
+		const uint mid = (low + high) / 2;
+		if (gr->blocks[mid].data_offset + gr->blocks[mid].data_len <= offset) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+
+	if (low != gr->block_index) {
+		/* Drop the block at the old read position and its read-ahead, except for blocks
+		 * the new position reads ahead too. Read-ahead is scheduled again from there. */
+		const uint ahead_end = MIN2(low + 1 + gr->ahead_max, gr->blocks_len);
+		const uint old_ahead_end = MAX2(gr->ahead_index, gr->block_index + 1);
+		const uint old_end = MIN2(old_ahead_end, gr->blocks_len);
+		for (uint i = gr->block_index; i < old_end; i++) {
+			if (i < low || i >= ahead_end) {
+				gzip_reader_block_discard(gr, &gr->blocks[i]);
+			}
+		}
+
+		gr->block_index = low;
+		gr->ahead_index = low;
+	}
+	gr->block_pos = (low < gr->blocks_len) ? (uint)(offset - gr->blocks[low].data_offset) : 0;
+
+	return true;
+}
+
+/**
+ * \return size of the uncompressed data.
+ */
+size_t BLI_gzip_reader_size(const GzipReader *gr)
+{
+	return gr->size;
+}
+
+void BLI_gzip_reader_free(GzipReader *gr)
+{
+	/* Pending read-ahead is not needed anymore, waits for running tasks. */
+	BLI_task_pool_free(gr->pool);
+
+	for (uint i = 0; i < gr->blocks_len; i++) {
+		if (gr->blocks[i].data) {
+			MEM_freeN(gr->blocks[i].data);
+		}
+	}
+	MEM_freeN(gr->blocks);
+
+	BLI_condition_end(&gr->cond);
+	BLI_mutex_end(&gr->mutex);
+	BLI_mutex_end(&gr->file_mutex);
+	MEM_freeN(gr);
+}
+
+/** \} */
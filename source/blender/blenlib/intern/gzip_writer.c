@@ -0,0 +1,401 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenlib/intern/gzip_writer.c
+ *  \ingroup bli
+ *
+ * Gzip file writer which compresses on the task scheduler threads.
+ *
+ * The stream is split into fixed size blocks, every block is compressed as a
+ * separate gzip member. Concatenated members are a valid gzip file which
+ * `gzread` (and any other gzip reader) decompresses as a single stream,
+ * while #GzipReader uses sizes stored in member headers to decompress blocks
+ * in parallel.
+ *
+ * The caller only copies data into the current block, compression happens
+ * in tasks. Blocks which are finished are written to the file in order by
+ * whichever thread finished compressing the oldest pending block, so the
+ * caller thread never waits for the disk unless too many blocks are queued,
+ * in which case it helps compressing them until the oldest block is written.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "zlib.h"
+
+#ifdef WIN32
+#  include <io.h>
+#else
+#  include <unistd.h>
+#endif
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_gzip_writer.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+
+#include "BLI_strict_flags.h"
+
+/* Number of queued blocks per thread, before the caller waits for them to be written. */
+#define GZIP_WRITER_QUEUE_PER_THREAD 2
+
+typedef struct GzipBlock {
+	struct GzipBlock *next;
+
+	char *in;
+	size_t in_len;
+
+	char *out;
+	size_t out_len;
+
+	bool done;
+	bool error;
+} GzipBlock;
+
+struct GzipWriter {
+	int file;
+	int level;
+	size_t block_size;
+
+	/* Block being filled by the caller, not yet in the queue. */
+	GzipBlock *block;
+	bool is_empty;
+
+	TaskPool *pool;
+
+	/* Queue of compressed and pending blocks, in file order. Protected by mutex. */
+	GzipBlock *queue_first, *queue_last;
+	uint queue_len, queue_max;
+	/* First block which no thread started compressing yet, blocks are claimed in order. */
+	GzipBlock *queue_unclaimed;
+	/* Some thread is currently writing blocks from the head of the queue. */
+	bool is_writing;
+	bool error;
+
+	ThreadMutex mutex;
+	/* Notified whenever a block was written and left the queue. */
+	ThreadCondition queue_cond;
+};
+
+/* -------------------------------------------------------------------- */
+/** \name Internal Block API
+ * \{ */
+
+static GzipBlock *gzip_block_new(size_t block_size)
+{
+	GzipBlock *block = MEM_callocN(sizeof(*block), __func__);
+	block->in = MEM_mallocN(block_size, "GzipBlock in");
+	return block;
+}
+
+static void gzip_block_free(GzipBlock *block)
+{
+	if (block->in) {
+		MEM_freeN(block->in);
+	}
+	if (block->out) {
+		MEM_freeN(block->out);
+	}
+	MEM_freeN(block);
+}
+
+static void gzip_write_uint32_le(char *buf, uint value)
+{
+	buf[0] = (char)(value & 0xff);
+	buf[1] = (char)((value >> 8) & 0xff);
+	buf[2] = (char)((value >> 16) & 0xff);
+	buf[3] = (char)((value >> 24) & 0xff);
+}
+
+/**
+ * Compress the block as a complete gzip member, see #BLI_GZIP_BLOCK_HEADER_SIZE for the layout.
+ * Header is written by hand, since its extra field stores the compressed size.
+ */
+static bool gzip_block_compress(GzipBlock *block, int level)
+{
+	z_stream strm = {NULL};
+	bool ok = false;
+
+	/* Negative window bits gives raw deflate data, 8 is the default memory level. */
+	if (deflateInit2(&strm, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		return false;
+	}
+
+	const size_t out_alloc = BLI_GZIP_BLOCK_HEADER_SIZE +
+	                         deflateBound(&strm, (uLong)block->in_len) +
+	                         BLI_GZIP_BLOCK_TRAILER_SIZE;
+	block->out = MEM_mallocN(out_alloc, "GzipBlock out");
+
+	strm.next_in = (Bytef *)block->in;
+	strm.avail_in = (uInt)block->in_len;
+	strm.next_out = (Bytef *)block->out + BLI_GZIP_BLOCK_HEADER_SIZE;
+	strm.avail_out = (uInt)(out_alloc - BLI_GZIP_BLOCK_HEADER_SIZE);
+
+	if (deflate(&strm, Z_FINISH) == Z_STREAM_END) {
+		const uint crc = (uint)crc32(0, (const Bytef *)block->in, (uInt)block->in_len);
+		char *header = block->out;
+		char *trailer = block->out + BLI_GZIP_BLOCK_HEADER_SIZE + strm.total_out;
+
+		block->out_len = BLI_GZIP_BLOCK_HEADER_SIZE + strm.total_out + BLI_GZIP_BLOCK_TRAILER_SIZE;
+
+		/* ID, deflate method, FEXTRA flag, no time, no extra flags, unknown OS. */
+		memcpy(header, "\x1f\x8b\x08\x04\x00\x00\x00\x00\x00\xff", 10);
+		/* XLEN, subfield ID and subfield length. */
+		memcpy(header + 10, "\x0c\x00" "BL" "\x08\x00", 6);
+		gzip_write_uint32_le(header + 16, (uint)block->out_len);
+		gzip_write_uint32_le(header + 20, (uint)block->in_len);
+
+		gzip_write_uint32_le(trailer, crc);
+		gzip_write_uint32_le(trailer + 4, (uint)block->in_len);
+		ok = true;
+	}
+	deflateEnd(&strm);
+
+	/* Uncompressed data is not needed anymore, release it before waiting in the queue. */
+	MEM_freeN(block->in);
+	block->in = NULL;
+
+	return ok;
+}
+
+/**
+ * Write all compressed blocks from the head of the queue, only one thread does it at a time.
+ */
+static void gzip_writer_queue_flush(GzipWriter *gw)
+{
+	BLI_mutex_lock(&gw->mutex);
+	if (gw->is_writing) {
+		/* Thread which is writing now will also write our block once it reaches it. */
+		BLI_mutex_unlock(&gw->mutex);
+		return;
+	}
+	gw->is_writing = true;
+
+	while (gw->queue_first && gw->queue_first->done) {
+		GzipBlock *block = gw->queue_first;
+		gw->queue_first = block->next;
+		if (gw->queue_first == NULL) {
+			gw->queue_last = NULL;
+		}
+		BLI_mutex_unlock(&gw->mutex);
+
+		/* Only this thread touches the error flag while is_writing is set. */
+		bool error = gw->error || block->error;
+		if (!error) {
+			if (write(gw->file, block->out, (uint)block->out_len) != (int)block->out_len) {
+				error = true;
+			}
+		}
+		gzip_block_free(block);
+
+		BLI_mutex_lock(&gw->mutex);
+		gw->error = error;
+		gw->queue_len--;
+		BLI_condition_notify_all(&gw->queue_cond);
+	}
+
+	gw->is_writing = false;
+	BLI_mutex_unlock(&gw->mutex);
+}
+
+/**
+ * Take the oldest block nobody is compressing yet, must be called with the mutex locked.
+ */
+static GzipBlock *gzip_writer_block_claim(GzipWriter *gw)
+{
+	GzipBlock *block = gw->queue_unclaimed;
+	if (block) {
+		gw->queue_unclaimed = block->next;
+	}
+	return block;
+}
+
+static void gzip_writer_block_compress(GzipWriter *gw, GzipBlock *block)
+{
+	const bool ok = gzip_block_compress(block, gw->level);
+
+	BLI_mutex_lock(&gw->mutex);
+	block->error = !ok;
+	block->done = true;
+	BLI_mutex_unlock(&gw->mutex);
+
+	gzip_writer_queue_flush(gw);
+}
+
+/**
+ * There is one task per submitted block, but the block it compresses is only chosen when it runs:
+ * the caller may have compressed the block the task was pushed for already (and it may be freed).
+ */
+static void gzip_writer_compress_func(TaskPool *__restrict pool, void *UNUSED(taskdata), int UNUSED(thread_id))
+{
+	GzipWriter *gw = BLI_task_pool_userdata(pool);
+
+	BLI_mutex_lock(&gw->mutex);
+	GzipBlock *block = gzip_writer_block_claim(gw);
+	BLI_mutex_unlock(&gw->mutex);
+
+	if (block) {
+		gzip_writer_block_compress(gw, block);
+	}
+}
+
+/**
+ * Give current block to compression, waits when the queue is full.
+ */
+static void gzip_writer_block_submit(GzipWriter *gw)
+{
+	GzipBlock *block = gw->block;
+	gw->block = NULL;
+
+	BLI_mutex_lock(&gw->mutex);
+	if (gw->queue_last) {
+		gw->queue_last->next = block;
+	}
+	else {
+		gw->queue_first = block;
+	}
+	gw->queue_last = block;
+	if (gw->queue_unclaimed == NULL) {
+		gw->queue_unclaimed = block;
+	}
+	gw->queue_len++;
+	BLI_mutex_unlock(&gw->mutex);
+
+	BLI_task_pool_push(gw->pool, gzip_writer_compress_func, NULL, false, TASK_PRIORITY_HIGH);
+
+	/* Limit memory usage when compression or the disk can't keep up, until the oldest block
+	 * is written. The caller thread helps compressing, so this also works when the scheduler
+	 * has no worker threads. */
+	BLI_mutex_lock(&gw->mutex);
+	while (gw->queue_len >= gw->queue_max) {
+		GzipBlock *claimed = gzip_writer_block_claim(gw);
+		if (claimed) {
+			BLI_mutex_unlock(&gw->mutex);
+			gzip_writer_block_compress(gw, claimed);
+			BLI_mutex_lock(&gw->mutex);
+		}
+		else {
+			BLI_condition_wait(&gw->queue_cond, &gw->mutex);
+		}
+	}
+	BLI_mutex_unlock(&gw->mutex);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Public API
+ * \{ */
+
+/**
+ * Create a writer to an open file.
+ *
+ * \param file: File descriptor, it's not closed by the writer.
+ * \param level: zlib compression level.
+ * \param block_size: Size of independently compressed blocks,
+ * zero uses #BLI_GZIP_WRITER_BLOCK_SIZE.
+ * \param scheduler: Scheduler to run compression tasks on.
+ */
+GzipWriter *BLI_gzip_writer_new(int file, int level, size_t block_size, TaskScheduler *scheduler)
+{
+	GzipWriter *gw = MEM_callocN(sizeof(*gw), __func__);
+
+	gw->file = file;
+	gw->level = level;
+	gw->block_size = block_size ? block_size : BLI_GZIP_WRITER_BLOCK_SIZE;
+	/* Sizes are stored as 32 bit in member headers. */
+	BLI_assert(gw->block_size < (1u << 31));
+	gw->is_empty = true;
+	gw->queue_max = (uint)BLI_task_scheduler_num_threads(scheduler) * GZIP_WRITER_QUEUE_PER_THREAD;
+
+	BLI_mutex_init(&gw->mutex);
+	BLI_condition_init(&gw->queue_cond);
+
+	gw->pool = BLI_task_pool_create(scheduler, gw);
+
+	return gw;
+}
+
+/**
+ * Append data to the stream.
+ *
+ * \return false when writing of some previous data failed.
+ */
+bool BLI_gzip_writer_write(GzipWriter *gw, const void *data, size_t data_len)
+{
+	const char *data_p = data;
+
+	if (UNLIKELY(gw->error)) {
+		return false;
+	}
+
+	while (data_len > 0) {
+		if (gw->block == NULL) {
+			gw->block = gzip_block_new(gw->block_size);
+		}
+
+		GzipBlock *block = gw->block;
+		const size_t len = MIN2(data_len, gw->block_size - block->in_len);
+		memcpy(block->in + block->in_len, data_p, len);
+		block->in_len += len;
+		data_p += len;
+		data_len -= len;
+		gw->is_empty = false;
+
+		if (block->in_len == gw->block_size) {
+			gzip_writer_block_submit(gw);
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Compress and write all remaining data, and free the writer.
+ *
+ * \return false when writing failed.
+ */
+bool BLI_gzip_writer_free(GzipWriter *gw)
+{
+	/* Empty stream still needs one member to be a valid gzip file. */
+	if (gw->block == NULL && gw->is_empty) {
+		gw->block = gzip_block_new(gw->block_size);
+	}
+	if (gw->block) {
+		gzip_writer_block_submit(gw);
+	}
+
+	BLI_task_pool_work_and_wait(gw->pool);
+	BLI_task_pool_free(gw->pool);
+
+	BLI_assert(gw->queue_first == NULL && gw->queue_len == 0);
+	const bool ok = !gw->error;
+
+	BLI_condition_end(&gw->queue_cond);
+	BLI_mutex_end(&gw->mutex);
+	MEM_freeN(gw);
+
+	return ok;
+}
+
+/** \} */
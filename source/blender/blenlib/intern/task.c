@@ -62,6 +62,14 @@
  */
 #define DELAYED_QUEUE_SIZE 4096
 
+/* Capacity of per-worker work stealing deque, must be power of two.
+ *
+ * When deque is full tasks are pushed to the scheduler's global queue, so
+ * there is no need to grow the deque dynamically.
+ */
+#define TASK_DEQUE_SIZE 4096
+#define TASK_DEQUE_MASK (TASK_DEQUE_SIZE - 1)
+
 #ifndef NDEBUG
 #  define ASSERT_THREAD_ID(scheduler, thread_id)                              \
 	do {                                                                      \
@@ -161,6 +169,26 @@ typedef struct TaskThreadLocalStorage {
 	Task *delayed_queue[DELAYED_QUEUE_SIZE];
 } TaskThreadLocalStorage;
 
+/* Lock-free work stealing deque (Chase-Lev) owned by a single worker thread.
+ *
+ * Owner thread pushes and pops tasks at the bottom without any locks, other
+ * threads are stealing the oldest tasks from the top using CAS. This keeps
+ * recently spawned tasks hot in the owner's cache and moves contention away
+ * from the scheduler's global queue mutex.
+ *
+ * The atomic read-modify-write operations used on top and bottom act as full
+ * memory barriers, which is what the algorithm relies on.
+ */
+typedef struct TaskDeque {
+	/* Index of the oldest task, only advanced by CAS. */
+	volatile int64_t top;
+	/* Keep top and bottom on separate cache lines. */
+	char pad[64 - sizeof(int64_t)];
+	/* Index past the newest task, only modified by the owner thread. */
+	volatile int64_t bottom;
+	Task *tasks[TASK_DEQUE_SIZE];
+} TaskDeque;
+
 struct TaskPool {
 	TaskScheduler *scheduler;
 
@@ -210,6 +238,11 @@ struct TaskScheduler {
 	int num_threads;
 	bool background_thread_only;
 
+	/* Worker threads have own deques and steal tasks from each other. */
+	bool use_work_stealing;
+	/* Number of worker threads waiting on queue_cond for new tasks. */
+	volatile uint32_t num_sleeping_threads;
+
 	ListBase queue;
 	ThreadMutex queue_mutex;
 	ThreadCondition queue_cond;
@@ -224,6 +257,8 @@ typedef struct TaskThread {
 	TaskScheduler *scheduler;
 	int id;
 	TaskThreadLocalStorage tls;
+	/* Only allocated for worker threads when work stealing is used. */
+	TaskDeque *deque;
 } TaskThread;
 
 /* Helper */
@@ -326,6 +361,70 @@ static void task_free(TaskPool *pool, Task *task, const int thread_id)
 	}
 }
 
+/* Work Stealing Deque */
+
+BLI_INLINE bool task_deque_is_full(TaskDeque *deque)
+{
+	/* Only thieves modify top and they can only make more space, so owner
+	 * is safe to push after this check succeeded.
+	 */
+	return (deque->bottom - deque->top) >= TASK_DEQUE_SIZE;
+}
+
+BLI_INLINE bool task_deque_is_empty(TaskDeque *deque)
+{
+	return deque->top >= deque->bottom;
+}
+
+/* Must only be called from the owner thread. */
+static void task_deque_push(TaskDeque *deque, Task *task)
+{
+	const int64_t bottom = deque->bottom;
+	BLI_assert(!task_deque_is_full(deque));
+	deque->tasks[bottom & TASK_DEQUE_MASK] = task;
+	/* Publish the task to thieves. */
+	atomic_add_and_fetch_int64((int64_t *)&deque->bottom, 1);
+}
+
+/* Must only be called from the owner thread. */
+static Task *task_deque_pop(TaskDeque *deque)
+{
+	const int64_t bottom = atomic_sub_and_fetch_int64((int64_t *)&deque->bottom, 1);
+	const int64_t top = deque->top;
+	Task *task = NULL;
+	if (top <= bottom) {
+		task = deque->tasks[bottom & TASK_DEQUE_MASK];
+		if (top != bottom) {
+			/* More than one task is left, no conflict with thieves possible. */
+			return task;
+		}
+		/* Last task in the deque, race against thieves for it. */
+		if (atomic_cas_int64((int64_t *)&deque->top, top, top + 1) != top) {
+			task = NULL;
+		}
+	}
+	/* Deque is empty now, restore canonical state where top == bottom. */
+	atomic_add_and_fetch_int64((int64_t *)&deque->bottom, 1);
+	return task;
+}
+
+/* Can be called from any thread. Might fail spuriously when another thief
+ * or the owner won the race for the same task.
+ */
+static Task *task_deque_steal(TaskDeque *deque)
+{
+	const int64_t top = atomic_fetch_and_add_int64((int64_t *)&deque->top, 0);
+	const int64_t bottom = deque->bottom;
+	if (top >= bottom) {
+		return NULL;
+	}
+	Task *task = deque->tasks[top & TASK_DEQUE_MASK];
+	if (atomic_cas_int64((int64_t *)&deque->top, top, top + 1) != top) {
+		return NULL;
+	}
+	return task;
+}
+
 /* Task Scheduler */
 
 static void task_pool_num_decrease(TaskPool *pool, size_t done)
@@ -334,9 +433,7 @@ static void task_pool_num_decrease(TaskPool *pool, size_t done)
 
 	BLI_assert(pool->num >= done);
 
-	pool->num -= done;
-
-	if (pool->num == 0)
+	if (atomic_sub_and_fetch_z((size_t *)&pool->num, done) == 0)
 		BLI_condition_notify_all(&pool->num_cond);
 
 	BLI_mutex_unlock(&pool->num_mutex);
@@ -346,19 +443,177 @@ static void task_pool_num_increase(TaskPool *pool, size_t new)
 {
 	BLI_mutex_lock(&pool->num_mutex);
 
-	pool->num += new;
+	atomic_add_and_fetch_z((size_t *)&pool->num, new);
 	BLI_condition_notify_all(&pool->num_cond);
 
 	BLI_mutex_unlock(&pool->num_mutex);
 }
 
+static bool task_scheduler_has_stealable(TaskScheduler *scheduler)
+{
+	for (int i = 1; i <= scheduler->num_threads; i++) {
+		if (!task_deque_is_empty(scheduler->task_threads[i].deque)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Steal a task from deque of any worker thread other than the given one. */
+static Task *task_scheduler_steal(TaskScheduler *scheduler, const int thread_id)
+{
+	const int num_threads = scheduler->num_threads;
+	for (int i = 0; i < num_threads; i++) {
+		/* Start from a different victim for every thief. */
+		const int victim_id = 1 + (thread_id + i) % num_threads;
+		if (victim_id == thread_id) {
+			continue;
+		}
+		Task *task = task_deque_steal(scheduler->task_threads[victim_id].deque);
+		if (task != NULL) {
+			return task;
+		}
+	}
+	return NULL;
+}
+
+/* Move task which is already accounted in its pool to the global queue,
+ * so it can be picked up by an idle worker or by a thread waiting for the
+ * task's pool.
+ */
+static void task_scheduler_forward(TaskScheduler *scheduler, Task *task)
+{
+	TaskPool *pool = task->pool;
+	/* Pool can not be freed while we hold its mutex and task is not done. */
+	BLI_mutex_lock(&pool->num_mutex);
+
+	BLI_mutex_lock(&scheduler->queue_mutex);
+	BLI_addhead(&scheduler->queue, task);
+	BLI_condition_notify_one(&scheduler->queue_cond);
+	BLI_mutex_unlock(&scheduler->queue_mutex);
+
+	BLI_condition_notify_all(&pool->num_cond);
+	BLI_mutex_unlock(&pool->num_mutex);
+}
+
+static Task *task_scheduler_try_pop(TaskScheduler *scheduler)
+{
+	Task *task;
+	/* Unlocked check to avoid mutex when queue is empty, the queue is
+	 * re-checked under the lock before going to sleep anyway.
+	 */
+	if (scheduler->queue.first == NULL) {
+		return NULL;
+	}
+	BLI_mutex_lock(&scheduler->queue_mutex);
+	task = scheduler->queue.first;
+	if (task != NULL) {
+		BLI_remlink(&scheduler->queue, task);
+	}
+	BLI_mutex_unlock(&scheduler->queue_mutex);
+	return task;
+}
+
+static bool task_scheduler_thread_steal_wait_pop(TaskScheduler *scheduler,
+                                                 TaskThread *thread,
+                                                 Task **task)
+{
+	for (;;) {
+		/* Own tasks first, they are most likely to be in cache. */
+		if ((*task = task_deque_pop(thread->deque)) != NULL) {
+			return true;
+		}
+		if ((*task = task_scheduler_steal(scheduler, thread->id)) != NULL) {
+			return true;
+		}
+		if ((*task = task_scheduler_try_pop(scheduler)) != NULL) {
+			return true;
+		}
+
+		BLI_mutex_lock(&scheduler->queue_mutex);
+		/* Announce we are going to sleep before checking deques one last
+		 * time. Pushing thread publishes its task before checking number
+		 * of sleeping threads, so one of us will see the other.
+		 */
+		atomic_add_and_fetch_uint32((uint32_t *)&scheduler->num_sleeping_threads, 1);
+		while (!scheduler->do_exit &&
+		       scheduler->queue.first == NULL &&
+		       !task_scheduler_has_stealable(scheduler))
+		{
+			BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+		}
+		atomic_sub_and_fetch_uint32((uint32_t *)&scheduler->num_sleeping_threads, 1);
+		const bool do_exit = scheduler->do_exit;
+		BLI_mutex_unlock(&scheduler->queue_mutex);
+
+		if (do_exit) {
+			return false;
+		}
+	}
+}
+
+static void task_scheduler_push_stealable(TaskScheduler *scheduler, TaskThread *thread, Task *task)
+{
+	/* Account task before it becomes visible to thieves, this also wakes up
+	 * a thread which waits for the pool so it can steal the task.
+	 */
+	task_pool_num_increase(task->pool, 1);
+
+	task_deque_push(thread->deque, task);
+
+	if (scheduler->num_sleeping_threads != 0) {
+		BLI_mutex_lock(&scheduler->queue_mutex);
+		BLI_condition_notify_one(&scheduler->queue_cond);
+		BLI_mutex_unlock(&scheduler->queue_mutex);
+	}
+}
+
+/* Get task of the given pool from the deque of the thread which waits for
+ * the pool. Tasks of other pools are forwarded to the global queue, running
+ * them here could lead to a deadlock.
+ */
+static Task *task_scheduler_pool_deque_pop(TaskScheduler *scheduler, TaskPool *pool)
+{
+	TaskDeque *deque = scheduler->task_threads[pool->thread_id].deque;
+	Task *task;
+	if (deque == NULL) {
+		return NULL;
+	}
+	while ((task = task_deque_pop(deque)) != NULL) {
+		if (task->pool == pool) {
+			return task;
+		}
+		task_scheduler_forward(scheduler, task);
+	}
+	return NULL;
+}
+
+/* Same as above, but steals from deques of other worker threads. */
+static Task *task_scheduler_pool_steal(TaskScheduler *scheduler, TaskPool *pool)
+{
+	Task *task = task_scheduler_steal(scheduler, pool->thread_id);
+	if (task != NULL && task->pool != pool) {
+		task_scheduler_forward(scheduler, task);
+		return NULL;
+	}
+	return task;
+}
+
+/* Wait for new tasks, must be called with queue_mutex locked. */
+BLI_INLINE void task_scheduler_thread_sleep(TaskScheduler *scheduler)
+{
+	atomic_add_and_fetch_uint32((uint32_t *)&scheduler->num_sleeping_threads, 1);
+	BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+	atomic_sub_and_fetch_uint32((uint32_t *)&scheduler->num_sleeping_threads, 1);
+}
+
 static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler, Task **task)
 {
 	bool found_task = false;
 	BLI_mutex_lock(&scheduler->queue_mutex);
 
 	while (!scheduler->queue.first && !scheduler->do_exit)
-		BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+		task_scheduler_thread_sleep(scheduler);
 
 	do {
 		Task *current_task;
@@ -394,7 +649,7 @@ static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler, Task **task
 			break;
 		}
 		if (!found_task)
-			BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+			task_scheduler_thread_sleep(scheduler);
 	} while (!found_task);
 
 	BLI_mutex_unlock(&scheduler->queue_mutex);
@@ -433,7 +688,10 @@ static void *task_scheduler_thread_run(void *thread_p)
 	pthread_setspecific(scheduler->tls_id_key, thread);
 
 	/* keep popping off tasks */
-	while (task_scheduler_thread_wait_pop(scheduler, &task)) {
+	while (scheduler->use_work_stealing ?
+	       task_scheduler_thread_steal_wait_pop(scheduler, thread, &task) :
+	       task_scheduler_thread_wait_pop(scheduler, &task))
+	{
 		TaskPool *pool = task->pool;
 
 		/* run task */
@@ -454,7 +712,12 @@ static void *task_scheduler_thread_run(void *thread_p)
 	return NULL;
 }
 
-TaskScheduler *BLI_task_scheduler_create(int num_threads)
+/**
+ * Create scheduler with the given number of threads.
+ *
+ * \param flag: Combination of #eTaskSchedulerFlag.
+ */
+TaskScheduler *BLI_task_scheduler_create_ex(int num_threads, int flag)
 {
 	TaskScheduler *scheduler = MEM_callocN(sizeof(TaskScheduler), "TaskScheduler");
 
@@ -480,11 +743,18 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 		num_threads = 1;
 	}
 
+	/* Background-only thread must not steal tasks which are supposed to be
+	 * handled by work_and_wait(), so it always uses the global queue.
+	 */
+	scheduler->use_work_stealing = (flag & TASK_SCHEDULER_WORK_STEALING) &&
+	                               !scheduler->background_thread_only;
+
 	scheduler->task_threads = MEM_mallocN(sizeof(TaskThread) * (num_threads + 1),
 	                                      "TaskScheduler task threads");
 
 	/* Initialize TLS for main thread. */
 	initialize_task_tls(&scheduler->task_threads[0].tls);
+	scheduler->task_threads[0].deque = NULL;
 
 	pthread_key_create(&scheduler->tls_id_key, NULL);
 
@@ -495,6 +765,19 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 		scheduler->num_threads = num_threads;
 		scheduler->threads = MEM_callocN(sizeof(pthread_t) * num_threads, "TaskScheduler threads");
 
+		/* Deques of all threads are to be ready before any thread starts
+		 * looking for work to steal.
+		 */
+		for (i = 0; i < num_threads; i++) {
+			TaskThread *thread = &scheduler->task_threads[i + 1];
+			if (scheduler->use_work_stealing) {
+				thread->deque = MEM_callocN(sizeof(TaskDeque), "TaskScheduler task deque");
+			}
+			else {
+				thread->deque = NULL;
+			}
+		}
+
 		for (i = 0; i < num_threads; i++) {
 			TaskThread *thread = &scheduler->task_threads[i + 1];
 			thread->scheduler = scheduler;
@@ -510,6 +793,11 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 	return scheduler;
 }
 
+TaskScheduler *BLI_task_scheduler_create(int num_threads)
+{
+	return BLI_task_scheduler_create_ex(num_threads, 0);
+}
+
 void BLI_task_scheduler_free(TaskScheduler *scheduler)
 {
 	Task *task;
@@ -539,6 +827,16 @@ void BLI_task_scheduler_free(TaskScheduler *scheduler)
 		for (int i = 0; i < scheduler->num_threads + 1; ++i) {
 			TaskThreadLocalStorage *tls = &scheduler->task_threads[i].tls;
 			free_task_tls(tls);
+
+			TaskDeque *deque = scheduler->task_threads[i].deque;
+			if (deque != NULL) {
+				/* delete leftover tasks */
+				while ((task = task_deque_pop(deque)) != NULL) {
+					task_data_free(task, 0);
+					MEM_freeN(task);
+				}
+				MEM_freeN(deque);
+			}
 		}
 
 		MEM_freeN(scheduler->task_threads);
@@ -620,6 +918,26 @@ static void task_scheduler_clear(TaskScheduler *scheduler, TaskPool *pool)
 
 	BLI_mutex_unlock(&scheduler->queue_mutex);
 
+	/* Tasks in the deque of the calling thread will not be handled by anyone
+	 * while we are waiting for the pool to become empty, so discard them too.
+	 * Tasks in other deques are handled as usual.
+	 */
+	if (scheduler->use_work_stealing && pool->thread_id != 0) {
+		TaskThread *thread = &scheduler->task_threads[pool->thread_id];
+		if (pthread_getspecific(scheduler->tls_id_key) == thread) {
+			while ((task = task_deque_pop(thread->deque)) != NULL) {
+				if (task->pool == pool) {
+					task_data_free(task, pool->thread_id);
+					MEM_freeN(task);
+					done++;
+				}
+				else {
+					task_scheduler_forward(scheduler, task);
+				}
+			}
+		}
+	}
+
 	/* notify done */
 	task_pool_num_decrease(pool, done);
 }
@@ -806,6 +1124,16 @@ static void task_pool_push(
 			tls->num_local_queue++;
 			return;
 		}
+		/* Worker threads push to their own deque without any locks, other
+		 * threads will steal from it when they run out of work.
+		 */
+		if (thread_id != 0 && pool->scheduler->use_work_stealing) {
+			TaskThread *thread = &pool->scheduler->task_threads[thread_id];
+			if (!task_deque_is_full(thread->deque)) {
+				task_scheduler_push_stealable(pool->scheduler, thread, task);
+				return;
+			}
+		}
 		/* If we are in the delayed tasks push mode, we push tasks to a
 		 * temporary local queue first without any locks, and then move them
 		 * to global execution queue with a single lock.
@@ -870,21 +1198,35 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 
 		BLI_mutex_unlock(&pool->num_mutex);
 
-		BLI_mutex_lock(&scheduler->queue_mutex);
+		if (scheduler->use_work_stealing) {
+			/* Tasks pushed by this thread are in its own deque. */
+			work_task = task_scheduler_pool_deque_pop(scheduler, pool);
+			found_task = (work_task != NULL);
+		}
+
+		if (!found_task) {
+			BLI_mutex_lock(&scheduler->queue_mutex);
 
-		/* find task from this pool. if we get a task from another pool,
-		 * we can get into deadlock */
+			/* find task from this pool. if we get a task from another pool,
+			 * we can get into deadlock */
 
-		for (task = scheduler->queue.first; task; task = task->next) {
-			if (task->pool == pool) {
-				work_task = task;
-				found_task = true;
-				BLI_remlink(&scheduler->queue, task);
-				break;
+			for (task = scheduler->queue.first; task; task = task->next) {
+				if (task->pool == pool) {
+					work_task = task;
+					found_task = true;
+					BLI_remlink(&scheduler->queue, task);
+					break;
+				}
 			}
+
+			BLI_mutex_unlock(&scheduler->queue_mutex);
 		}
 
-		BLI_mutex_unlock(&scheduler->queue_mutex);
+		if (!found_task && scheduler->use_work_stealing) {
+			/* Help with tasks spawned by other worker threads. */
+			work_task = task_scheduler_pool_steal(scheduler, pool);
+			found_task = (work_task != NULL);
+		}
 
 		/* if found task, do it, otherwise wait until other tasks are done */
 		if (found_task) {
@@ -894,7 +1236,7 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 			BLI_assert(!tls->do_delayed_push);
 
 			/* delete task */
-			task_free(pool, task, pool->thread_id);
+			task_free(pool, work_task, pool->thread_id);
 
 			/* Handle all tasks from local queue. */
 			handle_local_queue(tls, pool->thread_id);
@@ -997,12 +1339,41 @@ typedef struct ParallelRangeState {
 
 	int iter;
 	int chunk_size;
+	eTaskSchedulingMode scheduling_mode;
+	int num_tasks;
+
+	/* Tree reduction of per-task userdata chunks. */
+	TaskParallelRangeFuncReduce func_reduce;
+	void *userdata_chunk_array;
+	size_t userdata_chunk_size;
+	/* Number of finished children per node of the reduction tree. */
+	int *reduce_counters;
 } ParallelRangeState;
 
 BLI_INLINE bool parallel_range_next_iter_get(
         ParallelRangeState * __restrict state,
         int * __restrict iter, int * __restrict count)
 {
+	if (state->scheduling_mode == TASK_SCHEDULING_GUIDED) {
+		/* Chunk size is proportional to the remaining amount of work, so
+		 * there are few big chunks in the beginning and small chunks to
+		 * balance the load in the end.
+		 */
+		int previter, chunk_size;
+		do {
+			previter = *(volatile int *)&state->iter;
+			if (previter >= state->stop) {
+				return false;
+			}
+			chunk_size = max_ii(state->chunk_size, (state->stop - previter) / (state->num_tasks * 2));
+			chunk_size = min_ii(chunk_size, state->stop - previter);
+		} while (atomic_cas_int32(&state->iter, previter, previter + chunk_size) != previter);
+
+		*iter = previter;
+		*count = chunk_size;
+		return true;
+	}
+
 	int previter = atomic_fetch_and_add_int32(&state->iter, state->chunk_size);
 
 	*iter = previter;
@@ -1011,15 +1382,49 @@ BLI_INLINE bool parallel_range_next_iter_get(
 	return (previter < state->stop);
 }
 
+BLI_INLINE void *parallel_range_userdata_chunk_get(ParallelRangeState * __restrict state, const int index)
+{
+	if (state->userdata_chunk_array == NULL) {
+		return NULL;
+	}
+	return (char *)state->userdata_chunk_array + (state->userdata_chunk_size * index);
+}
+
+/* Walk up the binary reduction tree over task indices. Of the two sibling
+ * subtrees the one which finishes last joins the other one's chunk into the
+ * left chunk and continues up, so in the end everything is reduced into the
+ * chunk of the first task without any waiting.
+ */
+static void parallel_range_reduce(ParallelRangeState * __restrict state, int index)
+{
+	const int num_tasks = state->num_tasks;
+	for (int level = 0; (1 << level) < num_tasks; level++) {
+		const int stride = 1 << level;
+		const int join_index = index & ~((stride << 1) - 1);
+		const int other_index = join_index + stride;
+		if (other_index < num_tasks) {
+			if (atomic_add_and_fetch_int32(&state->reduce_counters[level * num_tasks + join_index], 1) == 1) {
+				/* Sibling subtree is still running, it will do the join. */
+				return;
+			}
+			state->func_reduce(state->userdata,
+			                   parallel_range_userdata_chunk_get(state, join_index),
+			                   parallel_range_userdata_chunk_get(state, other_index));
+		}
+		index = join_index;
+	}
+}
+
 static void parallel_range_func(
         TaskPool * __restrict pool,
-        void *userdata_chunk,
+        void *taskdata,
         int thread_id)
 {
 	ParallelRangeState * __restrict state = BLI_task_pool_userdata(pool);
+	const int task_index = GET_INT_FROM_POINTER(taskdata);
 	ParallelRangeTLS tls = {
 		.thread_id = thread_id,
-		.userdata_chunk = userdata_chunk,
+		.userdata_chunk = parallel_range_userdata_chunk_get(state, task_index),
 	};
 	int iter, count;
 	while (parallel_range_next_iter_get(state, &iter, &count)) {
@@ -1027,6 +1432,9 @@ static void parallel_range_func(
 			state->func(state->userdata, iter + i, &tls);
 		}
 	}
+	if (state->func_reduce != NULL) {
+		parallel_range_reduce(state, task_index);
+	}
 }
 
 static void palallel_range_single_thread(const int start, int const stop,
@@ -1049,6 +1457,9 @@ static void palallel_range_single_thread(const int start, int const stop,
 	for (int i = start; i < stop; ++i) {
 		func(userdata, i, &tls);
 	}
+	if (use_userdata_chunk && settings->func_reduce != NULL) {
+		settings->func_reduce(userdata, userdata_chunk, userdata_chunk_local);
+	}
 	if (settings->func_finalize != NULL) {
 		settings->func_finalize(userdata, userdata_chunk_local);
 	}
@@ -1074,6 +1485,8 @@ void BLI_task_parallel_range(const int start, const int stop,
 	const size_t userdata_chunk_size = settings->userdata_chunk_size;
 	void *userdata_chunk_local = NULL;
 	void *userdata_chunk_array = NULL;
+	int *reduce_counters = NULL;
+	size_t reduce_counters_size = 0;
 	const bool use_userdata_chunk = (userdata_chunk_size != 0) && (userdata_chunk != NULL);
 
 	if (start == stop) {
@@ -1096,7 +1509,7 @@ void BLI_task_parallel_range(const int start, const int stop,
 		return;
 	}
 
-	task_scheduler = BLI_task_scheduler_get();
+	task_scheduler = (settings->scheduler != NULL) ? settings->scheduler : BLI_task_scheduler_get();
 	num_threads = BLI_task_scheduler_num_threads(task_scheduler);
 
 	/* The idea here is to prevent creating task for each of the loop iterations
@@ -1105,11 +1518,21 @@ void BLI_task_parallel_range(const int start, const int stop,
 	 */
 	num_tasks = num_threads + 2;
 
+	/* When called from a task which is already running on a worker thread
+	 * only use threads which are idle at this moment. Other threads are busy
+	 * with tasks of the outer pool, pushing more tasks would only add
+	 * scheduling overhead without adding any parallelism.
+	 */
+	if (pthread_getspecific(task_scheduler->tls_id_key) != NULL) {
+		num_tasks = min_ii(num_tasks, (int)task_scheduler->num_sleeping_threads + 1);
+	}
+
 	state.start = start;
 	state.stop = stop;
 	state.userdata = userdata;
 	state.func = func;
 	state.iter = start;
+	state.scheduling_mode = settings->scheduling_mode;
 	switch (settings->scheduling_mode) {
 		case TASK_SCHEDULING_STATIC:
 			state.chunk_size = max_ii(
@@ -1120,6 +1543,10 @@ void BLI_task_parallel_range(const int start, const int stop,
 			/* TODO(sergey): Make it configurable from min_iter_per_thread. */
 			state.chunk_size = 32;
 			break;
+		case TASK_SCHEDULING_GUIDED:
+			/* Smallest chunk which is used in the end of the range. */
+			state.chunk_size = max_ii(1, settings->min_iter_per_thread);
+			break;
 	}
 
 	num_tasks = min_ii(num_tasks,
@@ -1133,15 +1560,31 @@ void BLI_task_parallel_range(const int start, const int stop,
 		return;
 	}
 
-	task_pool = BLI_task_pool_create_suspended(task_scheduler, &state);
+	state.num_tasks = num_tasks;
 
-	/* NOTE: This way we are adding a memory barrier and ensure all worker
-	 * threads can read and modify the value, without any locks. */
-	atomic_fetch_and_add_int32(&state.iter, 0);
+	task_pool = BLI_task_pool_create_suspended(task_scheduler, &state);
 
 	if (use_userdata_chunk) {
 		userdata_chunk_array = MALLOCA(userdata_chunk_size * num_tasks);
 	}
+	state.userdata_chunk_array = userdata_chunk_array;
+	state.userdata_chunk_size = userdata_chunk_size;
+	state.func_reduce = use_userdata_chunk ? settings->func_reduce : NULL;
+
+	if (state.func_reduce != NULL) {
+		int num_levels = 0;
+		while ((1 << num_levels) < num_tasks) {
+			num_levels++;
+		}
+		reduce_counters_size = sizeof(*reduce_counters) * num_levels * num_tasks;
+		reduce_counters = MALLOCA(reduce_counters_size);
+		memset(reduce_counters, 0, reduce_counters_size);
+	}
+	state.reduce_counters = reduce_counters;
+
+	/* NOTE: This way we are adding a memory barrier and ensure all worker
+	 * threads can read and modify the value, without any locks. */
+	atomic_fetch_and_add_int32(&state.iter, 0);
 
 	for (i = 0; i < num_tasks; i++) {
 		if (use_userdata_chunk) {
@@ -1151,7 +1594,7 @@ void BLI_task_parallel_range(const int start, const int stop,
 		/* Use this pool's pre-allocated tasks. */
 		BLI_task_pool_push_from_thread(task_pool,
 		                               parallel_range_func,
-		                               userdata_chunk_local, false,
+		                               SET_INT_IN_POINTER(i), false,
 		                               TASK_PRIORITY_HIGH,
 		                               task_pool->thread_id);
 	}
@@ -1160,6 +1603,11 @@ void BLI_task_parallel_range(const int start, const int stop,
 	BLI_task_pool_free(task_pool);
 
 	if (use_userdata_chunk) {
+		if (state.func_reduce != NULL) {
+			/* Everything is reduced to the first chunk by now. */
+			state.func_reduce(userdata, userdata_chunk, userdata_chunk_array);
+			MALLOCA_FREE(reduce_counters, reduce_counters_size);
+		}
 		if (settings->func_finalize != NULL) {
 			for (i = 0; i < num_tasks; i++) {
 				userdata_chunk_local = (char *)userdata_chunk_array + (userdata_chunk_size * i);
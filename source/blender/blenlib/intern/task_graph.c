@@ -0,0 +1,245 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenlib/intern/task_graph.c
+ *  \ingroup bli
+ *
+ * Task graph: tasks with dependencies between them, executed by the task
+ * scheduler.
+ *
+ * Every node keeps number of its predecessors. When node is finished it
+ * decrements pending counter of all its successors, and successors which
+ * became ready are scheduled right away from the same thread. One of them is
+ * executed directly as a continuation of the finished node, so long chains of
+ * nodes never go back to the scheduler queue.
+ *
+ * The graph is persistent: pending counters are restored by every node right
+ * before it runs, so the same graph can be executed again without any
+ * re-allocation or reset pass.
+ */
+
+#include <stdlib.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+
+#include "atomic_ops.h"
+
+/* Number of successors stored in a node without extra allocation. */
+#define NODE_INLINE_SUCCESSORS 4
+
+struct TaskNode {
+	TaskRunFunction run;
+	void *taskdata;
+	TaskGraphNodeFreeFunction free_taskdata;
+
+	/* Number of nodes which are to be finished before this node can run. */
+	uint32_t num_predecessors;
+	/* Number of predecessors which are not yet finished in the current
+	 * execution of the graph.
+	 */
+	uint32_t num_pending;
+
+	int num_successors;
+	int successors_alloc;
+	struct TaskNode **successors;
+	struct TaskNode *successors_inline[NODE_INLINE_SUCCESSORS];
+};
+
+struct TaskGraph {
+	BLI_mempool *nodes;
+
+	/* Nodes without predecessors, rebuilt lazily when topology changes. */
+	TaskNode **roots;
+	int num_roots;
+	bool roots_dirty;
+};
+
+TaskGraph *BLI_task_graph_create(void)
+{
+	TaskGraph *graph = MEM_callocN(sizeof(TaskGraph), "TaskGraph");
+	graph->nodes = BLI_mempool_create(sizeof(TaskNode), 0, 512, BLI_MEMPOOL_ALLOW_ITER);
+	graph->roots_dirty = true;
+	return graph;
+}
+
+void BLI_task_graph_free(TaskGraph *graph)
+{
+	BLI_mempool_iter iter;
+	TaskNode *node;
+
+	BLI_mempool_iternew(graph->nodes, &iter);
+	while ((node = BLI_mempool_iterstep(&iter)) != NULL) {
+		if (node->free_taskdata != NULL) {
+			node->free_taskdata(node->taskdata);
+		}
+		if (node->successors != node->successors_inline) {
+			MEM_freeN(node->successors);
+		}
+	}
+	BLI_mempool_destroy(graph->nodes);
+
+	if (graph->roots != NULL) {
+		MEM_freeN(graph->roots);
+	}
+	MEM_freeN(graph);
+}
+
+/**
+ * Add new node to the graph.
+ *
+ * \param run: Function to execute, pool passed to it is the one created by
+ * #BLI_task_graph_work_and_wait, so #BLI_task_pool_userdata can be used.
+ * \param free_taskdata: Optional function to free \a taskdata when graph is
+ * freed.
+ */
+TaskNode *BLI_task_graph_node_create(TaskGraph *graph,
+                                     TaskRunFunction run,
+                                     void *taskdata,
+                                     TaskGraphNodeFreeFunction free_taskdata)
+{
+	TaskNode *node = BLI_mempool_alloc(graph->nodes);
+	node->run = run;
+	node->taskdata = taskdata;
+	node->free_taskdata = free_taskdata;
+	node->num_predecessors = 0;
+	node->num_pending = 0;
+	node->num_successors = 0;
+	node->successors_alloc = NODE_INLINE_SUCCESSORS;
+	node->successors = node->successors_inline;
+	graph->roots_dirty = true;
+	return node;
+}
+
+/**
+ * Make \a to_node to be executed after \a from_node is finished.
+ *
+ * \note Graph must not be executing while edges are added, and the caller is
+ * responsible to not create cycles.
+ */
+void BLI_task_graph_edge_create(TaskGraph *graph, TaskNode *from_node, TaskNode *to_node)
+{
+	BLI_assert(from_node != to_node);
+	if (from_node->num_successors == from_node->successors_alloc) {
+		const int successors_alloc = from_node->successors_alloc * 2;
+		if (from_node->successors == from_node->successors_inline) {
+			from_node->successors = MEM_mallocN(sizeof(TaskNode *) * successors_alloc, __func__);
+			memcpy(from_node->successors,
+			       from_node->successors_inline,
+			       sizeof(TaskNode *) * from_node->num_successors);
+		}
+		else {
+			from_node->successors = MEM_reallocN(from_node->successors,
+			                                     sizeof(TaskNode *) * successors_alloc);
+		}
+		from_node->successors_alloc = successors_alloc;
+	}
+	from_node->successors[from_node->num_successors++] = to_node;
+	to_node->num_predecessors++;
+	to_node->num_pending++;
+	graph->roots_dirty = true;
+}
+
+static void task_graph_roots_update(TaskGraph *graph)
+{
+	BLI_mempool_iter iter;
+	TaskNode *node;
+	int num_roots = 0;
+
+	if (!graph->roots_dirty) {
+		return;
+	}
+
+	if (graph->roots != NULL) {
+		MEM_freeN(graph->roots);
+	}
+	graph->roots = MEM_mallocN(sizeof(TaskNode *) * BLI_mempool_len(graph->nodes), "TaskGraph roots");
+
+	BLI_mempool_iternew(graph->nodes, &iter);
+	while ((node = BLI_mempool_iterstep(&iter)) != NULL) {
+		if (node->num_predecessors == 0) {
+			graph->roots[num_roots++] = node;
+		}
+	}
+	graph->num_roots = num_roots;
+	graph->roots_dirty = false;
+}
+
+static void task_graph_node_run(TaskPool *__restrict pool, void *taskdata, int thread_id)
+{
+	TaskNode *node = taskdata;
+
+	while (node != NULL) {
+		TaskNode *continuation = NULL;
+
+		/* Nobody else touches the counter until next execution of the graph. */
+		node->num_pending = node->num_predecessors;
+
+		node->run(pool, node->taskdata, thread_id);
+
+		BLI_task_pool_delayed_push_begin(pool, thread_id);
+		for (int i = 0; i < node->num_successors; i++) {
+			TaskNode *successor = node->successors[i];
+			if (atomic_sub_and_fetch_uint32(&successor->num_pending, 1) != 0) {
+				continue;
+			}
+			/* First ready successor is handled by this thread right away,
+			 * others are given to the scheduler.
+			 */
+			if (continuation == NULL) {
+				continuation = successor;
+			}
+			else {
+				BLI_task_pool_push_from_thread(pool, task_graph_node_run, successor, false,
+				                               TASK_PRIORITY_HIGH, thread_id);
+			}
+		}
+		BLI_task_pool_delayed_push_end(pool, thread_id);
+
+		node = continuation;
+	}
+}
+
+/**
+ * Execute all nodes of the graph respecting dependencies, and wait for them
+ * to be finished. Can be called multiple times on the same graph.
+ *
+ * \param userdata: Accessible from node functions via #BLI_task_pool_userdata.
+ */
+void BLI_task_graph_work_and_wait(TaskGraph *graph, TaskScheduler *scheduler, void *userdata)
+{
+	TaskPool *pool;
+
+	task_graph_roots_update(graph);
+	if (graph->num_roots == 0) {
+		BLI_assert(BLI_mempool_len(graph->nodes) == 0 || !"Task graph has cycles");
+		return;
+	}
+
+	pool = BLI_task_pool_create_suspended(scheduler, userdata);
+	for (int i = 0; i < graph->num_roots; i++) {
+		BLI_task_pool_push(pool, task_graph_node_run, graph->roots[i], false, TASK_PRIORITY_HIGH);
+	}
+	BLI_task_pool_work_and_wait(pool);
+	BLI_task_pool_free(pool);
+}
@@ -0,0 +1,247 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenloader/intern/oldnewmap.c
+ *  \ingroup blenloader
+ *
+ * Pointer map used while reading files, old (file) addresses are the keys.
+ *
+ * Entries are stored in insertion order so callers can iterate over them,
+ * lookups go through an open addressing table (linear probing) of indices into the entries.
+ * When the same old address is inserted twice, the most recent entry is found.
+ *
+ * Since data is mostly read in the order it was written, the entry after the last hit
+ * is checked before the table.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+
+#include "oldnewmap.h"
+
+#define MAP_BIT_DEFAULT 11  /* 2048 slots, for 1024 entries */
+#define ENTRIES_DEFAULT 1024
+
+#define SLOT_EMPTY -1
+
+/* Fibonacci hashing, take the high bits since the low bits of aligned pointers are always zero. */
+BLI_INLINE uint oldnewmap_hash(const void *addr, const uint map_bit)
+{
+	return (uint)(((uint64_t)(uintptr_t)addr * 11400714819323198485ull) >> (64 - map_bit));
+}
+
+/* Keep the table at most half full. */
+BLI_INLINE uint oldnewmap_map_bit_for_entries(int nentries)
+{
+	uint map_bit = MAP_BIT_DEFAULT;
+	while (((size_t)1 << map_bit) < (size_t)nentries * 2) {
+		map_bit++;
+	}
+	return map_bit;
+}
+
+static void oldnewmap_map_insert(OldNewMap *onm, const void *addr, const int index)
+{
+	const uint mask = (1u << onm->map_bit) - 1;
+	uint slot = oldnewmap_hash(addr, onm->map_bit);
+
+	while (onm->map[slot] != SLOT_EMPTY) {
+		if (onm->entries[onm->map[slot]].old == addr) {
+			onm->has_duplicates = true;
+			break;
+		}
+		slot = (slot + 1) & mask;
+	}
+	onm->map[slot] = index;
+}
+
+static void oldnewmap_map_alloc(OldNewMap *onm, const uint map_bit)
+{
+	const size_t map_size = (size_t)1 << map_bit;
+
+	onm->map_bit = map_bit;
+	onm->map = MEM_malloc_arrayN(map_size, sizeof(*onm->map), "OldNewMap.map");
+	memset(onm->map, 0xff, sizeof(*onm->map) * map_size);
+}
+
+static void oldnewmap_map_rebuild(OldNewMap *onm, const uint map_bit)
+{
+	int i;
+
+	MEM_freeN(onm->map);
+	oldnewmap_map_alloc(onm, map_bit);
+
+	for (i = 0; i < onm->nentries; i++) {
+		oldnewmap_map_insert(onm, onm->entries[i].old, i);
+	}
+}
+
+OldNewMap *blo_oldnewmap_new(void)
+{
+	OldNewMap *onm = MEM_callocN(sizeof(*onm), "OldNewMap");
+
+	onm->entriessize = ENTRIES_DEFAULT;
+	onm->entries = MEM_malloc_arrayN(onm->entriessize, sizeof(*onm->entries), "OldNewMap.entries");
+	oldnewmap_map_alloc(onm, MAP_BIT_DEFAULT);
+	onm->lasthit = -1;
+
+	return onm;
+}
+
+/**
+ * Make room for \a nentries in total without further reallocation,
+ * when the number of entries is known in advance (the number of ID blocks for example).
+ */
+void blo_oldnewmap_reserve(OldNewMap *onm, int nentries)
+{
+	const uint map_bit = oldnewmap_map_bit_for_entries(nentries);
+
+	if (nentries > onm->entriessize) {
+		onm->entriessize = nentries;
+		onm->entries = MEM_reallocN(onm->entries, sizeof(*onm->entries) * onm->entriessize);
+	}
+	if (map_bit > onm->map_bit) {
+		oldnewmap_map_rebuild(onm, map_bit);
+	}
+}
+
+/* nr is zero for data, and ID code for libdata */
+void blo_oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr, int nr)
+{
+	OldNew *entry;
+
+	if (oldaddr == NULL || newaddr == NULL) return;
+
+	if (UNLIKELY(onm->nentries == onm->entriessize)) {
+		onm->entriessize *= 2;
+		onm->entries = MEM_reallocN(onm->entries, sizeof(*onm->entries) * onm->entriessize);
+	}
+	if (UNLIKELY(((size_t)onm->nentries + 1) * 2 > ((size_t)1 << onm->map_bit))) {
+		oldnewmap_map_rebuild(onm, onm->map_bit + 1);
+	}
+
+	entry = &onm->entries[onm->nentries];
+	entry->old = oldaddr;
+	entry->newp = newaddr;
+	entry->nr = nr;
+
+	oldnewmap_map_insert(onm, oldaddr, onm->nentries);
+	onm->nentries++;
+}
+
+OldNew *blo_oldnewmap_lookup_entry(const OldNewMap *onm, const void *addr)
+{
+	const uint mask = (1u << onm->map_bit) - 1;
+	uint slot;
+	int index;
+
+	if (addr == NULL) return NULL;
+
+	slot = oldnewmap_hash(addr, onm->map_bit);
+	while ((index = onm->map[slot]) != SLOT_EMPTY) {
+		OldNew *entry = &onm->entries[index];
+		if (entry->old == addr) {
+			return entry;
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	return NULL;
+}
+
+void *blo_oldnewmap_lookup_and_inc(OldNewMap *onm, const void *addr, bool increase_users)
+{
+	OldNew *entry = NULL;
+
+	if (onm->lasthit + 1 < onm->nentries && !onm->has_duplicates) {
+		OldNew *next = &onm->entries[onm->lasthit + 1];
+		if (next->old == addr && addr != NULL) {
+			entry = next;
+		}
+	}
+	if (entry == NULL) {
+		entry = blo_oldnewmap_lookup_entry(onm, addr);
+	}
+
+	if (entry) {
+		onm->lasthit = (int)(entry - onm->entries);
+		if (increase_users)
+			entry->nr++;
+		return entry->newp;
+	}
+
+	return NULL;
+}
+
+void blo_oldnewmap_free_unused(OldNewMap *onm)
+{
+	int i;
+
+	for (i = 0; i < onm->nentries; i++) {
+		OldNew *entry = &onm->entries[i];
+		if (entry->nr == 0) {
+			MEM_freeN(entry->newp);
+			entry->newp = NULL;
+		}
+	}
+}
+
+/**
+ * The data map is cleared after every ID, most of the time with only a few entries,
+ * so only the used slots are cleared instead of the whole table.
+ */
+void blo_oldnewmap_clear(OldNewMap *onm)
+{
+	const uint mask = (1u << onm->map_bit) - 1;
+	int i;
+
+	if (UNLIKELY(onm->has_duplicates)) {
+		/* A duplicate took over the slot of an earlier entry, which probe sequences of
+		 * entries in between may go through, so they can't be cleared one by one. */
+		memset(onm->map, 0xff, sizeof(*onm->map) << onm->map_bit);
+		onm->nentries = 0;
+	}
+
+	/* Slots before an entry in its probe sequence were taken by earlier entries,
+	 * clearing in reverse insertion order keeps them until the entry itself is cleared. */
+	for (i = onm->nentries - 1; i >= 0; i--) {
+		uint slot = oldnewmap_hash(onm->entries[i].old, onm->map_bit);
+		while (onm->map[slot] != SLOT_EMPTY) {
+			if (onm->map[slot] == i) {
+				onm->map[slot] = SLOT_EMPTY;
+				break;
+			}
+			slot = (slot + 1) & mask;
+		}
+	}
+	onm->nentries = 0;
+	onm->lasthit = -1;
+	onm->has_duplicates = false;
+}
+
+void blo_oldnewmap_free(OldNewMap *onm)
+{
+	MEM_freeN(onm->entries);
+	MEM_freeN(onm->map);
+	MEM_freeN(onm);
+}
@@ -0,0 +1,70 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenloader/intern/oldnewmap.h
+ *  \ingroup blenloader
+ *
+ * Map from pointers stored in the file to the newly allocated data.
+ */
+
+#ifndef __OLDNEWMAP_H__
+#define __OLDNEWMAP_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "BLI_sys_types.h"
+
+typedef struct OldNew {
+	const void *old;
+	void *newp;
+	int nr;
+} OldNew;
+
+typedef struct OldNewMap {
+	/* All inserted entries in insertion order, can be iterated directly. */
+	OldNew *entries;
+	int nentries, entriessize;
+
+	/* Open addressing table of indices into entries, -1 for empty slots. */
+	int *map;
+	uint map_bit;
+
+	/* Index of the last entry found, data is mostly read in the order it was written. */
+	int lasthit;
+	/* Some old address was inserted twice, the entry after lasthit may not be the latest one. */
+	bool has_duplicates;
+} OldNewMap;
+
+OldNewMap *blo_oldnewmap_new(void);
+void       blo_oldnewmap_reserve(OldNewMap *onm, int nentries);
+void       blo_oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr, int nr);
+OldNew    *blo_oldnewmap_lookup_entry(const OldNewMap *onm, const void *addr);
+void      *blo_oldnewmap_lookup_and_inc(OldNewMap *onm, const void *addr, bool increase_users);
+void       blo_oldnewmap_free_unused(OldNewMap *onm);
+void       blo_oldnewmap_clear(OldNewMap *onm);
+void       blo_oldnewmap_free(OldNewMap *onm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __OLDNEWMAP_H__ */
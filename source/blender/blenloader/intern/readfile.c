@@ -46,6 +46,7 @@
 #include "BLI_utildefines.h"
 #ifndef WIN32
 #  include <unistd.h> // for read close
+#  include <sys/mman.h> // for mmap
 #else
 #  include <io.h> // for open close read
 #  include "winsock2.h"
@@ -116,6 +117,7 @@
 
 #include "BLI_endian_switch.h"
 #include "BLI_blenlib.h"
+#include "BLI_gzip_reader.h"
 #include "BLI_math.h"
 #include "BLI_threads.h"
 #include "BLI_mempool.h"
@@ -173,6 +175,7 @@
 #include "RE_engine.h"
 
 #include "readfile.h"
+#include "oldnewmap.h"
 
 
 #include <errno.h>
@@ -233,6 +236,12 @@
 /* Use GHash for restoring pointers by name */
 #define USE_GHASH_RESTORE_POINTER
 
+/* Map uncompressed files in memory instead of reading all blocks.
+ * The mmap emulation on Windows has no copy-on-write of private mappings. */
+#ifndef WIN32
+#  define USE_BHEAD_MMAP
+#endif
+
 /* Define this to have verbose debug prints. */
 #define USE_DEBUG_PRINT
 
@@ -244,20 +253,6 @@
 
 /***/
 
-typedef struct OldNew {
-	const void *old;
-	void *newp;
-	int nr;
-} OldNew;
-
-typedef struct OldNewMap {
-	OldNew *entries;
-	int nentries, entriessize;
-	bool sorted;
-	int lasthit;
-} OldNewMap;
-
-
 /* local prototypes */
 static void *read_struct(FileData *fd, BHead *bh, const char *blockname);
 static void direct_link_modifiers(FileData *fd, ListBase *lb);
@@ -299,195 +294,27 @@ static const char *library_parent_filepath(Library *lib)
 	return lib->parent ? lib->parent->filepath : "<direct>";
 }
 
-static OldNewMap *oldnewmap_new(void) 
-{
-	OldNewMap *onm= MEM_callocN(sizeof(*onm), "OldNewMap");
-	
-	onm->entriessize = 1024;
-	onm->entries = MEM_malloc_arrayN(onm->entriessize, sizeof(*onm->entries), "OldNewMap.entries");
-	
-	return onm;
-}
-
-static int verg_oldnewmap(const void *v1, const void *v2)
-{
-	const struct OldNew *x1=v1, *x2=v2;
-	
-	if (x1->old > x2->old) return 1;
-	else if (x1->old < x2->old) return -1;
-	return 0;
-}
-
-
-static void oldnewmap_sort(FileData *fd) 
-{
-	BLI_assert(fd->libmap->sorted == false);
-	qsort(fd->libmap->entries, fd->libmap->nentries, sizeof(OldNew), verg_oldnewmap);
-	fd->libmap->sorted = 1;
-}
-
-/* nr is zero for data, and ID code for libdata */
-static void oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr, int nr)
-{
-	OldNew *entry;
-	
-	if (oldaddr==NULL || newaddr==NULL) return;
-	
-	if (UNLIKELY(onm->nentries == onm->entriessize)) {
-		onm->entriessize *= 2;
-		onm->entries = MEM_reallocN(onm->entries, sizeof(*onm->entries) * onm->entriessize);
-	}
-
-	entry = &onm->entries[onm->nentries++];
-	entry->old = oldaddr;
-	entry->newp = newaddr;
-	entry->nr = nr;
-}
-
 void blo_do_versions_oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr, int nr)
 {
-	oldnewmap_insert(onm, oldaddr, newaddr, nr);
-}
-
-/**
- * Do a full search (no state).
- *
- * \param lasthit: Use as a reference position to avoid a full search
- * from either end of the array, giving more efficient lookups.
- *
- * \note This would seem an ideal case for hash or btree lookups.
- * However the data is written in-order, using the \a lasthit will normally avoid calling this function.
- * Creating a btree/hash structure adds overhead for the common-case to optimize the corner-case
- * (since most entries will never be retrieved).
- * So just keep full lookups as a fall-back.
- */
-static int oldnewmap_lookup_entry_full(const OldNewMap *onm, const void *addr, int lasthit)
-{
-	const int nentries = onm->nentries;
-	const OldNew *entries = onm->entries;
-	int i;
-
-	/* search relative to lasthit where possible */
-	if (lasthit >= 0 && lasthit < nentries) {
-
-		/* search forwards */
-		i = lasthit;
-		while (++i != nentries) {
-			if (entries[i].old == addr) {
-				return i;
-			}
-		}
-
-		/* search backwards */
-		i = lasthit + 1;
-		while (i--) {
-			if (entries[i].old == addr) {
-				return i;
-			}
-		}
-	}
-	else {
-		/* search backwards (full) */
-		i = nentries;
-		while (i--) {
-			if (entries[i].old == addr) {
-				return i;
-			}
-		}
-	}
-
-	return -1;
-}
-
-static void *oldnewmap_lookup_and_inc(OldNewMap *onm, const void *addr, bool increase_users)
-{
-	int i;
-	
-	if (addr == NULL) return NULL;
-	
-	if (onm->lasthit < onm->nentries-1) {
-		OldNew *entry = &onm->entries[++onm->lasthit];
-		
-		if (entry->old == addr) {
-			if (increase_users)
-				entry->nr++;
-			return entry->newp;
-		}
-	}
-	
-	i = oldnewmap_lookup_entry_full(onm, addr, onm->lasthit);
-	if (i != -1) {
-		OldNew *entry = &onm->entries[i];
-		BLI_assert(entry->old == addr);
-		onm->lasthit = i;
-		if (increase_users)
-			entry->nr++;
-		return entry->newp;
-	}
-	
-	return NULL;
+	blo_oldnewmap_insert(onm, oldaddr, newaddr, nr);
 }
 
 /* for libdata, nr has ID code, no increment */
 static void *oldnewmap_liblookup(OldNewMap *onm, const void *addr, const void *lib)
 {
-	if (addr == NULL) {
-		return NULL;
-	}
+	OldNew *entry = blo_oldnewmap_lookup_entry(onm, addr);
 
-	/* lasthit works fine for non-libdata, linking there is done in same sequence as writing */
-	if (onm->sorted) {
-		const OldNew entry_s = {.old = addr};
-		OldNew *entry = bsearch(&entry_s, onm->entries, onm->nentries, sizeof(OldNew), verg_oldnewmap);
-		if (entry) {
-			ID *id = entry->newp;
+	if (entry) {
+		ID *id = entry->newp;
 
-			if (id && (!lib || id->lib)) {
-				return id;
-			}
-		}
-	}
-	else {
-		/* note, this can be a bottle neck when loading some files */
-		const int i = oldnewmap_lookup_entry_full(onm, addr, -1);
-		if (i != -1) {
-			OldNew *entry = &onm->entries[i];
-			ID *id = entry->newp;
-			BLI_assert(entry->old == addr);
-			if (id && (!lib || id->lib)) {
-				return id;
-			}
+		if (id && (!lib || id->lib)) {
+			return id;
 		}
 	}
 
 	return NULL;
 }
 
-static void oldnewmap_free_unused(OldNewMap *onm) 
-{
-	int i;
-
-	for (i = 0; i < onm->nentries; i++) {
-		OldNew *entry = &onm->entries[i];
-		if (entry->nr == 0) {
-			MEM_freeN(entry->newp);
-			entry->newp = NULL;
-		}
-	}
-}
-
-static void oldnewmap_clear(OldNewMap *onm) 
-{
-	onm->nentries = 0;
-	onm->lasthit = 0;
-}
-
-static void oldnewmap_free(OldNewMap *onm) 
-{
-	MEM_freeN(onm->entries);
-	MEM_freeN(onm);
-}
-
 /***/
 
 static void read_libraries(FileData *basefd, ListBase *mainlist);
@@ -812,13 +639,32 @@ static BHeadN *get_bhead(FileData *fd)
 			/* bhead now contains the (converted) bhead structure. Now read
 			 * the associated data and put everything in a BHeadN (creative naming !)
 			 */
+#ifdef USE_BHEAD_MMAP
+			if (!fd->eof && fd->mmap_data) {
+				/* Reference the data in place, it's only copied by the system when written to. */
+				if ((size_t)bhead.len <= fd->mmap_size - fd->mmap_seek) {
+					new_bhead = MEM_mallocN(sizeof(BHeadN), "new_bhead");
+					new_bhead->next = new_bhead->prev = NULL;
+					new_bhead->data = fd->mmap_data + fd->mmap_seek;
+					new_bhead->bhead = bhead;
+
+					fd->mmap_seek += (size_t)bhead.len;
+					fd->seek += bhead.len;
+				}
+				else {
+					fd->eof = 1;
+				}
+			}
+			else
+#endif
 			if (!fd->eof) {
 				new_bhead = MEM_mallocN(sizeof(BHeadN) + bhead.len, "new_bhead");
 				if (new_bhead) {
 					new_bhead->next = new_bhead->prev = NULL;
+					new_bhead->data = new_bhead + 1;
 					new_bhead->bhead = bhead;
 					
-					readsize = fd->read(fd, new_bhead + 1, bhead.len);
+					readsize = fd->read(fd, new_bhead->data, bhead.len);
 					
 					if (readsize != bhead.len) {
 						fd->eof = 1;
@@ -897,10 +743,19 @@ BHead *blo_nextbhead(FileData *fd, BHead *thisblock)
 	return(bhead);
 }
 
+/**
+ * \return Data of the block, which follows the BHead in the file.
+ */
+void *bhead_data(const BHead *bhead)
+{
+	const BHeadN *bheadn = (const BHeadN *)POINTER_OFFSET(bhead, -offsetof(BHeadN, bhead));
+	return bheadn->data;
+}
+
 /* Warning! Caller's responsibility to ensure given bhead **is** and ID one! */
 const char *bhead_id_name(const FileData *fd, const BHead *bhead)
 {
-	return (const char *)POINTER_OFFSET(bhead, sizeof(*bhead) + fd->id_name_offs);
+	return (const char *)POINTER_OFFSET(bhead_data(bhead), fd->id_name_offs);
 }
 
 static void decode_blender_header(FileData *fd)
@@ -957,10 +812,10 @@ static bool read_file_dna(FileData *fd, const char **r_error_message)
 		if (bhead->code == DNA1) {
 			const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
 			
-			fd->filesdna = DNA_sdna_from_data(&bhead[1], bhead->len, do_endian_swap, true, r_error_message);
+			fd->filesdna = DNA_sdna_from_data(bhead_data(bhead), bhead->len, do_endian_swap, true, r_error_message);
 			if (fd->filesdna) {
 				fd->compflags = DNA_struct_get_compareflags(fd->filesdna, fd->memsdna);
-				/* used to retrieve ID names from (bhead+1) */
+				/* used to retrieve ID names from bhead_data() */
 				fd->id_name_offs = DNA_elem_offset(fd->filesdna, "ID", "char", "name[]");
 
 				return true;
@@ -978,6 +833,23 @@ static bool read_file_dna(FileData *fd, const char **r_error_message)
 	return false;
 }
 
+static int fd_count_id_bheads(FileData *fd)
+{
+	BHead *bhead;
+	int count = 0;
+
+	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
+		if (bhead->code == ENDB) {
+			break;
+		}
+		else if (BKE_idcode_is_valid(bhead->code)) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
 static int *read_file_thumbnail(FileData *fd)
 {
 	BHead *bhead;
@@ -986,7 +858,7 @@ static int *read_file_thumbnail(FileData *fd)
 	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
 		if (bhead->code == TEST) {
 			const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
-			int *data = (int *)(bhead + 1);
+			int *data = bhead_data(bhead);
 
 			if (bhead->len < (2 * sizeof(int))) {
 				break;
@@ -1047,6 +919,33 @@ static int fd_read_gzip_from_file(FileData *filedata, void *buffer, unsigned int
 	return (readsize);
 }
 
+#ifdef USE_BHEAD_MMAP
+static int fd_read_from_mmap(FileData *filedata, void *buffer, unsigned int size)
+{
+	const size_t readsize = MIN2(size, filedata->mmap_size - filedata->mmap_seek);
+
+	memcpy(buffer, filedata->mmap_data + filedata->mmap_seek, readsize);
+	filedata->mmap_seek += readsize;
+	filedata->seek += (int)readsize;
+
+	return (int)readsize;
+}
+#endif
+
+static int fd_read_gzip_blocks_from_file(FileData *filedata, void *buffer, unsigned int size)
+{
+	int readsize = BLI_gzip_reader_read(filedata->gzreader, buffer, size);
+
+	if (readsize < 0) {
+		readsize = EOF;
+	}
+	else {
+		filedata->seek += readsize;
+	}
+
+	return readsize;
+}
+
 static int fd_read_from_memory(FileData *filedata, void *buffer, unsigned int size)
 {
 	/* don't read more bytes then there are available in the buffer */
@@ -1126,9 +1025,9 @@ static FileData *filedata_new(void)
 
 	fd->memsdna = DNA_sdna_current_get();
 
-	fd->datamap = oldnewmap_new();
-	fd->globmap = oldnewmap_new();
-	fd->libmap = oldnewmap_new();
+	fd->datamap = blo_oldnewmap_new();
+	fd->globmap = blo_oldnewmap_new();
+	fd->libmap = blo_oldnewmap_new();
 	
 	return fd;
 }
@@ -1156,29 +1055,107 @@ static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
 	return fd;
 }
 
-/* cannot be called with relative paths anymore! */
-/* on each new library added, it now checks for the current FileData and expands relativeness */
-FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
+#ifdef USE_BHEAD_MMAP
+/**
+ * Map an uncompressed file in memory. Block data is referenced in place and
+ * copied by the system only for pages which are written to (endian switching),
+ * data of blocks which are never read (e.g. most of a library file when only
+ * some IDs are linked) is not loaded at all.
+ *
+ * \note The mapping stays valid after the file is closed. Saving never
+ * truncates the file in place (a temporary file is renamed), so the mapped
+ * data stays valid while Blender overwrites the file.
+ */
+static FileData *blo_filedata_from_file_mmap(int file)
+{
+	FileData *fd;
+	char header[7];
+	char *data;
+
+	const size_t size = BLI_file_descriptor_size(file);
+	if (size == (size_t)-1 || size < SIZEOFBLENDERHEADER ||
+	    lseek(file, 0, SEEK_SET) != 0 ||
+	    read(file, header, sizeof(header)) != sizeof(header) ||
+	    !STREQLEN(header, "BLENDER", sizeof(header)))
+	{
+		return NULL;
+	}
+
+	data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+	if (data == MAP_FAILED) {
+		return NULL;
+	}
+
+	fd = filedata_new();
+	fd->mmap_data = data;
+	fd->mmap_size = size;
+	fd->read = fd_read_from_mmap;
+
+	return fd;
+}
+#endif
+
+/**
+ * Open the file for reading. Files written with parallel compression are
+ * decompressed in parallel, uncompressed files are memory mapped when
+ * supported, anything else goes through zlib.
+ */
+static FileData *blo_filedata_from_file_open(const char *filepath, ReportList *reports)
 {
+	FileData *fd = NULL;
 	gzFile gzfile;
+	int file;
+
+	errno = 0;
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file != -1) {
+		GzipReader *gzreader = BLI_gzip_reader_new(file, BLI_task_scheduler_get());
+		if (gzreader != NULL) {
+			fd = filedata_new();
+			fd->filedes = file;
+			fd->gzreader = gzreader;
+			fd->read = fd_read_gzip_blocks_from_file;
+			return fd;
+		}
+#ifdef USE_BHEAD_MMAP
+		fd = blo_filedata_from_file_mmap(file);
+#endif
+		close(file);
+		if (fd != NULL) {
+			return fd;
+		}
+	}
+
 	errno = 0;
 	gzfile = BLI_gzopen(filepath, "rb");
-	
+
 	if (gzfile == (gzFile)Z_NULL) {
 		BKE_reportf(reports, RPT_WARNING, "Unable to open '%s': %s",
 		            filepath, errno ? strerror(errno) : TIP_("unknown error reading file"));
 		return NULL;
 	}
-	else {
-		FileData *fd = filedata_new();
-		fd->gzfiledes = gzfile;
-		fd->read = fd_read_gzip_from_file;
-		
-		/* needed for library_append and read_libraries */
-		BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
-		
-		return blo_decode_and_check(fd, reports);
+
+	fd = filedata_new();
+	fd->gzfiledes = gzfile;
+	fd->read = fd_read_gzip_from_file;
+
+	return fd;
+}
+
+/* cannot be called with relative paths anymore! */
+/* on each new library added, it now checks for the current FileData and expands relativeness */
+FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
+{
+	FileData *fd = blo_filedata_from_file_open(filepath, reports);
+
+	if (fd == NULL) {
+		return NULL;
 	}
+
+	/* needed for library_append and read_libraries */
+	BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
+
+	return blo_decode_and_check(fd, reports);
 }
 
 /**
@@ -1298,9 +1275,19 @@ FileData *blo_openblendermemfile(MemFile *memfile, ReportList *reports)
 void blo_freefiledata(FileData *fd)
 {
 	if (fd) {
+		if (fd->gzreader != NULL) {
+			BLI_gzip_reader_free(fd->gzreader);
+		}
+
 		if (fd->filedes != -1) {
 			close(fd->filedes);
 		}
+
+#ifdef USE_BHEAD_MMAP
+		if (fd->mmap_data) {
+			munmap(fd->mmap_data, fd->mmap_size);
+		}
+#endif
 		
 		if (fd->gzfiledes != NULL) {
 			gzclose(fd->gzfiledes);
@@ -1326,19 +1313,19 @@ void blo_freefiledata(FileData *fd)
 			MEM_freeN((void *)fd->compflags);
 		
 		if (fd->datamap)
-			oldnewmap_free(fd->datamap);
+			blo_oldnewmap_free(fd->datamap);
 		if (fd->globmap)
-			oldnewmap_free(fd->globmap);
+			blo_oldnewmap_free(fd->globmap);
 		if (fd->imamap)
-			oldnewmap_free(fd->imamap);
+			blo_oldnewmap_free(fd->imamap);
 		if (fd->movieclipmap)
-			oldnewmap_free(fd->movieclipmap);
+			blo_oldnewmap_free(fd->movieclipmap);
 		if (fd->soundmap)
-			oldnewmap_free(fd->soundmap);
+			blo_oldnewmap_free(fd->soundmap);
 		if (fd->packedmap)
-			oldnewmap_free(fd->packedmap);
+			blo_oldnewmap_free(fd->packedmap);
 		if (fd->libmap && !(fd->flags & FD_FLAGS_NOT_MY_LIBMAP))
-			oldnewmap_free(fd->libmap);
+			blo_oldnewmap_free(fd->libmap);
 		if (fd->bheadmap)
 			MEM_freeN(fd->bheadmap);
 		
@@ -1475,71 +1462,46 @@ BlendThumbnail *BLO_thumbnail_from_file(const char *filepath)
 
 static void *newdataadr(FileData *fd, const void *adr)		/* only direct databocks */
 {
-	return oldnewmap_lookup_and_inc(fd->datamap, adr, true);
-}
-
-/* This is a special version of newdataadr() which allows us to keep lasthit of
- * map unchanged. In certain cases this makes file loading time significantly
- * faster.
- *
- * Use this function in cases like restoring pointer from one list element to
- * another list element, but keep lasthit value so we can continue restoring
- * pointers efficiently.
- *
- * Example of this could be found in direct_link_fcurves() which restores the
- * fcurve group pointer and keeps lasthit optimal for linking all further
- * fcurves.
- */
-static void *newdataadr_ex(FileData *fd, const void *adr, bool increase_lasthit)		/* only direct databocks */
-{
-	if (increase_lasthit) {
-		return newdataadr(fd, adr);
-	}
-	else {
-		int lasthit = fd->datamap->lasthit;
-		void *newadr = newdataadr(fd, adr);
-		fd->datamap->lasthit = lasthit;
-		return newadr;
-	}
+	return blo_oldnewmap_lookup_and_inc(fd->datamap, adr, true);
 }
 
 static void *newdataadr_no_us(FileData *fd, const void *adr)		/* only direct databocks */
 {
-	return oldnewmap_lookup_and_inc(fd->datamap, adr, false);
+	return blo_oldnewmap_lookup_and_inc(fd->datamap, adr, false);
 }
 
 static void *newglobadr(FileData *fd, const void *adr)	    /* direct datablocks with global linking */
 {
-	return oldnewmap_lookup_and_inc(fd->globmap, adr, true);
+	return blo_oldnewmap_lookup_and_inc(fd->globmap, adr, true);
 }
 
 static void *newimaadr(FileData *fd, const void *adr)		    /* used to restore image data after undo */
 {
 	if (fd->imamap && adr)
-		return oldnewmap_lookup_and_inc(fd->imamap, adr, true);
+		return blo_oldnewmap_lookup_and_inc(fd->imamap, adr, true);
 	return NULL;
 }
 
 static void *newmclipadr(FileData *fd, const void *adr)      /* used to restore movie clip data after undo */
 {
 	if (fd->movieclipmap && adr)
-		return oldnewmap_lookup_and_inc(fd->movieclipmap, adr, true);
+		return blo_oldnewmap_lookup_and_inc(fd->movieclipmap, adr, true);
 	return NULL;
 }
 
 static void *newsoundadr(FileData *fd, const void *adr)      /* used to restore sound data after undo */
 {
 	if (fd->soundmap && adr)
-		return oldnewmap_lookup_and_inc(fd->soundmap, adr, true);
+		return blo_oldnewmap_lookup_and_inc(fd->soundmap, adr, true);
 	return NULL;
 }
 
 static void *newpackedadr(FileData *fd, const void *adr)      /* used to restore packed data after undo */
 {
 	if (fd->packedmap && adr)
-		return oldnewmap_lookup_and_inc(fd->packedmap, adr, true);
+		return blo_oldnewmap_lookup_and_inc(fd->packedmap, adr, true);
 	
-	return oldnewmap_lookup_and_inc(fd->datamap, adr, true);
+	return blo_oldnewmap_lookup_and_inc(fd->datamap, adr, true);
 }
 
 
@@ -1580,9 +1542,6 @@ static void change_idid_adr_fd(FileData *fd, const void *old, void *new)
 {
 	int i;
 	
-	/* use a binary search if we have a sorted libmap, for now it's not needed. */
-	BLI_assert(fd->libmap->sorted == false);
-
 	for (i = 0; i < fd->libmap->nentries; i++) {
 		OldNew *entry = &fd->libmap->entries[i];
 		
@@ -1631,26 +1590,26 @@ void blo_make_image_pointer_map(FileData *fd, Main *oldmain)
 	Scene *sce = oldmain->scene.first;
 	int a;
 	
-	fd->imamap = oldnewmap_new();
+	fd->imamap = blo_oldnewmap_new();
 	
 	for (; ima; ima = ima->id.next) {
 		if (ima->cache)
-			oldnewmap_insert(fd->imamap, ima->cache, ima->cache, 0);
+			blo_oldnewmap_insert(fd->imamap, ima->cache, ima->cache, 0);
 		for (a = 0; a < TEXTARGET_COUNT; a++)
 			if (ima->gputexture[a])
-				oldnewmap_insert(fd->imamap, ima->gputexture[a], ima->gputexture[a], 0);
+				blo_oldnewmap_insert(fd->imamap, ima->gputexture[a], ima->gputexture[a], 0);
 		if (ima->rr)
-			oldnewmap_insert(fd->imamap, ima->rr, ima->rr, 0);
+			blo_oldnewmap_insert(fd->imamap, ima->rr, ima->rr, 0);
 		for (a=0; a < IMA_MAX_RENDER_SLOT; a++)
 			if (ima->renders[a])
-				oldnewmap_insert(fd->imamap, ima->renders[a], ima->renders[a], 0);
+				blo_oldnewmap_insert(fd->imamap, ima->renders[a], ima->renders[a], 0);
 	}
 	for (; sce; sce = sce->id.next) {
 		if (sce->nodetree && sce->nodetree->previews) {
 			bNodeInstanceHashIterator iter;
 			NODE_INSTANCE_HASH_ITER(iter, sce->nodetree->previews) {
 				bNodePreview *preview = BKE_node_instance_hash_iterator_get_value(&iter);
-				oldnewmap_insert(fd->imamap, preview, preview, 0);
+				blo_oldnewmap_insert(fd->imamap, preview, preview, 0);
 			}
 		}
 	}
@@ -1715,14 +1674,14 @@ void blo_make_movieclip_pointer_map(FileData *fd, Main *oldmain)
 	MovieClip *clip = oldmain->movieclip.first;
 	Scene *sce = oldmain->scene.first;
 	
-	fd->movieclipmap = oldnewmap_new();
+	fd->movieclipmap = blo_oldnewmap_new();
 	
 	for (; clip; clip = clip->id.next) {
 		if (clip->cache)
-			oldnewmap_insert(fd->movieclipmap, clip->cache, clip->cache, 0);
+			blo_oldnewmap_insert(fd->movieclipmap, clip->cache, clip->cache, 0);
 		
 		if (clip->tracking.camera.intrinsics)
-			oldnewmap_insert(fd->movieclipmap, clip->tracking.camera.intrinsics, clip->tracking.camera.intrinsics, 0);
+			blo_oldnewmap_insert(fd->movieclipmap, clip->tracking.camera.intrinsics, clip->tracking.camera.intrinsics, 0);
 	}
 	
 	for (; sce; sce = sce->id.next) {
@@ -1730,7 +1689,7 @@ void blo_make_movieclip_pointer_map(FileData *fd, Main *oldmain)
 			bNode *node;
 			for (node = sce->nodetree->nodes.first; node; node = node->next)
 				if (node->type == CMP_NODE_MOVIEDISTORTION)
-					oldnewmap_insert(fd->movieclipmap, node->storage, node->storage, 0);
+					blo_oldnewmap_insert(fd->movieclipmap, node->storage, node->storage, 0);
 		}
 	}
 }
@@ -1769,11 +1728,11 @@ void blo_make_sound_pointer_map(FileData *fd, Main *oldmain)
 {
 	bSound *sound = oldmain->sound.first;
 	
-	fd->soundmap = oldnewmap_new();
+	fd->soundmap = blo_oldnewmap_new();
 	
 	for (; sound; sound = sound->id.next) {
 		if (sound->waveform)
-			oldnewmap_insert(fd->soundmap, sound->waveform, sound->waveform, 0);			
+			blo_oldnewmap_insert(fd->soundmap, sound->waveform, sound->waveform, 0);			
 	}
 }
 
@@ -1800,8 +1759,8 @@ void blo_end_sound_pointer_map(FileData *fd, Main *oldmain)
 
 static void insert_packedmap(FileData *fd, PackedFile *pf)
 {
-	oldnewmap_insert(fd->packedmap, pf, pf, 0);
-	oldnewmap_insert(fd->packedmap, pf->data, pf->data, 0);
+	blo_oldnewmap_insert(fd->packedmap, pf, pf, 0);
+	blo_oldnewmap_insert(fd->packedmap, pf->data, pf->data, 0);
 }
 
 void blo_make_packed_pointer_map(FileData *fd, Main *oldmain)
@@ -1811,7 +1770,7 @@ void blo_make_packed_pointer_map(FileData *fd, Main *oldmain)
 	bSound *sound;
 	Library *lib;
 	
-	fd->packedmap = oldnewmap_new();
+	fd->packedmap = blo_oldnewmap_new();
 	
 	for (ima = oldmain->image.first; ima; ima = ima->id.next) {
 		ImagePackedFile *imapf;
@@ -1886,7 +1845,7 @@ void blo_add_library_pointer_map(ListBase *old_mainlist, FileData *fd)
 		while (i--) {
 			ID *id;
 			for (id = lbarray[i]->first; id; id = id->next)
-				oldnewmap_insert(fd->libmap, id, id, GS(id->name));
+				blo_oldnewmap_insert(fd->libmap, id, id, GS(id->name));
 		}
 	}
 
@@ -1902,7 +1861,7 @@ static void switch_endian_structs(const struct SDNA *filesdna, BHead *bhead)
 	int blocksize, nblocks;
 	char *data;
 	
-	data = (char *)(bhead+1);
+	data = bhead_data(bhead);
 	blocksize = filesdna->typelens[ filesdna->structs[bhead->SDNAnr][0] ];
 	
 	nblocks = bhead->nr;
@@ -1924,12 +1883,12 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 		
 		if (fd->compflags[bh->SDNAnr] != SDNA_CMP_REMOVED) {
 			if (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) {
-				temp = DNA_struct_reconstruct(fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, (bh+1));
+				temp = DNA_struct_reconstruct(fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, bhead_data(bh));
 			}
 			else {
 				/* SDNA_CMP_EQUAL */
 				temp = MEM_mallocN(bh->len, blockname);
-				memcpy(temp, (bh+1), bh->len);
+				memcpy(temp, bhead_data(bh), bh->len);
 			}
 		}
 	}
@@ -1976,7 +1935,7 @@ static void link_glob_list(FileData *fd, ListBase *lb)		/* for glob data */
 	if (BLI_listbase_is_empty(lb)) return;
 	poin = newdataadr(fd, lb->first);
 	if (lb->first) {
-		oldnewmap_insert(fd->globmap, lb->first, poin, 0);
+		blo_oldnewmap_insert(fd->globmap, lb->first, poin, 0);
 	}
 	lb->first = poin;
 	
@@ -1985,7 +1944,7 @@ static void link_glob_list(FileData *fd, ListBase *lb)		/* for glob data */
 	while (ln) {
 		poin = newdataadr(fd, ln->next);
 		if (ln->next) {
-			oldnewmap_insert(fd->globmap, ln->next, poin, 0);
+			blo_oldnewmap_insert(fd->globmap, ln->next, poin, 0);
 		}
 		ln->next = poin;
 		ln->prev = prev;
@@ -2582,7 +2541,7 @@ static void direct_link_fcurves(FileData *fd, ListBase *list)
 		fcu->rna_path = newdataadr(fd, fcu->rna_path);
 		
 		/* group */
-		fcu->grp = newdataadr_ex(fd, fcu->grp, false);
+		fcu->grp = newdataadr(fd, fcu->grp);
 		
 		/* clear disabled flag - allows disabled drivers to be tried again ([#32155]),
 		 * but also means that another method for "reviving disabled F-Curves" exists
@@ -6495,7 +6454,7 @@ static void direct_link_windowmanager(FileData *fd, wmWindowManager *wm)
 
 		win->workspace_hook = newdataadr(fd, hook);
 		/* we need to restore a pointer to this later when reading workspaces, so store in global oldnew-map */
-		oldnewmap_insert(fd->globmap, hook, win->workspace_hook, 0);
+		blo_oldnewmap_insert(fd->globmap, hook, win->workspace_hook, 0);
 
 		win->ghostwin = NULL;
 		win->gwnctx = NULL;
@@ -8423,7 +8382,7 @@ static BHead *read_data_into_oldnewmap(FileData *fd, BHead *bhead, const char *a
 #endif
 		
 		if (data) {
-			oldnewmap_insert(fd->datamap, bhead->old, data, 0);
+			blo_oldnewmap_insert(fd->datamap, bhead->old, data, 0);
 		}
 		
 		bhead = blo_nextbhead(fd, bhead);
@@ -8481,7 +8440,7 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short
 				DEBUG_PRINTF("FOUND!\n");
 				/* Even though we found our linked ID, there is no guarantee its address is still the same... */
 				if (id != bhead->old) {
-					oldnewmap_insert(fd->libmap, bhead->old, id, GS(id->name));
+					blo_oldnewmap_insert(fd->libmap, bhead->old, id, GS(id->name));
 				}
 
 				/* No need to do anything else for ID_ID, it's assumed already present in its lib's main... */
@@ -8502,7 +8461,7 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short
 		/* do after read_struct, for dna reconstruct */
 		lb = which_libbase(main, idcode);
 		if (lb) {
-			oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);	/* for ID_ID check */
+			blo_oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);	/* for ID_ID check */
 			BLI_addtail(lb, id);
 		}
 		else {
@@ -8654,8 +8613,8 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short
 			break;
 	}
 	
-	oldnewmap_free_unused(fd->datamap);
-	oldnewmap_clear(fd->datamap);
+	blo_oldnewmap_free_unused(fd->datamap);
+	blo_oldnewmap_clear(fd->datamap);
 	
 	if (wrong_id) {
 		BKE_libblock_free(main, id);
@@ -8791,8 +8750,6 @@ static void do_versions_after_linking(Main *main)
 
 static void lib_link_all(FileData *fd, Main *main)
 {
-	oldnewmap_sort(fd);
-	
 	lib_link_id(fd, main);
 
 	/* No load UI for undo memfiles */
@@ -8907,8 +8864,8 @@ static BHead *read_userdef(BlendFileData *bfd, FileData *fd, BHead *bhead)
 	link_list(fd, &user->uistyles);
 	
 	/* free fd->datamap again */
-	oldnewmap_free_unused(fd->datamap);
-	oldnewmap_clear(fd->datamap);
+	blo_oldnewmap_free_unused(fd->datamap);
+	blo_oldnewmap_clear(fd->datamap);
 	
 	return bhead;
 }
@@ -8929,6 +8886,9 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 	bfd->type = BLENFILETYPE_BLEND;
 	BLI_strncpy(bfd->main->name, filepath, sizeof(bfd->main->name));
 
+	/* All ID blocks end up in the libmap, avoid growing it while reading. */
+	blo_oldnewmap_reserve(fd->libmap, fd_count_id_bheads(fd));
+
 	if (G.background) {
 		/* We only read & store .blend thumbnail in background mode
 		 * (because we cannot re-generate it, no OpenGL available).
@@ -9221,7 +9181,7 @@ static void expand_doit_library(void *fdhandle, Main *mainvar, void *old)
 					 *
 					 * The crash that this check avoided earlier was because bhead->code wasn't properly passed in, making
 					 * change_idid_adr not detect the mapping was for an ID_ID datablock. */
-					oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);
+					blo_oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);
 					change_idid_adr_fd(fd, bhead->old, id);
 					
 					// commented because this can print way too much
@@ -9244,7 +9204,7 @@ static void expand_doit_library(void *fdhandle, Main *mainvar, void *old)
 			else {
 				/* this is actually only needed on UI call? when ID was already read before, and another append
 				 * happens which invokes same ID... in that case the lookup table needs this entry */
-				oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);
+				blo_oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);
 				// commented because this can print way too much
 				// if (G.debug & G_DEBUG) printf("expand: already read %s\n", id->name);
 			}
@@ -10406,7 +10366,7 @@ static ID *link_named_part(
 			/* already linked */
 			if (G.debug)
 				printf("append: already linked\n");
-			oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);
+			blo_oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);
 			if (!force_indirect && (id->tag & LIB_TAG_INDIRECT)) {
 				id->tag &= ~LIB_TAG_INDIRECT;
 				id->tag |= LIB_TAG_EXTERN;
@@ -10869,9 +10829,9 @@ static void read_libraries(FileData *basefd, ListBase *mainlist)
 						fd->reports = basefd->reports;
 						
 						if (fd->libmap)
-							oldnewmap_free(fd->libmap);
+							blo_oldnewmap_free(fd->libmap);
 						
-						fd->libmap = oldnewmap_new();
+						fd->libmap = blo_oldnewmap_new();
 						
 						mainptr->curlib->filedata = fd;
 						mainptr->versionfile=  fd->fileversion;
@@ -38,6 +38,7 @@
 #include "DNA_space_types.h"
 #include "DNA_windowmanager_types.h"  /* for ReportType */
 
+struct GzipReader;
 struct OldNewMap;
 struct MemFile;
 struct ReportList;
@@ -63,6 +64,12 @@ typedef struct FileData {
 	// variables needed for reading from file
 	int filedes;
 	gzFile gzfiledes;
+	/* Used instead of gzfiledes for files written with parallel compression. */
+	struct GzipReader *gzreader;
+
+	/* Uncompressed file mapped in memory, BHead data points into it (see USE_BHEAD_MMAP). */
+	char *mmap_data;
+	size_t mmap_size, mmap_seek;
 
 	// now only in use for library appending
 	char relabase[FILE_MAX];
@@ -80,7 +87,7 @@ typedef struct FileData {
 	const char *compflags;  /* array of eSDNA_StructCompare */
 	
 	int fileversion;
-	int id_name_offs;       /* used to retrieve ID names from (bhead+1) */
+	int id_name_offs;       /* used to retrieve ID names from bhead_data() */
 	int globalf, fileflags; /* for do_versions patching */
 	
 	eBLOReadSkip skip_flags;  /* skip some data-blocks */
@@ -111,6 +118,9 @@ typedef struct FileData {
 
 typedef struct BHeadN {
 	struct BHeadN *next, *prev;
+	/* Data following the BHead in the file. Stored right after the BHeadN in the same
+	 * allocation, or pointing into a memory mapped file. */
+	void *data;
 	struct BHead bhead;
 } BHeadN;
 
@@ -154,6 +164,7 @@ BHead *blo_firstbhead(FileData *fd);
 BHead *blo_nextbhead(FileData *fd, BHead *thisblock);
 BHead *blo_prevbhead(FileData *fd, BHead *thisblock);
 
+void *bhead_data(const BHead *bhead);
 const char *bhead_id_name(const FileData *fd, const BHead *bhead);
 
 /* do versions stuff */
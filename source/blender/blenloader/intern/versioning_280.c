@@ -45,6 +45,7 @@
 #include "DNA_lightprobe_types.h"
 #include "DNA_material_types.h"
 #include "DNA_mesh_types.h"
+#include "DNA_node_types.h"
 #include "DNA_particle_types.h"
 #include "DNA_scene_types.h"
 #include "DNA_screen_types.h"
@@ -938,5 +939,13 @@ void blo_do_versions_280(FileData *fd, Library *UNUSED(lib), Main *main)
 				probe->intensity = 1.0f;
 			}
 		}
+
+		if (!DNA_struct_elem_find(fd->filesdna, "bNodeTree", "int", "cache_size")) {
+			for (Scene *scene = main->scene.first; scene; scene = scene->id.next) {
+				if (scene->nodetree) {
+					scene->nodetree->cache_size = 1024;
+				}
+			}
+		}
 	}
 }
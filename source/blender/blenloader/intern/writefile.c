@@ -159,8 +159,10 @@
 #include "MEM_guardedalloc.h" // MEM_freeN
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
+#include "BLI_gzip_writer.h"
 #include "BLI_linklist.h"
 #include "BLI_mempool.h"
+#include "BLI_threads.h"
 
 #include "BKE_action.h"
 #include "BKE_blender_version.h"
@@ -225,7 +227,10 @@ struct WriteWrap {
 	/* internal */
 	union {
 		int file_handle;
-		gzFile gz_handle;
+		struct {
+			int file_handle;
+			GzipWriter *writer;
+		} gz;
 	} _user_data;
 };
 
@@ -257,18 +262,22 @@ static size_t ww_write_none(WriteWrap *ww, const char *buf, size_t buf_len)
 }
 #undef FILE_HANDLE
 
-/* zlib */
+/* zlib, compressed in parallel as independent gzip members */
 #define FILE_HANDLE(ww) \
-	(ww)->_user_data.gz_handle
+	(ww)->_user_data.gz.file_handle
+#define GZIP_WRITER(ww) \
+	(ww)->_user_data.gz.writer
 
 static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
 {
-	gzFile file;
+	int file;
 
-	file = BLI_gzopen(filepath, "wb1");
+	file = BLI_open(filepath, O_BINARY + O_WRONLY + O_CREAT + O_TRUNC, 0666);
 
-	if (file != Z_NULL) {
+	if (file != -1) {
 		FILE_HANDLE(ww) = file;
+		/* Same compression level as 'wb1' mode used before. */
+		GZIP_WRITER(ww) = BLI_gzip_writer_new(file, 1, 0, BLI_task_scheduler_get());
 		return true;
 	}
 	else {
@@ -277,12 +286,14 @@ static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
 }
 static bool ww_close_zlib(WriteWrap *ww)
 {
-	return (gzclose(FILE_HANDLE(ww)) == Z_OK);
+	const bool ok = BLI_gzip_writer_free(GZIP_WRITER(ww));
+	return (close(FILE_HANDLE(ww)) != -1) && ok;
 }
 static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
 {
-	return gzwrite(FILE_HANDLE(ww), buf, buf_len);
+	return BLI_gzip_writer_write(GZIP_WRITER(ww), buf, buf_len) ? buf_len : 0;
 }
+#undef GZIP_WRITER
 #undef FILE_HANDLE
 
 /* --- end compression types --- */
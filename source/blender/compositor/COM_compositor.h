@@ -103,10 +103,10 @@ extern "C" {
  *  - [@ref OrderOfChunks.COM_TO_TOP_DOWN]: Start calculation from the bottom to the top of the image
  *  - [@ref OrderOfChunks.COM_TO_RULE_OF_THIRDS]: Experimental order based on 9 hot-spots in the image
  *
- * When the chunk-order is determined, the first few chunks will be checked if they can be scheduled.
+ * When the chunk-order is determined, the chunks are scheduled in that order.
  * Chunks can have three states:
- *  - [@ref ChunkExecutionState.COM_ES_NOT_SCHEDULED]: Chunk is not yet scheduled, or dependencies are not met
- *  - [@ref ChunkExecutionState.COM_ES_SCHEDULED]: All dependencies are met, chunk is scheduled, but not finished
+ *  - [@ref ChunkExecutionState.COM_ES_NOT_SCHEDULED]: Chunk is not yet scheduled
+ *  - [@ref ChunkExecutionState.COM_ES_SCHEDULED]: Chunk is scheduled, it is executed when its dependencies are met
  *  - [@ref ChunkExecutionState.COM_ES_EXECUTED]: Chunk is finished
  *
  * @see ExecutionGroup.execute
@@ -116,7 +116,7 @@ extern "C" {
  * @section interest Area of interest
  * An ExecutionGroup can have dependencies to other ExecutionGroup's. Data passing from one ExecutionGroup to another
  * one are stored in 'chunks'.
- * If not all input chunks are available the chunk execution will not be scheduled.
+ * A chunk is only handed to the WorkScheduler when all its input chunks are available.
  * <pre>
  * +-------------------------------------+              +--------------------------------------+
  * | ExecutionGroup A                    |              | ExecutionGroup B                     |
@@ -144,8 +144,10 @@ extern "C" {
  * but not all input chunks are available. The relevant ExecutionGroup (that can calculate the missing chunks;
  * ExecutionGroup A) is asked to calculate the area ExecutionGroup B is missing.
  * [@ref ExecutionGroup.scheduleAreaWhenPossible]
- * ExecutionGroup B checks what chunks the area spans, and tries to schedule these chunks.
- * If all input data is available these chunks are scheduled [@ref ExecutionGroup.scheduleChunk]
+ * ExecutionGroup A checks what chunks the area spans, and schedules these chunks. Every chunk of A
+ * remembers the chunk of B waiting for it, and B counts the chunks it is waiting for.
+ * When a chunk is executed the chunks waiting for it are released, a chunk which isn't waiting for any
+ * other chunk is added to the WorkScheduler [@ref ExecutionGroup.releaseChunk]
  *
  * <pre>
  *
@@ -169,7 +171,7 @@ extern "C" {
  *            .                                .  .                                         .  O-------/
  *            .                                .  .                                         .  O
  *            .                                .  .                                         .  O
- *            .                                .  .                                         .  O-------\ ExecutionGroup.scheduleChunk
+ *            .                                .  .                                         .  O-------\ ExecutionGroup.releaseChunk
  *            .                                .  .                                         .  .       |
  *            .                                .  .                                         .  .  O----/
  *            .                                .  .                                         .  O<=O
@@ -207,11 +209,11 @@ extern "C" {
  * </pre>
  *
  * @see ExecutionGroup.execute Execute a complete ExecutionGroup. Halts until finished or breaked by user
- * @see ExecutionGroup.scheduleChunkWhenPossible Tries to schedule a single chunk,
- * checks if all input data is available. Can trigger dependent chunks to be calculated
- * @see ExecutionGroup.scheduleAreaWhenPossible Tries to schedule an area. This can be multiple chunks
+ * @see ExecutionGroup.scheduleChunkWhenPossible Schedules a single chunk,
+ * and the chunks of the input data it depends on
+ * @see ExecutionGroup.scheduleAreaWhenPossible Schedules an area. This can be multiple chunks
  * (is called from [@ref ExecutionGroup.scheduleChunkWhenPossible])
- * @see ExecutionGroup.scheduleChunk Schedule a chunk on the WorkScheduler
+ * @see ExecutionGroup.releaseChunk Schedule a chunk on the WorkScheduler when its dependencies are executed
  * @see NodeOperation.determineDependingAreaOfInterest Influence the area of interest of a chunk.
  * @see WriteBufferOperation Operation to write to a MemoryProxy/MemoryBuffer
  * @see ReadBufferOperation Operation to read from a MemoryProxy/MemoryBuffer
@@ -224,10 +226,10 @@ extern "C" {
  * the work-scheduler can work in 2 states. For witching these between the state you need to recompile blender
  *
  * @subsection multithread Multi threaded
- * Default the work-scheduler will place all work as WorkPackage in a queue.
- * For every CPUcore a working thread is created. These working threads will ask the WorkScheduler if there is work
- * for a specific Device.
- * the work-scheduler will find work for the device and the device will be asked to execute the WorkPackage
+ * Default the work-scheduler will push every WorkPackage as a task to the global task scheduler, which is
+ * shared with the rest of Blender. Chunks of the viewer (high priority) are pushed as high priority tasks.
+ * WorkPackages for OpenCL devices are placed in a queue, for every OpenCL device a thread is created
+ * which will execute the WorkPackages of the queue.
  *
  * @subsection singlethread Single threaded
  * For debugging reasons the multi-threading can be disabled. This is done by changing the COM_CURRENT_THREADING_MODEL
@@ -329,7 +331,7 @@ void COM_deinitialize(void);
  * @brief Clear all compositor caches. (Compositor system will still remain available). 
  * To deinitialize the compositor use the COM_deinitialize method.
  */
-// void COM_clearCaches(void); // NOT YET WRITTEN
+void COM_clearCaches(void);
 
 #ifdef __cplusplus
 }
@@ -72,9 +72,9 @@ typedef enum CompositorPriority {
 
 // workscheduler threading models
 /**
- * COM_TM_QUEUE is a multithreaded model, which uses the BLI_thread_queue pattern. This is the default option.
+ * COM_TM_TASK is a multithreaded model, chunks are executed as tasks of the global task scheduler. This is the default option.
  */
-#define COM_TM_QUEUE 1
+#define COM_TM_TASK 1
 
 /**
  * COM_TM_NOTHREAD is a single threading model, everything is executed in the caller thread. easy for debugging
@@ -82,9 +82,9 @@ typedef enum CompositorPriority {
 #define COM_TM_NOTHREAD 0
 
 /**
- * COM_CURRENT_THREADING_MODEL can be one of the above, COM_TM_QUEUE is currently default.
+ * COM_CURRENT_THREADING_MODEL can be one of the above, COM_TM_TASK is currently default.
  */
-#define COM_CURRENT_THREADING_MODEL COM_TM_QUEUE
+#define COM_CURRENT_THREADING_MODEL COM_TM_TASK
 // chunk order
 /**
  * @brief The order of chunks to be scheduled
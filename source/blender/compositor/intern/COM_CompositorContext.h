@@ -200,6 +200,21 @@ public:
 	void setFastCalculation(bool fastCalculation) {this->m_fastCalculation = fastCalculation;}
 	bool isFastCalculation() const { return this->m_fastCalculation; }
 	bool isGroupnodeBufferEnabled() const { return (this->getbNodeTree()->flag & NTREE_COM_GROUPNODE_BUFFER) != 0; }
+
+	/**
+	 * @brief execute operations on whole images instead of tiles
+	 * @see ExecutionSystem.executeFullFrame
+	 */
+	bool isFullFrameEnabled() const { return (this->getbNodeTree()->flag & NTREE_COM_FULL_FRAME) != 0; }
+
+	/**
+	 * @brief memory in bytes for results kept between executions, zero when the result cache is not used
+	 * @see ResultCache
+	 */
+	size_t getResultCacheLimit() const {
+		const int cache_size = this->getbNodeTree()->cache_size;
+		return (isFullFrameEnabled() && cache_size > 0) ? (size_t)cache_size * 1024 * 1024 : 0;
+	}
 };
 
 
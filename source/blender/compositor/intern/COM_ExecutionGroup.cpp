@@ -50,6 +50,9 @@ ExecutionGroup::ExecutionGroup()
 	this->m_isOutput = false;
 	this->m_complex = false;
 	this->m_chunkExecutionStates = NULL;
+	this->m_chunkWaitingCounts = NULL;
+	this->m_chunkDependents = NULL;
+	BLI_mutex_init(&this->m_dependentsMutex);
 	this->m_bTree = NULL;
 	this->m_height = 0;
 	this->m_width = 0;
@@ -65,6 +68,11 @@ ExecutionGroup::ExecutionGroup()
 	this->m_executionStartTime = 0;
 }
 
+ExecutionGroup::~ExecutionGroup()
+{
+	BLI_mutex_end(&this->m_dependentsMutex);
+}
+
 CompositorPriority ExecutionGroup::getRenderPriotrity()
 {
 	return this->getOutputOperation()->getRenderPriority();
@@ -112,13 +120,19 @@ void ExecutionGroup::initExecution()
 {
 	if (this->m_chunkExecutionStates != NULL) {
 		MEM_freeN(this->m_chunkExecutionStates);
+		MEM_freeN(this->m_chunkWaitingCounts);
+		delete[] this->m_chunkDependents;
 	}
 	unsigned int index;
 	determineNumberOfChunks();
 
 	this->m_chunkExecutionStates = NULL;
+	this->m_chunkWaitingCounts = NULL;
+	this->m_chunkDependents = NULL;
 	if (this->m_numberOfChunks != 0) {
 		this->m_chunkExecutionStates = (ChunkExecutionState *)MEM_mallocN(sizeof(ChunkExecutionState) * this->m_numberOfChunks, __func__);
+		this->m_chunkWaitingCounts = (unsigned int *)MEM_callocN(sizeof(unsigned int) * this->m_numberOfChunks, __func__);
+		this->m_chunkDependents = new vector<pair<ExecutionGroup *, unsigned int> >[this->m_numberOfChunks];
 		for (index = 0; index < this->m_numberOfChunks; index++) {
 			this->m_chunkExecutionStates[index] = COM_ES_NOT_SCHEDULED;
 		}
@@ -144,7 +158,11 @@ void ExecutionGroup::deinitExecution()
 {
 	if (this->m_chunkExecutionStates != NULL) {
 		MEM_freeN(this->m_chunkExecutionStates);
+		MEM_freeN(this->m_chunkWaitingCounts);
+		delete[] this->m_chunkDependents;
 		this->m_chunkExecutionStates = NULL;
+		this->m_chunkWaitingCounts = NULL;
+		this->m_chunkDependents = NULL;
 	}
 	this->m_numberOfChunks = 0;
 	this->m_numberOfXChunks = 0;
@@ -304,46 +322,21 @@ void ExecutionGroup::execute(ExecutionSystem *graph)
 	DebugInfo::execution_group_started(this);
 	DebugInfo::graphviz(graph);
 
-	bool breaked = false;
-	bool finished = false;
-	unsigned int startIndex = 0;
-	const int maxNumberEvaluated = BLI_system_thread_count() * 2;
-
-	while (!finished && !breaked) {
-		bool startEvaluated = false;
-		finished = true;
-		int numberEvaluated = 0;
-
-		for (index = startIndex; index < this->m_numberOfChunks && numberEvaluated < maxNumberEvaluated; index++) {
-			chunkNumber = chunkOrder[index];
-			int yChunk = chunkNumber / this->m_numberOfXChunks;
-			int xChunk = chunkNumber - (yChunk * this->m_numberOfXChunks);
-			const ChunkExecutionState state = this->m_chunkExecutionStates[chunkNumber];
-			if (state == COM_ES_NOT_SCHEDULED) {
-				scheduleChunkWhenPossible(graph, xChunk, yChunk);
-				finished = false;
-				startEvaluated = true;
-				numberEvaluated++;
-
-				if (bTree->update_draw)
-					bTree->update_draw(bTree->udh);
-			}
-			else if (state == COM_ES_SCHEDULED) {
-				finished = false;
-				startEvaluated = true;
-				numberEvaluated++;
-			}
-			else if (state == COM_ES_EXECUTED && !startEvaluated) {
-				startIndex = index + 1;
-			}
-		}
-
-		WorkScheduler::finish();
+	/* every chunk is handed to the WorkScheduler as soon as the chunks it depends on are executed,
+	 * chunks earlier in the order get their dependencies scheduled first */
+	for (index = 0; index < this->m_numberOfChunks; index++) {
+		chunkNumber = chunkOrder[index];
+		int yChunk = chunkNumber / this->m_numberOfXChunks;
+		int xChunk = chunkNumber - (yChunk * this->m_numberOfXChunks);
+		scheduleChunkWhenPossible(graph, xChunk, yChunk, NULL, 0);
 
 		if (bTree->test_break && bTree->test_break(bTree->tbh)) {
-			breaked = true;
+			break;
 		}
 	}
+
+	WorkScheduler::finish();
+
 	DebugInfo::execution_group_finished(this);
 	DebugInfo::graphviz(graph);
 
@@ -380,8 +373,17 @@ MemoryBuffer *ExecutionGroup::constructConsolidatedMemoryBuffer(MemoryProxy *mem
 
 void ExecutionGroup::finalizeChunkExecution(int chunkNumber, MemoryBuffer **memoryBuffers)
 {
+	vector<pair<ExecutionGroup *, unsigned int> > dependents;
+
+	BLI_mutex_lock(&this->m_dependentsMutex);
 	if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_SCHEDULED)
 		this->m_chunkExecutionStates[chunkNumber] = COM_ES_EXECUTED;
+	dependents.swap(this->m_chunkDependents[chunkNumber]);
+	BLI_mutex_unlock(&this->m_dependentsMutex);
+
+	for (unsigned int index = 0; index < dependents.size(); index++) {
+		dependents[index].first->releaseChunk(dependents[index].second);
+	}
 	
 	atomic_add_and_fetch_u(&this->m_chunksFinished, 1);
 	if (memoryBuffers) {
@@ -407,6 +409,9 @@ void ExecutionGroup::finalizeChunkExecution(int chunkNumber, MemoryBuffer **memo
 		             this->m_chunksFinished,
 		             this->m_numberOfChunks);
 		this->m_bTree->stats_draw(this->m_bTree->sdh, buf);
+
+		if (this->m_bTree->update_draw)
+			this->m_bTree->update_draw(this->m_bTree->udh);
 	}
 }
 
@@ -448,10 +453,12 @@ MemoryBuffer *ExecutionGroup::allocateOutputBuffer(int /*chunkNumber*/,
 }
 
 
-bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area)
+void ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area,
+                                              ExecutionGroup *dependentGroup, unsigned int dependentChunk)
 {
 	if (this->m_singleThreaded) {
-		return scheduleChunkWhenPossible(graph, 0, 0);
+		scheduleChunkWhenPossible(graph, 0, 0, dependentGroup, dependentChunk);
+		return;
 	}
 	// find all chunks inside the rect
 	// determine minxchunk, minychunk, maxxchunk, maxychunk where x and y are chunknumbers
@@ -470,79 +477,71 @@ bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area
 	maxxchunk = min_ii(maxxchunk, (int)m_numberOfXChunks);
 	maxychunk = min_ii(maxychunk, (int)m_numberOfYChunks);
 
-	bool result = true;
 	for (indexx = minxchunk; indexx < maxxchunk; indexx++) {
 		for (indexy = minychunk; indexy < maxychunk; indexy++) {
-			if (!scheduleChunkWhenPossible(graph, indexx, indexy)) {
-				result = false;
-			}
+			scheduleChunkWhenPossible(graph, indexx, indexy, dependentGroup, dependentChunk);
 		}
 	}
-
-	return result;
 }
 
-bool ExecutionGroup::scheduleChunk(unsigned int chunkNumber)
+void ExecutionGroup::releaseChunk(unsigned int chunkNumber)
 {
-	if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_NOT_SCHEDULED) {
-		this->m_chunkExecutionStates[chunkNumber] = COM_ES_SCHEDULED;
+	if (atomic_sub_and_fetch_u(&this->m_chunkWaitingCounts[chunkNumber], 1) == 0) {
 		WorkScheduler::schedule(this, chunkNumber);
-		return true;
 	}
-	return false;
 }
 
-bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk)
+void ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk,
+                                               ExecutionGroup *dependentGroup, unsigned int dependentChunk)
 {
 	if (xChunk < 0 || xChunk >= (int)this->m_numberOfXChunks) {
-		return true;
+		return;
 	}
 	if (yChunk < 0 || yChunk >= (int)this->m_numberOfYChunks) {
-		return true;
+		return;
 	}
 	int chunkNumber = yChunk * this->m_numberOfXChunks + xChunk;
-	// chunk is already executed
-	if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_EXECUTED) {
-		return true;
-	}
-
-	// chunk is scheduled, but not executed
-	if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_SCHEDULED) {
-		return false;
-	}
-
-	// chunk is nor executed nor scheduled.
-	vector<MemoryProxy *> memoryProxies;
-	this->determineDependingMemoryProxies(&memoryProxies);
-
-	rcti rect;
-	determineChunkRect(&rect, xChunk, yChunk);
-	unsigned int index;
-	bool canBeExecuted = true;
-	rcti area;
 
-	for (index = 0; index < this->m_cachedReadOperations.size(); index++) {
-		ReadBufferOperation *readOperation = (ReadBufferOperation *)this->m_cachedReadOperations[index];
-		BLI_rcti_init(&area, 0, 0, 0, 0);
-		MemoryProxy *memoryProxy = memoryProxies[index];
-		determineDependingAreaOfInterest(&rect, readOperation, &area);
-		ExecutionGroup *group = memoryProxy->getExecutor();
-
-		if (group != NULL) {
-			if (!group->scheduleAreaWhenPossible(graph, &area)) {
-				canBeExecuted = false;
+	/* only the thread executing the groups schedules chunks, so the state can be read without the lock */
+	if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_NOT_SCHEDULED) {
+		this->m_chunkExecutionStates[chunkNumber] = COM_ES_SCHEDULED;
+		/* the extra count keeps the chunk from being released while its dependencies are scheduled */
+		this->m_chunkWaitingCounts[chunkNumber] = 1;
+
+		vector<MemoryProxy *> memoryProxies;
+		this->determineDependingMemoryProxies(&memoryProxies);
+
+		rcti rect;
+		determineChunkRect(&rect, xChunk, yChunk);
+		unsigned int index;
+		rcti area;
+
+		for (index = 0; index < this->m_cachedReadOperations.size(); index++) {
+			ReadBufferOperation *readOperation = (ReadBufferOperation *)this->m_cachedReadOperations[index];
+			BLI_rcti_init(&area, 0, 0, 0, 0);
+			MemoryProxy *memoryProxy = memoryProxies[index];
+			determineDependingAreaOfInterest(&rect, readOperation, &area);
+			ExecutionGroup *group = memoryProxy->getExecutor();
+
+			if (group != NULL) {
+				group->scheduleAreaWhenPossible(graph, &area, this, chunkNumber);
+			}
+			else {
+				throw "ERROR";
 			}
 		}
-		else {
-			throw "ERROR";
-		}
-	}
 
-	if (canBeExecuted) {
-		scheduleChunk(chunkNumber);
+		releaseChunk(chunkNumber);
 	}
 
-	return false;
+	if (dependentGroup) {
+		BLI_mutex_lock(&this->m_dependentsMutex);
+		if (this->m_chunkExecutionStates[chunkNumber] != COM_ES_EXECUTED) {
+			atomic_add_and_fetch_u(&dependentGroup->m_chunkWaitingCounts[dependentChunk], 1);
+			this->m_chunkDependents[chunkNumber].push_back(std::make_pair(dependentGroup, dependentChunk));
+		}
+		BLI_mutex_unlock(&this->m_dependentsMutex);
+	}
 }
 
 void ExecutionGroup::determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output)
@@ -25,12 +25,15 @@
 
 #include "COM_Node.h"
 #include "COM_NodeOperation.h"
+#include <utility>
 #include <vector>
 #include "BLI_rect.h"
+#include "BLI_threads.h"
 #include "COM_MemoryProxy.h"
 #include "COM_Device.h"
 #include "COM_CompositorContext.h"
 
+using std::pair;
 using std::vector;
 
 class ExecutionSystem;
@@ -49,6 +52,7 @@ typedef enum ChunkExecutionState {
 	COM_ES_NOT_SCHEDULED = 0,
 	/**
 	 * @brief chunk is scheduled, but not yet executed
+	 * @note the chunk is handed to the WorkScheduler when the chunks it depends on are executed
 	 */
 	COM_ES_SCHEDULED = 1,
 	/**
@@ -155,6 +159,19 @@ private:
 	 *   - COM_ES_EXECUTED: executed
 	 */
 	ChunkExecutionState *m_chunkExecutionStates;
+
+	/**
+	 * @brief per chunk the number of chunks of other ExecutionGroups it is waiting for
+	 * when it drops to zero the chunk is added to the WorkScheduler
+	 */
+	unsigned int *m_chunkWaitingCounts;
+
+	/**
+	 * @brief per chunk the chunks of other ExecutionGroups waiting for it, as (group, chunkNumber)
+	 * @note guarded by m_dependentsMutex together with the transition to COM_ES_EXECUTED
+	 */
+	vector<pair<ExecutionGroup *, unsigned int> > *m_chunkDependents;
+	ThreadMutex m_dependentsMutex;
 	
 	/**
 	 * @brief indicator when this ExecutionGroup has valid Operations in its vector for Execution
@@ -208,34 +225,31 @@ private:
 	void determineNumberOfChunks();
 	
 	/**
-	 * @brief try to schedule a specific chunk.
-	 * @note scheduling succeeds when all input requirements are met and the chunks hasn't been scheduled yet.
+	 * @brief schedule a specific chunk, to be executed when the chunks it depends on are executed.
+	 * @note the chunks of the input groups are scheduled as well, each of them releases this chunk when it is executed.
 	 * @param graph
 	 * @param xChunk
 	 * @param yChunk
-	 * @return [true:false]
-	 * true: package(s) are scheduled
-	 * false: scheduling is deferred (depending workpackages are scheduled)
+	 * @param dependentGroup group of the chunk waiting for this chunk, or NULL
+	 * @param dependentChunk number of the chunk waiting for this chunk
 	 */
-	bool scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk);
+	void scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk,
+	                               ExecutionGroup *dependentGroup, unsigned int dependentChunk);
 
 	/**
-	 * @brief try to schedule a specific area.
-	 * @note Check if a certain area is available, when not available this are will be checked.
+	 * @brief schedule all chunks of a specific area.
 	 * @note This method is called from other ExecutionGroup's.
-	 * @param graph
-	 * @param rect
-	 * @return [true:false]
-	 * true: package(s) are scheduled
-	 * false: scheduling is deferred (depending workpackages are scheduled)
+	 * @see scheduleChunkWhenPossible
 	 */
-	bool scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *rect);
+	void scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *rect,
+	                              ExecutionGroup *dependentGroup, unsigned int dependentChunk);
 
 	/**
-	 * @brief add a chunk to the WorkScheduler.
+	 * @brief one of the chunks a chunk is waiting for is executed.
+	 * the chunk is added to the WorkScheduler when it is not waiting for other chunks.
 	 * @param chunknumber
 	 */
-	bool scheduleChunk(unsigned int chunkNumber);
+	void releaseChunk(unsigned int chunkNumber);
 	
 	/**
 	 * @brief determine the area of interest of a certain input area
@@ -250,6 +264,7 @@ private:
 public:
 	// constructors
 	ExecutionGroup();
+	~ExecutionGroup();
 	
 	// methods
 	/**
@@ -348,6 +363,7 @@ public:
 
 	/**
 	 * @brief after a chunk is executed the needed resources can be freed or unlocked.
+	 * chunks waiting for this chunk are released.
 	 * @param chunknumber
 	 * @param memorybuffers
 	 */
@@ -369,7 +385,8 @@ public:
 	 *   - CenterX
 	 *   - CenterY
 	 *
-	 * After determining the order of the chunks the chunks will be scheduled
+	 * After determining the order of the chunks the chunks will be scheduled, every chunk is executed
+	 * as soon as the chunks it depends on are executed.
 	 *
 	 * @see ViewerOperation
 	 * @param system
@@ -413,6 +430,11 @@ public:
 
 	void setRenderBorder(float xmin, float xmax, float ymin, float ymax);
 
+	/**
+	 * @brief get the area of the output to calculate, measured in pixel space
+	 */
+	const rcti *getViewerBorder() const { return &this->m_viewerBorder; }
+
 	/* allow the DebugInfo class to look at internals */
 	friend class DebugInfo;
 
@@ -22,9 +22,14 @@
 
 #include "COM_ExecutionSystem.h"
 
+#include <map>
+#include <set>
+
 #include "PIL_time.h"
 #include "BLI_utildefines.h"
 extern "C" {
+#include "BLI_string.h"
+#include "BLI_task.h"
 #include "BKE_node.h"
 }
 
@@ -36,11 +41,12 @@ extern "C" {
 #include "COM_ExecutionGroup.h"
 #include "COM_WorkScheduler.h"
 #include "COM_ReadBufferOperation.h"
+#include "COM_WriteBufferOperation.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_ResultCache.h"
 #include "COM_Debug.h"
 
-#ifdef WITH_CXX_GUARDEDALLOC
 #include "MEM_guardedalloc.h"
-#endif
 
 ExecutionSystem::ExecutionSystem(RenderData *rd, Scene *scene, bNodeTree *editingtree, bool rendering, bool fastcalculation,
                                  const ColorManagedViewSettings *viewSettings, const ColorManagedDisplaySettings *displaySettings,
@@ -59,7 +65,9 @@ ExecutionSystem::ExecutionSystem(RenderData *rd, Scene *scene, bNodeTree *editin
 		this->m_context.setQuality((CompositorQuality)editingtree->edit_quality);
 	}
 	this->m_context.setRendering(rendering);
-	this->m_context.setHasActiveOpenCLDevices(WorkScheduler::hasGPUDevices() && (editingtree->flag & NTREE_COM_OPENCL));
+	/* full frame execution doesn't schedule chunks on OpenCL devices */
+	this->m_context.setHasActiveOpenCLDevices(WorkScheduler::hasGPUDevices() && (editingtree->flag & NTREE_COM_OPENCL) &&
+	                                          !(editingtree->flag & NTREE_COM_FULL_FRAME));
 
 	this->m_context.setRenderData(rd);
 	this->m_context.setViewSettings(viewSettings);
@@ -174,16 +182,24 @@ void ExecutionSystem::execute()
 		executionGroup->initExecution();
 	}
 
-	WorkScheduler::start(this->m_context);
+	/* frees the cached results when the cache is disabled */
+	ResultCache::setLimit(this->m_context.getResultCacheLimit());
 
-	executeGroups(COM_PRIORITY_HIGH);
-	if (!this->getContext().isFastCalculation()) {
-		executeGroups(COM_PRIORITY_MEDIUM);
-		executeGroups(COM_PRIORITY_LOW);
+	if (this->m_context.isFullFrameEnabled()) {
+		executeFullFrame();
 	}
+	else {
+		WorkScheduler::start(this->m_context);
 
-	WorkScheduler::finish();
-	WorkScheduler::stop();
+		executeGroups(COM_PRIORITY_HIGH);
+		if (!this->getContext().isFastCalculation()) {
+			executeGroups(COM_PRIORITY_MEDIUM);
+			executeGroups(COM_PRIORITY_LOW);
+		}
+
+		WorkScheduler::finish();
+		WorkScheduler::stop();
+	}
 
 	editingtree->stats_draw(editingtree->sdh, IFACE_("Compositing | De-initializing execution"));
 	for (index = 0; index < this->m_operations.size(); index++) {
@@ -201,6 +217,7 @@ void ExecutionSystem::executeGroups(CompositorPriority priority)
 	unsigned int index;
 	vector<ExecutionGroup *> executionGroups;
 	this->findOutputExecutionGroup(&executionGroups, priority);
+	WorkScheduler::setPriority(priority);
 
 	for (index = 0; index < executionGroups.size(); index++) {
 		ExecutionGroup *group = executionGroups[index];
@@ -229,3 +246,467 @@ void ExecutionSystem::findOutputExecutionGroup(vector<ExecutionGroup *> *result)
 		}
 	}
 }
+
+/* ******** Full Frame Execution ******** */
+
+typedef struct FullFrameState {
+	const CompositorContext *context;
+	/* number of inputs reading each operation which are not evaluated yet */
+	std::map<NodeOperation *, int> users;
+	std::set<NodeOperation *> evaluated;
+	unsigned int num_operations;
+	/* keys of the results in the ResultCache, zero for results which are not cached */
+	bool use_cache;
+	std::map<NodeOperation *, ResultCacheKey> cache_keys;
+	/* operations which calculated their whole buffer, without being cancelled */
+	std::set<NodeOperation *> completed;
+} FullFrameState;
+
+typedef struct FullFrameTask {
+	NodeOperation *operation;
+	/* NULL for output operations, which write their results themselves */
+	MemoryBuffer *output;
+	MemoryBuffer **inputs;
+	const rcti *area;
+	int band_height;
+} FullFrameTask;
+
+static NodeOperation *full_frame_input_operation(NodeOperation *operation, unsigned int index)
+{
+	NodeOperationOutput *link = operation->getInputSocket(index)->getLink();
+	return (link) ? &link->getOperation() : NULL;
+}
+
+/* Calculate the area pixel by pixel, for operations which don't implement updateOutputBuffer.
+ * Reads of the inputs are redirected to their buffers. */
+static void full_frame_execute_pixels(NodeOperation *operation, MemoryBuffer *output, rcti *area)
+{
+	const int num_channels = output->get_num_channels();
+	void *data = NULL;
+	int x, y;
+
+	if (operation->isComplex()) {
+		data = operation->initializeTileData(area);
+	}
+
+	for (y = area->ymin; y < area->ymax; y++) {
+		float *elem = output->getElem(area->xmin, y);
+		for (x = area->xmin; x < area->xmax; x++) {
+			if (operation->isComplex()) {
+				operation->read(elem, x, y, data);
+			}
+			else {
+				operation->readSampled(elem, x, y, COM_PS_NEAREST);
+			}
+			elem += num_channels;
+		}
+	}
+
+	if (operation->isComplex()) {
+		operation->deinitializeTileData(area, data);
+	}
+}
+
+static void full_frame_execute_band(void *__restrict userdata,
+                                    const int iter,
+                                    const ParallelRangeTLS *__restrict tls)
+{
+	FullFrameTask *task = (FullFrameTask *)userdata;
+	NodeOperation *operation = task->operation;
+	rcti band;
+
+	if (operation->isBreaked()) {
+		return;
+	}
+
+	/* per thread data of operations like TextureOperation is indexed by the thread id */
+	WorkScheduler::set_current_thread_id(tls->thread_id);
+
+	BLI_rcti_init(&band, task->area->xmin, task->area->xmax,
+	              task->area->ymin + iter * task->band_height,
+	              min_ii(task->area->ymin + (iter + 1) * task->band_height, task->area->ymax));
+
+	if (task->output == NULL) {
+		operation->executeRegion(&band, iter);
+	}
+	else if (operation->isFullFrame()) {
+		operation->updateOutputBuffer(task->output, &band, task->inputs);
+	}
+	else {
+		full_frame_execute_pixels(operation, task->output, &band);
+	}
+
+	WorkScheduler::set_current_thread_id(-1);
+}
+
+/* Buffer of the input holding the area of the operation, either the buffer of the
+ * input operation or a temporary buffer which is freed by the caller. */
+static MemoryBuffer *full_frame_input_buffer(NodeOperation *operation, unsigned int index, bool *r_temporary)
+{
+	NodeOperation *input_operation = full_frame_input_operation(operation, index);
+	MemoryBuffer *buffer = input_operation->getFullFrameBuffer();
+	DataType datatype = operation->getInputSocket(index)->getLink()->getDataType();
+	rcti rect;
+
+	BLI_rcti_init(&rect, 0, operation->getWidth(), 0, operation->getHeight());
+
+	if (input_operation->isReadBufferOperation()) {
+		ReadBufferOperation *readOperation = (ReadBufferOperation *)input_operation;
+		if (!readOperation->getMemoryProxy()->getWriteBufferOperation()->isSingleValue()) {
+			buffer = readOperation->getMemoryProxy()->getBuffer();
+		}
+		else {
+			buffer = NULL;
+			/* single values are stored at (0,0) */
+			BLI_rcti_init(&rect, 0, 1, 0, 1);
+		}
+	}
+
+	*r_temporary = false;
+	if (buffer && (buffer->isSingleElem() || BLI_rcti_compare(buffer->getRect(), &rect))) {
+		return buffer;
+	}
+
+	/* resample the input to the area of the operation */
+	MemoryBuffer *temporary = new MemoryBuffer(datatype, &rect, buffer == NULL && input_operation->isReadBufferOperation());
+	const int num_channels = temporary->get_num_channels();
+	const int elem_stride = temporary->getElemStride();
+	float color[4];
+	int x, y;
+
+	for (y = rect.ymin; y < rect.ymax; y++) {
+		float *elem = temporary->getElem(rect.xmin, y);
+		for (x = rect.xmin; x < rect.xmax; x++) {
+			input_operation->readSampled(color, x, y, COM_PS_NEAREST);
+			memcpy(elem, color, sizeof(float) * num_channels);
+			elem += elem_stride;
+		}
+	}
+
+	*r_temporary = true;
+	return temporary;
+}
+
+static void full_frame_execute(NodeOperation *operation, MemoryBuffer *output, const rcti *area,
+                               const FullFrameState &state)
+{
+	const unsigned int num_inputs = operation->getNumberOfInputSockets();
+	MemoryBuffer **inputs = NULL;
+	bool *temporary = NULL;
+	FullFrameTask task;
+	ParallelRangeSettings settings;
+	unsigned int index;
+
+	if (BLI_rcti_is_empty(area)) {
+		return;
+	}
+
+	if (operation->isFullFrame() && num_inputs > 0) {
+		inputs = (MemoryBuffer **)MEM_callocN(sizeof(MemoryBuffer *) * num_inputs, __func__);
+		temporary = (bool *)MEM_callocN(sizeof(bool) * num_inputs, __func__);
+		for (index = 0; index < num_inputs; index++) {
+			inputs[index] = full_frame_input_buffer(operation, index, &temporary[index]);
+		}
+	}
+
+	task.operation = operation;
+	task.output = output;
+	task.inputs = inputs;
+	task.area = area;
+	/* single threaded operations calculate their whole result at once */
+	task.band_height = operation->isSingleThreaded() ? BLI_rcti_size_y(area) : state.context->getChunksize();
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+	settings.scheduler = WorkScheduler::get_task_scheduler();
+	BLI_task_parallel_range(0, (BLI_rcti_size_y(area) + task.band_height - 1) / task.band_height,
+	                        &task, full_frame_execute_band, &settings);
+
+	if (inputs) {
+		for (index = 0; index < num_inputs; index++) {
+			if (temporary[index]) {
+				delete inputs[index];
+			}
+		}
+		MEM_freeN(inputs);
+		MEM_freeN(temporary);
+	}
+}
+
+/* Copy the result of the input into the buffer of the MemoryProxy. */
+static void full_frame_write_buffer(WriteBufferOperation *operation)
+{
+	NodeOperation *input_operation = full_frame_input_operation(operation, 0);
+	MemoryBuffer *proxy_buffer = operation->getMemoryProxy()->getBuffer();
+	MemoryBuffer *buffer = input_operation->getFullFrameBuffer();
+	rcti *rect = proxy_buffer->getRect();
+	const int num_channels = proxy_buffer->get_num_channels();
+	float color[4];
+	int x, y;
+
+	if (buffer && !buffer->isSingleElem() && BLI_rcti_compare(buffer->getRect(), rect)) {
+		memcpy(proxy_buffer->getBuffer(), buffer->getBuffer(),
+		       sizeof(float) * num_channels * proxy_buffer->getWidth() * proxy_buffer->getHeight());
+		return;
+	}
+
+	for (y = rect->ymin; y < rect->ymax; y++) {
+		float *elem = proxy_buffer->getElem(rect->xmin, y);
+		for (x = rect->xmin; x < rect->xmax; x++) {
+			input_operation->readSampled(color, x, y, COM_PS_NEAREST);
+			memcpy(elem, color, sizeof(float) * num_channels);
+			elem += num_channels;
+		}
+	}
+}
+
+static void full_frame_evaluate(NodeOperation *operation, FullFrameState &state);
+
+/* Free the buffer of the operation, complete buffers are moved to the cache instead. */
+static void full_frame_free_buffer(NodeOperation *operation, FullFrameState &state)
+{
+	MemoryBuffer *buffer = operation->getFullFrameBuffer();
+
+	if (buffer == NULL) {
+		return;
+	}
+	operation->setFullFrameBuffer(NULL);
+
+	if (state.completed.count(operation) && state.cache_keys[operation] != 0) {
+		ResultCache::store(state.cache_keys[operation], buffer);
+	}
+	else {
+		delete buffer;
+	}
+}
+
+/* Key of the result of the operation, hashing its settings and the keys of its inputs.
+ * Operations without inputs, like images and render layers, are evaluated to hash their
+ * buffers, since their data can change without their settings changing. */
+static ResultCacheKey full_frame_cache_key(NodeOperation *operation, FullFrameState &state)
+{
+	std::map<NodeOperation *, ResultCacheKey>::iterator it = state.cache_keys.find(operation);
+	ResultCacheKey key = 0;
+	unsigned int index;
+
+	if (it != state.cache_keys.end()) {
+		return it->second;
+	}
+
+	if (operation->isReadBufferOperation()) {
+		ReadBufferOperation *readOperation = (ReadBufferOperation *)operation;
+		key = full_frame_cache_key(readOperation->getMemoryProxy()->getWriteBufferOperation(), state);
+	}
+	else if (operation->getNumberOfInputSockets() == 0) {
+		MemoryBuffer *buffer = NULL;
+
+		if (operation->getResultCacheSettings() != 0) {
+			full_frame_evaluate(operation, state);
+			buffer = operation->getFullFrameBuffer();
+		}
+		if (buffer) {
+			ResultCacheHash hash;
+			hash.addKey(operation->getResultCacheSettings());
+			hash.addInt(buffer->isSingleElem());
+			hash.add(buffer->getBuffer(), sizeof(float) * buffer->get_num_channels() *
+			         (buffer->isSingleElem() ? 1 : buffer->getWidth() * buffer->getHeight()));
+			key = hash.end();
+		}
+	}
+	else {
+		ResultCacheHash hash;
+		bool cached = (operation->getResultCacheSettings() != 0);
+
+		hash.addKey(operation->getResultCacheSettings());
+		for (index = 0; index < operation->getNumberOfInputSockets(); index++) {
+			NodeOperation *input_operation = full_frame_input_operation(operation, index);
+			ResultCacheKey input_key = (input_operation) ? full_frame_cache_key(input_operation, state) : 0;
+			/* keys of all inputs are needed, inputs can be cached when this operation isn't */
+			cached = cached && (input_key != 0);
+			hash.addKey(input_key);
+		}
+		key = (cached) ? hash.end() : 0;
+	}
+
+	state.cache_keys[operation] = key;
+	return key;
+}
+
+static void full_frame_evaluate_inputs(NodeOperation *operation, FullFrameState &state)
+{
+	unsigned int index;
+
+	if (operation->isReadBufferOperation()) {
+		ReadBufferOperation *readOperation = (ReadBufferOperation *)operation;
+		full_frame_evaluate(readOperation->getMemoryProxy()->getWriteBufferOperation(), state);
+		return;
+	}
+
+	for (index = 0; index < operation->getNumberOfInputSockets(); index++) {
+		NodeOperation *input_operation = full_frame_input_operation(operation, index);
+		if (input_operation) {
+			full_frame_evaluate(input_operation, state);
+		}
+	}
+}
+
+/* Free the buffers of inputs which have no other users left. */
+static void full_frame_release_inputs(NodeOperation *operation, FullFrameState &state)
+{
+	unsigned int index;
+
+	for (index = 0; index < operation->getNumberOfInputSockets(); index++) {
+		NodeOperation *input_operation = full_frame_input_operation(operation, index);
+		if (input_operation && --state.users[input_operation] == 0) {
+			full_frame_free_buffer(input_operation, state);
+		}
+	}
+}
+
+static void full_frame_update_progress(FullFrameState &state)
+{
+	const bNodeTree *bTree = state.context->getbNodeTree();
+	char buf[128];
+
+	if (bTree->progress) {
+		bTree->progress(bTree->prh, (float)state.evaluated.size() / state.num_operations);
+	}
+	if (bTree->stats_draw) {
+		BLI_snprintf(buf, sizeof(buf), IFACE_("Compositing | Operation %u-%u"),
+		             (unsigned int)state.evaluated.size(), state.num_operations);
+		bTree->stats_draw(bTree->sdh, buf);
+	}
+}
+
+/* Use the result of the operation from the cache, without evaluating its inputs. */
+static bool full_frame_read_cache(NodeOperation *operation, FullFrameState &state)
+{
+	std::map<NodeOperation *, ResultCacheKey>::iterator it = state.cache_keys.find(operation);
+	MemoryBuffer *buffer;
+
+	if (it == state.cache_keys.end() || it->second == 0 ||
+	    operation->isReadBufferOperation() || operation->isWriteBufferOperation())
+	{
+		return false;
+	}
+
+	buffer = ResultCache::read(it->second);
+	if (buffer == NULL) {
+		return false;
+	}
+
+	operation->setFullFrameBuffer(buffer);
+	state.evaluated.insert(operation);
+	full_frame_release_inputs(operation, state);
+	full_frame_update_progress(state);
+	return true;
+}
+
+static void full_frame_evaluate(NodeOperation *operation, FullFrameState &state)
+{
+	if (state.evaluated.count(operation)) {
+		return;
+	}
+
+	if (state.use_cache && full_frame_read_cache(operation, state)) {
+		return;
+	}
+
+	full_frame_evaluate_inputs(operation, state);
+	state.evaluated.insert(operation);
+
+	if (operation->isReadBufferOperation()) {
+		return;
+	}
+	else if (operation->isWriteBufferOperation()) {
+		if (!operation->isBreaked()) {
+			full_frame_write_buffer((WriteBufferOperation *)operation);
+		}
+	}
+	else if (operation->getNumberOfOutputSockets() > 0) {
+		const DataType datatype = operation->getOutputSocket()->getDataType();
+		const int width = operation->getWidth();
+		const int height = operation->getHeight();
+		MemoryBuffer *output;
+		rcti rect;
+
+		BLI_rcti_init(&rect, 0, width, 0, height);
+
+		if (operation->isSetOperation() || width == 0 || height == 0) {
+			float color[4];
+			output = new MemoryBuffer(datatype, &rect, true);
+			operation->readSampled(color, 0, 0, COM_PS_NEAREST);
+			memcpy(output->getBuffer(), color, sizeof(float) * output->get_num_channels());
+		}
+		else {
+			output = new MemoryBuffer(datatype, &rect);
+			full_frame_execute(operation, output, &rect, state);
+			if (state.use_cache && !operation->isBreaked()) {
+				state.completed.insert(operation);
+			}
+		}
+		operation->setFullFrameBuffer(output);
+	}
+
+	full_frame_release_inputs(operation, state);
+	full_frame_update_progress(state);
+}
+
+void ExecutionSystem::executeFullFrameGroups(CompositorPriority priority, FullFrameState &state)
+{
+	vector<ExecutionGroup *> executionGroups;
+	unsigned int index;
+
+	this->findOutputExecutionGroup(&executionGroups, priority);
+	WorkScheduler::setPriority(priority);
+
+	for (index = 0; index < executionGroups.size(); index++) {
+		ExecutionGroup *group = executionGroups[index];
+		NodeOperation *operation = group->getOutputOperation();
+
+		if (group->getWidth() == 0 || group->getHeight() == 0 || operation->isBreaked()) {
+			continue;
+		}
+
+		if (state.use_cache) {
+			full_frame_cache_key(operation, state);
+		}
+		full_frame_evaluate_inputs(operation, state);
+		full_frame_execute(operation, NULL, group->getViewerBorder(), state);
+		state.evaluated.insert(operation);
+		full_frame_release_inputs(operation, state);
+		full_frame_update_progress(state);
+	}
+}
+
+void ExecutionSystem::executeFullFrame()
+{
+	FullFrameState state;
+	unsigned int index;
+
+	state.context = &this->m_context;
+	state.num_operations = this->m_operations.size();
+	state.use_cache = ResultCache::isEnabled();
+
+	for (index = 0; index < this->m_operations.size(); index++) {
+		NodeOperation *operation = this->m_operations[index];
+		unsigned int input_index;
+		for (input_index = 0; input_index < operation->getNumberOfInputSockets(); input_index++) {
+			NodeOperation *input_operation = full_frame_input_operation(operation, input_index);
+			if (input_operation) {
+				state.users[input_operation]++;
+			}
+		}
+	}
+
+	executeFullFrameGroups(COM_PRIORITY_HIGH, state);
+	if (!this->getContext().isFastCalculation()) {
+		executeFullFrameGroups(COM_PRIORITY_MEDIUM, state);
+		executeFullFrameGroups(COM_PRIORITY_LOW, state);
+	}
+
+	/* buffers of operations which are only used by outputs that weren't executed */
+	for (index = 0; index < this->m_operations.size(); index++) {
+		full_frame_free_buffer(this->m_operations[index], state);
+	}
+}
@@ -21,6 +21,7 @@
  */
 
 class ExecutionGroup;
+struct FullFrameState;
 
 #ifndef _COM_ExecutionSystem_h
 #define _COM_ExecutionSystem_h
@@ -177,6 +178,19 @@ public:
 private:
 	void executeGroups(CompositorPriority priority);
 
+	/**
+	 * @brief execute the output groups on whole images
+	 *
+	 * Every operation needed by the outputs calculates its result for its whole resolution into a
+	 * MemoryBuffer once, after its inputs. Operations implementing NodeOperation.updateOutputBuffer
+	 * calculate the buffer from their input buffers, other operations are evaluated pixel by pixel
+	 * with reads redirected to the input buffers. Buffers are freed as soon as all operations
+	 * reading them are done, or moved to the ResultCache. Operations whose result is found in
+	 * the ResultCache don't evaluate their inputs.
+	 */
+	void executeFullFrame();
+	void executeFullFrameGroups(CompositorPriority priority, FullFrameState &state);
+
 	/* allow the DebugInfo class to look at internals */
 	friend class DebugInfo;
 
@@ -0,0 +1,539 @@
+/*
+ * Copyright 2018, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <string.h>
+
+#include "COM_FFTConvolution.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_WorkScheduler.h"
+
+#include "MEM_guardedalloc.h"
+extern "C" {
+#include "BLI_math.h"
+#include "BLI_task.h"
+}
+
+/*
+ *  2D Fast Hartley Transform, used for convolution
+ */
+
+typedef float fREAL;
+
+// returns next highest power of 2 of x, as well it's log2 in L2
+static unsigned int nextPow2(unsigned int x, unsigned int *L2)
+{
+	unsigned int pw, x_notpow2 = x & (x - 1);
+	*L2 = 0;
+	while (x >>= 1) ++(*L2);
+	pw = 1 << (*L2);
+	if (x_notpow2) { (*L2)++;  pw <<= 1; }
+	return pw;
+}
+
+//------------------------------------------------------------------------------
+
+// from FXT library by Joerg Arndt, faster in order bitreversal
+// use: r = revbin_upd(r, h) where h = N>>1
+static unsigned int revbin_upd(unsigned int r, unsigned int h)
+{
+	while (!((r ^= h) & h)) h >>= 1;
+	return r;
+}
+//------------------------------------------------------------------------------
+static void FHT(fREAL *data, unsigned int M, unsigned int inverse)
+{
+	double tt, fc, dc, fs, ds, a = M_PI;
+	fREAL t1, t2;
+	int n2, bd, bl, istep, k, len = 1 << M, n = 1;
+
+	int i, j = 0;
+	unsigned int Nh = len >> 1;
+	for (i = 1; i < (len - 1); ++i) {
+		j = revbin_upd(j, Nh);
+		if (j > i) {
+			t1 = data[i];
+			data[i] = data[j];
+			data[j] = t1;
+		}
+	}
+
+	do {
+		fREAL *data_n = &data[n];
+
+		istep = n << 1;
+		for (k = 0; k < len; k += istep) {
+			t1 = data_n[k];
+			data_n[k] = data[k] - t1;
+			data[k] += t1;
+		}
+
+		n2 = n >> 1;
+		if (n > 2) {
+			fc = dc = cos(a);
+			fs = ds = sqrt(1.0 - fc * fc); //sin(a);
+			bd = n - 2;
+			for (bl = 1; bl < n2; bl++) {
+				fREAL *data_nbd = &data_n[bd];
+				fREAL *data_bd = &data[bd];
+				for (k = bl; k < len; k += istep) {
+					t1 = fc * (double)data_n[k] + fs * (double)data_nbd[k];
+					t2 = fs * (double)data_n[k] - fc * (double)data_nbd[k];
+					data_n[k] = data[k] - t1;
+					data_nbd[k] = data_bd[k] - t2;
+					data[k] += t1;
+					data_bd[k] += t2;
+				}
+				tt = fc * dc - fs * ds;
+				fs = fs * dc + fc * ds;
+				fc = tt;
+				bd -= 2;
+			}
+		}
+
+		if (n > 1) {
+			for (k = n2; k < len; k += istep) {
+				t1 = data_n[k];
+				data_n[k] = data[k] - t1;
+				data[k] += t1;
+			}
+		}
+
+		n = istep;
+		a *= 0.5;
+	} while (n < len);
+
+	if (inverse) {
+		fREAL sc = (fREAL)1 / (fREAL)len;
+		for (k = 0; k < len; ++k)
+			data[k] *= sc;
+	}
+}
+//------------------------------------------------------------------------------
+
+typedef struct FHTRows {
+	fREAL *data;
+	unsigned int M;
+	unsigned int inverse;
+} FHTRows;
+
+static void fht_rows_cb(void *__restrict userdata, const int row, const ParallelRangeTLS *__restrict /*tls*/)
+{
+	const FHTRows *rows = (const FHTRows *)userdata;
+	FHT(&rows->data[(size_t)row << rows->M], rows->M, rows->inverse);
+}
+
+/* FHT of the first num_rows rows of data, rows are 1 << M long */
+static void fht_rows(fREAL *data, unsigned int M, unsigned int num_rows, unsigned int inverse, bool threaded)
+{
+	FHTRows rows = {data, M, inverse};
+	ParallelRangeSettings settings;
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.scheduler = WorkScheduler::get_task_scheduler();
+	settings.use_threading = threaded;
+	BLI_task_parallel_range(0, num_rows, &rows, fht_rows_cb, &settings);
+}
+
+/* columns of src transposed per block, so every row of src is read a cache line at a time */
+#define TRANSPOSE_BLOCK 16
+
+typedef struct Transpose {
+	const fREAL *src;
+	fREAL *dst;
+	/* log2 of width/height of src */
+	unsigned int Mx, My;
+} Transpose;
+
+static void transpose_cb(void *__restrict userdata, const int block, const ParallelRangeTLS *__restrict /*tls*/)
+{
+	const Transpose *tr = (const Transpose *)userdata;
+	const unsigned int Nx = 1 << tr->Mx, Ny = 1 << tr->My;
+	const unsigned int imin = block * TRANSPOSE_BLOCK;
+	const unsigned int imax = min_ii(imin + TRANSPOSE_BLOCK, Nx);
+	unsigned int i, j;
+
+	for (j = 0; j < Ny; j++) {
+		const fREAL *src = &tr->src[(size_t)j << tr->Mx];
+		for (i = imin; i < imax; i++)
+			tr->dst[((size_t)i << tr->My) + j] = src[i];
+	}
+}
+
+static void transpose(const fREAL *src, fREAL *dst, unsigned int Mx, unsigned int My, bool threaded)
+{
+	Transpose tr = {src, dst, Mx, My};
+	ParallelRangeSettings settings;
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.scheduler = WorkScheduler::get_task_scheduler();
+	settings.use_threading = threaded;
+	BLI_task_parallel_range(0, ((1 << Mx) + TRANSPOSE_BLOCK - 1) / TRANSPOSE_BLOCK, &tr, transpose_cb, &settings);
+}
+
+//------------------------------------------------------------------------------
+/* 2D Fast Hartley Transform, Mx/My -> log2 of width/height,
+ * nzp -> the row where zero pad data starts,
+ * inverse -> see above.
+ * The transposed result is written to *tmp, after which *data and *tmp are swapped,
+ * threaded -> rows and columns are transformed in parallel */
+static void FHT2D(fREAL **data, fREAL **tmp, unsigned int Mx, unsigned int My,
+                  unsigned int nzp, unsigned int inverse, bool threaded)
+{
+	unsigned int i, j, Nx, Ny;
+	fREAL *d;
+
+	Nx = 1 << Mx;
+	Ny = 1 << My;
+
+	// rows (forward transform skips 0 pad data)
+	fht_rows(*data, Mx, inverse ? Ny : nzp, inverse, threaded);
+
+	// transpose data
+	transpose(*data, *tmp, Mx, My, threaded);
+	SWAP(fREAL *, *data, *tmp);
+	d = *data;
+
+	SWAP(unsigned int, Nx, Ny);
+	SWAP(unsigned int, Mx, My);
+
+	// now columns == transposed rows
+	fht_rows(d, Mx, Ny, inverse, threaded);
+
+	// finalize
+	for (j = 0; j <= (Ny >> 1); j++) {
+		unsigned int jm = (Ny - j) & (Ny - 1);
+		unsigned int ji = j << Mx;
+		unsigned int jmi = jm << Mx;
+		for (i = 0; i <= (Nx >> 1); i++) {
+			unsigned int im = (Nx - i) & (Nx - 1);
+			fREAL A = d[ji + i];
+			fREAL B = d[jmi + i];
+			fREAL C = d[ji + im];
+			fREAL D = d[jmi + im];
+			fREAL E = (fREAL)0.5 * ((A + D) - (B + C));
+			d[ji + i] = A - E;
+			d[jmi + i] = B + E;
+			d[ji + im] = C + E;
+			d[jmi + im] = D - E;
+		}
+	}
+
+}
+
+//------------------------------------------------------------------------------
+
+/* 2D convolution calc, d1 *= d2, M/N - > log2 of width/height */
+static void fht_convolve(fREAL *d1, fREAL *d2, unsigned int M, unsigned int N)
+{
+	fREAL a, b;
+	unsigned int i, j, k, L, mj, mL;
+	unsigned int m = 1 << M, n = 1 << N;
+	unsigned int m2 = 1 << (M - 1), n2 = 1 << (N - 1);
+	unsigned int mn2 = m << (N - 1);
+
+	d1[0] *= d2[0];
+	d1[mn2] *= d2[mn2];
+	d1[m2] *= d2[m2];
+	d1[m2 + mn2] *= d2[m2 + mn2];
+	for (i = 1; i < m2; i++) {
+		k = m - i;
+		a = d1[i] * d2[i] - d1[k] * d2[k];
+		b = d1[k] * d2[i] + d1[i] * d2[k];
+		d1[i] = (b + a) * (fREAL)0.5;
+		d1[k] = (b - a) * (fREAL)0.5;
+		a = d1[i + mn2] * d2[i + mn2] - d1[k + mn2] * d2[k + mn2];
+		b = d1[k + mn2] * d2[i + mn2] + d1[i + mn2] * d2[k + mn2];
+		d1[i + mn2] = (b + a) * (fREAL)0.5;
+		d1[k + mn2] = (b - a) * (fREAL)0.5;
+	}
+	for (j = 1; j < n2; j++) {
+		L = n - j;
+		mj = j << M;
+		mL = L << M;
+		a = d1[mj] * d2[mj] - d1[mL] * d2[mL];
+		b = d1[mL] * d2[mj] + d1[mj] * d2[mL];
+		d1[mj] = (b + a) * (fREAL)0.5;
+		d1[mL] = (b - a) * (fREAL)0.5;
+		a = d1[m2 + mj] * d2[m2 + mj] - d1[m2 + mL] * d2[m2 + mL];
+		b = d1[m2 + mL] * d2[m2 + mj] + d1[m2 + mj] * d2[m2 + mL];
+		d1[m2 + mj] = (b + a) * (fREAL)0.5;
+		d1[m2 + mL] = (b - a) * (fREAL)0.5;
+	}
+	for (i = 1; i < m2; i++) {
+		k = m - i;
+		for (j = 1; j < n2; j++) {
+			L = n - j;
+			mj = j << M;
+			mL = L << M;
+			a = d1[i + mj] * d2[i + mj] - d1[k + mL] * d2[k + mL];
+			b = d1[k + mL] * d2[i + mj] + d1[i + mj] * d2[k + mL];
+			d1[i + mj] = (b + a) * (fREAL)0.5;
+			d1[k + mL] = (b - a) * (fREAL)0.5;
+			a = d1[i + mL] * d2[i + mL] - d1[k + mj] * d2[k + mj];
+			b = d1[k + mj] * d2[i + mL] + d1[i + mL] * d2[k + mj];
+			d1[i + mL] = (b + a) * (fREAL)0.5;
+			d1[k + mj] = (b - a) * (fREAL)0.5;
+		}
+	}
+}
+//------------------------------------------------------------------------------
+
+typedef struct FFTConvolveData {
+	const float *image;
+	int width, height, imageChannels;
+	float *result;
+	int resultChannels, numChannels;
+	/* transformed kernel of every channel, can all point to the same transform */
+	fREAL **kernels;
+	unsigned int w2, h2, log2_w, log2_h;
+	/* size of the image blocks, number of blocks in x */
+	int xbsz, ybsz, nxb;
+	/* offset of the convolution result to the pixel the kernel is applied to */
+	int offx, offy;
+	/* blocks of the pass calculated in parallel */
+	int xparity, yparity, num_pass_xb;
+} FFTConvolveData;
+
+/* convolve one block of the image and add it to the result */
+static void fft_convolve_block(const FFTConvolveData *cd, int xbl, int ybl, fREAL *data, fREAL *tmp, bool threaded)
+{
+	const size_t data_size = (size_t)cd->w2 * cd->h2 * sizeof(fREAL);
+	int x, y, ch;
+
+	// each channel one by one
+	for (ch = 0; ch < cd->numChannels; ch++) {
+		// image, channel ch -> data
+		memset(data, 0, data_size);
+		for (y = 0; y < cd->ybsz; y++) {
+			const int yy = ybl * cd->ybsz + y;
+			if (yy >= cd->height) break;
+			fREAL *fp = &data[y * cd->w2];
+			const float *colp = &cd->image[((size_t)yy * cd->width + xbl * cd->xbsz) * cd->imageChannels + ch];
+			const int xmax = min_ii(cd->xbsz, cd->width - xbl * cd->xbsz);
+			for (x = 0; x < xmax; x++)
+				fp[x] = colp[x * cd->imageChannels];
+		}
+
+		FHT2D(&data, &tmp, cd->log2_w, cd->log2_h, cd->ybsz, 0, threaded);
+
+		// FHT2D transposed data, row/col now swapped
+		// convolve & inverse FHT
+		fht_convolve(data, cd->kernels[ch], cd->log2_h, cd->log2_w);
+		FHT2D(&data, &tmp, cd->log2_h, cd->log2_w, 0, 1, threaded);
+		// data again transposed, so in order again
+
+		// overlap-add result
+		for (y = 0; y < (int)cd->h2; y++) {
+			const int yy = ybl * cd->ybsz + y - cd->offy;
+			if ((yy < 0) || (yy >= cd->height)) continue;
+			const fREAL *fp = &data[y * cd->w2];
+			float *colp = &cd->result[(size_t)yy * cd->width * cd->resultChannels + ch];
+			for (x = 0; x < (int)cd->w2; x++) {
+				const int xx = xbl * cd->xbsz + x - cd->offx;
+				if ((xx < 0) || (xx >= cd->width)) continue;
+				colp[xx * cd->resultChannels] += fp[x];
+			}
+		}
+	}
+}
+
+static void fft_convolve_block_cb(void *__restrict userdata, const int iter, const ParallelRangeTLS *__restrict /*tls*/)
+{
+	const FFTConvolveData *cd = (const FFTConvolveData *)userdata;
+	const int xbl = cd->xparity + 2 * (iter % cd->num_pass_xb);
+	const int ybl = cd->yparity + 2 * (iter / cd->num_pass_xb);
+	fREAL *data = (fREAL *)MEM_mallocN(2 * (size_t)cd->w2 * cd->h2 * sizeof(fREAL), "fft_convolve_block data");
+
+	fft_convolve_block(cd, xbl, ybl, data, data + (size_t)cd->w2 * cd->h2, false);
+	MEM_freeN(data);
+}
+
+typedef struct FFTNormalizeData {
+	float *result;
+	int width, height, resultChannels, numChannels;
+	/* summed area tables of the kernel, one per kernel channel */
+	double **tables;
+	int kernelWidth, kernelHeight, centerX, centerY;
+} FFTNormalizeData;
+
+/* divide by the sum of the kernel elements which were applied to pixels inside the image */
+static void fft_normalize_row_cb(void *__restrict userdata, const int y, const ParallelRangeTLS *__restrict /*tls*/)
+{
+	const FFTNormalizeData *nd = (const FFTNormalizeData *)userdata;
+	const int tw = nd->kernelWidth + 1;
+	const int jmin = max_ii(0, nd->centerY - y);
+	const int jmax = min_ii(nd->kernelHeight, nd->centerY + nd->height - y);
+	float *colp = &nd->result[(size_t)y * nd->width * nd->resultChannels];
+
+	for (int x = 0; x < nd->width; x++, colp += nd->resultChannels) {
+		const int imin = max_ii(0, nd->centerX - x);
+		const int imax = min_ii(nd->kernelWidth, nd->centerX + nd->width - x);
+		for (int ch = 0; ch < nd->numChannels; ch++) {
+			const double *sat = nd->tables[ch];
+			const double sum = sat[jmax * tw + imax] - sat[jmin * tw + imax] - sat[jmax * tw + imin] + sat[jmin * tw + imin];
+			if (sum != 0.0) {
+				colp[ch] /= (float)sum;
+			}
+		}
+	}
+}
+
+bool FFTConvolution::isEfficient(int kernelWidth, int kernelHeight)
+{
+	return kernelWidth * kernelHeight >= COM_FFT_CONVOLUTION_MIN_KERNEL_SIZE;
+}
+
+void FFTConvolution::convolve(MemoryBuffer *output, MemoryBuffer *input, int numChannels,
+                              const float *kernel, int kernelWidth, int kernelHeight, int kernelChannels,
+                              int centerX, int centerY, bool normalize)
+{
+	FFTConvolveData cd;
+	const int num_kernels = (kernelChannels == 1) ? 1 : numChannels;
+	int x, y, ch;
+
+	cd.image = input->getBuffer();
+	cd.width = input->getWidth();
+	cd.height = input->getHeight();
+	cd.imageChannels = input->get_num_channels();
+	cd.result = output->getBuffer();
+	cd.resultChannels = output->get_num_channels();
+	cd.numChannels = numChannels;
+
+	// convolution result width & height, no need to transform more than the image and its border
+	// FFT pow2 required size & log2, fht_convolve needs at least two elements
+	cd.w2 = nextPow2(max_ii(2, min_ii(2 * kernelWidth - 1, cd.width + kernelWidth - 1)), &cd.log2_w);
+	cd.h2 = nextPow2(max_ii(2, min_ii(2 * kernelHeight - 1, cd.height + kernelHeight - 1)), &cd.log2_h);
+	const size_t data_len = (size_t)cd.w2 * cd.h2;
+
+	// block add-overlap, blocks are at least as large as the kernel,
+	// so a block only adds to the result of its direct neighbors
+	cd.xbsz = (cd.w2 + 1) - kernelWidth;
+	cd.ybsz = (cd.h2 + 1) - kernelHeight;
+	cd.nxb = (cd.width + cd.xbsz - 1) / cd.xbsz;
+	const int nyb = (cd.height + cd.ybsz - 1) / cd.ybsz;
+	// kernel is flipped below, so the result at kernelWidth - 1 belongs to the pixel at centerX
+	cd.offx = kernelWidth - 1 - centerX;
+	cd.offy = kernelHeight - 1 - centerY;
+
+	const int num_threads = BLI_task_scheduler_num_threads(WorkScheduler::get_task_scheduler());
+	const bool threaded_blocks = cd.nxb * nyb >= 8 * num_threads;
+	const bool threaded_kernel = data_len >= 256 * 256;
+
+	// flipped kernel of every channel -> transformed kernels
+	fREAL *tmp = (fREAL *)MEM_mallocN(data_len * sizeof(fREAL), "fft_convolve kernel tmp");
+	fREAL **kernels = (fREAL **)MEM_mallocN(numChannels * sizeof(fREAL *), "fft_convolve kernels");
+	for (ch = 0; ch < num_kernels; ch++) {
+		fREAL *data = (fREAL *)MEM_callocN(data_len * sizeof(fREAL), "fft_convolve kernel");
+		for (y = 0; y < kernelHeight; y++) {
+			fREAL *fp = &data[(kernelHeight - 1 - y) * cd.w2 + kernelWidth - 1];
+			const float *colp = &kernel[(size_t)y * kernelWidth * kernelChannels + ch];
+			for (x = 0; x < kernelWidth; x++)
+				fp[-x] = colp[x * kernelChannels];
+		}
+		// zero pad data start == kernel height
+		FHT2D(&data, &tmp, cd.log2_w, cd.log2_h, kernelHeight, 0, threaded_kernel);
+		kernels[ch] = data;
+	}
+	for (; ch < numChannels; ch++) {
+		kernels[ch] = kernels[0];
+	}
+	cd.kernels = kernels;
+
+	for (y = 0; y < cd.height; y++) {
+		float *colp = &cd.result[(size_t)y * cd.width * cd.resultChannels];
+		for (x = 0; x < cd.width; x++, colp += cd.resultChannels) {
+			memset(colp, 0, numChannels * sizeof(float));
+		}
+	}
+
+	if (threaded_blocks) {
+		// blocks two apart do not overlap, four passes add every block without locking
+		ParallelRangeSettings settings;
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.scheduler = WorkScheduler::get_task_scheduler();
+		settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+		for (int pass = 0; pass < 4; pass++) {
+			cd.xparity = pass & 1;
+			cd.yparity = pass >> 1;
+			cd.num_pass_xb = (cd.nxb - cd.xparity + 1) / 2;
+			const int num_pass_yb = (nyb - cd.yparity + 1) / 2;
+			if (cd.num_pass_xb > 0 && num_pass_yb > 0) {
+				BLI_task_parallel_range(0, cd.num_pass_xb * num_pass_yb, &cd, fft_convolve_block_cb, &settings);
+			}
+		}
+	}
+	else {
+		// few large blocks, transform rows and columns in parallel instead
+		fREAL *data = (fREAL *)MEM_mallocN(data_len * sizeof(fREAL), "fft_convolve data");
+		for (int ybl = 0; ybl < nyb; ybl++) {
+			for (int xbl = 0; xbl < cd.nxb; xbl++) {
+				fft_convolve_block(&cd, xbl, ybl, data, tmp, true);
+			}
+		}
+		MEM_freeN(data);
+	}
+
+	for (ch = 0; ch < num_kernels; ch++) {
+		MEM_freeN(kernels[ch]);
+	}
+	MEM_freeN(kernels);
+	MEM_freeN(tmp);
+
+	if (normalize) {
+		FFTNormalizeData nd;
+		const int tw = kernelWidth + 1;
+		double **tables = (double **)MEM_mallocN(numChannels * sizeof(double *), "fft_convolve tables");
+
+		for (ch = 0; ch < num_kernels; ch++) {
+			double *sat = (double *)MEM_callocN((size_t)tw * (kernelHeight + 1) * sizeof(double), "fft_convolve table");
+			for (y = 0; y < kernelHeight; y++) {
+				const float *colp = &kernel[(size_t)y * kernelWidth * kernelChannels + ch];
+				double row_sum = 0.0;
+				for (x = 0; x < kernelWidth; x++) {
+					row_sum += colp[x * kernelChannels];
+					sat[(y + 1) * tw + x + 1] = sat[y * tw + x + 1] + row_sum;
+				}
+			}
+			tables[ch] = sat;
+		}
+		for (; ch < numChannels; ch++) {
+			tables[ch] = tables[0];
+		}
+
+		nd.result = cd.result;
+		nd.width = cd.width;
+		nd.height = cd.height;
+		nd.resultChannels = cd.resultChannels;
+		nd.numChannels = numChannels;
+		nd.tables = tables;
+		nd.kernelWidth = kernelWidth;
+		nd.kernelHeight = kernelHeight;
+		nd.centerX = centerX;
+		nd.centerY = centerY;
+
+		ParallelRangeSettings settings;
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.scheduler = WorkScheduler::get_task_scheduler();
+		BLI_task_parallel_range(0, cd.height, &nd, fft_normalize_row_cb, &settings);
+
+		for (ch = 0; ch < num_kernels; ch++) {
+			MEM_freeN(tables[ch]);
+		}
+		MEM_freeN(tables);
+	}
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2018, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _COM_FFTConvolution_h_
+#define _COM_FFTConvolution_h_
+
+class MemoryBuffer;
+
+/**
+ * @brief number of kernel elements from which the FFT is faster than evaluating the kernel directly
+ */
+#define COM_FFT_CONVOLUTION_MIN_KERNEL_SIZE (32 * 32)
+
+/**
+ * @brief convolution of a MemoryBuffer with a large kernel, using the 2D fast Hartley transform
+ *
+ * The image is split in blocks which are transformed, multiplied with the transformed kernel and
+ * added to the result (overlap-add). When there are enough blocks they are calculated in parallel,
+ * otherwise the rows and columns of every transform are.
+ *
+ * The result is the same weighted sum the direct blur loops calculate:
+ *   output(x, y) = sum(kernel(i, j) * input(x + i - centerX, y + j - centerY))
+ * @ingroup Execution
+ */
+class FFTConvolution {
+public:
+	/**
+	 * @brief is the FFT faster than evaluating a kernel of this size for every pixel
+	 */
+	static bool isEfficient(int kernelWidth, int kernelHeight);
+
+	/**
+	 * @brief convolve the first channels of the input with the kernel
+	 * @param output buffer with the rect of the input, only the convolved channels are written
+	 * @param numChannels number of channels of the input to convolve
+	 * @param kernel rows of kernelWidth elements with kernelChannels weights each
+	 * @param kernelChannels 1 when all channels use the same weights, otherwise at least numChannels
+	 * @param centerX, centerY element of the kernel which is applied to the pixel itself
+	 * @param normalize divide every pixel by the sum of the weights which fall inside the input,
+	 * like the direct loops which skip pixels outside the input
+	 */
+	static void convolve(MemoryBuffer *output, MemoryBuffer *input, int numChannels,
+	                     const float *kernel, int kernelWidth, int kernelHeight, int kernelChannels,
+	                     int centerX, int centerY, bool normalize);
+};
+
+#endif /* _COM_FFTConvolution_h_ */
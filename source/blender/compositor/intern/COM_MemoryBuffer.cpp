@@ -42,6 +42,9 @@ static unsigned int determine_num_channels(DataType datatype)
 
 unsigned int MemoryBuffer::determineBufferSize()
 {
+	if (this->m_isSingleElem) {
+		return 1;
+	}
 	return getWidth() * getHeight();
 }
 
@@ -61,6 +64,7 @@ MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, unsigned int chunkNumber, r
 	this->m_height = BLI_rcti_size_y(&this->m_rect);
 	this->m_memoryProxy = memoryProxy;
 	this->m_chunkNumber = chunkNumber;
+	this->m_isSingleElem = false;
 	this->m_num_channels = determine_num_channels(memoryProxy->getDataType());
 	this->m_buffer = (float *)MEM_mallocN_aligned(sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
 	this->m_state = COM_MB_ALLOCATED;
@@ -74,12 +78,13 @@ MemoryBuffer::MemoryBuffer(MemoryProxy *memoryProxy, rcti *rect)
 	this->m_height = BLI_rcti_size_y(&this->m_rect);
 	this->m_memoryProxy = memoryProxy;
 	this->m_chunkNumber = -1;
+	this->m_isSingleElem = false;
 	this->m_num_channels = determine_num_channels(memoryProxy->getDataType());
 	this->m_buffer = (float *)MEM_mallocN_aligned(sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
 	this->m_state = COM_MB_TEMPORARILY;
 	this->m_datatype = memoryProxy->getDataType();
 }
-MemoryBuffer::MemoryBuffer(DataType dataType, rcti *rect)
+MemoryBuffer::MemoryBuffer(DataType dataType, rcti *rect, bool isSingleElem)
 {
 	BLI_rcti_init(&this->m_rect, rect->xmin, rect->xmax, rect->ymin, rect->ymax);
 	this->m_width = BLI_rcti_size_x(&this->m_rect);
@@ -87,6 +92,7 @@ MemoryBuffer::MemoryBuffer(DataType dataType, rcti *rect)
 	this->m_height = this->m_rect.ymax - this->m_rect.ymin;
 	this->m_memoryProxy = NULL;
 	this->m_chunkNumber = -1;
+	this->m_isSingleElem = isSingleElem;
 	this->m_num_channels = determine_num_channels(dataType);
 	this->m_buffer = (float *)MEM_mallocN_aligned(sizeof(float) * determineBufferSize() * this->m_num_channels, 16, "COM_MemoryBuffer");
 	this->m_state = COM_MB_TEMPORARILY;
@@ -94,7 +100,13 @@ MemoryBuffer::MemoryBuffer(DataType dataType, rcti *rect)
 }
 MemoryBuffer *MemoryBuffer::duplicate()
 {
-	MemoryBuffer *result = new MemoryBuffer(this->m_memoryProxy, &this->m_rect);
+	MemoryBuffer *result;
+	if (this->m_memoryProxy) {
+		result = new MemoryBuffer(this->m_memoryProxy, &this->m_rect);
+	}
+	else {
+		result = new MemoryBuffer(this->m_datatype, &this->m_rect, this->m_isSingleElem);
+	}
 	memcpy(result->m_buffer, this->m_buffer, this->determineBufferSize() * this->m_num_channels * sizeof(float));
 	return result;
 }
@@ -101,6 +101,11 @@ private:
 	int m_width;
 	int m_height;
 
+	/**
+	 * @brief the buffer holds one element, which is the value of all pixels in the rect
+	 */
+	bool m_isSingleElem;
+
 public:
 	/**
 	 * @brief construct new MemoryBuffer for a chunk
@@ -114,8 +119,9 @@ public:
 
 	/**
 	 * @brief construct new temporarily MemoryBuffer for an area
+	 * @param isSingleElem only allocate one element for the whole area
 	 */
-	MemoryBuffer(DataType datatype, rcti *rect);
+	MemoryBuffer(DataType datatype, rcti *rect, bool isSingleElem = false);
 
 	/**
 	 * @brief destructor
@@ -134,6 +140,32 @@ public:
 	 * @note buffer should already be available in memory
 	 */
 	float *getBuffer() { return this->m_buffer; }
+
+	bool isSingleElem() const { return this->m_isSingleElem; }
+
+	/**
+	 * @brief number of floats between two neighbouring pixels, zero for single element buffers
+	 * so loops can step through the buffer without checking
+	 */
+	int getElemStride() const { return this->m_isSingleElem ? 0 : this->m_num_channels; }
+
+	/**
+	 * @brief get the element of pixel (x, y), which has to be inside the rect
+	 */
+	inline float *getElem(int x, int y)
+	{
+		if (this->m_isSingleElem) {
+			return this->m_buffer;
+		}
+		BLI_assert(x >= m_rect.xmin && x < m_rect.xmax && y >= m_rect.ymin && y < m_rect.ymax);
+		const int offset = (this->m_width * (y - m_rect.ymin) + (x - m_rect.xmin)) * this->m_num_channels;
+		return &this->m_buffer[offset];
+	}
+
+	inline void readElem(float *result, int x, int y)
+	{
+		memcpy(result, getElem(x, y), sizeof(float) * this->m_num_channels);
+	}
 	
 	/**
 	 * @brief after execution the state will be set to available by calling this method
@@ -36,6 +36,7 @@ extern "C" {
 #include "COM_Node.h"
 #include "COM_MemoryBuffer.h"
 #include "COM_MemoryProxy.h"
+#include "COM_ResultCache.h"
 #include "COM_SocketReader.h"
 
 #include "clew.h"
@@ -105,6 +106,18 @@ private:
 	 */
 	bool m_openCL;
 
+	/**
+	 * @brief can this operation calculate whole buffers at once
+	 * @see NodeOperation.updateOutputBuffer
+	 */
+	bool m_fullFrame;
+
+	/**
+	 * @brief hash of the settings of this operation, zero when its result can't be cached
+	 * @see NodeOperationBuilder.add_result_cache_settings
+	 */
+	ResultCacheKey m_resultCacheSettings;
+
 	/**
 	 * @brief mutex reference for very special node initializations
 	 * @note only use when you really know what you are doing.
@@ -216,6 +229,28 @@ public:
 	                           list<cl_kernel> * /*clKernelsToCleanUp*/) {}
 	virtual void deinitExecution();
 
+	/**
+	 * @brief calculate an area of the output buffer from the input buffers, during full frame execution
+	 * @ingroup execution
+	 * @note this method is only called when the operation is full frame, other operations are
+	 * evaluated pixel by pixel. It can be called from multiple threads for different areas.
+	 * @param output buffer covering the resolution of this operation
+	 * @param area the area of the output to calculate
+	 * @param inputs buffers of the input sockets, covering the resolution of this operation
+	 * or holding a single element
+	 * @see ExecutionSystem.executeFullFrame
+	 */
+	virtual void updateOutputBuffer(MemoryBuffer * /*output*/,
+	                                rcti * /*area*/,
+	                                MemoryBuffer ** /*inputs*/) {}
+
+	/**
+	 * @brief add settings which are not stored in the node, like data of other ID blocks, to the result cache key
+	 * @return false when the result of this operation can't be cached
+	 * @see NodeOperationBuilder.add_result_cache_settings
+	 */
+	virtual bool hashExternalSettings(ResultCacheHash & /*hash*/) const { return true; }
+
 	bool isResolutionSet() {
 		return this->m_isResolutionSet;
 	}
@@ -288,6 +323,19 @@ public:
 	 * @see ExecutionGroup.addOperation
 	 */
 	bool isOpenCL() const { return this->m_openCL; }
+
+	/**
+	 * @brief does this NodeOperation implement updateOutputBuffer
+	 * @see ExecutionSystem.executeFullFrame
+	 */
+	bool isFullFrame() const { return this->m_fullFrame; }
+
+	/**
+	 * @brief hash of the settings of this operation, used for the key of its result in the ResultCache
+	 * @return zero when the result can't be cached
+	 */
+	ResultCacheKey getResultCacheSettings() const { return this->m_resultCacheSettings; }
+	void setResultCacheSettings(ResultCacheKey settings) { this->m_resultCacheSettings = settings; }
 	
 	virtual bool isViewerOperation() const { return false; }
 	virtual bool isPreviewOperation() const { return false; }
@@ -333,6 +381,11 @@ protected:
 	 */
 	void setOpenCL(bool openCL) { this->m_openCL = openCL; }
 
+	/**
+	 * @brief set if this NodeOperation implements updateOutputBuffer
+	 */
+	void setFullFrame(bool fullFrame) { this->m_fullFrame = fullFrame; }
+
 	/* allow the DebugInfo class to look at internals */
 	friend class DebugInfo;
 
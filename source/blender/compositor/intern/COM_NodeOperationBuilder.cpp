@@ -19,6 +19,8 @@
  *		Lukas Toenne
  */
 
+#include <typeinfo>
+
 extern "C" {
 #include "BLI_utildefines.h"
 }
@@ -45,6 +47,7 @@ extern "C" {
 NodeOperationBuilder::NodeOperationBuilder(const CompositorContext *context, bNodeTree *b_nodetree) :
     m_context(context),
     m_current_node(NULL),
+    m_current_node_num_operations(0),
     m_active_viewer(NULL)
 {
 	m_graph.from_bNodeTree(*context, b_nodetree);
@@ -63,6 +66,7 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 		Node *node = (Node *)m_graph.nodes()[index];
 		
 		m_current_node = node;
+		m_current_node_num_operations = 0;
 		
 		DebugInfo::node_to_operations(node);
 		node->convertToOperations(converter, *m_context);
@@ -118,6 +122,10 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 	
 	prune_operations();
 	
+	if (m_context->getResultCacheLimit() > 0) {
+		add_result_cache_settings();
+	}
+	
 	/* ensure topological (link-based) order of nodes */
 	/*sort_operations();*/ /* not needed yet */
 	
@@ -131,6 +139,9 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 void NodeOperationBuilder::addOperation(NodeOperation *operation)
 {
 	m_operations.push_back(operation);
+	if (m_current_node) {
+		m_operation_nodes[operation] = std::make_pair(m_current_node, m_current_node_num_operations++);
+	}
 }
 
 void NodeOperationBuilder::mapInputSocket(NodeInput *node_socket, NodeOperationInput *operation_socket)
@@ -608,13 +619,64 @@ void NodeOperationBuilder::prune_operations()
 		
 		if (reachable.find(op) != reachable.end())
 			reachable_ops.push_back(op);
-		else
+		else {
+			m_operation_nodes.erase(op);
 			delete op;
+		}
 	}
 	/* finally replace the operations list with the pruned list */
 	m_operations = reachable_ops;
 }
 
+void NodeOperationBuilder::add_result_cache_settings()
+{
+	const RenderData *rd = m_context->getRenderData();
+	const char *view_name = m_context->getViewName();
+	ResultCacheHash context_hash;
+
+	context_hash.addInt(m_context->getQuality());
+	context_hash.addInt(m_context->isRendering());
+	context_hash.addInt(m_context->getFramenumber());
+	context_hash.addString(view_name ? view_name : "");
+	if (rd) {
+		context_hash.addInt(rd->xsch);
+		context_hash.addInt(rd->ysch);
+		context_hash.addInt(rd->size);
+		context_hash.addInt(rd->scemode);
+	}
+
+	for (Operations::const_iterator it = m_operations.begin(); it != m_operations.end(); ++it) {
+		NodeOperation *op = *it;
+		ResultCacheHash hash = context_hash;
+
+		hash.addString(typeid(*op).name());
+		hash.addInt(op->getWidth());
+		hash.addInt(op->getHeight());
+
+		OperationNodeMap::const_iterator node_it = m_operation_nodes.find(op);
+		if (node_it != m_operation_nodes.end()) {
+			const bNode *node = node_it->second.first->getbNode();
+
+			/* images, textures and movie clips can change without the node changing, only operations
+			 * without inputs read them and their results are hashed during execution */
+			if (node->id && GS(node->id->name) != ID_SCE && op->getNumberOfInputSockets() > 0) {
+				op->setResultCacheSettings(0);
+				continue;
+			}
+
+			hash.addNode(node);
+			hash.addInt(node_it->second.second);
+		}
+
+		if (!op->hashExternalSettings(hash)) {
+			op->setResultCacheSettings(0);
+			continue;
+		}
+
+		op->setResultCacheSettings(hash.end());
+	}
+}
+
 /* topological (depth-first) sorting of operations */
 static void sort_operations_recursive(NodeOperationBuilder::Operations &sorted, Tags &visited, NodeOperation *op)
 {
@@ -73,6 +73,9 @@ public:
 	typedef std::vector<NodeOperationInput *> OpInputs;
 	typedef std::map<NodeInput *, OpInputs> OpInputInverseMap;
 	
+	/** Node that added an operation and the index of the operation among the operations of the node */
+	typedef std::map<NodeOperation *, std::pair<Node *, int> > OperationNodeMap;
+	
 private:
 	const CompositorContext *m_context;
 	NodeGraph m_graph;
@@ -87,6 +90,10 @@ private:
 	OutputSocketMap m_output_map;
 	
 	Node *m_current_node;
+	int m_current_node_num_operations;
+	
+	/** Maps operations to the nodes that added them */
+	OperationNodeMap m_operation_nodes;
 	
 	/** Operation that will be writing to the viewer image
 	 *  Only one operation can occupy this place at a time,
@@ -152,6 +159,9 @@ protected:
 	/** Remove unreachable operations */
 	void prune_operations();
 	
+	/** Hash the settings of each operation for keys in the ResultCache */
+	void add_result_cache_settings();
+	
 	/** Sort operations by link dependencies */
 	void sort_operations();
 	
@@ -0,0 +1,243 @@
+/*
+ * Copyright 2018, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <list>
+#include <map>
+#include <string.h>
+
+#include "COM_ResultCache.h"
+#include "COM_MemoryBuffer.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+
+#include "BKE_node.h"
+
+#include "DNA_color_types.h"
+#include "DNA_genfile.h"
+#include "DNA_ID.h"
+#include "DNA_node_types.h"
+#include "DNA_sdna_types.h"
+
+#include "MEM_guardedalloc.h"
+}
+
+using std::list;
+using std::map;
+
+/* ******** Hash ******** */
+
+ResultCacheHash::ResultCacheHash()
+{
+	BLI_hash_mm2a_init(&this->m_low, 0);
+	BLI_hash_mm2a_init(&this->m_high, 0x9e3779b9);
+}
+
+void ResultCacheHash::add(const void *data, size_t len)
+{
+	BLI_hash_mm2a_add(&this->m_low, (const unsigned char *)data, len);
+	BLI_hash_mm2a_add(&this->m_high, (const unsigned char *)data, len);
+}
+
+void ResultCacheHash::addInt(int value)
+{
+	BLI_hash_mm2a_add_int(&this->m_low, value);
+	BLI_hash_mm2a_add_int(&this->m_high, value);
+}
+
+void ResultCacheHash::addKey(ResultCacheKey key)
+{
+	addInt((int)(key & 0xffffffff));
+	addInt((int)(key >> 32));
+}
+
+void ResultCacheHash::addString(const char *str)
+{
+	add(str, strlen(str) + 1);
+}
+
+void ResultCacheHash::addDNAStruct(const SDNA *sdna, int struct_nr, const char *data)
+{
+	const short *sp = sdna->structs[struct_nr];
+	const short first_struct_type = sdna->structs[0][0];
+	const int num_members = sp[1];
+
+	sp += 2;
+	for (int a = 0; a < num_members; a++, sp += 2) {
+		const char *name = sdna->names[sp[1]];
+		const int array_len = DNA_elem_array_size(name);
+
+		if (name[0] == '*' || (name[0] == '(' && name[1] == '*')) {
+			/* pointers differ between copies of the same settings */
+			data += sdna->pointerlen * array_len;
+		}
+		else if (sp[0] >= first_struct_type) {
+			const int member_struct_nr = DNA_struct_find_nr(sdna, sdna->types[sp[0]]);
+			for (int i = 0; i < array_len; i++) {
+				addDNAStruct(sdna, member_struct_nr, data);
+				data += sdna->typelens[sp[0]];
+			}
+		}
+		else {
+			add(data, sdna->typelens[sp[0]] * array_len);
+			data += sdna->typelens[sp[0]] * array_len;
+		}
+	}
+}
+
+void ResultCacheHash::addDNAStruct(const char *struct_name, const void *data)
+{
+	const SDNA *sdna = DNA_sdna_current_get();
+	const int struct_nr = DNA_struct_find_nr(sdna, struct_name);
+
+	BLI_assert(struct_nr != -1);
+	addString(struct_name);
+	addDNAStruct(sdna, struct_nr, (const char *)data);
+}
+
+void ResultCacheHash::addNode(const bNode *node)
+{
+	addInt(node->type);
+	addInt(node->custom1);
+	addInt(node->custom2);
+	add(&node->custom3, sizeof(node->custom3));
+	add(&node->custom4, sizeof(node->custom4));
+	if (node->id) {
+		/* the data of the ID is hashed by the operations reading it */
+		addString(node->id->name);
+		addString(node->id->lib ? node->id->lib->name : "");
+	}
+	else {
+		addString("");
+	}
+
+	if (node->storage) {
+		addDNAStruct(node->typeinfo->storagename, node->storage);
+		if (STREQ(node->typeinfo->storagename, "CurveMapping")) {
+			const CurveMapping *cumap = (const CurveMapping *)node->storage;
+			for (int a = 0; a < CM_TOT; a++) {
+				if (cumap->cm[a].curve) {
+					add(cumap->cm[a].curve, sizeof(CurveMapPoint) * cumap->cm[a].totpoint);
+				}
+			}
+		}
+	}
+
+	/* nodes read unlinked input values and the values of value and color nodes from the sockets,
+	 * the socket values of the compositor don't contain pointers */
+	const ListBase *socket_lists[2] = {&node->inputs, &node->outputs};
+	for (int i = 0; i < 2; i++) {
+		for (bNodeSocket *sock = (bNodeSocket *)socket_lists[i]->first; sock; sock = sock->next) {
+			if (sock->default_value) {
+				add(sock->default_value, MEM_allocN_len(sock->default_value));
+			}
+		}
+	}
+}
+
+ResultCacheKey ResultCacheHash::end()
+{
+	ResultCacheKey key = ((ResultCacheKey)BLI_hash_mm2a_end(&this->m_high) << 32) |
+	                     (ResultCacheKey)BLI_hash_mm2a_end(&this->m_low);
+	/* zero is reserved for results which are not cached */
+	return (key != 0) ? key : 1;
+}
+
+/* ******** Cache ******** */
+
+typedef struct ResultCacheEntry {
+	MemoryBuffer *buffer;
+	size_t size;
+	/* position in g_lru */
+	list<ResultCacheKey>::iterator lru;
+} ResultCacheEntry;
+
+static map<ResultCacheKey, ResultCacheEntry> g_entries;
+/* keys of the entries, most recently used first */
+static list<ResultCacheKey> g_lru;
+static size_t g_size = 0;
+static size_t g_limit = 0;
+
+static size_t result_cache_buffer_size(MemoryBuffer *buffer)
+{
+	const size_t num_elements = buffer->isSingleElem() ? 1 : (size_t)buffer->getWidth() * buffer->getHeight();
+	return num_elements * buffer->get_num_channels() * sizeof(float);
+}
+
+static void result_cache_evict(size_t size)
+{
+	while (!g_lru.empty() && g_size + size > g_limit) {
+		map<ResultCacheKey, ResultCacheEntry>::iterator it = g_entries.find(g_lru.back());
+		g_size -= it->second.size;
+		delete it->second.buffer;
+		g_entries.erase(it);
+		g_lru.pop_back();
+	}
+}
+
+void ResultCache::setLimit(size_t limit)
+{
+	g_limit = limit;
+	result_cache_evict(0);
+}
+
+bool ResultCache::isEnabled()
+{
+	return g_limit > 0;
+}
+
+MemoryBuffer *ResultCache::read(ResultCacheKey key)
+{
+	map<ResultCacheKey, ResultCacheEntry>::iterator it = g_entries.find(key);
+	if (it == g_entries.end()) {
+		return NULL;
+	}
+
+	ResultCacheEntry &entry = it->second;
+	g_lru.splice(g_lru.begin(), g_lru, entry.lru);
+	return entry.buffer->duplicate();
+}
+
+void ResultCache::store(ResultCacheKey key, MemoryBuffer *buffer)
+{
+	const size_t size = result_cache_buffer_size(buffer);
+
+	if (size > g_limit || g_entries.count(key)) {
+		delete buffer;
+		return;
+	}
+
+	result_cache_evict(size);
+
+	ResultCacheEntry &entry = g_entries[key];
+	g_lru.push_front(key);
+	entry.buffer = buffer;
+	entry.size = size;
+	entry.lru = g_lru.begin();
+	g_size += size;
+}
+
+void ResultCache::clear()
+{
+	for (map<ResultCacheKey, ResultCacheEntry>::iterator it = g_entries.begin(); it != g_entries.end(); ++it) {
+		delete it->second.buffer;
+	}
+	g_entries.clear();
+	g_lru.clear();
+	g_size = 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2018, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _COM_ResultCache_h_
+#define _COM_ResultCache_h_
+
+extern "C" {
+#include "BLI_hash_mm2a.h"
+}
+
+class MemoryBuffer;
+struct bNode;
+struct SDNA;
+
+/**
+ * @brief key of a result in the ResultCache, zero marks results which are not cached
+ */
+typedef uint64_t ResultCacheKey;
+
+/**
+ * @brief incremental hash for ResultCacheKey's
+ * Two murmur hashes with different seeds are combined, so unrelated results practically never share a key.
+ * @ingroup Execution
+ */
+class ResultCacheHash {
+private:
+	BLI_HashMurmur2A m_low;
+	BLI_HashMurmur2A m_high;
+
+	void addDNAStruct(const SDNA *sdna, int struct_nr, const char *data);
+
+public:
+	ResultCacheHash();
+
+	void add(const void *data, size_t len);
+	void addInt(int value);
+	void addKey(ResultCacheKey key);
+	void addString(const char *str);
+
+	/**
+	 * @brief add the values of a DNA struct, pointers in the struct are skipped
+	 * Nested structs are added member by member as well.
+	 */
+	void addDNAStruct(const char *struct_name, const void *data);
+
+	/**
+	 * @brief add the settings of a node: its type, custom values, storage and socket values
+	 * The storage is added by value, so copies of a node (like in a localized tree) get the same hash.
+	 */
+	void addNode(const bNode *node);
+
+	/**
+	 * @brief get the key of all data added, can only be called once
+	 */
+	ResultCacheKey end();
+};
+
+/**
+ * @brief results of operations, kept between executions of the compositor
+ *
+ * During full frame execution the buffer of every operation is stored under a key, which is a hash
+ * of the settings of the operation and the keys of its inputs. When a later execution finds the key
+ * of an operation, the operation and the operations it depends on are not calculated again.
+ * When the size of the stored buffers exceeds the limit the least recently used buffers are freed.
+ *
+ * @note the cache is only accessed while the compositor mutex is locked.
+ * @see ExecutionSystem.executeFullFrame
+ * @see NodeOperationBuilder.add_result_cache_settings
+ * @ingroup Execution
+ */
+class ResultCache {
+public:
+	/**
+	 * @brief set the maximum size of the stored buffers in bytes, freeing buffers when needed
+	 * Zero disables the cache.
+	 */
+	static void setLimit(size_t limit);
+
+	static bool isEnabled();
+
+	/**
+	 * @brief get a copy of the buffer stored under the key
+	 * @return the copy which is owned by the caller, or NULL when the key is not stored
+	 */
+	static MemoryBuffer *read(ResultCacheKey key);
+
+	/**
+	 * @brief store a buffer under the key, the cache takes ownership of the buffer
+	 * Buffers of keys which are already stored and buffers larger than the limit are freed.
+	 */
+	static void store(ResultCacheKey key, MemoryBuffer *buffer);
+
+	/**
+	 * @brief free all stored buffers
+	 */
+	static void clear();
+};
+
+#endif /* _COM_ResultCache_h_ */
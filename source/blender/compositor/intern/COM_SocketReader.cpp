@@ -23,3 +23,33 @@
 #include "COM_SocketReader.h"
 
 
+#include "COM_MemoryBuffer.h"
+
+void SocketReader::readFullFrameBuffer(float result[4], float x, float y, PixelSampler sampler)
+{
+	MemoryBuffer *buffer = this->m_fullFrameBuffer;
+
+	if (buffer->isSingleElem()) {
+		buffer->readElem(result, 0, 0);
+	}
+	else if (sampler == COM_PS_NEAREST) {
+		buffer->read(result, x, y);
+	}
+	else {
+		buffer->readBilinear(result, x, y);
+	}
+}
+
+void SocketReader::readFullFrameBufferFiltered(float result[4], float x, float y, float dx[2], float dy[2])
+{
+	MemoryBuffer *buffer = this->m_fullFrameBuffer;
+
+	if (buffer->isSingleElem()) {
+		buffer->readElem(result, 0, 0);
+	}
+	else {
+		const float uv[2] = { x, y };
+		const float deriv[2][2] = { {dx[0], dx[1]}, {dy[0], dy[1]} };
+		buffer->readEWA(result, uv, deriv);
+	}
+}
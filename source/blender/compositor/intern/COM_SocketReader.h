@@ -54,6 +54,12 @@ protected:
 	 */
 	unsigned int m_height;
 
+	/**
+	 * @brief result of this operation for the whole image, in full frame execution
+	 * @note when set all reads are redirected to this buffer
+	 * @see ExecutionSystem.executeFullFrame
+	 */
+	MemoryBuffer *m_fullFrameBuffer;
 
 	/**
 	 * @brief calculate a single pixel
@@ -95,15 +101,35 @@ protected:
 	                                  float /*x*/, float /*y*/,
 	                                  float /*dx*/[2], float /*dy*/[2]) {}
 
+	void readFullFrameBuffer(float result[4], float x, float y, PixelSampler sampler);
+	void readFullFrameBufferFiltered(float result[4], float x, float y, float dx[2], float dy[2]);
+
 public:
+	SocketReader() : m_fullFrameBuffer(NULL) {}
+
 	inline void readSampled(float result[4], float x, float y, PixelSampler sampler) {
-		executePixelSampled(result, x, y, sampler);
+		if (this->m_fullFrameBuffer) {
+			readFullFrameBuffer(result, x, y, sampler);
+		}
+		else {
+			executePixelSampled(result, x, y, sampler);
+		}
 	}
 	inline void read(float result[4], int x, int y, void *chunkData) {
-		executePixel(result, x, y, chunkData);
+		if (this->m_fullFrameBuffer) {
+			readFullFrameBuffer(result, x, y, COM_PS_NEAREST);
+		}
+		else {
+			executePixel(result, x, y, chunkData);
+		}
 	}
 	inline void readFiltered(float result[4], float x, float y, float dx[2], float dy[2]) {
-		executePixelFiltered(result, x, y, dx, dy);
+		if (this->m_fullFrameBuffer) {
+			readFullFrameBufferFiltered(result, x, y, dx, dy);
+		}
+		else {
+			executePixelFiltered(result, x, y, dx, dy);
+		}
 	}
 
 	virtual void *initializeTileData(rcti * /*rect*/) { return 0; }
@@ -116,6 +142,9 @@ public:
 	inline const unsigned int getWidth() const { return this->m_width; }
 	inline const unsigned int getHeight() const { return this->m_height; }
 
+	MemoryBuffer *getFullFrameBuffer() const { return this->m_fullFrameBuffer; }
+	void setFullFrameBuffer(MemoryBuffer *buffer) { this->m_fullFrameBuffer = buffer; }
+
 #ifdef WITH_CXX_GUARDEDALLOC
 	MEM_CXX_CLASS_ALLOC_FUNCS("COM:SocketReader")
 #endif
@@ -35,6 +35,8 @@
 
 #include "PIL_time.h"
 #include "BLI_threads.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
 
 #include "BKE_global.h"
 
@@ -42,24 +44,27 @@
 #  ifndef DEBUG  /* test this so we dont get warnings in debug builds */
 #    warning COM_CURRENT_THREADING_MODEL COM_TM_NOTHREAD is activated. Use only for debugging.
 #  endif
-#elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
    /* do nothing - default */
 #else
 #  error COM_CURRENT_THREADING_MODEL No threading model selected
 #endif
 
 
-/// @brief list of all CPUDevices. for every hardware thread an instance of CPUDevice is created
-static vector<CPUDevice*> g_cpudevices;
-static ThreadLocal(CPUDevice *) g_thread_device;
-
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-/// @brief list of all thread for every CPUDevice in cpudevices a thread exists
-static ListBase g_cputhreads;
+/// @brief thread id of the task scheduler plus one, zero for threads which are not executing a chunk
+static ThreadLocal(void *) g_thread_id;
 static bool g_cpuInitialized = false;
-/// @brief all scheduled work for the cpu
-static ThreadQueue *g_cpuqueue;
-static ThreadQueue *g_gpuqueue;
+
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+/// @brief scheduler executing the cpu work, the global task scheduler unless the render settings use another number of threads
+static TaskScheduler *g_scheduler = NULL;
+/// @brief scheduler for a fixed number of threads, kept between executions while the number doesn't change
+static TaskScheduler *g_fixedScheduler = NULL;
+static int g_fixedSchedulerThreads = 0;
+/// @brief all scheduled work for the cpu, executed by the threads of g_scheduler
+static TaskPool *g_cpupool;
+/// @brief priority of the chunks which are currently scheduled
+static TaskPriority g_priority = TASK_PRIORITY_HIGH;
 #ifdef COM_OPENCL_ENABLED
 static cl_context g_context;
 static cl_program g_program;
@@ -68,27 +73,42 @@ static vector<OpenCLDevice *> g_gpudevices;
 /// @brief list of all thread for every GPUDevice in cpudevices a thread exists
 static ListBase g_gputhreads;
 /// @brief all scheduled work for the gpu
-#ifdef COM_OPENCL_ENABLED
+static ThreadQueue *g_gpuqueue;
+/// @brief number of chunks scheduled and finished on the gpu, guarded by g_gpumutex
+static unsigned int g_gpuScheduled = 0;
+static unsigned int g_gpuFinished = 0;
+static ThreadMutex g_gpumutex = BLI_MUTEX_INITIALIZER;
+static ThreadCondition g_gpucondition;
 static bool g_openclActive = false;
 static bool g_openclInitialized = false;
 #endif
 #endif
-#endif
 
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-void *WorkScheduler::thread_execute_cpu(void *data)
+static int task_thread_id()
 {
-	CPUDevice *device = (CPUDevice *)data;
-	WorkPackage *work;
-	BLI_thread_local_set(g_thread_device, device);
-	while ((work = (WorkPackage *)BLI_thread_queue_pop(g_cpuqueue))) {
-		device->execute(work);
-		delete work;
+	return GET_INT_FROM_POINTER(BLI_thread_local_get(g_thread_id)) - 1;
+}
+
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+void WorkScheduler::execute_cpu_task(TaskPool *__restrict /*pool*/, void *taskdata, int threadid)
+{
+	WorkPackage *work = (WorkPackage *)taskdata;
+	ExecutionGroup *group = work->getExecutionGroup();
+	CPUDevice device(threadid);
+
+	set_current_thread_id(threadid);
+	if (group->getOutputOperation()->isBreaked()) {
+		/* still finalize, chunks waiting for this one are released and skipped as well */
+		group->finalizeChunkExecution(work->getChunkNumber(), NULL);
 	}
-	
-	return NULL;
+	else {
+		device.execute(work);
+	}
+	set_current_thread_id(-1);
+	delete work;
 }
 
+#ifdef COM_OPENCL_ENABLED
 void *WorkScheduler::thread_execute_gpu(void *data)
 {
 	Device *device = (Device *)data;
@@ -97,11 +117,17 @@ void *WorkScheduler::thread_execute_gpu(void *data)
 	while ((work = (WorkPackage *)BLI_thread_queue_pop(g_gpuqueue))) {
 		device->execute(work);
 		delete work;
+
+		BLI_mutex_lock(&g_gpumutex);
+		g_gpuFinished++;
+		BLI_condition_notify_all(&g_gpucondition);
+		BLI_mutex_unlock(&g_gpumutex);
 	}
 	
 	return NULL;
 }
 #endif
+#endif
 
 
 
@@ -112,33 +138,49 @@ void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
 	CPUDevice device(0);
 	device.execute(package);
 	delete package;
-#elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 #ifdef COM_OPENCL_ENABLED
 	if (group->isOpenCL() && g_openclActive) {
+		BLI_mutex_lock(&g_gpumutex);
+		g_gpuScheduled++;
+		BLI_mutex_unlock(&g_gpumutex);
 		BLI_thread_queue_push(g_gpuqueue, package);
+		return;
+	}
+#endif
+	/* the package is a C++ object, it is deleted by execute_cpu_task instead of the task pool */
+	const int thread_id = task_thread_id();
+	if (thread_id != -1) {
+		/* chunks released by a finished chunk are picked up by the same thread, while its inputs are still in cache */
+		BLI_task_pool_push_from_thread(g_cpupool, execute_cpu_task, package, false, g_priority, thread_id);
 	}
 	else {
-		BLI_thread_queue_push(g_cpuqueue, package);
+		BLI_task_pool_push(g_cpupool, execute_cpu_task, package, false, g_priority);
 	}
-#else
-	BLI_thread_queue_push(g_cpuqueue, package);
 #endif
+}
+
+void WorkScheduler::setPriority(CompositorPriority priority)
+{
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+	g_priority = (priority == COM_PRIORITY_HIGH) ? TASK_PRIORITY_HIGH : TASK_PRIORITY_LOW;
+#else
+	(void)priority;
 #endif
 }
 
 void WorkScheduler::start(CompositorContext &context)
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-	unsigned int index;
-	g_cpuqueue = BLI_thread_queue_init();
-	BLI_threadpool_init(&g_cputhreads, thread_execute_cpu, g_cpudevices.size());
-	for (index = 0; index < g_cpudevices.size(); index++) {
-		Device *device = g_cpudevices[index];
-		BLI_threadpool_insert(&g_cputhreads, device);
-	}
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+	g_cpupool = BLI_task_pool_create(get_task_scheduler(), NULL);
+	g_priority = TASK_PRIORITY_HIGH;
 #ifdef COM_OPENCL_ENABLED
 	if (context.getHasActiveOpenCLDevices()) {
+		unsigned int index;
 		g_gpuqueue = BLI_thread_queue_init();
+		g_gpuScheduled = 0;
+		g_gpuFinished = 0;
+		BLI_condition_init(&g_gpucondition);
 		BLI_threadpool_init(&g_gputhreads, thread_execute_gpu, g_gpudevices.size());
 		for (index = 0; index < g_gpudevices.size(); index++) {
 			Device *device = g_gpudevices[index];
@@ -149,37 +191,58 @@ void WorkScheduler::start(CompositorContext &context)
 	else {
 		g_openclActive = false;
 	}
+#else
+	(void)context;
 #endif
+#else
+	(void)context;
 #endif
 }
 void WorkScheduler::finish()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 #ifdef COM_OPENCL_ENABLED
 	if (g_openclActive) {
-		BLI_thread_queue_wait_finish(g_gpuqueue);
-		BLI_thread_queue_wait_finish(g_cpuqueue);
+		/* chunks finished on the gpu can release chunks for the cpu and the other way around.
+		 * Wait until the gpu is idle and no gpu chunk finished while waiting for the cpu. */
+		BLI_mutex_lock(&g_gpumutex);
+		unsigned int finished = g_gpuFinished;
+		BLI_mutex_unlock(&g_gpumutex);
+		for (;;) {
+			BLI_task_pool_work_and_wait(g_cpupool);
+
+			BLI_mutex_lock(&g_gpumutex);
+			while (g_gpuFinished != g_gpuScheduled) {
+				BLI_condition_wait(&g_gpucondition, &g_gpumutex);
+			}
+			const bool gpu_released_work = (g_gpuFinished != finished);
+			finished = g_gpuFinished;
+			BLI_mutex_unlock(&g_gpumutex);
+
+			if (!gpu_released_work) {
+				break;
+			}
+		}
 	}
 	else {
-		BLI_thread_queue_wait_finish(g_cpuqueue);
+		BLI_task_pool_work_and_wait(g_cpupool);
 	}
 #else
-	BLI_thread_queue_wait_finish(cpuqueue);
+	BLI_task_pool_work_and_wait(g_cpupool);
 #endif
 #endif
 }
 void WorkScheduler::stop()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-	BLI_thread_queue_nowait(g_cpuqueue);
-	BLI_threadpool_end(&g_cputhreads);
-	BLI_thread_queue_free(g_cpuqueue);
-	g_cpuqueue = NULL;
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+	BLI_task_pool_free(g_cpupool);
+	g_cpupool = NULL;
 #ifdef COM_OPENCL_ENABLED
 	if (g_openclActive) {
 		BLI_thread_queue_nowait(g_gpuqueue);
 		BLI_threadpool_end(&g_gputhreads);
 		BLI_thread_queue_free(g_gpuqueue);
+		BLI_condition_end(&g_gpucondition);
 		g_gpuqueue = NULL;
 	}
 #endif
@@ -188,7 +251,7 @@ void WorkScheduler::stop()
 
 bool WorkScheduler::hasGPUDevices()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 #ifdef COM_OPENCL_ENABLED
 	return g_gpudevices.size() > 0;
 #else
@@ -199,7 +262,7 @@ bool WorkScheduler::hasGPUDevices()
 #endif
 }
 
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 static void CL_CALLBACK clContextError(const char *errinfo,
                                        const void * /*private_info*/,
                                        size_t /*cb*/,
@@ -211,34 +274,32 @@ static void CL_CALLBACK clContextError(const char *errinfo,
 
 void WorkScheduler::initialize(bool use_opencl, int num_cpu_threads)
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-	/* deinitialize if number of threads doesn't match */
-	if (g_cpudevices.size() != num_cpu_threads) {
-		Device *device;
-
-		while (g_cpudevices.size() > 0) {
-			device = g_cpudevices.back();
-			g_cpudevices.pop_back();
-			device->deinitialize();
-			delete device;
-		}
-		if (g_cpuInitialized) {
-			BLI_thread_local_delete(g_thread_device);
-		}
-		g_cpuInitialized = false;
+	if (!g_cpuInitialized) {
+		BLI_thread_local_create(g_thread_id);
+		g_cpuInitialized = true;
 	}
 
-	/* initialize CPU threads */
-	if (!g_cpuInitialized) {
-		for (int index = 0; index < num_cpu_threads; index++) {
-			CPUDevice *device = new CPUDevice(index);
-			device->initialize();
-			g_cpudevices.push_back(device);
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+	/* share the threads of the global task scheduler when it has the requested number of threads */
+	if (num_cpu_threads == BLI_system_thread_count()) {
+		g_scheduler = BLI_task_scheduler_get();
+	}
+	else {
+		if (g_fixedScheduler && g_fixedSchedulerThreads != num_cpu_threads) {
+			BLI_task_scheduler_free(g_fixedScheduler);
+			g_fixedScheduler = NULL;
 		}
-		BLI_thread_local_create(g_thread_device);
-		g_cpuInitialized = true;
+		if (g_fixedScheduler == NULL) {
+			g_fixedScheduler = BLI_task_scheduler_create_ex(num_cpu_threads, TASK_SCHEDULER_WORK_STEALING);
+			g_fixedSchedulerThreads = num_cpu_threads;
+		}
+		g_scheduler = g_fixedScheduler;
 	}
+#else
+	(void)num_cpu_threads;
+#endif
 
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 #ifdef COM_OPENCL_ENABLED
 	/* deinitialize OpenCL GPU's */
 	if (use_opencl && !g_openclInitialized) {
@@ -311,20 +372,18 @@ void WorkScheduler::initialize(bool use_opencl, int num_cpu_threads)
 
 void WorkScheduler::deinitialize()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
-	/* deinitialize CPU threads */
 	if (g_cpuInitialized) {
-		Device *device;
-		while (g_cpudevices.size() > 0) {
-			device = g_cpudevices.back();
-			g_cpudevices.pop_back();
-			device->deinitialize();
-			delete device;
-		}
-		BLI_thread_local_delete(g_thread_device);
+		BLI_thread_local_delete(g_thread_id);
 		g_cpuInitialized = false;
 	}
 
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+	g_scheduler = NULL;
+	if (g_fixedScheduler) {
+		BLI_task_scheduler_free(g_fixedScheduler);
+		g_fixedScheduler = NULL;
+		g_fixedSchedulerThreads = 0;
+	}
 #ifdef COM_OPENCL_ENABLED
 	/* deinitialize OpenCL GPU's */
 	if (g_openclInitialized) {
@@ -350,8 +409,23 @@ void WorkScheduler::deinitialize()
 #endif
 }
 
+TaskScheduler *WorkScheduler::get_task_scheduler()
+{
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+	if (g_scheduler) {
+		return g_scheduler;
+	}
+#endif
+	return BLI_task_scheduler_get();
+}
+
+void WorkScheduler::set_current_thread_id(int thread_id)
+{
+	BLI_thread_local_set(g_thread_id, SET_INT_IN_POINTER(thread_id + 1));
+}
+
 int WorkScheduler::current_thread_id()
 {
-	CPUDevice *device = (CPUDevice *)BLI_thread_local_get(g_thread_device);
-	return device->thread_id();
+	const int thread_id = task_thread_id();
+	return (thread_id != -1) ? thread_id : 0;
 }
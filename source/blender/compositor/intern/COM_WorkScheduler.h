@@ -26,6 +26,7 @@
 #include "COM_ExecutionGroup.h"
 extern "C" {
 #  include "BLI_threads.h"
+#  include "BLI_task.h"
 }
 #include "COM_WorkPackage.h"
 #include "COM_defines.h"
@@ -36,17 +37,12 @@ extern "C" {
  */
 class WorkScheduler {
 
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
 	/**
-	 * @brief are we being stopped.
+	 * @brief task executing a chunk on the CPU
+	 * the task runs on one of the threads of the global task scheduler
 	 */
-	static bool isStopping();
-
-	/**
-	 * @brief main thread loop for cpudevices
-	 * inside this loop new work is queried and being executed
-	 */
-	static void *thread_execute_cpu(void *data);
+	static void execute_cpu_task(TaskPool *__restrict pool, void *taskdata, int threadid);
 
 	/**
 	 * @brief main thread loop for gpudevices
@@ -59,23 +55,31 @@ public:
 	 * @brief schedule a chunk of a group to be calculated.
 	 * An execution group schedules a chunk in the WorkScheduler
 	 * when ExecutionGroup.isOpenCL is set the work will be handled by a OpenCLDevice
-	 * otherwise the work is scheduled for an CPUDevice
-	 * @see ExecutionGroup.execute
+	 * otherwise the work is scheduled as a task of the global task scheduler
+	 * @note chunks are only scheduled when the chunks they depend on are executed
+	 * @see ExecutionGroup.scheduleChunkWhenPossible
 	 * @param group the execution group
 	 * @param chunkNumber the number of the chunk in the group to be executed
 	 */
 	static void schedule(ExecutionGroup *group, int chunkNumber);
 
+	/**
+	 * @brief set the priority of the chunks scheduled from now on
+	 * chunks of high priority output groups (viewers) are picked up before other work of the task scheduler
+	 * @see ExecutionSystem.executeGroups
+	 */
+	static void setPriority(CompositorPriority priority);
+
 	/**
 	 * @brief initialize the WorkScheduler
 	 *
-	 * during initialization the mutexes are initialized.
-	 * there are two mutexes (for every device type one)
-	 * After mutex initialization the system is queried in order to count the number of CPUDevices and GPUDevices to be created.
-	 * For every hardware thread a CPUDevice and for every OpenCL GPU device a OpenCLDevice is created.
-	 * these devices are stored in a separate list (cpudevices & gpudevices)
+	 * CPU work is executed by the threads of the global task scheduler. When the number of CPU threads differs
+	 * from the one of the global task scheduler (a fixed number of threads in the render settings), a task
+	 * scheduler with that number of threads is created instead.
+	 * For every OpenCL GPU device a OpenCLDevice is created and stored in a separate list (gpudevices)
 	 *
-	 * This function can be called multiple times to lazily initialize OpenCL.
+	 * This function can be called multiple times to lazily initialize OpenCL and to change the number of threads.
+	 * @param num_cpu_threads number of threads executing CPU work, including the compositing thread
 	 */
 	static void initialize(bool use_opencl, int num_cpu_threads);
 
@@ -87,21 +91,22 @@ public:
 
 	/**
 	 * @brief Start the execution
-	 * this methods will start the WorkScheduler. Inside this method all threads are initialized.
-	 * for every device a thread is created.
+	 * this methods will start the WorkScheduler. Inside this method the task pool for CPU work is created,
+	 * for every OpenCL device a thread is created.
 	 * @see initialize Initialization and query of the number of devices
 	 */
 	static void start(CompositorContext &context);
 
 	/**
 	 * @brief stop the execution
-	 * All created thread by the start method are destroyed.
+	 * The task pool and all threads created by the start method are destroyed.
 	 * @see start
 	 */
 	static void stop();
 
 	/**
 	 * @brief wait for all work to be completed.
+	 * the calling thread executes CPU work while waiting.
 	 */
 	static void finish();
 
@@ -113,6 +118,23 @@ public:
 	 */
 	static bool hasGPUDevices();
 
+	/**
+	 * @brief task scheduler executing the CPU work
+	 * Multi-threaded loops of operations run on it as well, so they use the same number of threads.
+	 * @see initialize
+	 */
+	static TaskScheduler *get_task_scheduler();
+
+	/**
+	 * @brief set the thread id returned by current_thread_id for the calling thread
+	 * @param thread_id id of the task scheduler thread, or -1 when the thread stops executing compositor work
+	 */
+	static void set_current_thread_id(int thread_id);
+
+	/**
+	 * @brief id of the task scheduler thread executing the current chunk
+	 * Ids are unique between threads executing at the same time, and are used to index per thread data.
+	 */
 	static int current_thread_id();
 
 #ifdef WITH_CXX_GUARDEDALLOC
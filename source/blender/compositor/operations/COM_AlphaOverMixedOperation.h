@@ -41,7 +41,8 @@ public:
 	/**
 	 * the inner loop of this program
 	 */
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float value[4],
+	              const float inputColor1[4], const float inputOverColor[4]);
 	
 	void setX(float x) { this->m_x = x; }
 };
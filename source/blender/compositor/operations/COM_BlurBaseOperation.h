@@ -26,6 +26,8 @@
 #include "COM_QualityStepHelper.h"
 
 #define MAX_GAUSSTAB_RADIUS 30000
+/* radius from which the gaussian filter is calculated recursively instead of with the kernel */
+#define IIR_GAUSS_MIN_RADIUS 64
 
 #ifdef __SSE2__
 #  include <emmintrin.h>
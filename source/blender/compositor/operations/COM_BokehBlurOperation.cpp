@@ -23,6 +23,8 @@
 #include "COM_BokehBlurOperation.h"
 #include "BLI_math.h"
 #include "COM_OpenCLDevice.h"
+#include "COM_FFTConvolution.h"
+#include "MEM_guardedalloc.h"
 
 extern "C" {
 #  include "RE_pipeline.h"
@@ -45,6 +47,8 @@ BokehBlurOperation::BokehBlurOperation() : NodeOperation()
 	this->m_inputBoundingBoxReader = NULL;
 
 	this->m_extend_bounds = false;
+	this->m_useFFT = false;
+	this->m_fftResult = NULL;
 }
 
 void *BokehBlurOperation::initializeTileData(rcti * /*rect*/)
@@ -54,10 +58,52 @@ void *BokehBlurOperation::initializeTileData(rcti * /*rect*/)
 		updateSize();
 	}
 	void *buffer = getInputOperation(0)->initializeTileData(NULL);
+	if (this->m_useFFT) {
+		if (this->m_fftResult == NULL) {
+			this->m_fftResult = createFFTResult((MemoryBuffer *)buffer);
+		}
+		buffer = this->m_fftResult;
+	}
 	unlockMutex();
 	return buffer;
 }
 
+bool BokehBlurOperation::useFFT(unsigned int width, unsigned int height)
+{
+	/* execution groups are created before the size input can be read */
+	if (!this->m_sizeavailable) {
+		return false;
+	}
+	const float max_dim = max(width, height);
+	const int pixelSize = this->m_size * max_dim / 100.0f;
+	return FFTConvolution::isEfficient(2 * pixelSize, 2 * pixelSize);
+}
+
+MemoryBuffer *BokehBlurOperation::createFFTResult(MemoryBuffer *input)
+{
+	const float max_dim = max(this->getWidth(), this->getHeight());
+	const int pixelSize = this->m_size * max_dim / 100.0f;
+	const int kernelSize = 2 * pixelSize;
+	const float m = this->m_bokehDimension / pixelSize;
+
+	/* sample the bokeh for every offset executePixel uses */
+	float *kernel = (float *)MEM_mallocN(sizeof(float) * kernelSize * kernelSize * COM_NUM_CHANNELS_COLOR, __func__);
+	float *bokeh = kernel;
+	for (int dy = -pixelSize; dy < pixelSize; dy++) {
+		for (int dx = -pixelSize; dx < pixelSize; dx++, bokeh += COM_NUM_CHANNELS_COLOR) {
+			float u = this->m_bokehMidX - dx * m;
+			float v = this->m_bokehMidY - dy * m;
+			this->m_inputBokehProgram->readSampled(bokeh, u, v, COM_PS_NEAREST);
+		}
+	}
+
+	MemoryBuffer *result = new MemoryBuffer(COM_DT_COLOR, input->getRect());
+	FFTConvolution::convolve(result, input, COM_NUM_CHANNELS_COLOR, kernel, kernelSize, kernelSize,
+	                         COM_NUM_CHANNELS_COLOR, pixelSize, pixelSize, true);
+	MEM_freeN(kernel);
+	return result;
+}
+
 void BokehBlurOperation::initExecution()
 {
 	initMutex();
@@ -83,7 +129,10 @@ void BokehBlurOperation::executePixel(float output[4], int x, int y, void *data)
 	float bokeh[4];
 
 	this->m_inputBoundingBoxReader->readSampled(tempBoundingBox, x, y, COM_PS_NEAREST);
-	if (tempBoundingBox[0] > 0.0f) {
+	if (tempBoundingBox[0] > 0.0f && this->m_useFFT) {
+		((MemoryBuffer *)data)->readNoCheck(output, x, y);
+	}
+	else if (tempBoundingBox[0] > 0.0f) {
 		float multiplier_accum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
 		MemoryBuffer *inputBuffer = (MemoryBuffer *)data;
 		float *buffer = inputBuffer->getBuffer();
@@ -139,6 +188,10 @@ void BokehBlurOperation::executePixel(float output[4], int x, int y, void *data)
 void BokehBlurOperation::deinitExecution()
 {
 	deinitMutex();
+	if (this->m_fftResult) {
+		delete this->m_fftResult;
+		this->m_fftResult = NULL;
+	}
 	this->m_inputProgram = NULL;
 	this->m_inputBokehProgram = NULL;
 	this->m_inputBoundingBoxReader = NULL;
@@ -150,7 +203,14 @@ bool BokehBlurOperation::determineDependingAreaOfInterest(rcti *input, ReadBuffe
 	rcti bokehInput;
 	const float max_dim = max(this->getWidth(), this->getHeight());
 
-	if (this->m_sizeavailable) {
+	if (this->m_useFFT) {
+		/* the whole image is convolved at once */
+		newInput.xmin = 0;
+		newInput.ymin = 0;
+		newInput.xmax = this->getWidth();
+		newInput.ymax = this->getHeight();
+	}
+	else if (this->m_sizeavailable) {
 		newInput.xmax = input->xmax + (this->m_size * max_dim / 100.0f);
 		newInput.xmin = input->xmin - (this->m_size * max_dim / 100.0f);
 		newInput.ymax = input->ymax + (this->m_size * max_dim / 100.0f);
@@ -239,4 +299,6 @@ void BokehBlurOperation::determineResolution(unsigned int resolution[2],
 		resolution[0] += 2 * this->m_size * max_dim / 100.0f;
 		resolution[1] += 2 * this->m_size * max_dim / 100.0f;
 	}
+	/* decided once, so the chunks, the area of interest and executePixel agree */
+	this->m_useFFT = useFFT(resolution[0], resolution[1]);
 }
@@ -38,10 +38,24 @@ private:
 	float m_bokehMidY;
 	float m_bokehDimension;
 	bool m_extend_bounds;
+	/**
+	 * @brief the whole image is convolved at once with the FFT, see useFFT
+	 */
+	bool m_useFFT;
+	MemoryBuffer *m_fftResult;
+	/**
+	 * @brief large kernels of a known size are convolved with the FFT instead of for every pixel
+	 */
+	bool useFFT(unsigned int width, unsigned int height);
+	MemoryBuffer *createFFTResult(MemoryBuffer *input);
 public:
 	BokehBlurOperation();
 
 	void *initializeTileData(rcti *rect);
+	/**
+	 * the FFT calculates the whole result in a single chunk
+	 */
+	int isSingleThreaded() { return this->m_useFFT; }
 	/**
 	 * the inner loop of this program
 	 */
@@ -41,6 +41,7 @@ ColorBalanceASCCDLOperation::ColorBalanceASCCDLOperation() : NodeOperation()
 	this->m_inputValueOperation = NULL;
 	this->m_inputColorOperation = NULL;
 	this->setResolutionInputSocketIndex(1);
+	this->setFullFrame(true);
 }
 
 void ColorBalanceASCCDLOperation::initExecution()
@@ -49,6 +50,17 @@ void ColorBalanceASCCDLOperation::initExecution()
 	this->m_inputColorOperation = this->getInputSocketReader(1);
 }
 
+inline void ColorBalanceASCCDLOperation::balancePixel(float output[4], float fac, const float inputColor[4])
+{
+	fac = min(1.0f, fac);
+	const float mfac = 1.0f - fac;
+
+	output[0] = mfac * inputColor[0] + fac * colorbalance_cdl(inputColor[0], this->m_offset[0], this->m_power[0], this->m_slope[0]);
+	output[1] = mfac * inputColor[1] + fac * colorbalance_cdl(inputColor[1], this->m_offset[1], this->m_power[1], this->m_slope[1]);
+	output[2] = mfac * inputColor[2] + fac * colorbalance_cdl(inputColor[2], this->m_offset[2], this->m_power[2], this->m_slope[2]);
+	output[3] = inputColor[3];
+}
+
 void ColorBalanceASCCDLOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputColor[4];
@@ -57,15 +69,28 @@ void ColorBalanceASCCDLOperation::executePixelSampled(float output[4], float x,
 	this->m_inputValueOperation->readSampled(value, x, y, sampler);
 	this->m_inputColorOperation->readSampled(inputColor, x, y, sampler);
 	
-	float fac = value[0];
-	fac = min(1.0f, fac);
-	const float mfac = 1.0f - fac;
-	
-	output[0] = mfac * inputColor[0] + fac * colorbalance_cdl(inputColor[0], this->m_offset[0], this->m_power[0], this->m_slope[0]);
-	output[1] = mfac * inputColor[1] + fac * colorbalance_cdl(inputColor[1], this->m_offset[1], this->m_power[1], this->m_slope[1]);
-	output[2] = mfac * inputColor[2] + fac * colorbalance_cdl(inputColor[2], this->m_offset[2], this->m_power[2], this->m_slope[2]);
-	output[3] = inputColor[3];
+	balancePixel(output, value[0], inputColor);
+}
+
+void ColorBalanceASCCDLOperation::updateOutputBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+	MemoryBuffer *inputValue = inputs[0];
+	MemoryBuffer *inputColor = inputs[1];
+	const int valueStride = inputValue->getElemStride();
+	const int colorStride = inputColor->getElemStride();
+
+	for (int y = area->ymin; y < area->ymax; y++) {
+		float *out = output->getElem(area->xmin, y);
+		const float *in_value = inputValue->getElem(area->xmin, y);
+		const float *in_color = inputColor->getElem(area->xmin, y);
 
+		for (int x = area->xmin; x < area->xmax; x++) {
+			balancePixel(out, in_value[0], in_color);
+			out += COM_NUM_CHANNELS_COLOR;
+			in_value += valueStride;
+			in_color += colorStride;
+		}
+	}
 }
 
 void ColorBalanceASCCDLOperation::deinitExecution()
@@ -23,6 +23,7 @@
 #ifndef _COM_ColorBalanceASCCDLOperation_h
 #define _COM_ColorBalanceASCCDLOperation_h
 #include "COM_NodeOperation.h"
+#include "COM_MemoryBuffer.h"
 
 /**
  * this program converts an input color to an output value.
@@ -40,6 +41,11 @@ protected:
 	float m_power[3];
 	float m_slope[3];
 
+	/**
+	 * Apply the color balance to a single pixel
+	 */
+	inline void balancePixel(float output[4], float fac, const float inputColor[4]);
+
 public:
 	/**
 	 * Default constructor
@@ -50,6 +56,8 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+	void updateOutputBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 	
 	/**
 	 * Initialize the execution
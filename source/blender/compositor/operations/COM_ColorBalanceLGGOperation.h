@@ -23,6 +23,7 @@
 #ifndef _COM_ColorBalanceLGGOperation_h
 #define _COM_ColorBalanceLGGOperation_h
 #include "COM_NodeOperation.h"
+#include "COM_MemoryBuffer.h"
 
 
 /**
@@ -41,6 +42,11 @@ protected:
 	float m_lift[3];
 	float m_gamma_inv[3];
 
+	/**
+	 * Apply the color balance to a single pixel
+	 */
+	inline void balancePixel(float output[4], float fac, const float inputColor[4]);
+
 public:
 	/**
 	 * Default constructor
@@ -51,6 +57,8 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+	void updateOutputBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 	
 	/**
 	 * Initialize the execution
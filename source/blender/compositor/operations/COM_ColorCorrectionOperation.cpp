@@ -37,6 +37,7 @@ ColorCorrectionOperation::ColorCorrectionOperation() : NodeOperation()
 	this->m_redChannelEnabled = true;
 	this->m_greenChannelEnabled = true;
 	this->m_blueChannelEnabled = true;
+	this->setFullFrame(true);
 }
 void ColorCorrectionOperation::initExecution()
 {
@@ -50,7 +51,11 @@ void ColorCorrectionOperation::executePixelSampled(float output[4], float x, flo
 	float inputMask[4];
 	this->m_inputImage->readSampled(inputImageColor, x, y, sampler);
 	this->m_inputMask->readSampled(inputMask, x, y, sampler);
-	
+	correctPixel(output, inputImageColor, inputMask[0]);
+}
+
+inline void ColorCorrectionOperation::correctPixel(float output[4], const float inputImageColor[4], float value)
+{
 	float level = (inputImageColor[0] + inputImageColor[1] + inputImageColor[2]) / 3.0f;
 	float contrast = this->m_data->master.contrast;
 	float saturation = this->m_data->master.saturation;
@@ -59,7 +64,6 @@ void ColorCorrectionOperation::executePixelSampled(float output[4], float x, flo
 	float lift = this->m_data->master.lift;
 	float r, g, b;
 	
-	float value = inputMask[0];
 	value = min(1.0f, value);
 	const float mvalue = 1.0f - value;
 	
@@ -139,6 +143,27 @@ void ColorCorrectionOperation::executePixelSampled(float output[4], float x, flo
 	output[3] = inputImageColor[3];
 }
 
+void ColorCorrectionOperation::updateOutputBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+	MemoryBuffer *inputImage = inputs[0];
+	MemoryBuffer *inputMask = inputs[1];
+	const int imageStride = inputImage->getElemStride();
+	const int maskStride = inputMask->getElemStride();
+
+	for (int y = area->ymin; y < area->ymax; y++) {
+		float *out = output->getElem(area->xmin, y);
+		const float *in_image = inputImage->getElem(area->xmin, y);
+		const float *in_mask = inputMask->getElem(area->xmin, y);
+
+		for (int x = area->xmin; x < area->xmax; x++) {
+			correctPixel(out, in_image, in_mask[0]);
+			out += COM_NUM_CHANNELS_COLOR;
+			in_image += imageStride;
+			in_mask += maskStride;
+		}
+	}
+}
+
 void ColorCorrectionOperation::deinitExecution()
 {
 	this->m_inputImage = NULL;
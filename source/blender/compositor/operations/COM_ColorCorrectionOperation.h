@@ -23,6 +23,7 @@
 #ifndef _COM_ColorCorrectionOperation_h
 #define _COM_ColorCorrectionOperation_h
 #include "COM_NodeOperation.h"
+#include "COM_MemoryBuffer.h"
 
 
 class ColorCorrectionOperation : public NodeOperation {
@@ -38,6 +39,8 @@ private:
 	bool m_greenChannelEnabled;
 	bool m_blueChannelEnabled;
 
+	inline void correctPixel(float output[4], const float inputImageColor[4], float value);
+
 public:
 	ColorCorrectionOperation();
 	
@@ -45,6 +48,8 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+	void updateOutputBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 	
 	/**
 	 * Initialize the execution
@@ -101,6 +101,19 @@ void ConvertDepthToRadiusOperation::executePixelSampled(float output[4], float x
 	}
 }
 
+bool ConvertDepthToRadiusOperation::hashExternalSettings(ResultCacheHash &hash) const
+{
+	/* the camera is not part of the node settings */
+	if (this->m_cameraObject && this->m_cameraObject->type == OB_CAMERA) {
+		Camera *camera = (Camera *)this->m_cameraObject->data;
+		const float settings[3] = {camera->lens,
+		                           BKE_camera_sensor_size(camera->sensor_fit, camera->sensor_x, camera->sensor_y),
+		                           BKE_camera_object_dof_distance(this->m_cameraObject)};
+		hash.add(settings, sizeof(settings));
+	}
+	return true;
+}
+
 void ConvertDepthToRadiusOperation::deinitExecution()
 {
 	this->m_inputOperation = NULL;
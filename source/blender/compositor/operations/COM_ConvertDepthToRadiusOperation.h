@@ -65,6 +65,8 @@ public:
 	 * Deinitialize the execution
 	 */
 	void deinitExecution();
+
+	bool hashExternalSettings(ResultCacheHash &hash) const;
 	
 	void setfStop(float fStop) { this->m_fStop = fStop; }
 	void setMaxRadius(float maxRadius) { this->m_maxRadius = maxRadius; }
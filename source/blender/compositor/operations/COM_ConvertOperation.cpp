@@ -26,9 +26,14 @@ extern "C" {
 #include "IMB_colormanagement.h"
 }
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 ConvertBaseOperation::ConvertBaseOperation()
 {
 	this->m_inputOperation = NULL;
+	this->setFullFrame(true);
 }
 
 void ConvertBaseOperation::initExecution()
@@ -41,6 +46,34 @@ void ConvertBaseOperation::deinitExecution()
 	this->m_inputOperation = NULL;
 }
 
+void ConvertBaseOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+{
+	float input[4];
+	this->m_inputOperation->readSampled(input, x, y, sampler);
+	convertPixel(output, input);
+}
+
+void ConvertBaseOperation::updateOutputBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+	MemoryBuffer *input = inputs[0];
+	const int inputStride = input->getElemStride();
+	const int outputStride = output->getElemStride();
+
+	for (int y = area->ymin; y < area->ymax; y++) {
+		convertRow(output->getElem(area->xmin, y), input->getElem(area->xmin, y),
+		           inputStride, outputStride, BLI_rcti_size_x(area));
+	}
+}
+
+void ConvertBaseOperation::convertRow(float *output, const float *input, int inputStride, int outputStride, int width)
+{
+	for (int x = 0; x < width; x++) {
+		convertPixel(output, input);
+		output += outputStride;
+		input += inputStride;
+	}
+}
+
 
 /* ******** Value to Color ******** */
 
@@ -50,14 +83,28 @@ ConvertValueToColorOperation::ConvertValueToColorOperation() : ConvertBaseOperat
 	this->addOutputSocket(COM_DT_COLOR);
 }
 
-void ConvertValueToColorOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void ConvertValueToColorOperation::convertPixel(float output[4], const float input[4])
 {
-	float value;
-	this->m_inputOperation->readSampled(&value, x, y, sampler);
-	output[0] = output[1] = output[2] = value;
+	output[0] = output[1] = output[2] = input[0];
 	output[3] = 1.0f;
 }
 
+#ifdef __SSE2__
+void ConvertValueToColorOperation::convertRow(float *output, const float *input, int inputStride, int outputStride, int width)
+{
+	/* alpha is the only channel set from the last lane */
+	const __m128 alpha_mask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	for (int x = 0; x < width; x++) {
+		const __m128 value = _mm_set1_ps(input[0]);
+		_mm_storeu_ps(output, _mm_or_ps(_mm_andnot_ps(alpha_mask, value), _mm_and_ps(alpha_mask, one)));
+		output += outputStride;
+		input += inputStride;
+	}
+}
+#endif
+
 
 /* ******** Color to Value ******** */
 
@@ -67,10 +114,8 @@ ConvertColorToValueOperation::ConvertColorToValueOperation() : ConvertBaseOperat
 	this->addOutputSocket(COM_DT_VALUE);
 }
 
-void ConvertColorToValueOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void ConvertColorToValueOperation::convertPixel(float output[4], const float inputColor[4])
 {
-	float inputColor[4];
-	this->m_inputOperation->readSampled(inputColor, x, y, sampler);
 	output[0] = (inputColor[0] + inputColor[1] + inputColor[2]) / 3.0f;
 }
 
@@ -83,10 +128,8 @@ ConvertColorToBWOperation::ConvertColorToBWOperation() : ConvertBaseOperation()
 	this->addOutputSocket(COM_DT_VALUE);
 }
 
-void ConvertColorToBWOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void ConvertColorToBWOperation::convertPixel(float output[4], const float inputColor[4])
 {
-	float inputColor[4];
-	this->m_inputOperation->readSampled(inputColor, x, y, sampler);
 	output[0] = IMB_colormanagement_get_luminance(inputColor);
 }
 
@@ -99,11 +142,10 @@ ConvertColorToVectorOperation::ConvertColorToVectorOperation() : ConvertBaseOper
 	this->addOutputSocket(COM_DT_VECTOR);
 }
 
-void ConvertColorToVectorOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void ConvertColorToVectorOperation::convertPixel(float output[4], const float color[4])
 {
-	float color[4];
-	this->m_inputOperation->readSampled(color, x, y, sampler);
-	copy_v3_v3(output, color);}
+	copy_v3_v3(output, color);
+}
 
 
 /* ******** Value to Vector ******** */
@@ -114,11 +156,9 @@ ConvertValueToVectorOperation::ConvertValueToVectorOperation() : ConvertBaseOper
 	this->addOutputSocket(COM_DT_VECTOR);
 }
 
-void ConvertValueToVectorOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void ConvertValueToVectorOperation::convertPixel(float output[4], const float input[4])
 {
-	float value;
-	this->m_inputOperation->readSampled(&value, x, y, sampler);
-	output[0] = output[1] = output[2] = value;
+	output[0] = output[1] = output[2] = input[0];
 }
 
 
@@ -130,9 +170,9 @@ ConvertVectorToColorOperation::ConvertVectorToColorOperation() : ConvertBaseOper
 	this->addOutputSocket(COM_DT_COLOR);
 }
 
-void ConvertVectorToColorOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void ConvertVectorToColorOperation::convertPixel(float output[4], const float input[4])
 {
-	this->m_inputOperation->readSampled(output, x, y, sampler);
+	copy_v3_v3(output, input);
 	output[3] = 1.0f;
 }
 
@@ -145,10 +185,8 @@ ConvertVectorToValueOperation::ConvertVectorToValueOperation() : ConvertBaseOper
 	this->addOutputSocket(COM_DT_VALUE);
 }
 
-void ConvertVectorToValueOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void ConvertVectorToValueOperation::convertPixel(float output[4], const float input[4])
 {
-	float input[4];
-	this->m_inputOperation->readSampled(input, x, y, sampler);
 	output[0] = (input[0] + input[1] + input[2]) / 3.0f;
 }
 
@@ -177,12 +215,10 @@ void ConvertRGBToYCCOperation::setMode(int mode)
 	}
 }
 
-void ConvertRGBToYCCOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void ConvertRGBToYCCOperation::convertPixel(float output[4], const float inputColor[4])
 {
-	float inputColor[4];
 	float color[3];
 
-	this->m_inputOperation->readSampled(inputColor, x, y, sampler);
 	rgb_to_ycc(inputColor[0], inputColor[1], inputColor[2], &color[0], &color[1], &color[2], this->m_mode);
 
 	/* divided by 255 to normalize for viewing in */
@@ -215,16 +251,15 @@ void ConvertYCCToRGBOperation::setMode(int mode)
 	}
 }
 
-void ConvertYCCToRGBOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void ConvertYCCToRGBOperation::convertPixel(float output[4], const float inputColor[4])
 {
-	float inputColor[4];
-	this->m_inputOperation->readSampled(inputColor, x, y, sampler);
+	float color[3];
 
 	/* need to un-normalize the data */
 	/* R,G,B --> Y,Cb,Cr */
-	mul_v3_fl(inputColor, 255.0f);
+	mul_v3_v3fl(color, inputColor, 255.0f);
 
-	ycc_to_rgb(inputColor[0], inputColor[1], inputColor[2], &output[0], &output[1], &output[2], this->m_mode);
+	ycc_to_rgb(color[0], color[1], color[2], &output[0], &output[1], &output[2], this->m_mode);
 	output[3] = inputColor[3];
 }
 
@@ -237,10 +272,8 @@ ConvertRGBToYUVOperation::ConvertRGBToYUVOperation() : ConvertBaseOperation()
 	this->addOutputSocket(COM_DT_COLOR);
 }
 
-void ConvertRGBToYUVOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void ConvertRGBToYUVOperation::convertPixel(float output[4], const float inputColor[4])
 {
-	float inputColor[4];
-	this->m_inputOperation->readSampled(inputColor, x, y, sampler);
 	rgb_to_yuv(inputColor[0], inputColor[1], inputColor[2], &output[0], &output[1], &output[2]);
 	output[3] = inputColor[3];
 }
@@ -254,10 +287,8 @@ ConvertYUVToRGBOperation::ConvertYUVToRGBOperation() : ConvertBaseOperation()
 	this->addOutputSocket(COM_DT_COLOR);
 }
 
-void ConvertYUVToRGBOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void ConvertYUVToRGBOperation::convertPixel(float output[4], const float inputColor[4])
 {
-	float inputColor[4];
-	this->m_inputOperation->readSampled(inputColor, x, y, sampler);
 	yuv_to_rgb(inputColor[0], inputColor[1], inputColor[2], &output[0], &output[1], &output[2]);
 	output[3] = inputColor[3];
 }
@@ -271,10 +302,8 @@ ConvertRGBToHSVOperation::ConvertRGBToHSVOperation() : ConvertBaseOperation()
 	this->addOutputSocket(COM_DT_COLOR);
 }
 
-void ConvertRGBToHSVOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void ConvertRGBToHSVOperation::convertPixel(float output[4], const float inputColor[4])
 {
-	float inputColor[4];
-	this->m_inputOperation->readSampled(inputColor, x, y, sampler);
 	rgb_to_hsv_v(inputColor, output);
 	output[3] = inputColor[3];
 }
@@ -288,10 +317,8 @@ ConvertHSVToRGBOperation::ConvertHSVToRGBOperation() : ConvertBaseOperation()
 	this->addOutputSocket(COM_DT_COLOR);
 }
 
-void ConvertHSVToRGBOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void ConvertHSVToRGBOperation::convertPixel(float output[4], const float inputColor[4])
 {
-	float inputColor[4];
-	this->m_inputOperation->readSampled(inputColor, x, y, sampler);
 	hsv_to_rgb_v(inputColor, output);
 	output[0] = max_ff(output[0], 0.0f);
 	output[1] = max_ff(output[1], 0.0f);
@@ -308,12 +335,10 @@ ConvertPremulToStraightOperation::ConvertPremulToStraightOperation() : ConvertBa
 	this->addOutputSocket(COM_DT_COLOR);
 }
 
-void ConvertPremulToStraightOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void ConvertPremulToStraightOperation::convertPixel(float output[4], const float inputValue[4])
 {
-	float inputValue[4];
 	float alpha;
 
-	this->m_inputOperation->readSampled(inputValue, x, y, sampler);
 	alpha = inputValue[3];
 
 	if (fabsf(alpha) < 1e-5f) {
@@ -327,6 +352,27 @@ void ConvertPremulToStraightOperation::executePixelSampled(float output[4], floa
 	output[3] = alpha;
 }
 
+#ifdef __SSE2__
+void ConvertPremulToStraightOperation::convertRow(float *output, const float *input, int inputStride, int outputStride, int width)
+{
+	const __m128 alpha_mask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+	const __m128 sign_mask = _mm_set1_ps(-0.0f);
+	const __m128 epsilon = _mm_set1_ps(1e-5f);
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	for (int x = 0; x < width; x++) {
+		const __m128 color = _mm_loadu_ps(input);
+		const __m128 alpha = _mm_set1_ps(input[3]);
+		/* zero the color for (almost) transparent pixels, like the scalar code */
+		const __m128 valid = _mm_cmpge_ps(_mm_andnot_ps(sign_mask, alpha), epsilon);
+		const __m128 straight = _mm_and_ps(valid, _mm_mul_ps(color, _mm_div_ps(one, alpha)));
+		_mm_storeu_ps(output, _mm_or_ps(_mm_andnot_ps(alpha_mask, straight), _mm_and_ps(alpha_mask, color)));
+		output += outputStride;
+		input += inputStride;
+	}
+}
+#endif
+
 
 /* ******** Straight to Premul ******** */
 
@@ -336,12 +382,10 @@ ConvertStraightToPremulOperation::ConvertStraightToPremulOperation() : ConvertBa
 	this->addOutputSocket(COM_DT_COLOR);
 }
 
-void ConvertStraightToPremulOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void ConvertStraightToPremulOperation::convertPixel(float output[4], const float inputValue[4])
 {
-	float inputValue[4];
 	float alpha;
 
-	this->m_inputOperation->readSampled(inputValue, x, y, sampler);
 	alpha = inputValue[3];
 
 	mul_v3_v3fl(output, inputValue, alpha);
@@ -350,6 +394,21 @@ void ConvertStraightToPremulOperation::executePixelSampled(float output[4], floa
 	output[3] = alpha;
 }
 
+#ifdef __SSE2__
+void ConvertStraightToPremulOperation::convertRow(float *output, const float *input, int inputStride, int outputStride, int width)
+{
+	const __m128 alpha_mask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+
+	for (int x = 0; x < width; x++) {
+		const __m128 color = _mm_loadu_ps(input);
+		const __m128 premul = _mm_mul_ps(color, _mm_set1_ps(input[3]));
+		_mm_storeu_ps(output, _mm_or_ps(_mm_andnot_ps(alpha_mask, premul), _mm_and_ps(alpha_mask, color)));
+		output += outputStride;
+		input += inputStride;
+	}
+}
+#endif
+
 
 /* ******** Separate Channels ******** */
 
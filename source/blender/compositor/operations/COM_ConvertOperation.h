@@ -24,6 +24,7 @@
 #define _COM_ConvertOperation_h
 
 #include "COM_NodeOperation.h"
+#include "COM_MemoryBuffer.h"
 
 
 class ConvertBaseOperation : public NodeOperation {
@@ -33,6 +34,19 @@ protected:
 public:
 	ConvertBaseOperation();
 	
+	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void updateOutputBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
+
+	/**
+	 * Convert a single pixel, only the channels of the input and output data types are used
+	 */
+	virtual void convertPixel(float output[4], const float input[4]) = 0;
+
+	/**
+	 * Convert a row of pixels, the input and output advance by their stride for every pixel
+	 */
+	virtual void convertRow(float *output, const float *input, int inputStride, int outputStride, int width);
+
 	void initExecution();
 	void deinitExecution();
 };
@@ -42,7 +56,10 @@ class ConvertValueToColorOperation : public ConvertBaseOperation {
 public:
 	ConvertValueToColorOperation();
 	
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void convertPixel(float output[4], const float input[4]);
+#ifdef __SSE2__
+	void convertRow(float *output, const float *input, int inputStride, int outputStride, int width);
+#endif
 };
 
 
@@ -50,7 +67,7 @@ class ConvertColorToValueOperation : public ConvertBaseOperation {
 public:
 	ConvertColorToValueOperation();
 	
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void convertPixel(float output[4], const float input[4]);
 };
 
 
@@ -58,7 +75,7 @@ class ConvertColorToBWOperation : public ConvertBaseOperation {
 public:
 	ConvertColorToBWOperation();
 	
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void convertPixel(float output[4], const float input[4]);
 };
 
 
@@ -66,7 +83,7 @@ class ConvertColorToVectorOperation : public ConvertBaseOperation {
 public:
 	ConvertColorToVectorOperation();
 	
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void convertPixel(float output[4], const float input[4]);
 };
 
 
@@ -74,7 +91,7 @@ class ConvertValueToVectorOperation : public ConvertBaseOperation {
 public:
 	ConvertValueToVectorOperation();
 	
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void convertPixel(float output[4], const float input[4]);
 };
 
 
@@ -82,7 +99,7 @@ class ConvertVectorToColorOperation : public ConvertBaseOperation {
 public:
 	ConvertVectorToColorOperation();
 	
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void convertPixel(float output[4], const float input[4]);
 };
 
 
@@ -90,7 +107,7 @@ class ConvertVectorToValueOperation : public ConvertBaseOperation {
 public:
 	ConvertVectorToValueOperation();
 	
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void convertPixel(float output[4], const float input[4]);
 };
 
 
@@ -101,7 +118,7 @@ private:
 public:
 	ConvertRGBToYCCOperation();
 
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void convertPixel(float output[4], const float input[4]);
 
 	/** Set the YCC mode */
 	void setMode(int mode);
@@ -115,7 +132,7 @@ private:
 public:
 	ConvertYCCToRGBOperation();
 	
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void convertPixel(float output[4], const float input[4]);
 	
 	/** Set the YCC mode */
 	void setMode(int mode);
@@ -126,7 +143,7 @@ class ConvertRGBToYUVOperation : public ConvertBaseOperation {
 public:
 	ConvertRGBToYUVOperation();
 	
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void convertPixel(float output[4], const float input[4]);
 };
 
 
@@ -134,7 +151,7 @@ class ConvertYUVToRGBOperation : public ConvertBaseOperation {
 public:
 	ConvertYUVToRGBOperation();
 	
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void convertPixel(float output[4], const float input[4]);
 };
 
 
@@ -142,7 +159,7 @@ class ConvertRGBToHSVOperation : public ConvertBaseOperation {
 public:
 	ConvertRGBToHSVOperation();
 	
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void convertPixel(float output[4], const float input[4]);
 };
 
 
@@ -150,7 +167,7 @@ class ConvertHSVToRGBOperation : public ConvertBaseOperation {
 public:
 	ConvertHSVToRGBOperation();
 	
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void convertPixel(float output[4], const float input[4]);
 };
 
 
@@ -158,7 +175,10 @@ class ConvertPremulToStraightOperation : public ConvertBaseOperation {
 public:
 	ConvertPremulToStraightOperation();
 
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void convertPixel(float output[4], const float input[4]);
+#ifdef __SSE2__
+	void convertRow(float *output, const float *input, int inputStride, int outputStride, int width);
+#endif
 };
 
 
@@ -166,7 +186,10 @@ class ConvertStraightToPremulOperation : public ConvertBaseOperation {
 public:
 	ConvertStraightToPremulOperation();
 
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void convertPixel(float output[4], const float input[4]);
+#ifdef __SSE2__
+	void convertRow(float *output, const float *input, int inputStride, int outputStride, int width);
+#endif
 };
 
 
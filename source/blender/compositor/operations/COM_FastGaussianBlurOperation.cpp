@@ -23,8 +23,12 @@
 #include <limits.h>
 
 #include "COM_FastGaussianBlurOperation.h"
+#include "COM_WorkScheduler.h"
 #include "MEM_guardedalloc.h"
 #include "BLI_utildefines.h"
+extern "C" {
+#include "BLI_task.h"
+}
 
 FastGaussianBlurOperation::FastGaussianBlurOperation() : BlurBaseOperation(COM_DT_COLOR)
 {
@@ -111,28 +115,30 @@ void *FastGaussianBlurOperation::initializeTileData(rcti *rect)
 	return this->m_iirgaus;
 }
 
-void FastGaussianBlurOperation::IIR_gauss(MemoryBuffer *src, float sigma, unsigned int chan, unsigned int xy)
+typedef struct IIRGaussData {
+	float *buffer;
+	unsigned int width, height, num_channels;
+	/* channels chan_start up to chan_end are filtered */
+	unsigned int chan_start, chan_end;
+	bool horizontal;
+	/* lines are padded with zeros and multiplied by the inverse of the filtered mask,
+	 * NULL when the border is extended, see IIR_gauss_normalized */
+	double *mask_inv;
+	unsigned int pad;
+	/* length of the padded lines */
+	unsigned int line_size;
+	double cf[4], tsM[9];
+} IIRGaussData;
+
+/* returns false when sigma is too small to filter */
+static bool iir_gauss_coefficients(IIRGaussData *data, float sigma)
 {
-	double q, q2, sc, cf[4], tsM[9], tsu[3], tsv[3];
-	double *X, *Y, *W;
-	const unsigned int src_width = src->getWidth();
-	const unsigned int src_height = src->getHeight();
-	unsigned int x, y, sz;
-	unsigned int i;
-	float *buffer = src->getBuffer();
-	const unsigned int num_channels = src->get_num_channels();
-	
+	double q, q2, sc;
+	double *cf = data->cf, *tsM = data->tsM;
+
 	// <0.5 not valid, though can have a possibly useful sort of sharpening effect
-	if (sigma < 0.5f) return;
-	
-	if ((xy < 1) || (xy > 3)) xy = 3;
-	
-	// XXX The YVV macro defined below explicitly expects sources of at least 3x3 pixels,
-	//     so just skiping blur along faulty direction if src's def is below that limit!
-	if (src_width < 3) xy &= ~1;
-	if (src_height < 3) xy &= ~2;
-	if (xy < 1) return;
-	
+	if (sigma < 0.5f) return false;
+
 	// see "Recursive Gabor Filtering" by Young/VanVliet
 	// all factors here in double.prec. Required, because for single.prec it seems to blow up if sigma > ~200
 	if (sigma >= 3.556f)
@@ -148,7 +154,7 @@ void FastGaussianBlurOperation::IIR_gauss(MemoryBuffer *src, float sigma, unsign
 	// 0 & 3 unchanged
 	cf[3] = q2 * q / sc;
 	cf[0] = 1.0 - cf[1] - cf[2] - cf[3];
-	
+
 	// Triggs/Sdika border corrections,
 	// it seems to work, not entirely sure if it is actually totally correct,
 	// Besides J.M.Geusebroek's anigauss.c (see http://www.science.uva.nl/~mark),
@@ -166,78 +172,161 @@ void FastGaussianBlurOperation::IIR_gauss(MemoryBuffer *src, float sigma, unsign
 	tsM[6] = sc * (cf[3] * cf[1] + cf[2] + cf[1] * cf[1] - cf[2] * cf[2]);
 	tsM[7] = sc * (cf[1] * cf[2] + cf[3] * cf[2] * cf[2] - cf[1] * cf[3] * cf[3] - cf[3] * cf[3] * cf[3] - cf[3] * cf[2] + cf[3]);
 	tsM[8] = sc * (cf[3] * (cf[1] + cf[3] * cf[2]));
-	
-#define YVV(L)                                                                          \
-{                                                                                       \
-	W[0] = cf[0] * X[0] + cf[1] * X[0] + cf[2] * X[0] + cf[3] * X[0];                   \
-	W[1] = cf[0] * X[1] + cf[1] * W[0] + cf[2] * X[0] + cf[3] * X[0];                   \
-	W[2] = cf[0] * X[2] + cf[1] * W[1] + cf[2] * W[0] + cf[3] * X[0];                   \
-	for (i = 3; i < L; i++) {                                                           \
-		W[i] = cf[0] * X[i] + cf[1] * W[i - 1] + cf[2] * W[i - 2] + cf[3] * W[i - 3];   \
-	}                                                                                   \
-	tsu[0] = W[L - 1] - X[L - 1];                                                       \
-	tsu[1] = W[L - 2] - X[L - 1];                                                       \
-	tsu[2] = W[L - 3] - X[L - 1];                                                       \
-	tsv[0] = tsM[0] * tsu[0] + tsM[1] * tsu[1] + tsM[2] * tsu[2] + X[L - 1];            \
-	tsv[1] = tsM[3] * tsu[0] + tsM[4] * tsu[1] + tsM[5] * tsu[2] + X[L - 1];            \
-	tsv[2] = tsM[6] * tsu[0] + tsM[7] * tsu[1] + tsM[8] * tsu[2] + X[L - 1];            \
-	Y[L - 1] = cf[0] * W[L - 1] + cf[1] * tsv[0] + cf[2] * tsv[1] + cf[3] * tsv[2];     \
-	Y[L - 2] = cf[0] * W[L - 2] + cf[1] * Y[L - 1] + cf[2] * tsv[0] + cf[3] * tsv[1];   \
-	Y[L - 3] = cf[0] * W[L - 3] + cf[1] * Y[L - 2] + cf[2] * Y[L - 1] + cf[3] * tsv[0]; \
-	/* 'i != UINT_MAX' is really 'i >= 0', but necessary for unsigned int wrapping */   \
-	for (i = L - 4; i != UINT_MAX; i--) {                                               \
-		Y[i] = cf[0] * W[i] + cf[1] * Y[i + 1] + cf[2] * Y[i + 2] + cf[3] * Y[i + 3];   \
-	}                                                                                   \
-} (void)0
-	
-	// intermediate buffers
-	sz = max(src_width, src_height);
-	X = (double *)MEM_callocN(sz * sizeof(double), "IIR_gauss X buf");
-	Y = (double *)MEM_callocN(sz * sizeof(double), "IIR_gauss Y buf");
-	W = (double *)MEM_callocN(sz * sizeof(double), "IIR_gauss W buf");
-	if (xy & 1) {   // H
-		int offset;
-		for (y = 0; y < src_height; ++y) {
-			const int yx = y * src_width;
-			offset = yx * num_channels + chan;
-			for (x = 0; x < src_width; ++x) {
-				X[x] = buffer[offset];
-				offset += num_channels;
+	return true;
+}
+
+/* filter X into Y, W is an intermediate buffer, all of length L (at least 3),
+ * the line is continued with its first and last value */
+static void iir_gauss_line(const IIRGaussData *data, const double *X, double *Y, double *W, unsigned int L)
+{
+	const double *cf = data->cf, *tsM = data->tsM;
+	double tsu[3], tsv[3];
+	unsigned int i;
+
+	W[0] = cf[0] * X[0] + cf[1] * X[0] + cf[2] * X[0] + cf[3] * X[0];
+	W[1] = cf[0] * X[1] + cf[1] * W[0] + cf[2] * X[0] + cf[3] * X[0];
+	W[2] = cf[0] * X[2] + cf[1] * W[1] + cf[2] * W[0] + cf[3] * X[0];
+	for (i = 3; i < L; i++) {
+		W[i] = cf[0] * X[i] + cf[1] * W[i - 1] + cf[2] * W[i - 2] + cf[3] * W[i - 3];
+	}
+	tsu[0] = W[L - 1] - X[L - 1];
+	tsu[1] = W[L - 2] - X[L - 1];
+	tsu[2] = W[L - 3] - X[L - 1];
+	tsv[0] = tsM[0] * tsu[0] + tsM[1] * tsu[1] + tsM[2] * tsu[2] + X[L - 1];
+	tsv[1] = tsM[3] * tsu[0] + tsM[4] * tsu[1] + tsM[5] * tsu[2] + X[L - 1];
+	tsv[2] = tsM[6] * tsu[0] + tsM[7] * tsu[1] + tsM[8] * tsu[2] + X[L - 1];
+	Y[L - 1] = cf[0] * W[L - 1] + cf[1] * tsv[0] + cf[2] * tsv[1] + cf[3] * tsv[2];
+	Y[L - 2] = cf[0] * W[L - 2] + cf[1] * Y[L - 1] + cf[2] * tsv[0] + cf[3] * tsv[1];
+	Y[L - 3] = cf[0] * W[L - 3] + cf[1] * Y[L - 2] + cf[2] * Y[L - 1] + cf[3] * tsv[0];
+	/* 'i != UINT_MAX' is really 'i >= 0', but necessary for unsigned int wrapping */
+	for (i = L - 4; i != UINT_MAX; i--) {
+		Y[i] = cf[0] * W[i] + cf[1] * Y[i + 1] + cf[2] * Y[i + 2] + cf[3] * Y[i + 3];
+	}
+}
+
+static void iir_gauss_lines_cb(void *__restrict userdata, const int line, const ParallelRangeTLS *__restrict tls)
+{
+	const IIRGaussData *data = (const IIRGaussData *)userdata;
+	const unsigned int pad = data->pad;
+	const unsigned int L = data->line_size;
+	const unsigned int len = L - 2 * pad;
+	const size_t stride = data->horizontal ? data->num_channels : (size_t)data->width * data->num_channels;
+	float *buffer = data->buffer + (data->horizontal ? (size_t)line * data->width * data->num_channels :
+	                                                   (size_t)line * data->num_channels);
+	// intermediate buffers of this thread
+	double *X = (double *)tls->userdata_chunk;
+	double *Y = X + L;
+	double *W = Y + L;
+	unsigned int i, chan;
+
+	for (chan = data->chan_start; chan < data->chan_end; chan++) {
+		float *fp = buffer + chan;
+		for (i = 0; i < len; i++) {
+			X[pad + i] = fp[i * stride];
+		}
+		iir_gauss_line(data, X, Y, W, L);
+		if (data->mask_inv) {
+			for (i = 0; i < len; i++) {
+				fp[i * stride] = Y[pad + i] * data->mask_inv[i];
 			}
-			YVV(src_width);
-			offset = yx * num_channels + chan;
-			for (x = 0; x < src_width; ++x) {
-				buffer[offset] = Y[x];
-				offset += num_channels;
+		}
+		else {
+			for (i = 0; i < len; i++) {
+				fp[i * stride] = Y[i];
 			}
 		}
 	}
-	if (xy & 2) {   // V
-		int offset;
-		const int add = src_width * num_channels;
-
-		for (x = 0; x < src_width; ++x) {
-			offset = x * num_channels + chan;
-			for (y = 0; y < src_height; ++y) {
-				X[y] = buffer[offset];
-				offset += add;
-			}
-			YVV(src_height);
-			offset = x * num_channels + chan;
-			for (y = 0; y < src_height; ++y) {
-				buffer[offset] = Y[y];
-				offset += add;
-			}
+}
+
+/* filter all rows or all columns in parallel */
+static void iir_gauss_lines(IIRGaussData *data, bool horizontal, bool normalize)
+{
+	const unsigned int len = horizontal ? data->width : data->height;
+	ParallelRangeSettings settings;
+	unsigned int i;
+
+	data->horizontal = horizontal;
+	data->pad = normalize ? 1 : 0;
+	data->line_size = len + 2 * data->pad;
+	data->mask_inv = NULL;
+
+	double *lines = (double *)MEM_callocN(3 * data->line_size * sizeof(double), "IIR_gauss lines");
+
+	if (normalize) {
+		// a single zero on both ends makes the line continue with zeros,
+		// the filtered mask is the sum of the weights of the pixels inside the line
+		double *X = lines, *Y = X + data->line_size, *W = Y + data->line_size;
+		for (i = 0; i < len; i++) {
+			X[i + 1] = 1.0;
 		}
+		iir_gauss_line(data, X, Y, W, data->line_size);
+		data->mask_inv = (double *)MEM_mallocN(len * sizeof(double), "IIR_gauss mask");
+		for (i = 0; i < len; i++) {
+			data->mask_inv[i] = 1.0 / Y[i + 1];
+		}
+		memset(lines, 0, 3 * data->line_size * sizeof(double));
 	}
-	
-	MEM_freeN(X);
-	MEM_freeN(W);
-	MEM_freeN(Y);
-#undef YVV
-	
+
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.scheduler = WorkScheduler::get_task_scheduler();
+	settings.userdata_chunk = lines;
+	settings.userdata_chunk_size = 3 * data->line_size * sizeof(double);
+	BLI_task_parallel_range(0, horizontal ? data->height : data->width, data, iir_gauss_lines_cb, &settings);
+
+	if (data->mask_inv) {
+		MEM_freeN(data->mask_inv);
+	}
+	MEM_freeN(lines);
 }
 
+void FastGaussianBlurOperation::IIR_gauss(MemoryBuffer *src, float sigma, unsigned int chan, unsigned int xy)
+{
+	IIRGaussData data;
+
+	data.buffer = src->getBuffer();
+	data.width = src->getWidth();
+	data.height = src->getHeight();
+	data.num_channels = src->get_num_channels();
+	data.chan_start = chan;
+	data.chan_end = chan + 1;
+
+	if (!iir_gauss_coefficients(&data, sigma)) return;
+
+	if ((xy < 1) || (xy > 3)) xy = 3;
+
+	// XXX The line filter explicitly expects sources of at least 3x3 pixels,
+	//     so just skiping blur along faulty direction if src's def is below that limit!
+	if (data.width < 3) xy &= ~1;
+	if (data.height < 3) xy &= ~2;
+
+	if (xy & 1) {   // H
+		iir_gauss_lines(&data, true, false);
+	}
+	if (xy & 2) {   // V
+		iir_gauss_lines(&data, false, false);
+	}
+}
+
+void FastGaussianBlurOperation::IIR_gauss_normalized(MemoryBuffer *src, float sigma, unsigned int xy)
+{
+	IIRGaussData data;
+
+	data.buffer = src->getBuffer();
+	data.width = src->getWidth();
+	data.height = src->getHeight();
+	data.num_channels = src->get_num_channels();
+	data.chan_start = 0;
+	data.chan_end = data.num_channels;
+
+	if (!iir_gauss_coefficients(&data, sigma)) return;
+
+	if (xy & 1) {   // H
+		iir_gauss_lines(&data, true, true);
+	}
+	if (xy & 2) {   // V
+		iir_gauss_lines(&data, false, true);
+	}
+}
 
 ///
 FastGaussianBlurValueOperation::FastGaussianBlurValueOperation() : NodeOperation()
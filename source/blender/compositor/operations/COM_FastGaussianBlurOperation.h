@@ -36,8 +36,21 @@ public:
 	bool determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output);
 	void executePixel(float output[4], int x, int y, void *data);
 	
+	/**
+	 * @brief recursive gaussian filter of one channel, rows and columns are filtered in parallel
+	 * @param xy 1 for the rows, 2 for the columns, 3 for both
+	 */
 	static void IIR_gauss(MemoryBuffer *src, float sigma, unsigned int channel, unsigned int xy);
+	/**
+	 * @brief recursive gaussian filter of all channels, which only uses pixels inside the buffer,
+	 * like the kernel of GaussianXBlurOperation and GaussianYBlurOperation
+	 */
+	static void IIR_gauss_normalized(MemoryBuffer *src, float sigma, unsigned int xy);
 	void *initializeTileData(rcti *rect);
+	/**
+	 * the recursive filter calculates the whole result in a single chunk
+	 */
+	int isSingleThreaded() { return true; }
 	void deinitExecution();
 	void initExecution();
 };
@@ -65,6 +78,10 @@ public:
 	void executePixel(float output[4], int x, int y, void *data);
 	
 	void *initializeTileData(rcti *rect);
+	/**
+	 * the recursive filter calculates the whole result in a single chunk
+	 */
+	int isSingleThreaded() { return true; }
 	void deinitExecution();
 	void initExecution();
 	void setSigma(float sigma) { this->m_sigma = sigma; }
@@ -30,6 +30,7 @@ GammaOperation::GammaOperation() : NodeOperation()
 	this->addOutputSocket(COM_DT_COLOR);
 	this->m_inputProgram = NULL;
 	this->m_inputGammaProgram = NULL;
+	this->setFullFrame(true);
 }
 void GammaOperation::initExecution()
 {
@@ -44,7 +45,11 @@ void GammaOperation::executePixelSampled(float output[4], float x, float y, Pixe
 	
 	this->m_inputProgram->readSampled(inputValue, x, y, sampler);
 	this->m_inputGammaProgram->readSampled(inputGamma, x, y, sampler);
-	const float gamma = inputGamma[0];
+	gammaPixel(output, inputValue, inputGamma[0]);
+}
+
+inline void GammaOperation::gammaPixel(float output[4], const float inputValue[4], const float gamma)
+{
 	/* check for negative to avoid nan's */
 	output[0] = inputValue[0] > 0.0f ? powf(inputValue[0], gamma) : inputValue[0];
 	output[1] = inputValue[1] > 0.0f ? powf(inputValue[1], gamma) : inputValue[1];
@@ -53,6 +58,27 @@ void GammaOperation::executePixelSampled(float output[4], float x, float y, Pixe
 	output[3] = inputValue[3];
 }
 
+void GammaOperation::updateOutputBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+	MemoryBuffer *inputValue = inputs[0];
+	MemoryBuffer *inputGamma = inputs[1];
+	const int valueStride = inputValue->getElemStride();
+	const int gammaStride = inputGamma->getElemStride();
+
+	for (int y = area->ymin; y < area->ymax; y++) {
+		float *out = output->getElem(area->xmin, y);
+		const float *in_value = inputValue->getElem(area->xmin, y);
+		const float *in_gamma = inputGamma->getElem(area->xmin, y);
+
+		for (int x = area->xmin; x < area->xmax; x++) {
+			gammaPixel(out, in_value, in_gamma[0]);
+			out += COM_NUM_CHANNELS_COLOR;
+			in_value += valueStride;
+			in_gamma += gammaStride;
+		}
+	}
+}
+
 void GammaOperation::deinitExecution()
 {
 	this->m_inputProgram = NULL;
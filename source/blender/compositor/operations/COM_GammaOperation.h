@@ -23,6 +23,7 @@
 #ifndef _COM_GammaOperation_h
 #define _COM_GammaOperation_h
 #include "COM_NodeOperation.h"
+#include "COM_MemoryBuffer.h"
 
 
 class GammaOperation : public NodeOperation {
@@ -33,6 +34,8 @@ private:
 	SocketReader *m_inputProgram;
 	SocketReader *m_inputGammaProgram;
 
+	inline void gammaPixel(float output[4], const float inputValue[4], const float gamma);
+
 public:
 	GammaOperation();
 	
@@ -40,6 +43,8 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+	void updateOutputBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 	
 	/**
 	 * Initialize the execution
@@ -21,6 +21,7 @@
  */
 
 #include "COM_GaussianBokehBlurOperation.h"
+#include "COM_FFTConvolution.h"
 #include "BLI_math.h"
 #include "MEM_guardedalloc.h"
 extern "C" {
@@ -30,6 +31,8 @@ extern "C" {
 GaussianBokehBlurOperation::GaussianBokehBlurOperation() : BlurBaseOperation(COM_DT_COLOR)
 {
 	this->m_gausstab = NULL;
+	this->m_useFFT = false;
+	this->m_fftResult = NULL;
 }
 
 void *GaussianBokehBlurOperation::initializeTileData(rcti * /*rect*/)
@@ -39,6 +42,16 @@ void *GaussianBokehBlurOperation::initializeTileData(rcti * /*rect*/)
 		updateGauss();
 	}
 	void *buffer = getInputOperation(0)->initializeTileData(NULL);
+	if (this->m_useFFT) {
+		if (this->m_fftResult == NULL) {
+			MemoryBuffer *input = (MemoryBuffer *)buffer;
+			this->m_fftResult = new MemoryBuffer(COM_DT_COLOR, input->getRect());
+			FFTConvolution::convolve(this->m_fftResult, input, COM_NUM_CHANNELS_COLOR, this->m_gausstab,
+			                         2 * this->m_radx + 1, 2 * this->m_rady + 1, 1,
+			                         this->m_radx, this->m_rady, true);
+		}
+		buffer = this->m_fftResult;
+	}
 	unlockMutex();
 	return buffer;
 }
@@ -54,6 +67,35 @@ void GaussianBokehBlurOperation::initExecution()
 	}
 }
 
+void GaussianBokehBlurOperation::determineResolution(unsigned int resolution[2],
+                                                     unsigned int preferredResolution[2])
+{
+	BlurBaseOperation::determineResolution(resolution, preferredResolution);
+	/* decided once, so the chunks, the area of interest and executePixel agree */
+	this->m_useFFT = useFFT(resolution[0], resolution[1]);
+}
+
+void GaussianBokehBlurOperation::calculateRadius(float width, float height, float *r_radxf, float *r_radyf)
+{
+	*r_radxf = this->m_size * (float)this->m_data.sizex;
+	CLAMP(*r_radxf, 0.0f, width / 2.0f);
+
+	/* vertical */
+	*r_radyf = this->m_size * (float)this->m_data.sizey;
+	CLAMP(*r_radyf, 0.0f, height / 2.0f);
+}
+
+bool GaussianBokehBlurOperation::useFFT(unsigned int width, unsigned int height)
+{
+	/* execution groups are created before the size input can be read */
+	if (!this->m_sizeavailable) {
+		return false;
+	}
+	float radxf, radyf;
+	calculateRadius(width, height, &radxf, &radyf);
+	return FFTConvolution::isEfficient(2 * (int)ceil(radxf) + 1, 2 * (int)ceil(radyf) + 1);
+}
+
 void GaussianBokehBlurOperation::updateGauss()
 {
 	if (this->m_gausstab == NULL) {
@@ -63,17 +105,10 @@ void GaussianBokehBlurOperation::updateGauss()
 		float *dgauss;
 		float *ddgauss;
 		int j, i;
-		const float width = this->getWidth();
-		const float height = this->getHeight();
 		if (!this->m_sizeavailable) {
 			updateSize();
 		}
-		radxf = this->m_size * (float)this->m_data.sizex;
-		CLAMP(radxf, 0.0f, width / 2.0f);
-	
-		/* vertical */
-		radyf = this->m_size * (float)this->m_data.sizey;
-		CLAMP(radyf, 0.0f, height / 2.0f);
+		calculateRadius(this->getWidth(), this->getHeight(), &radxf, &radyf);
 	
 		this->m_radx = ceil(radxf);
 		this->m_rady = ceil(radyf);
@@ -116,6 +151,11 @@ void GaussianBokehBlurOperation::updateGauss()
 
 void GaussianBokehBlurOperation::executePixel(float output[4], int x, int y, void *data)
 {
+	if (this->m_useFFT) {
+		((MemoryBuffer *)data)->readNoCheck(output, x, y);
+		return;
+	}
+
 	float tempColor[4];
 	tempColor[0] = 0;
 	tempColor[1] = 0;
@@ -162,6 +202,10 @@ void GaussianBokehBlurOperation::deinitExecution()
 		MEM_freeN(this->m_gausstab);
 		this->m_gausstab = NULL;
 	}
+	if (this->m_fftResult) {
+		delete this->m_fftResult;
+		this->m_fftResult = NULL;
+	}
 
 	deinitMutex();
 }
@@ -180,7 +224,7 @@ bool GaussianBokehBlurOperation::determineDependingAreaOfInterest(rcti *input, R
 		return true;
 	}
 	else {
-		if (this->m_sizeavailable && this->m_gausstab != NULL) {
+		if ((this->m_sizeavailable && this->m_gausstab != NULL) || this->m_useFFT) {
 			newInput.xmin = 0;
 			newInput.ymin = 0;
 			newInput.xmax = this->getWidth();
@@ -30,12 +30,26 @@ class GaussianBokehBlurOperation : public BlurBaseOperation {
 private:
 	float *m_gausstab;
 	int m_radx, m_rady;
+	/**
+	 * @brief the whole image is convolved at once with the FFT, see useFFT
+	 */
+	bool m_useFFT;
+	MemoryBuffer *m_fftResult;
+	void calculateRadius(float width, float height, float *r_radxf, float *r_radyf);
 	void updateGauss();
+	/**
+	 * @brief large kernels of a known size are convolved with the FFT instead of for every pixel
+	 */
+	bool useFFT(unsigned int width, unsigned int height);
 
 public:
 	GaussianBokehBlurOperation();
 	void initExecution();
 	void *initializeTileData(rcti *rect);
+	/**
+	 * the FFT calculates the whole result in a single chunk
+	 */
+	int isSingleThreaded() { return this->m_useFFT; }
 	/**
 	 * the inner loop of this program
 	 */
@@ -47,6 +61,8 @@ public:
 	void deinitExecution();
 	
 	bool determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output);
+	void determineResolution(unsigned int resolution[2],
+	                         unsigned int preferredResolution[2]);
 };
 
 class GaussianBlurReferenceOperation : public BlurBaseOperation {
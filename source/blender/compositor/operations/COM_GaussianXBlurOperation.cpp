@@ -21,6 +21,7 @@
  */
 
 #include "COM_GaussianXBlurOperation.h"
+#include "COM_FastGaussianBlurOperation.h"
 #include "COM_OpenCLDevice.h"
 #include "BLI_math.h"
 #include "MEM_guardedalloc.h"
@@ -36,6 +37,9 @@ GaussianXBlurOperation::GaussianXBlurOperation() : BlurBaseOperation(COM_DT_COLO
 	this->m_gausstab_sse = NULL;
 #endif
 	this->m_filtersize = 0;
+	this->m_useIIR = false;
+	this->m_iirResult = NULL;
+	this->setFullFrame(true);
 }
 
 void *GaussianXBlurOperation::initializeTileData(rcti * /*rect*/)
@@ -45,6 +49,12 @@ void *GaussianXBlurOperation::initializeTileData(rcti * /*rect*/)
 		updateGauss();
 	}
 	void *buffer = getInputOperation(0)->initializeTileData(NULL);
+	if (this->m_useIIR) {
+		if (this->m_iirResult == NULL) {
+			this->m_iirResult = createIIRResult((MemoryBuffer *)buffer);
+		}
+		buffer = this->m_iirResult;
+	}
 	unlockMutex();
 	return buffer;
 }
@@ -68,6 +78,14 @@ void GaussianXBlurOperation::initExecution()
 	}
 }
 
+void GaussianXBlurOperation::determineResolution(unsigned int resolution[2],
+                                                 unsigned int preferredResolution[2])
+{
+	BlurBaseOperation::determineResolution(resolution, preferredResolution);
+	/* decided once, so the chunks, the area of interest and executePixel agree */
+	this->m_useIIR = useIIR();
+}
+
 void GaussianXBlurOperation::updateGauss()
 {
 	if (this->m_gausstab == NULL) {
@@ -83,8 +101,31 @@ void GaussianXBlurOperation::updateGauss()
 	}
 }
 
+bool GaussianXBlurOperation::useIIR()
+{
+	/* execution groups are created before the size input can be read,
+	 * only the gaussian filter has a recursive counterpart */
+	if (!this->m_sizeavailable || this->m_data.filtertype != R_FILTER_GAUSS) {
+		return false;
+	}
+	return m_size * m_data.sizex >= IIR_GAUSS_MIN_RADIUS;
+}
+
+MemoryBuffer *GaussianXBlurOperation::createIIRResult(MemoryBuffer *input)
+{
+	MemoryBuffer *result = input->duplicate();
+	/* the kernel ends at three times sigma, see RE_filter_value */
+	FastGaussianBlurOperation::IIR_gauss_normalized(result, m_size * m_data.sizex / 3.0f, 1);
+	return result;
+}
+
 void GaussianXBlurOperation::executePixel(float output[4], int x, int y, void *data)
 {
+	if (this->m_useIIR) {
+		((MemoryBuffer *)data)->readNoCheck(output, x, y);
+		return;
+	}
+
 	float ATTR_ALIGN(16) color_accum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
 	float multiplier_accum = 0.0f;
 	MemoryBuffer *inputBuffer = (MemoryBuffer *)data;
@@ -123,6 +164,37 @@ void GaussianXBlurOperation::executePixel(float output[4], int x, int y, void *d
 	mul_v4_v4fl(output, color_accum, 1.0f / multiplier_accum);
 }
 
+void GaussianXBlurOperation::updateOutputBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+	MemoryBuffer *input = inputs[0];
+
+	lockMutex();
+	if (!this->m_sizeavailable) {
+		updateGauss();
+	}
+	if (this->m_useIIR && !input->isSingleElem()) {
+		if (this->m_iirResult == NULL) {
+			this->m_iirResult = createIIRResult(input);
+		}
+		input = this->m_iirResult;
+	}
+	unlockMutex();
+
+	for (int y = area->ymin; y < area->ymax; y++) {
+		float *out = output->getElem(area->xmin, y);
+		for (int x = area->xmin; x < area->xmax; x++) {
+			if (input->isSingleElem()) {
+				/* blurring a constant color doesn't change it */
+				input->readElem(out, x, y);
+			}
+			else {
+				GaussianXBlurOperation::executePixel(out, x, y, input);
+			}
+			out += COM_NUM_CHANNELS_COLOR;
+		}
+	}
+}
+
 void GaussianXBlurOperation::executeOpenCL(OpenCLDevice *device,
                                            MemoryBuffer *outputMemoryBuffer, cl_mem clOutputBuffer,
                                            MemoryBuffer **inputMemoryBuffers, list<cl_mem> *clMemToCleanUp,
@@ -164,6 +236,11 @@ void GaussianXBlurOperation::deinitExecution()
 	}
 #endif
 
+	if (this->m_iirResult) {
+		delete this->m_iirResult;
+		this->m_iirResult = NULL;
+	}
+
 	deinitMutex();
 }
 
@@ -183,7 +260,14 @@ bool GaussianXBlurOperation::determineDependingAreaOfInterest(rcti *input, ReadB
 		}
 	}
 	{
-		if (this->m_sizeavailable && this->m_gausstab != NULL) {
+		if (this->m_useIIR) {
+			/* the recursive filter needs whole rows */
+			newInput.xmax = this->getWidth();
+			newInput.xmin = 0;
+			newInput.ymax = input->ymax;
+			newInput.ymin = input->ymin;
+		}
+		else if (this->m_sizeavailable && this->m_gausstab != NULL) {
 			newInput.xmax = input->xmax + this->m_filtersize + 1;
 			newInput.xmin = input->xmin - this->m_filtersize - 1;
 			newInput.ymax = input->ymax;
@@ -33,6 +33,16 @@ private:
 #endif
 	int m_filtersize;
 	void updateGauss();
+	/**
+	 * @brief the whole result is filtered at once, see useIIR
+	 */
+	bool m_useIIR;
+	MemoryBuffer *m_iirResult;
+	/**
+	 * @brief large gaussian kernels of a known size are replaced by the recursive filter
+	 */
+	bool useIIR();
+	MemoryBuffer *createIIRResult(MemoryBuffer *input);
 public:
 	GaussianXBlurOperation();
 
@@ -41,6 +51,8 @@ public:
 	 */
 	void executePixel(float output[4], int x, int y, void *data);
 
+	void updateOutputBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
+
 	void executeOpenCL(OpenCLDevice *device,
 	                   MemoryBuffer *outputMemoryBuffer, cl_mem clOutputBuffer,
 	                   MemoryBuffer **inputMemoryBuffers, list<cl_mem> *clMemToCleanUp,
@@ -57,7 +69,13 @@ public:
 	void deinitExecution();
 	
 	void *initializeTileData(rcti *rect);
+	/**
+	 * the recursive filter calculates the whole result in a single chunk
+	 */
+	int isSingleThreaded() { return this->m_useIIR; }
 	bool determineDependingAreaOfInterest(rcti *input, ReadBufferOperation *readOperation, rcti *output);
+	void determineResolution(unsigned int resolution[2],
+	                         unsigned int preferredResolution[2]);
 
 	void checkOpenCL() {
 		this->setOpenCL(m_data.sizex >= 128);
@@ -21,6 +21,7 @@
  */
 
 #include "COM_GaussianYBlurOperation.h"
+#include "COM_FastGaussianBlurOperation.h"
 #include "COM_OpenCLDevice.h"
 #include "BLI_math.h"
 #include "MEM_guardedalloc.h"
@@ -36,6 +37,9 @@ GaussianYBlurOperation::GaussianYBlurOperation() : BlurBaseOperation(COM_DT_COLO
 	this->m_gausstab_sse = NULL;
 #endif
 	this->m_filtersize = 0;
+	this->m_useIIR = false;
+	this->m_iirResult = NULL;
+	this->setFullFrame(true);
 }
 
 void *GaussianYBlurOperation::initializeTileData(rcti * /*rect*/)
@@ -45,6 +49,12 @@ void *GaussianYBlurOperation::initializeTileData(rcti * /*rect*/)
 		updateGauss();
 	}
 	void *buffer = getInputOperation(0)->initializeTileData(NULL);
+	if (this->m_useIIR) {
+		if (this->m_iirResult == NULL) {
+			this->m_iirResult = createIIRResult((MemoryBuffer *)buffer);
+		}
+		buffer = this->m_iirResult;
+	}
 	unlockMutex();
 	return buffer;
 }
@@ -67,6 +77,14 @@ void GaussianYBlurOperation::initExecution()
 	}
 }
 
+void GaussianYBlurOperation::determineResolution(unsigned int resolution[2],
+                                                 unsigned int preferredResolution[2])
+{
+	BlurBaseOperation::determineResolution(resolution, preferredResolution);
+	/* decided once, so the chunks, the area of interest and executePixel agree */
+	this->m_useIIR = useIIR();
+}
+
 void GaussianYBlurOperation::updateGauss()
 {
 	if (this->m_gausstab == NULL) {
@@ -82,8 +100,31 @@ void GaussianYBlurOperation::updateGauss()
 	}
 }
 
+bool GaussianYBlurOperation::useIIR()
+{
+	/* execution groups are created before the size input can be read,
+	 * only the gaussian filter has a recursive counterpart */
+	if (!this->m_sizeavailable || this->m_data.filtertype != R_FILTER_GAUSS) {
+		return false;
+	}
+	return m_size * m_data.sizey >= IIR_GAUSS_MIN_RADIUS;
+}
+
+MemoryBuffer *GaussianYBlurOperation::createIIRResult(MemoryBuffer *input)
+{
+	MemoryBuffer *result = input->duplicate();
+	/* the kernel ends at three times sigma, see RE_filter_value */
+	FastGaussianBlurOperation::IIR_gauss_normalized(result, m_size * m_data.sizey / 3.0f, 2);
+	return result;
+}
+
 void GaussianYBlurOperation::executePixel(float output[4], int x, int y, void *data)
 {
+	if (this->m_useIIR) {
+		((MemoryBuffer *)data)->readNoCheck(output, x, y);
+		return;
+	}
+
 	float ATTR_ALIGN(16) color_accum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
 	float multiplier_accum = 0.0f;
 	MemoryBuffer *inputBuffer = (MemoryBuffer *)data;
@@ -125,6 +166,37 @@ void GaussianYBlurOperation::executePixel(float output[4], int x, int y, void *d
 	mul_v4_v4fl(output, color_accum, 1.0f / multiplier_accum);
 }
 
+void GaussianYBlurOperation::updateOutputBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+	MemoryBuffer *input = inputs[0];
+
+	lockMutex();
+	if (!this->m_sizeavailable) {
+		updateGauss();
+	}
+	if (this->m_useIIR && !input->isSingleElem()) {
+		if (this->m_iirResult == NULL) {
+			this->m_iirResult = createIIRResult(input);
+		}
+		input = this->m_iirResult;
+	}
+	unlockMutex();
+
+	for (int y = area->ymin; y < area->ymax; y++) {
+		float *out = output->getElem(area->xmin, y);
+		for (int x = area->xmin; x < area->xmax; x++) {
+			if (input->isSingleElem()) {
+				/* blurring a constant color doesn't change it */
+				input->readElem(out, x, y);
+			}
+			else {
+				GaussianYBlurOperation::executePixel(out, x, y, input);
+			}
+			out += COM_NUM_CHANNELS_COLOR;
+		}
+	}
+}
+
 void GaussianYBlurOperation::executeOpenCL(OpenCLDevice *device,
                                            MemoryBuffer *outputMemoryBuffer, cl_mem clOutputBuffer,
                                            MemoryBuffer **inputMemoryBuffers, list<cl_mem> *clMemToCleanUp,
@@ -166,6 +238,11 @@ void GaussianYBlurOperation::deinitExecution()
 	}
 #endif
 
+	if (this->m_iirResult) {
+		delete this->m_iirResult;
+		this->m_iirResult = NULL;
+	}
+
 	deinitMutex();
 }
 
@@ -185,7 +262,14 @@ bool GaussianYBlurOperation::determineDependingAreaOfInterest(rcti *input, ReadB
 		}
 	}
 	{
-		if (this->m_sizeavailable && this->m_gausstab != NULL) {
+		if (this->m_useIIR) {
+			/* the recursive filter needs whole columns */
+			newInput.xmax = input->xmax;
+			newInput.xmin = input->xmin;
+			newInput.ymax = this->getHeight();
+			newInput.ymin = 0;
+		}
+		else if (this->m_sizeavailable && this->m_gausstab != NULL) {
 			newInput.xmax = input->xmax;
 			newInput.xmin = input->xmin;
 			newInput.ymax = input->ymax + this->m_filtersize + 1;
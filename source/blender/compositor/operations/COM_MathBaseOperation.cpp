@@ -25,6 +25,54 @@ extern "C" {
 #include "BLI_math.h"
 }
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+
+/* Load the values of four pixels, inputs with a zero stride have the same value for all. */
+static inline __m128 math_load_sse2(const float *input, int stride)
+{
+	return (stride) ? _mm_loadu_ps(input) : _mm_set1_ps(input[0]);
+}
+
+/* Calculate a row of pixels with an SSE2 kernel, four pixels per register. The remaining
+ * pixels are calculated one by one by the operation. */
+template<typename MathKernel>
+static void math_row_sse2(MathBaseOperation *operation, float *output,
+                          const float *inputValue1, const float *inputValue2,
+                          int value1Stride, int value2Stride, int width,
+                          bool useClamp, const MathKernel &kernel)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	int x = 0;
+
+	for (; x + 4 <= width; x += 4) {
+		__m128 result = kernel(math_load_sse2(inputValue1, value1Stride),
+		                       math_load_sse2(inputValue2, value2Stride));
+		if (useClamp) {
+			result = _mm_min_ps(_mm_max_ps(result, zero), one);
+		}
+		_mm_storeu_ps(output, result);
+
+		output += 4;
+		inputValue1 += 4 * value1Stride;
+		inputValue2 += 4 * value2Stride;
+	}
+
+	for (; x < width; x++) {
+		operation->mathPixel(output, inputValue1, inputValue2);
+
+		output++;
+		inputValue1 += value1Stride;
+		inputValue2 += value2Stride;
+	}
+}
+
+#  define MATH_ROW_SSE2(kernel) \
+	math_row_sse2(this, output, inputValue1, inputValue2, \
+	              value1Stride, value2Stride, width, this->m_useClamp, kernel)
+#endif  /* __SSE2__ */
+
 MathBaseOperation::MathBaseOperation() : NodeOperation()
 {
 	this->addInputSocket(COM_DT_VALUE);
@@ -33,6 +81,7 @@ MathBaseOperation::MathBaseOperation() : NodeOperation()
 	this->m_inputValue1Operation = NULL;
 	this->m_inputValue2Operation = NULL;
 	this->m_useClamp = false;
+	this->setFullFrame(true);
 }
 
 void MathBaseOperation::initExecution()
@@ -65,6 +114,43 @@ void MathBaseOperation::determineResolution(unsigned int resolution[2], unsigned
 	NodeOperation::determineResolution(resolution, preferredResolution);
 }
 
+void MathBaseOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+{
+	float inputValue1[4];
+	float inputValue2[4];
+
+	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
+	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
+
+	mathPixel(output, inputValue1, inputValue2);
+}
+
+void MathBaseOperation::updateOutputBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+	MemoryBuffer *inputValue1 = inputs[0];
+	MemoryBuffer *inputValue2 = inputs[1];
+
+	for (int y = area->ymin; y < area->ymax; y++) {
+		mathRow(output->getElem(area->xmin, y),
+		        inputValue1->getElem(area->xmin, y),
+		        inputValue2->getElem(area->xmin, y),
+		        inputValue1->getElemStride(), inputValue2->getElemStride(),
+		        BLI_rcti_size_x(area));
+	}
+}
+
+void MathBaseOperation::mathRow(float *output, const float *inputValue1, const float *inputValue2,
+                                int value1Stride, int value2Stride, int width)
+{
+	for (int x = 0; x < width; x++) {
+		mathPixel(output, inputValue1, inputValue2);
+
+		output++;
+		inputValue1 += value1Stride;
+		inputValue2 += value2Stride;
+	}
+}
+
 void MathBaseOperation::clampIfNeeded(float *color)
 {
 	if (this->m_useClamp) {
@@ -72,53 +158,74 @@ void MathBaseOperation::clampIfNeeded(float *color)
 	}
 }
 
-void MathAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MathAddOperation::mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
-	
 	output[0] = inputValue1[0] + inputValue2[0];
 
 	clampIfNeeded(output);
 }
 
-void MathSubtractOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+#ifdef __SSE2__
+struct MathAddKernel {
+	inline __m128 operator()(__m128 value1, __m128 value2) const
+	{
+		return _mm_add_ps(value1, value2);
+	}
+};
+
+void MathAddOperation::mathRow(float *output, const float *inputValue1, const float *inputValue2,
+                               int value1Stride, int value2Stride, int width)
+{
+	MATH_ROW_SSE2(MathAddKernel());
+}
+#endif
+
+void MathSubtractOperation::mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
-	
 	output[0] = inputValue1[0] - inputValue2[0];
 
 	clampIfNeeded(output);
 }
 
-void MathMultiplyOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+#ifdef __SSE2__
+struct MathSubtractKernel {
+	inline __m128 operator()(__m128 value1, __m128 value2) const
+	{
+		return _mm_sub_ps(value1, value2);
+	}
+};
+
+void MathSubtractOperation::mathRow(float *output, const float *inputValue1, const float *inputValue2,
+                                    int value1Stride, int value2Stride, int width)
+{
+	MATH_ROW_SSE2(MathSubtractKernel());
+}
+#endif
+
+void MathMultiplyOperation::mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
-	
 	output[0] = inputValue1[0] * inputValue2[0];
 
 	clampIfNeeded(output);
 }
 
-void MathDivideOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+#ifdef __SSE2__
+struct MathMultiplyKernel {
+	inline __m128 operator()(__m128 value1, __m128 value2) const
+	{
+		return _mm_mul_ps(value1, value2);
+	}
+};
+
+void MathMultiplyOperation::mathRow(float *output, const float *inputValue1, const float *inputValue2,
+                                    int value1Stride, int value2Stride, int width)
+{
+	MATH_ROW_SSE2(MathMultiplyKernel());
+}
+#endif
+
+void MathDivideOperation::mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
-	
 	if (inputValue2[0] == 0) /* We don't want to divide by zero. */
 		output[0] = 0.0;
 	else
@@ -127,53 +234,46 @@ void MathDivideOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
-void MathSineOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+#ifdef __SSE2__
+struct MathDivideKernel {
+	inline __m128 operator()(__m128 value1, __m128 value2) const
+	{
+		/* We don't want to divide by zero. */
+		const __m128 valid = _mm_cmpneq_ps(value2, _mm_setzero_ps());
+		return _mm_and_ps(valid, _mm_div_ps(value1, value2));
+	}
+};
+
+void MathDivideOperation::mathRow(float *output, const float *inputValue1, const float *inputValue2,
+                                  int value1Stride, int value2Stride, int width)
+{
+	MATH_ROW_SSE2(MathDivideKernel());
+}
+#endif
+
+void MathSineOperation::mathPixel(float output[4], const float inputValue1[4], const float /*inputValue2*/[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
-	
 	output[0] = sin(inputValue1[0]);
 
 	clampIfNeeded(output);
 }
 
-void MathCosineOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MathCosineOperation::mathPixel(float output[4], const float inputValue1[4], const float /*inputValue2*/[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
-	
 	output[0] = cos(inputValue1[0]);
 
 	clampIfNeeded(output);
 }
 
-void MathTangentOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MathTangentOperation::mathPixel(float output[4], const float inputValue1[4], const float /*inputValue2*/[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
-	
 	output[0] = tan(inputValue1[0]);
 
 	clampIfNeeded(output);
 }
 
-void MathArcSineOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MathArcSineOperation::mathPixel(float output[4], const float inputValue1[4], const float /*inputValue2*/[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
-	
 	if (inputValue1[0] <= 1 && inputValue1[0] >= -1)
 		output[0] = asin(inputValue1[0]);
 	else
@@ -182,14 +282,8 @@ void MathArcSineOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
-void MathArcCosineOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MathArcCosineOperation::mathPixel(float output[4], const float inputValue1[4], const float /*inputValue2*/[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
-	
 	if (inputValue1[0] <= 1 && inputValue1[0] >= -1)
 		output[0] = acos(inputValue1[0]);
 	else
@@ -198,27 +292,15 @@ void MathArcCosineOperation::executePixelSampled(float output[4], float x, float
 	clampIfNeeded(output);
 }
 
-void MathArcTangentOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MathArcTangentOperation::mathPixel(float output[4], const float inputValue1[4], const float /*inputValue2*/[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
-	
 	output[0] = atan(inputValue1[0]);
 
 	clampIfNeeded(output);
 }
 
-void MathPowerOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MathPowerOperation::mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
-	
 	if (inputValue1[0] >= 0) {
 		output[0] = pow(inputValue1[0], inputValue2[0]);
 	}
@@ -236,14 +318,8 @@ void MathPowerOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
-void MathLogarithmOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MathLogarithmOperation::mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
-	
 	if (inputValue1[0] > 0  && inputValue2[0] > 0)
 		output[0] = log(inputValue1[0]) / log(inputValue2[0]);
 	else
@@ -252,79 +328,105 @@ void MathLogarithmOperation::executePixelSampled(float output[4], float x, float
 	clampIfNeeded(output);
 }
 
-void MathMinimumOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MathMinimumOperation::mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
-	
 	output[0] = min(inputValue1[0], inputValue2[0]);
 
 	clampIfNeeded(output);
 }
 
-void MathMaximumOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+#ifdef __SSE2__
+struct MathMinimumKernel {
+	inline __m128 operator()(__m128 value1, __m128 value2) const
+	{
+		/* same order of arguments as min(), for equal values and NaN */
+		return _mm_min_ps(value2, value1);
+	}
+};
+
+void MathMinimumOperation::mathRow(float *output, const float *inputValue1, const float *inputValue2,
+                                   int value1Stride, int value2Stride, int width)
+{
+	MATH_ROW_SSE2(MathMinimumKernel());
+}
+#endif
+
+void MathMaximumOperation::mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
-	
 	output[0] = max(inputValue1[0], inputValue2[0]);
 
 	clampIfNeeded(output);
 }
 
-void MathRoundOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+#ifdef __SSE2__
+struct MathMaximumKernel {
+	inline __m128 operator()(__m128 value1, __m128 value2) const
+	{
+		/* same order of arguments as max(), for equal values and NaN */
+		return _mm_max_ps(value2, value1);
+	}
+};
+
+void MathMaximumOperation::mathRow(float *output, const float *inputValue1, const float *inputValue2,
+                                   int value1Stride, int value2Stride, int width)
+{
+	MATH_ROW_SSE2(MathMaximumKernel());
+}
+#endif
+
+void MathRoundOperation::mathPixel(float output[4], const float inputValue1[4], const float /*inputValue2*/[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
-	
 	output[0] = round(inputValue1[0]);
 
 	clampIfNeeded(output);
 }
 
-void MathLessThanOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MathLessThanOperation::mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
-	
 	output[0] = inputValue1[0] < inputValue2[0] ? 1.0f : 0.0f;
 
 	clampIfNeeded(output);
 }
 
-void MathGreaterThanOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+#ifdef __SSE2__
+struct MathLessThanKernel {
+	inline __m128 operator()(__m128 value1, __m128 value2) const
+	{
+		return _mm_and_ps(_mm_cmplt_ps(value1, value2), _mm_set1_ps(1.0f));
+	}
+};
+
+void MathLessThanOperation::mathRow(float *output, const float *inputValue1, const float *inputValue2,
+                                    int value1Stride, int value2Stride, int width)
+{
+	MATH_ROW_SSE2(MathLessThanKernel());
+}
+#endif
+
+void MathGreaterThanOperation::mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
-	
 	output[0] = inputValue1[0] > inputValue2[0] ? 1.0f : 0.0f;
 
 	clampIfNeeded(output);
 }
 
-void MathModuloOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+#ifdef __SSE2__
+struct MathGreaterThanKernel {
+	inline __m128 operator()(__m128 value1, __m128 value2) const
+	{
+		return _mm_and_ps(_mm_cmpgt_ps(value1, value2), _mm_set1_ps(1.0f));
+	}
+};
+
+void MathGreaterThanOperation::mathRow(float *output, const float *inputValue1, const float *inputValue2,
+                                       int value1Stride, int value2Stride, int width)
+{
+	MATH_ROW_SSE2(MathGreaterThanKernel());
+}
+#endif
+
+void MathModuloOperation::mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4])
 {
-	float inputValue1[4];
-	float inputValue2[4];
-	
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-	this->m_inputValue2Operation->readSampled(inputValue2, x, y, sampler);
-	
 	if (inputValue2[0] == 0)
 		output[0] = 0.0;
 	else
@@ -333,13 +435,24 @@ void MathModuloOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
-void MathAbsoluteOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MathAbsoluteOperation::mathPixel(float output[4], const float inputValue1[4], const float /*inputValue2*/[4])
 {
-	float inputValue1[4];
-
-	this->m_inputValue1Operation->readSampled(inputValue1, x, y, sampler);
-
 	output[0] = fabs(inputValue1[0]);
 
 	clampIfNeeded(output);
 }
+
+#ifdef __SSE2__
+struct MathAbsoluteKernel {
+	inline __m128 operator()(__m128 value1, __m128 /*value2*/) const
+	{
+		return _mm_andnot_ps(_mm_set1_ps(-0.0f), value1);
+	}
+};
+
+void MathAbsoluteOperation::mathRow(float *output, const float *inputValue1, const float *inputValue2,
+                                    int value1Stride, int value2Stride, int width)
+{
+	MATH_ROW_SSE2(MathAbsoluteKernel());
+}
+#endif
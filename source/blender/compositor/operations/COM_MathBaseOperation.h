@@ -23,6 +23,7 @@
 #ifndef _COM_MathBaseOperation_h
 #define _COM_MathBaseOperation_h
 #include "COM_NodeOperation.h"
+#include "COM_MemoryBuffer.h"
 
 
 /**
@@ -50,7 +51,20 @@ public:
 	/**
 	 * the inner loop of this program
 	 */
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler) = 0;
+	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+	void updateOutputBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
+
+	/**
+	 * Calculate a single pixel from both values
+	 */
+	virtual void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]) = 0;
+
+	/**
+	 * Calculate a row of pixels, the inputs advance by their stride for every pixel
+	 */
+	virtual void mathRow(float *output, const float *inputValue1, const float *inputValue2,
+	                     int value1Stride, int value2Stride, int width);
 	
 	/**
 	 * Initialize the execution
@@ -73,100 +87,136 @@ public:
 class MathAddOperation : public MathBaseOperation {
 public:
 	MathAddOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
+#ifdef __SSE2__
+	void mathRow(float *output, const float *inputValue1, const float *inputValue2,
+	             int value1Stride, int value2Stride, int width);
+#endif
 };
 class MathSubtractOperation : public MathBaseOperation {
 public:
 	MathSubtractOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
+#ifdef __SSE2__
+	void mathRow(float *output, const float *inputValue1, const float *inputValue2,
+	             int value1Stride, int value2Stride, int width);
+#endif
 };
 class MathMultiplyOperation : public MathBaseOperation {
 public:
 	MathMultiplyOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
+#ifdef __SSE2__
+	void mathRow(float *output, const float *inputValue1, const float *inputValue2,
+	             int value1Stride, int value2Stride, int width);
+#endif
 };
 class MathDivideOperation : public MathBaseOperation {
 public:
 	MathDivideOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
+#ifdef __SSE2__
+	void mathRow(float *output, const float *inputValue1, const float *inputValue2,
+	             int value1Stride, int value2Stride, int width);
+#endif
 };
 class MathSineOperation : public MathBaseOperation {
 public:
 	MathSineOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
 };
 class MathCosineOperation : public MathBaseOperation {
 public:
 	MathCosineOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
 };
 class MathTangentOperation : public MathBaseOperation {
 public:
 	MathTangentOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
 };
 
 class MathArcSineOperation : public MathBaseOperation {
 public:
 	MathArcSineOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
 };
 class MathArcCosineOperation : public MathBaseOperation {
 public:
 	MathArcCosineOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
 };
 class MathArcTangentOperation : public MathBaseOperation {
 public:
 	MathArcTangentOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
 };
 class MathPowerOperation : public MathBaseOperation {
 public:
 	MathPowerOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
 };
 class MathLogarithmOperation : public MathBaseOperation {
 public:
 	MathLogarithmOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
 };
 class MathMinimumOperation : public MathBaseOperation {
 public:
 	MathMinimumOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
+#ifdef __SSE2__
+	void mathRow(float *output, const float *inputValue1, const float *inputValue2,
+	             int value1Stride, int value2Stride, int width);
+#endif
 };
 class MathMaximumOperation : public MathBaseOperation {
 public:
 	MathMaximumOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
+#ifdef __SSE2__
+	void mathRow(float *output, const float *inputValue1, const float *inputValue2,
+	             int value1Stride, int value2Stride, int width);
+#endif
 };
 class MathRoundOperation : public MathBaseOperation {
 public:
 	MathRoundOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
 };
 class MathLessThanOperation : public MathBaseOperation {
 public:
 	MathLessThanOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
+#ifdef __SSE2__
+	void mathRow(float *output, const float *inputValue1, const float *inputValue2,
+	             int value1Stride, int value2Stride, int width);
+#endif
 };
 class MathGreaterThanOperation : public MathBaseOperation {
 public:
 	MathGreaterThanOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
+#ifdef __SSE2__
+	void mathRow(float *output, const float *inputValue1, const float *inputValue2,
+	             int value1Stride, int value2Stride, int width);
+#endif
 };
 
 class MathModuloOperation : public MathBaseOperation {
 public:
 	MathModuloOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
 };
 
 class MathAbsoluteOperation : public MathBaseOperation {
 public:
 	MathAbsoluteOperation() : MathBaseOperation() {}
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mathPixel(float output[4], const float inputValue1[4], const float inputValue2[4]);
+#ifdef __SSE2__
+	void mathRow(float *output, const float *inputValue1, const float *inputValue2,
+	             int value1Stride, int value2Stride, int width);
+#endif
 };
 
 #endif
@@ -26,6 +26,49 @@ extern "C" {
 #  include "BLI_math.h"
 }
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+
+/* Mix a row of pixels with an SSE2 kernel, one pixel per register. The kernel gets the factor
+ * in all lanes and both colors and returns the mixed RGB, alpha is taken from the first color. */
+template<typename MixKernel>
+static void mix_row_sse2(float *output, const float *inputValue,
+                         const float *inputColor1, const float *inputColor2,
+                         int valueStride, int color1Stride, int color2Stride, int width,
+                         bool valueAlphaMultiply, bool useClamp, const MixKernel &kernel)
+{
+	const __m128 alpha_mask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	for (int x = 0; x < width; x++) {
+		const __m128 color1 = _mm_loadu_ps(inputColor1);
+		const __m128 color2 = _mm_loadu_ps(inputColor2);
+		float value = inputValue[0];
+		if (valueAlphaMultiply) {
+			value *= inputColor2[3];
+		}
+
+		__m128 result = kernel(_mm_set1_ps(value), color1, color2);
+		result = _mm_or_ps(_mm_andnot_ps(alpha_mask, result), _mm_and_ps(alpha_mask, color1));
+		if (useClamp) {
+			result = _mm_min_ps(_mm_max_ps(result, zero), one);
+		}
+		_mm_storeu_ps(output, result);
+
+		output += COM_NUM_CHANNELS_COLOR;
+		inputValue += valueStride;
+		inputColor1 += color1Stride;
+		inputColor2 += color2Stride;
+	}
+}
+
+#  define MIX_ROW_SSE2(kernel) \
+	mix_row_sse2(output, inputValue, inputColor1, inputColor2, \
+	             valueStride, color1Stride, color2Stride, width, \
+	             this->useValueAlphaMultiply(), this->m_useClamp, kernel)
+#endif  /* __SSE2__ */
+
 /* ******** Mix Base Operation ******** */
 
 MixBaseOperation::MixBaseOperation() : NodeOperation()
@@ -39,6 +82,7 @@ MixBaseOperation::MixBaseOperation() : NodeOperation()
 	this->m_inputColor2Operation = NULL;
 	this->setUseValueAlphaMultiply(false);
 	this->setUseClamp(false);
+	this->setFullFrame(true);
 }
 
 void MixBaseOperation::initExecution()
@@ -53,11 +97,54 @@ void MixBaseOperation::executePixelSampled(float output[4], float x, float y, Pi
 	float inputColor1[4];
 	float inputColor2[4];
 	float inputValue[4];
-	
+
 	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
 	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
 	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
-	
+
+	mixPixel(output, inputValue, inputColor1, inputColor2);
+}
+
+void MixBaseOperation::updateOutputBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+	MemoryBuffer *inputValue = inputs[0];
+	MemoryBuffer *inputColor1 = inputs[1];
+	MemoryBuffer *inputColor2 = inputs[2];
+	const int valueStride = inputValue->getElemStride();
+	const int color1Stride = inputColor1->getElemStride();
+	const int color2Stride = inputColor2->getElemStride();
+
+	for (int y = area->ymin; y < area->ymax; y++) {
+		mixRow(output->getElem(area->xmin, y),
+		       inputValue->getElem(area->xmin, y),
+		       inputColor1->getElem(area->xmin, y),
+		       inputColor2->getElem(area->xmin, y),
+		       valueStride, color1Stride, color2Stride,
+		       BLI_rcti_size_x(area));
+	}
+}
+
+void MixBaseOperation::mixRow(float *output, const float *inputValue,
+                              const float *inputColor1, const float *inputColor2,
+                              int valueStride, int color1Stride, int color2Stride, int width)
+{
+	float value[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+	for (int x = 0; x < width; x++) {
+		/* value buffers only store one channel */
+		value[0] = inputValue[0];
+		mixPixel(output, value, inputColor1, inputColor2);
+
+		output += COM_NUM_CHANNELS_COLOR;
+		inputValue += valueStride;
+		inputColor1 += color1Stride;
+		inputColor2 += color2Stride;
+	}
+}
+
+void MixBaseOperation::mixPixel(float output[4], const float inputValue[4],
+                                const float inputColor1[4], const float inputColor2[4])
+{
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -107,16 +194,9 @@ MixAddOperation::MixAddOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MixAddOperation::mixPixel(float output[4], const float inputValue[4],
+                               const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -129,6 +209,22 @@ void MixAddOperation::executePixelSampled(float output[4], float x, float y, Pix
 	clampIfNeeded(output);
 }
 
+#ifdef __SSE2__
+struct MixAddKernel {
+	inline __m128 operator()(__m128 value, __m128 color1, __m128 color2) const
+	{
+		return _mm_add_ps(color1, _mm_mul_ps(value, color2));
+	}
+};
+
+void MixAddOperation::mixRow(float *output, const float *inputValue,
+                             const float *inputColor1, const float *inputColor2,
+                             int valueStride, int color1Stride, int color2Stride, int width)
+{
+	MIX_ROW_SSE2(MixAddKernel());
+}
+#endif
+
 /* ******** Mix Blend Operation ******** */
 
 MixBlendOperation::MixBlendOperation() : MixBaseOperation()
@@ -136,16 +232,11 @@ MixBlendOperation::MixBlendOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixBlendOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MixBlendOperation::mixPixel(float output[4], const float inputValue[4],
+                                 const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
 	float value;
 
-	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
 	value = inputValue[0];
 	
 	if (this->useValueAlphaMultiply()) {
@@ -160,6 +251,22 @@ void MixBlendOperation::executePixelSampled(float output[4], float x, float y, P
 	clampIfNeeded(output);
 }
 
+#ifdef __SSE2__
+struct MixBlendKernel {
+	inline __m128 operator()(__m128 value, __m128 color1, __m128 color2) const
+	{
+		return _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.0f), value), color1), _mm_mul_ps(value, color2));
+	}
+};
+
+void MixBlendOperation::mixRow(float *output, const float *inputValue,
+                               const float *inputColor1, const float *inputColor2,
+                               int valueStride, int color1Stride, int color2Stride, int width)
+{
+	MIX_ROW_SSE2(MixBlendKernel());
+}
+#endif
+
 /* ******** Mix Burn Operation ******** */
 
 MixBurnOperation::MixBurnOperation() : MixBaseOperation()
@@ -167,17 +274,11 @@ MixBurnOperation::MixBurnOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixBurnOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MixBurnOperation::mixPixel(float output[4], const float inputValue[4],
+                                const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
 	float tmp;
 
-	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -235,16 +336,9 @@ MixColorOperation::MixColorOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixColorOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MixColorOperation::mixPixel(float output[4], const float inputValue[4],
+                                 const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -277,16 +371,9 @@ MixDarkenOperation::MixDarkenOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixDarkenOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MixDarkenOperation::mixPixel(float output[4], const float inputValue[4],
+                                  const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -300,6 +387,23 @@ void MixDarkenOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+#ifdef __SSE2__
+struct MixDarkenKernel {
+	inline __m128 operator()(__m128 value, __m128 color1, __m128 color2) const
+	{
+		return _mm_add_ps(_mm_mul_ps(_mm_min_ps(color1, color2), value),
+		                  _mm_mul_ps(color1, _mm_sub_ps(_mm_set1_ps(1.0f), value)));
+	}
+};
+
+void MixDarkenOperation::mixRow(float *output, const float *inputValue,
+                                const float *inputColor1, const float *inputColor2,
+                                int valueStride, int color1Stride, int color2Stride, int width)
+{
+	MIX_ROW_SSE2(MixDarkenKernel());
+}
+#endif
+
 /* ******** Mix Difference Operation ******** */
 
 MixDifferenceOperation::MixDifferenceOperation() : MixBaseOperation()
@@ -307,16 +411,9 @@ MixDifferenceOperation::MixDifferenceOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixDifferenceOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MixDifferenceOperation::mixPixel(float output[4], const float inputValue[4],
+                                      const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -330,6 +427,25 @@ void MixDifferenceOperation::executePixelSampled(float output[4], float x, float
 	clampIfNeeded(output);
 }
 
+#ifdef __SSE2__
+struct MixDifferenceKernel {
+	inline __m128 operator()(__m128 value, __m128 color1, __m128 color2) const
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 sign_mask = _mm_set1_ps(-0.0f);
+		const __m128 difference = _mm_andnot_ps(sign_mask, _mm_sub_ps(color1, color2));
+		return _mm_add_ps(_mm_mul_ps(_mm_sub_ps(one, value), color1), _mm_mul_ps(value, difference));
+	}
+};
+
+void MixDifferenceOperation::mixRow(float *output, const float *inputValue,
+                                    const float *inputColor1, const float *inputColor2,
+                                    int valueStride, int color1Stride, int color2Stride, int width)
+{
+	MIX_ROW_SSE2(MixDifferenceKernel());
+}
+#endif
+
 /* ******** Mix Difference Operation ******** */
 
 MixDivideOperation::MixDivideOperation() : MixBaseOperation()
@@ -337,16 +453,9 @@ MixDivideOperation::MixDivideOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixDivideOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MixDivideOperation::mixPixel(float output[4], const float inputValue[4],
+                                  const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -378,17 +487,11 @@ MixDodgeOperation::MixDodgeOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixDodgeOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MixDodgeOperation::mixPixel(float output[4], const float inputValue[4],
+                                 const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
 	float tmp;
 
-	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -451,27 +554,24 @@ MixGlareOperation::MixGlareOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixGlareOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MixGlareOperation::mixPixel(float output[4], const float inputValue[4],
+                                 const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
+	float color1[4];
 	float value;
 
-	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
 	value = inputValue[0];
 	float mf = 2.0f - 2.0f * fabsf(value - 0.5f);
 
-	if (inputColor1[0] < 0.0f) inputColor1[0] = 0.0f;
-	if (inputColor1[1] < 0.0f) inputColor1[1] = 0.0f;
-	if (inputColor1[2] < 0.0f) inputColor1[2] = 0.0f;
+	copy_v4_v4(color1, inputColor1);
+	if (color1[0] < 0.0f) color1[0] = 0.0f;
+	if (color1[1] < 0.0f) color1[1] = 0.0f;
+	if (color1[2] < 0.0f) color1[2] = 0.0f;
 
-	output[0] = mf * max(inputColor1[0] + value * (inputColor2[0] - inputColor1[0]), 0.0f);
-	output[1] = mf * max(inputColor1[1] + value * (inputColor2[1] - inputColor1[1]), 0.0f);
-	output[2] = mf * max(inputColor1[2] + value * (inputColor2[2] - inputColor1[2]), 0.0f);
-	output[3] = inputColor1[3];
+	output[0] = mf * max(color1[0] + value * (inputColor2[0] - color1[0]), 0.0f);
+	output[1] = mf * max(color1[1] + value * (inputColor2[1] - color1[1]), 0.0f);
+	output[2] = mf * max(color1[2] + value * (inputColor2[2] - color1[2]), 0.0f);
+	output[3] = color1[3];
 
 	clampIfNeeded(output);
 }
@@ -483,16 +583,9 @@ MixHueOperation::MixHueOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixHueOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MixHueOperation::mixPixel(float output[4], const float inputValue[4],
+                               const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -525,16 +618,9 @@ MixLightenOperation::MixLightenOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixLightenOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MixLightenOperation::mixPixel(float output[4], const float inputValue[4],
+                                   const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -554,6 +640,22 @@ void MixLightenOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+#ifdef __SSE2__
+struct MixLightenKernel {
+	inline __m128 operator()(__m128 value, __m128 color1, __m128 color2) const
+	{
+		return _mm_max_ps(_mm_mul_ps(value, color2), color1);
+	}
+};
+
+void MixLightenOperation::mixRow(float *output, const float *inputValue,
+                                 const float *inputColor1, const float *inputColor2,
+                                 int valueStride, int color1Stride, int color2Stride, int width)
+{
+	MIX_ROW_SSE2(MixLightenKernel());
+}
+#endif
+
 /* ******** Mix Linear Light Operation ******** */
 
 MixLinearLightOperation::MixLinearLightOperation() : MixBaseOperation()
@@ -561,16 +663,9 @@ MixLinearLightOperation::MixLinearLightOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixLinearLightOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MixLinearLightOperation::mixPixel(float output[4], const float inputValue[4],
+                                       const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -600,16 +695,9 @@ MixMultiplyOperation::MixMultiplyOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixMultiplyOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MixMultiplyOperation::mixPixel(float output[4], const float inputValue[4],
+                                    const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -623,6 +711,22 @@ void MixMultiplyOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+#ifdef __SSE2__
+struct MixMultiplyKernel {
+	inline __m128 operator()(__m128 value, __m128 color1, __m128 color2) const
+	{
+		return _mm_mul_ps(color1, _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), value), _mm_mul_ps(value, color2)));
+	}
+};
+
+void MixMultiplyOperation::mixRow(float *output, const float *inputValue,
+                                  const float *inputColor1, const float *inputColor2,
+                                  int valueStride, int color1Stride, int color2Stride, int width)
+{
+	MIX_ROW_SSE2(MixMultiplyKernel());
+}
+#endif
+
 /* ******** Mix Ovelray Operation ******** */
 
 MixOverlayOperation::MixOverlayOperation() : MixBaseOperation()
@@ -630,16 +734,9 @@ MixOverlayOperation::MixOverlayOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixOverlayOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MixOverlayOperation::mixPixel(float output[4], const float inputValue[4],
+                                   const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -677,16 +774,9 @@ MixSaturationOperation::MixSaturationOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixSaturationOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MixSaturationOperation::mixPixel(float output[4], const float inputValue[4],
+                                      const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -716,16 +806,9 @@ MixScreenOperation::MixScreenOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixScreenOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MixScreenOperation::mixPixel(float output[4], const float inputValue[4],
+                                  const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -740,6 +823,24 @@ void MixScreenOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+#ifdef __SSE2__
+struct MixScreenKernel {
+	inline __m128 operator()(__m128 value, __m128 color1, __m128 color2) const
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 factor = _mm_add_ps(_mm_sub_ps(one, value), _mm_mul_ps(value, _mm_sub_ps(one, color2)));
+		return _mm_sub_ps(one, _mm_mul_ps(factor, _mm_sub_ps(one, color1)));
+	}
+};
+
+void MixScreenOperation::mixRow(float *output, const float *inputValue,
+                                const float *inputColor1, const float *inputColor2,
+                                int valueStride, int color1Stride, int color2Stride, int width)
+{
+	MIX_ROW_SSE2(MixScreenKernel());
+}
+#endif
+
 /* ******** Mix Soft Light Operation ******** */
 
 MixSoftLightOperation::MixSoftLightOperation() : MixBaseOperation()
@@ -747,16 +848,9 @@ MixSoftLightOperation::MixSoftLightOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixSoftLightOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler) \
+void MixSoftLightOperation::mixPixel(float output[4], const float inputValue[4],
+                                     const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -784,16 +878,9 @@ MixSubtractOperation::MixSubtractOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixSubtractOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MixSubtractOperation::mixPixel(float output[4], const float inputValue[4],
+                                    const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->readSampled(inputValue,   x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1,   x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2,   x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
@@ -806,6 +893,22 @@ void MixSubtractOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+#ifdef __SSE2__
+struct MixSubtractKernel {
+	inline __m128 operator()(__m128 value, __m128 color1, __m128 color2) const
+	{
+		return _mm_sub_ps(color1, _mm_mul_ps(value, color2));
+	}
+};
+
+void MixSubtractOperation::mixRow(float *output, const float *inputValue,
+                                  const float *inputColor1, const float *inputColor2,
+                                  int valueStride, int color1Stride, int color2Stride, int width)
+{
+	MIX_ROW_SSE2(MixSubtractKernel());
+}
+#endif
+
 /* ******** Mix Value Operation ******** */
 
 MixValueOperation::MixValueOperation() : MixBaseOperation()
@@ -813,16 +916,9 @@ MixValueOperation::MixValueOperation() : MixBaseOperation()
 	/* pass */
 }
 
-void MixValueOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+void MixValueOperation::mixPixel(float output[4], const float inputValue[4],
+                                 const float inputColor1[4], const float inputColor2[4])
 {
-	float inputColor1[4];
-	float inputColor2[4];
-	float inputValue[4];
-
-	this->m_inputValueOperation->readSampled(inputValue, x, y, sampler);
-	this->m_inputColor1Operation->readSampled(inputColor1, x, y, sampler);
-	this->m_inputColor2Operation->readSampled(inputColor2, x, y, sampler);
-
 	float value = inputValue[0];
 	if (this->useValueAlphaMultiply()) {
 		value *= inputColor2[3];
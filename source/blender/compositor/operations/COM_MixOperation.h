@@ -23,6 +23,7 @@
 #ifndef _COM_MixBaseOperation_h
 #define _COM_MixBaseOperation_h
 #include "COM_NodeOperation.h"
+#include "COM_MemoryBuffer.h"
 
 
 /**
@@ -61,7 +62,22 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
-	
+
+	void updateOutputBuffer(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
+
+	/**
+	 * Mix a single pixel of both colors
+	 */
+	virtual void mixPixel(float output[4], const float inputValue[4],
+	                      const float inputColor1[4], const float inputColor2[4]);
+
+	/**
+	 * Mix a row of pixels, the inputs advance by their stride for every pixel
+	 */
+	virtual void mixRow(float *output, const float *inputValue,
+	                    const float *inputColor1, const float *inputColor2,
+	                    int valueStride, int color1Stride, int color2Stride, int width);
+
 	/**
 	 * Initialize the execution
 	 */
@@ -83,115 +99,174 @@ public:
 class MixAddOperation : public MixBaseOperation {
 public:
 	MixAddOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
+#ifdef __SSE2__
+	void mixRow(float *output, const float *inputValue,
+	            const float *inputColor1, const float *inputColor2,
+	            int valueStride, int color1Stride, int color2Stride, int width);
+#endif
 };
 
 class MixBlendOperation : public MixBaseOperation {
 public:
 	MixBlendOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
+#ifdef __SSE2__
+	void mixRow(float *output, const float *inputValue,
+	            const float *inputColor1, const float *inputColor2,
+	            int valueStride, int color1Stride, int color2Stride, int width);
+#endif
 };
 
 class MixBurnOperation : public MixBaseOperation {
 public:
 	MixBurnOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
 };
 
 class MixColorOperation : public MixBaseOperation {
 public:
 	MixColorOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
 };
 
 class MixDarkenOperation : public MixBaseOperation {
 public:
 	MixDarkenOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
+#ifdef __SSE2__
+	void mixRow(float *output, const float *inputValue,
+	            const float *inputColor1, const float *inputColor2,
+	            int valueStride, int color1Stride, int color2Stride, int width);
+#endif
 };
 
 class MixDifferenceOperation : public MixBaseOperation {
 public:
 	MixDifferenceOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
+#ifdef __SSE2__
+	void mixRow(float *output, const float *inputValue,
+	            const float *inputColor1, const float *inputColor2,
+	            int valueStride, int color1Stride, int color2Stride, int width);
+#endif
 };
 
 class MixDivideOperation : public MixBaseOperation {
 public:
 	MixDivideOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
 };
 
 class MixDodgeOperation : public MixBaseOperation {
 public:
 	MixDodgeOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
 };
 
 class MixGlareOperation : public MixBaseOperation {
 public:
 	MixGlareOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
 };
 
 class MixHueOperation : public MixBaseOperation {
 public:
 	MixHueOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
 };
 
 class MixLightenOperation : public MixBaseOperation {
 public:
 	MixLightenOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
+#ifdef __SSE2__
+	void mixRow(float *output, const float *inputValue,
+	            const float *inputColor1, const float *inputColor2,
+	            int valueStride, int color1Stride, int color2Stride, int width);
+#endif
 };
 
 class MixLinearLightOperation : public MixBaseOperation {
 public:
 	MixLinearLightOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
 };
 
 class MixMultiplyOperation : public MixBaseOperation {
 public:
 	MixMultiplyOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
+#ifdef __SSE2__
+	void mixRow(float *output, const float *inputValue,
+	            const float *inputColor1, const float *inputColor2,
+	            int valueStride, int color1Stride, int color2Stride, int width);
+#endif
 };
 
 class MixOverlayOperation : public MixBaseOperation {
 public:
 	MixOverlayOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
 };
 
 class MixSaturationOperation : public MixBaseOperation {
 public:
 	MixSaturationOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
 };
 
 class MixScreenOperation : public MixBaseOperation {
 public:
 	MixScreenOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
+#ifdef __SSE2__
+	void mixRow(float *output, const float *inputValue,
+	            const float *inputColor1, const float *inputColor2,
+	            int valueStride, int color1Stride, int color2Stride, int width);
+#endif
 };
 
 class MixSoftLightOperation : public MixBaseOperation {
 public:
 	MixSoftLightOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
 };
 
 class MixSubtractOperation : public MixBaseOperation {
 public:
 	MixSubtractOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
+#ifdef __SSE2__
+	void mixRow(float *output, const float *inputValue,
+	            const float *inputColor1, const float *inputColor2,
+	            int valueStride, int color1Stride, int color2Stride, int width);
+#endif
 };
 
 class MixValueOperation : public MixBaseOperation {
 public:
 	MixValueOperation();
-	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void mixPixel(float output[4], const float inputValue[4],
+	              const float inputColor1[4], const float inputColor2[4]);
 };
 
 #endif
@@ -141,11 +141,16 @@ typedef struct RenderEngine {
 	rcti last_disprect;
 	float last_viewmat[4][4];
 	int last_winx, last_winy;
+
+	/* Dependency graphs of the view layers, kept between the frames of an
+	 * animation with persistent data. */
+	ListBase depsgraphs;
 } RenderEngine;
 
 RenderEngine *RE_engine_create(RenderEngineType *type);
 RenderEngine *RE_engine_create_ex(RenderEngineType *type, bool use_for_viewport);
 void RE_engine_free(RenderEngine *engine);
+void RE_engine_free_depsgraphs(RenderEngine *engine);
 
 void RE_layer_load_from_file(struct RenderLayer *layer, struct ReportList *reports, const char *filename, int x, int y);
 void RE_result_load_from_file(struct RenderResult *result, struct ReportList *reports, const char *filename);
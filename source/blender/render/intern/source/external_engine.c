@@ -197,9 +197,34 @@ void RE_engine_free(RenderEngine *engine)
 		BLI_threaded_malloc_end();
 	}
 
+	RE_engine_free_depsgraphs(engine);
+
 	MEM_freeN(engine);
 }
 
+void RE_engine_free_depsgraphs(RenderEngine *engine)
+{
+	for (LinkData *link = engine->depsgraphs.first; link; link = link->next) {
+		DEG_graph_free(link->data);
+	}
+	BLI_freelistN(&engine->depsgraphs);
+}
+
+/* Dependency graph of the view layer kept from the previous frame, or a new one
+ * which is kept for the next frames. */
+static Depsgraph *engine_depsgraph_ensure(RenderEngine *engine, ViewLayer *view_layer)
+{
+	for (LinkData *link = engine->depsgraphs.first; link; link = link->next) {
+		if (STREQ(DEG_get_evaluated_view_layer(link->data)->name, view_layer->name)) {
+			return link->data;
+		}
+	}
+
+	Depsgraph *depsgraph = DEG_graph_new();
+	BLI_addtail(&engine->depsgraphs, BLI_genericNodeN(depsgraph));
+	return depsgraph;
+}
+
 /* Render Results */
 
 static RenderPart *get_part_from_result(Render *re, RenderResult *result)
@@ -753,11 +778,21 @@ int RE_engine_render(Render *re, int do_all)
 	}
 
 	if (type->render_to_image) {
+		/* With persistent data the engine keeps its data between renders, and only
+		 * syncs what the depsgraph tagged for update. The depsgraphs are kept
+		 * between the frames of an animation, so only data which changed is tagged,
+		 * other renders start from a new depsgraph which tags everything. */
+		const bool keep_depsgraphs = persistent_data && (re->flag & R_ANIMATION);
+
+		if (!keep_depsgraphs) {
+			RE_engine_free_depsgraphs(engine);
+		}
+
 		FOREACH_VIEW_LAYER_TO_RENDER_BEGIN(re, view_layer_iter)
 		{
 			EvaluationContext *eval_ctx = DEG_evaluation_context_new(DAG_EVAL_RENDER);
-			Depsgraph *depsgraph = DEG_graph_new();
 			ViewLayer *view_layer = BLI_findstring(&re->scene->view_layers, view_layer_iter->name, offsetof(ViewLayer, name));
+			Depsgraph *depsgraph = keep_depsgraphs ? engine_depsgraph_ensure(engine, view_layer) : DEG_graph_new();
 
 			DEG_evaluation_context_init_from_view_layer_for_render(
 						eval_ctx,
@@ -765,13 +800,25 @@ int RE_engine_render(Render *re, int do_all)
 						re->scene,
 						view_layer);
 
-			BKE_scene_graph_update_tagged(eval_ctx, depsgraph, re->main, re->scene, view_layer);
+			if (persistent_data) {
+				/* recalc flags are kept until the engine rendered the frame */
+				BKE_scene_graph_update_for_render_frame(eval_ctx, depsgraph, re->main, re->scene, view_layer);
+			}
+			else {
+				BKE_scene_graph_update_tagged(eval_ctx, depsgraph, re->main, re->scene, view_layer);
+			}
 			type->render_to_image(engine, depsgraph);
 
-			DEG_graph_free(depsgraph);
+			if (!keep_depsgraphs) {
+				DEG_graph_free(depsgraph);
+			}
 			DEG_evaluation_context_free(eval_ctx);
 		}
 		FOREACH_VIEW_LAYER_TO_RENDER_END;
+
+		if (persistent_data) {
+			DEG_ids_clear_recalc(re->main);
+		}
 	}
 
 	engine->tile_x = 0;
@@ -3839,6 +3839,11 @@ void RE_BlenderAnim(Render *re, Main *bmain, Scene *scene, Object *camera_overri
 
 	re->flag &= ~R_ANIMATION;
 
+	/* changes made before the next render are not tagged in these */
+	if (re->engine) {
+		RE_engine_free_depsgraphs(re->engine);
+	}
+
 	BLI_callback_exec(re->main, (ID *)scene, G.is_break ? BLI_CB_EVT_RENDER_CANCEL : BLI_CB_EVT_RENDER_COMPLETE);
 	BKE_sound_reset_scene_specs(scene);
 
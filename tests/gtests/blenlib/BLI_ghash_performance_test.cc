@@ -11,6 +11,9 @@ extern "C" {
 #include "BLI_ghash.h"
 #include "BLI_rand.h"
 #include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
 #include "PIL_time_utildefines.h"
 }
 
@@ -534,3 +537,227 @@ TEST(ghash, MultiRandIntMurmur2a200000)
 
 	multi_small_ghash_tests(ghash, "MultiSmall RandIntGHash - Murmur2a - 200000", 200000);
 }
+
+
+/* Chaining vs open addressing: insert, lookup and remove the same keys with both storages. */
+
+static void backend_ghash_tests_one(GHash *ghash, const char *id, void **keys, const unsigned int nbr)
+{
+	unsigned int i;
+
+	printf("---------- %s ----------\n", id);
+
+	{
+		TIMEIT_START(insert);
+
+#ifdef GHASH_RESERVE
+		BLI_ghash_reserve(ghash, nbr);
+#endif
+
+		for (i = 0; i < nbr; i++) {
+			BLI_ghash_insert(ghash, keys[i], SET_UINT_IN_POINTER(i));
+		}
+
+		TIMEIT_END(insert);
+	}
+
+	PRINTF_GHASH_STATS(ghash);
+
+	{
+		TIMEIT_START(lookup);
+
+		for (i = 0; i < nbr; i++) {
+			void *v = BLI_ghash_lookup(ghash, keys[i]);
+			EXPECT_EQ(GET_UINT_FROM_POINTER(v), i);
+		}
+
+		TIMEIT_END(lookup);
+	}
+
+	{
+		TIMEIT_START(remove);
+
+		for (i = 0; i < nbr; i++) {
+			EXPECT_TRUE(BLI_ghash_remove(ghash, keys[i], NULL, NULL));
+		}
+
+		TIMEIT_END(remove);
+	}
+	EXPECT_EQ(BLI_ghash_len(ghash), 0);
+
+	BLI_ghash_free(ghash, NULL, NULL);
+}
+
+static void backend_ghash_tests(
+        GHashHashFP hashfp, GHashCmpFP cmpfp, const char *id, void **keys, const unsigned int nbr)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	backend_ghash_tests_one(
+	        BLI_ghash_new(hashfp, cmpfp, __func__), "Chaining", keys, nbr);
+	backend_ghash_tests_one(
+	        BLI_ghash_new_flag_ex(hashfp, cmpfp, __func__, 0, GHASH_FLAG_OPEN_ADDRESSING), "Open Addressing",
+	        keys, nbr);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+/* Unique, well spread keys (multiplying by an odd number is a bijection). */
+#define BACKEND_KEY(_i) ((_i) * 2654435761u)
+
+static void ptr_backend_ghash_tests(const char *id, const unsigned int nbr)
+{
+	void **keys = (void **)MEM_mallocN(sizeof(*keys) * (size_t)nbr, __func__);
+	/* Addresses of actual allocated elements. */
+	char *data = (char *)MEM_mallocN(sizeof(float[3]) * (size_t)nbr, __func__);
+	unsigned int i;
+
+	for (i = 0; i < nbr; i++) {
+		keys[i] = data + sizeof(float[3]) * i;
+	}
+	BLI_array_randomize(keys, sizeof(*keys), nbr, 0);
+
+	backend_ghash_tests(BLI_ghashutil_ptrhash, BLI_ghashutil_ptrcmp, id, keys, nbr);
+
+	MEM_freeN(keys);
+	MEM_freeN(data);
+}
+
+static void int_backend_ghash_tests(const char *id, const unsigned int nbr)
+{
+	void **keys = (void **)MEM_mallocN(sizeof(*keys) * (size_t)nbr, __func__);
+	unsigned int i;
+
+	for (i = 0; i < nbr; i++) {
+		keys[i] = SET_UINT_IN_POINTER(BACKEND_KEY(i));
+	}
+
+	backend_ghash_tests(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, id, keys, nbr);
+
+	MEM_freeN(keys);
+}
+
+static void str_backend_ghash_tests(const char *id, const unsigned int nbr)
+{
+	void **keys = (void **)MEM_mallocN(sizeof(*keys) * (size_t)nbr, __func__);
+	char (*data)[16] = (char (*)[16])MEM_mallocN(sizeof(*data) * (size_t)nbr, __func__);
+	unsigned int i;
+
+	for (i = 0; i < nbr; i++) {
+		BLI_snprintf(data[i], sizeof(*data), "%x", BACKEND_KEY(i));
+		keys[i] = data[i];
+	}
+
+	backend_ghash_tests(BLI_ghashutil_strhash_p, BLI_ghashutil_strcmp, id, keys, nbr);
+
+	MEM_freeN(keys);
+	MEM_freeN(data);
+}
+
+#undef BACKEND_KEY
+
+TEST(ghash, BackendPtr1000000)
+{
+	ptr_backend_ghash_tests("BackendGHash - Ptr - 1000000", 1000000);
+}
+
+TEST(ghash, BackendInt1000000)
+{
+	int_backend_ghash_tests("BackendGHash - Int - 1000000", 1000000);
+}
+
+TEST(ghash, BackendStr1000000)
+{
+	str_backend_ghash_tests("BackendGHash - Str - 1000000", 1000000);
+}
+
+
+/* Concurrent GHash: scaling of parallel insertion/lookup with the number of threads. */
+
+#define CONCURRENT_NUM_KEYS 2000000
+
+typedef struct ConcurrentBenchData {
+	GHashConcurrent *cgh;
+	int num_tasks;
+	bool lookup;
+} ConcurrentBenchData;
+
+static void concurrent_bench_task(TaskPool *__restrict pool, void *taskdata, int UNUSED(thread_id))
+{
+	ConcurrentBenchData *data = (ConcurrentBenchData *)BLI_task_pool_userdata(pool);
+	const unsigned int task_index = GET_UINT_FROM_POINTER(taskdata);
+	const unsigned int start = task_index * CONCURRENT_NUM_KEYS / data->num_tasks;
+	const unsigned int end = (task_index + 1) * CONCURRENT_NUM_KEYS / data->num_tasks;
+
+	for (unsigned int i = start; i < end; i++) {
+		void *key = SET_UINT_IN_POINTER(i * 2654435761u);
+		if (data->lookup) {
+			EXPECT_EQ(BLI_ghash_concurrent_lookup(data->cgh, key), key);
+		}
+		else {
+			BLI_ghash_concurrent_insert(data->cgh, key, key);
+		}
+	}
+}
+
+static double concurrent_bench_run(TaskScheduler *scheduler, ConcurrentBenchData *data)
+{
+	TaskPool *pool = BLI_task_pool_create(scheduler, data);
+	const double time_start = PIL_check_seconds_timer();
+	for (int i = 0; i < data->num_tasks; i++) {
+		BLI_task_pool_push(pool, concurrent_bench_task, SET_INT_IN_POINTER(i), false, TASK_PRIORITY_HIGH);
+	}
+	BLI_task_pool_work_and_wait(pool);
+	BLI_task_pool_free(pool);
+	return PIL_check_seconds_timer() - time_start;
+}
+
+TEST(ghash, ConcurrentIntScaling)
+{
+	const int max_threads = MAX2(BLI_system_thread_count(), 4);
+
+	BLI_threadapi_init();
+
+	printf("\n========== STARTING ConcurrentIntScaling ==========\n");
+
+	{
+		GHash *ghash = BLI_ghash_int_new_ex(__func__, 0);
+		double time_start = PIL_check_seconds_timer();
+		for (unsigned int i = 0; i < CONCURRENT_NUM_KEYS; i++) {
+			BLI_ghash_insert(ghash, SET_UINT_IN_POINTER(i * 2654435761u), SET_UINT_IN_POINTER(i * 2654435761u));
+		}
+		const double time_insert = PIL_check_seconds_timer() - time_start;
+		time_start = PIL_check_seconds_timer();
+		for (unsigned int i = 0; i < CONCURRENT_NUM_KEYS; i++) {
+			void *key = SET_UINT_IN_POINTER(i * 2654435761u);
+			EXPECT_EQ(BLI_ghash_lookup(ghash, key), key);
+		}
+		const double time_lookup = PIL_check_seconds_timer() - time_start;
+		BLI_ghash_free(ghash, NULL, NULL);
+
+		printf("GHash      insert: %8.3f Mkeys/s    lookup: %8.3f Mkeys/s\n",
+		       CONCURRENT_NUM_KEYS / time_insert * 1e-6, CONCURRENT_NUM_KEYS / time_lookup * 1e-6);
+	}
+
+	for (int num_threads = 1; num_threads <= max_threads; num_threads++) {
+		TaskScheduler *scheduler = BLI_task_scheduler_create(num_threads);
+		ConcurrentBenchData data;
+
+		data.cgh = BLI_ghash_concurrent_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__, 0);
+		data.num_tasks = num_threads * 4;
+
+		data.lookup = false;
+		const double time_insert = concurrent_bench_run(scheduler, &data);
+		EXPECT_EQ(BLI_ghash_concurrent_len(data.cgh), CONCURRENT_NUM_KEYS);
+		data.lookup = true;
+		const double time_lookup = concurrent_bench_run(scheduler, &data);
+
+		BLI_ghash_concurrent_free(data.cgh, NULL, NULL);
+		BLI_task_scheduler_free(scheduler);
+
+		printf("%02d threads insert: %8.3f Mkeys/s    lookup: %8.3f Mkeys/s\n",
+		       num_threads, CONCURRENT_NUM_KEYS / time_insert * 1e-6, CONCURRENT_NUM_KEYS / time_lookup * 1e-6);
+	}
+
+	printf("========== ENDED ConcurrentIntScaling ==========\n\n");
+}
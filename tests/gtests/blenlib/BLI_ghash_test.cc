@@ -4,10 +4,14 @@
 
 #define GHASH_INTERNAL_API
 
+#include "atomic_ops.h"
+
 extern "C" {
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
 #include "BLI_rand.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 }
 
 #define TESTCASE_SIZE 10000
@@ -198,3 +202,225 @@ TEST(ghash, Pop)
 
 	BLI_ghash_free(ghash, NULL, NULL);
 }
+
+/* Open addressing storage: insert, lookup all keys, then remove half of them, checking remaining ones are
+ * still found (removal moves entries around). */
+TEST(ghash, OpenAddressingInsertRemove)
+{
+	GHash *ghash = BLI_ghash_new_flag_ex(
+	        BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__, 0,
+	        GHASH_FLAG_OPEN_ADDRESSING | GHASH_FLAG_ALLOW_SHRINK);
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i, bkt_size;
+
+	init_keys(keys, 40);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		BLI_ghash_insert(ghash, SET_UINT_IN_POINTER(*k), SET_UINT_IN_POINTER(*k));
+	}
+
+	EXPECT_EQ(BLI_ghash_len(ghash), TESTCASE_SIZE);
+	bkt_size = BLI_ghash_buckets_len(ghash);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		void *v = BLI_ghash_lookup(ghash, SET_UINT_IN_POINTER(*k));
+		EXPECT_EQ(GET_UINT_FROM_POINTER(v), *k);
+	}
+
+	for (i = 0; i < TESTCASE_SIZE; i += 2) {
+		EXPECT_TRUE(BLI_ghash_remove(ghash, SET_UINT_IN_POINTER(keys[i]), NULL, NULL));
+	}
+
+	EXPECT_EQ(BLI_ghash_len(ghash), TESTCASE_SIZE / 2);
+
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		void **v_p = BLI_ghash_lookup_p(ghash, SET_UINT_IN_POINTER(keys[i]));
+		if (i % 2) {
+			EXPECT_TRUE(v_p != NULL);
+			EXPECT_EQ(GET_UINT_FROM_POINTER(*v_p), keys[i]);
+		}
+		else {
+			EXPECT_TRUE(v_p == NULL);
+		}
+	}
+
+	for (i = 1; i < TESTCASE_SIZE; i += 2) {
+		void *v = BLI_ghash_popkey(ghash, SET_UINT_IN_POINTER(keys[i]), NULL);
+		EXPECT_EQ(GET_UINT_FROM_POINTER(v), keys[i]);
+	}
+
+	EXPECT_EQ(BLI_ghash_len(ghash), 0);
+	EXPECT_LT(BLI_ghash_buckets_len(ghash), bkt_size);
+
+	BLI_ghash_free(ghash, NULL, NULL);
+}
+
+/* Open addressing storage: iterators must visit each entry exactly once, also after copy. */
+TEST(ghash, OpenAddressingIterCopy)
+{
+	GHash *ghash = BLI_ghash_new_flag_ex(
+	        BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__, 0, GHASH_FLAG_OPEN_ADDRESSING);
+	GHash *ghash_copy;
+	GHashIterator gh_iter;
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i;
+
+	init_keys(keys, 50);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		void **val_p;
+		EXPECT_FALSE(BLI_ghash_ensure_p(ghash, SET_UINT_IN_POINTER(*k), &val_p));
+		*val_p = SET_UINT_IN_POINTER(0);
+	}
+
+	ghash_copy = BLI_ghash_copy(ghash, NULL, NULL);
+	EXPECT_EQ(BLI_ghash_len(ghash_copy), TESTCASE_SIZE);
+	EXPECT_EQ(BLI_ghash_buckets_len(ghash_copy), BLI_ghash_buckets_len(ghash));
+
+	i = 0;
+	GHASH_ITER (gh_iter, ghash_copy) {
+		void **val_p = BLI_ghashIterator_getValue_p(&gh_iter);
+		EXPECT_EQ(*val_p, BLI_ghash_lookup(ghash_copy, BLI_ghashIterator_getKey(&gh_iter)));
+		*val_p = SET_UINT_IN_POINTER(GET_UINT_FROM_POINTER(*val_p) + 1);
+		i++;
+	}
+	EXPECT_EQ(i, TESTCASE_SIZE);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		EXPECT_EQ(GET_UINT_FROM_POINTER(BLI_ghash_lookup(ghash_copy, SET_UINT_IN_POINTER(*k))), 1);
+		EXPECT_EQ(GET_UINT_FROM_POINTER(BLI_ghash_lookup(ghash, SET_UINT_IN_POINTER(*k))), 0);
+	}
+
+	BLI_ghash_free(ghash, NULL, NULL);
+	BLI_ghash_free(ghash_copy, NULL, NULL);
+}
+
+/* Open addressing storage: pop, and GSet API. */
+TEST(ghash, OpenAddressingPopGSet)
+{
+	GSet *gset = BLI_gset_new_flag_ex(
+	        BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__, 0,
+	        GHASH_FLAG_OPEN_ADDRESSING | GHASH_FLAG_ALLOW_SHRINK);
+	unsigned int keys[TESTCASE_SIZE], *k;
+	int i;
+
+	init_keys(keys, 60);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		EXPECT_TRUE(BLI_gset_add(gset, SET_UINT_IN_POINTER(*k)));
+		EXPECT_FALSE(BLI_gset_add(gset, SET_UINT_IN_POINTER(*k)));
+	}
+
+	EXPECT_EQ(BLI_gset_len(gset), TESTCASE_SIZE);
+
+	GSetIterState pop_state = {0};
+
+	for (i = TESTCASE_SIZE / 2; i--; ) {
+		void *key;
+		EXPECT_TRUE(BLI_gset_pop(gset, &pop_state, &key));
+		EXPECT_FALSE(BLI_gset_haskey(gset, key));
+	}
+
+	EXPECT_EQ(BLI_gset_len(gset), TESTCASE_SIZE - TESTCASE_SIZE / 2);
+
+	for (i = TESTCASE_SIZE, k = keys; i--; k++) {
+		BLI_gset_remove(gset, SET_UINT_IN_POINTER(*k), NULL);
+	}
+
+	EXPECT_EQ(BLI_gset_len(gset), 0);
+
+	BLI_gset_free(gset, NULL);
+}
+
+/* Concurrent GHash: all threads ensure the same keys at the same time (in different orders),
+ * each key must be created exactly once. */
+
+#define CONCURRENT_NUM_THREADS 8
+
+typedef struct ConcurrentData {
+	GHashConcurrent *cgh;
+	unsigned int *keys;
+	unsigned int *num_created;
+	unsigned int num_created_total;
+} ConcurrentData;
+
+static void *concurrent_create_cb(const void *key, void *userdata)
+{
+	ConcurrentData *data = (ConcurrentData *)userdata;
+	atomic_add_and_fetch_uint32(&data->num_created_total, 1);
+	return (void *)key;
+}
+
+static void concurrent_ensure_task(TaskPool *__restrict pool, void *taskdata, int UNUSED(thread_id))
+{
+	ConcurrentData *data = (ConcurrentData *)BLI_task_pool_userdata(pool);
+	const int offset = GET_INT_FROM_POINTER(taskdata) * (TESTCASE_SIZE / CONCURRENT_NUM_THREADS);
+
+	for (int i = 0; i < TESTCASE_SIZE; i++) {
+		const int index = (i + offset) % TESTCASE_SIZE;
+		void *key = SET_UINT_IN_POINTER(data->keys[index]);
+		void **val_p;
+
+		if (!BLI_ghash_concurrent_ensure_p(data->cgh, key, &val_p)) {
+			atomic_add_and_fetch_uint32(&data->num_created[index], 1);
+			*val_p = SET_INT_IN_POINTER(index);
+		}
+		EXPECT_TRUE(BLI_ghash_concurrent_haskey(data->cgh, key));
+
+		/* Keys with odd bits set are also removed and re-added. */
+		if (data->keys[index] & 1) {
+			BLI_ghash_concurrent_remove(data->cgh, SET_UINT_IN_POINTER(~data->keys[index]), NULL, NULL);
+		}
+		else {
+			void *v = BLI_ghash_concurrent_ensure(
+			        data->cgh, SET_UINT_IN_POINTER(~data->keys[index]), concurrent_create_cb, data);
+			EXPECT_EQ(v, SET_UINT_IN_POINTER(~data->keys[index]));
+		}
+	}
+}
+
+TEST(ghash, ConcurrentEnsureStress)
+{
+	unsigned int keys[TESTCASE_SIZE];
+	unsigned int num_created[TESTCASE_SIZE] = {0};
+	ConcurrentData data;
+	int i;
+
+	BLI_threadapi_init();
+	init_keys(keys, 70);
+
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		/* Keep both keys and their complement free of collisions. */
+		keys[i] = (keys[i] & ~1u) | ((i & 2) ? 1u : 0u);
+		keys[i] &= 0x7fffffff;
+	}
+
+	data.cgh = BLI_ghash_concurrent_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__, 0);
+	data.keys = keys;
+	data.num_created = num_created;
+	data.num_created_total = 0;
+
+	TaskScheduler *scheduler = BLI_task_scheduler_create(CONCURRENT_NUM_THREADS);
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+	for (i = 0; i < CONCURRENT_NUM_THREADS; i++) {
+		BLI_task_pool_push(pool, concurrent_ensure_task, SET_INT_IN_POINTER(i), false, TASK_PRIORITY_HIGH);
+	}
+	BLI_task_pool_work_and_wait(pool);
+	BLI_task_pool_free(pool);
+	BLI_task_scheduler_free(scheduler);
+
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		EXPECT_EQ(num_created[i], 1);
+		EXPECT_EQ(BLI_ghash_concurrent_lookup(data.cgh, SET_UINT_IN_POINTER(keys[i])), SET_INT_IN_POINTER(i));
+	}
+	/* Complement keys of even keys were created exactly once, odd ones never. */
+	EXPECT_EQ(data.num_created_total, TESTCASE_SIZE / 2);
+	EXPECT_EQ(BLI_ghash_concurrent_len(data.cgh), TESTCASE_SIZE + TESTCASE_SIZE / 2);
+
+	GHash *ghash = BLI_ghash_concurrent_to_ghash(data.cgh, __func__);
+	EXPECT_EQ(BLI_ghash_len(ghash), TESTCASE_SIZE + TESTCASE_SIZE / 2);
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		EXPECT_EQ(BLI_ghash_lookup(ghash, SET_UINT_IN_POINTER(keys[i])), SET_INT_IN_POINTER(i));
+	}
+	BLI_ghash_free(ghash, NULL, NULL);
+}
@@ -0,0 +1,172 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "zlib.h"
+
+#ifdef WIN32
+#  include <io.h>
+#else
+#  include <unistd.h>
+#endif
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_gzip_reader.h"
+#include "BLI_gzip_writer.h"
+#include "BLI_rand.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+#include "PIL_time.h"
+}
+
+/* Size of the written stream. */
+#define GZIP_DATA_SIZE (256 << 20)
+
+/* Same size as chunks given by .blend file writing. */
+#define GZIP_WRITE_SIZE (128 << 10)
+
+/* Mimic .blend file content: mostly zeroes, small integers and noisy floats. */
+static char *gzip_perf_data_new(const size_t data_len)
+{
+	char *data = (char *)MEM_mallocN(data_len, __func__);
+	RNG *rng = BLI_rng_new(0);
+	float *fp = (float *)data;
+	const size_t num_floats = data_len / sizeof(float);
+
+	for (size_t i = 0; i < num_floats; i++) {
+		switch (BLI_rng_get_int(rng) % 4) {
+			case 0: fp[i] = 0.0f; break;
+			case 1: fp[i] = (float)(BLI_rng_get_int(rng) % 16); break;
+			default: fp[i] = BLI_rng_get_float(rng); break;
+		}
+	}
+	BLI_rng_free(rng);
+	return data;
+}
+
+static double gzip_perf_write_zlib(const char *data, const size_t data_len, size_t *r_file_len)
+{
+	FILE *fp = tmpfile();
+	const double time_start = PIL_check_seconds_timer();
+
+	gzFile gzfile = gzdopen(dup(fileno(fp)), "wb1");
+	for (size_t i = 0; i < data_len; i += GZIP_WRITE_SIZE) {
+		gzwrite(gzfile, data + i, (unsigned int)MIN2(data_len - i, GZIP_WRITE_SIZE));
+	}
+	gzclose(gzfile);
+
+	const double time = PIL_check_seconds_timer() - time_start;
+	*r_file_len = (size_t)lseek(fileno(fp), 0, SEEK_END);
+	fclose(fp);
+	return time;
+}
+
+static double gzip_perf_write_threaded(
+        const char *data, const size_t data_len, const int num_threads, size_t *r_file_len)
+{
+	FILE *fp = tmpfile();
+	TaskScheduler *scheduler = BLI_task_scheduler_create(num_threads);
+	const double time_start = PIL_check_seconds_timer();
+
+	GzipWriter *gw = BLI_gzip_writer_new(fileno(fp), 1, 0, scheduler);
+	for (size_t i = 0; i < data_len; i += GZIP_WRITE_SIZE) {
+		BLI_gzip_writer_write(gw, data + i, MIN2(data_len - i, GZIP_WRITE_SIZE));
+	}
+	EXPECT_TRUE(BLI_gzip_writer_free(gw));
+
+	const double time = PIL_check_seconds_timer() - time_start;
+	BLI_task_scheduler_free(scheduler);
+	*r_file_len = (size_t)lseek(fileno(fp), 0, SEEK_END);
+	fclose(fp);
+	return time;
+}
+
+static double gzip_perf_read_zlib(FILE *fp, char *buf)
+{
+	const double time_start = PIL_check_seconds_timer();
+
+	lseek(fileno(fp), 0, SEEK_SET);
+	gzFile gzfile = gzdopen(dup(fileno(fp)), "rb");
+	while (gzread(gzfile, buf, GZIP_WRITE_SIZE) > 0) {
+		/* pass */
+	}
+	gzclose(gzfile);
+
+	return PIL_check_seconds_timer() - time_start;
+}
+
+static double gzip_perf_read_threaded(FILE *fp, char *buf, const int num_threads)
+{
+	TaskScheduler *scheduler = BLI_task_scheduler_create(num_threads);
+	const double time_start = PIL_check_seconds_timer();
+
+	GzipReader *gr = BLI_gzip_reader_new(fileno(fp), scheduler);
+	EXPECT_TRUE(gr != NULL);
+	while (BLI_gzip_reader_read(gr, buf, GZIP_WRITE_SIZE) > 0) {
+		/* pass */
+	}
+	BLI_gzip_reader_free(gr);
+
+	const double time = PIL_check_seconds_timer() - time_start;
+	BLI_task_scheduler_free(scheduler);
+	return time;
+}
+
+TEST(gzip_writer, ThreadedVsZlib)
+{
+	const int max_threads = MAX2(BLI_system_thread_count(), 2);
+	char *data = gzip_perf_data_new(GZIP_DATA_SIZE);
+	size_t file_len;
+
+	BLI_threadapi_init();
+
+	printf("\n========== STARTING %s ==========\n", "ThreadedVsZlib");
+	const double time_zlib = gzip_perf_write_zlib(data, GZIP_DATA_SIZE, &file_len);
+	printf("gzwrite:        %8.3f s  %8.1f MB/s  ratio %.3f\n",
+	       time_zlib, GZIP_DATA_SIZE / time_zlib / (1 << 20), (double)file_len / GZIP_DATA_SIZE);
+
+	for (int num_threads = 1; num_threads <= max_threads; num_threads++) {
+		const double time = gzip_perf_write_threaded(data, GZIP_DATA_SIZE, num_threads, &file_len);
+		printf("%02d threads:     %8.3f s  %8.1f MB/s  ratio %.3f\n",
+		       num_threads, time, GZIP_DATA_SIZE / time / (1 << 20), (double)file_len / GZIP_DATA_SIZE);
+	}
+	printf("========== ENDED %s ==========\n\n", "ThreadedVsZlib");
+
+	MEM_freeN(data);
+}
+
+TEST(gzip_reader, ThreadedVsZlib)
+{
+	const int max_threads = MAX2(BLI_system_thread_count(), 2);
+	char *data = gzip_perf_data_new(GZIP_DATA_SIZE);
+	char *buf = (char *)MEM_mallocN(GZIP_WRITE_SIZE, __func__);
+	FILE *fp = tmpfile();
+
+	BLI_threadapi_init();
+
+	/* Same file for both, gzread handles concatenated members. */
+	TaskScheduler *scheduler = BLI_task_scheduler_create(max_threads);
+	GzipWriter *gw = BLI_gzip_writer_new(fileno(fp), 1, 0, scheduler);
+	BLI_gzip_writer_write(gw, data, GZIP_DATA_SIZE);
+	EXPECT_TRUE(BLI_gzip_writer_free(gw));
+	BLI_task_scheduler_free(scheduler);
+	MEM_freeN(data);
+
+	printf("\n========== STARTING %s ==========\n", "ReaderThreadedVsZlib");
+	const double time_zlib = gzip_perf_read_zlib(fp, buf);
+	printf("gzread:         %8.3f s  %8.1f MB/s\n", time_zlib, GZIP_DATA_SIZE / time_zlib / (1 << 20));
+
+	for (int num_threads = 1; num_threads <= max_threads; num_threads++) {
+		const double time = gzip_perf_read_threaded(fp, buf, num_threads);
+		printf("%02d threads:     %8.3f s  %8.1f MB/s\n", num_threads, time, GZIP_DATA_SIZE / time / (1 << 20));
+	}
+	printf("========== ENDED %s ==========\n\n", "ReaderThreadedVsZlib");
+
+	fclose(fp);
+	MEM_freeN(buf);
+}
@@ -0,0 +1,215 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "zlib.h"
+
+#ifdef WIN32
+#  include <io.h>
+#else
+#  include <unistd.h>
+#endif
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_gzip_reader.h"
+#include "BLI_gzip_writer.h"
+#include "BLI_rand.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+#include "PIL_time.h"
+}
+
+/* Somewhat compressible data: runs of random bytes from a small alphabet. */
+static char *gzip_test_data_new(const size_t data_len)
+{
+	char *data = (char *)MEM_mallocN(data_len, __func__);
+	RNG *rng = BLI_rng_new(data_len);
+
+	for (size_t i = 0; i < data_len; ) {
+		const char c = (char)('a' + BLI_rng_get_int(rng) % 8);
+		const size_t run = MIN2(data_len - i, 1 + (size_t)(BLI_rng_get_int(rng) % 16));
+		memset(data + i, c, run);
+		i += run;
+	}
+	BLI_rng_free(rng);
+	return data;
+}
+
+/* Write data in chunks of odd sizes, so blocks are filled from several writes. */
+static void gzip_test_write_and_read(const size_t data_len, const size_t block_size, const int num_threads)
+{
+	char *data = gzip_test_data_new(data_len);
+	char *data_read = (char *)MEM_mallocN(data_len + 1, __func__);
+	FILE *fp = tmpfile();
+	ASSERT_TRUE(fp != NULL);
+
+	TaskScheduler *scheduler = BLI_task_scheduler_create(num_threads);
+	GzipWriter *gw = BLI_gzip_writer_new(fileno(fp), 1, block_size, scheduler);
+	size_t chunk_len = 1;
+	for (size_t i = 0; i < data_len; i += chunk_len) {
+		chunk_len = MIN2(data_len - i, chunk_len * 3 + 1);
+		EXPECT_TRUE(BLI_gzip_writer_write(gw, data + i, chunk_len));
+	}
+	EXPECT_TRUE(BLI_gzip_writer_free(gw));
+	BLI_task_scheduler_free(scheduler);
+
+	/* Concatenated members are read back as a single stream. */
+	lseek(fileno(fp), 0, SEEK_SET);
+	gzFile gzfile = gzdopen(dup(fileno(fp)), "rb");
+	ASSERT_TRUE(gzfile != NULL);
+	int len_read = gzread(gzfile, data_read, (unsigned int)data_len + 1);
+	gzclose(gzfile);
+
+	EXPECT_EQ(len_read, (int)data_len);
+	EXPECT_EQ(memcmp(data, data_read, data_len), 0);
+
+	/* Parallel reader, also in chunks of odd sizes. */
+	memset(data_read, 0, data_len);
+	scheduler = BLI_task_scheduler_create(num_threads);
+	GzipReader *gr = BLI_gzip_reader_new(fileno(fp), scheduler);
+	ASSERT_TRUE(gr != NULL);
+	EXPECT_EQ(BLI_gzip_reader_size(gr), data_len);
+	len_read = 0;
+	chunk_len = 1;
+	for (int len; (len = BLI_gzip_reader_read(gr, data_read + len_read, (unsigned int)chunk_len)) > 0; ) {
+		len_read += len;
+		chunk_len = chunk_len * 3 + 1;
+	}
+	BLI_gzip_reader_free(gr);
+	BLI_task_scheduler_free(scheduler);
+	fclose(fp);
+
+	EXPECT_EQ(len_read, (int)data_len);
+	EXPECT_EQ(memcmp(data, data_read, data_len), 0);
+
+	MEM_freeN(data);
+	MEM_freeN(data_read);
+}
+
+TEST(gzip_writer, Empty)
+{
+	BLI_threadapi_init();
+	gzip_test_write_and_read(0, 0, 4);
+}
+
+TEST(gzip_writer, SingleBlock)
+{
+	BLI_threadapi_init();
+	gzip_test_write_and_read(1000, 0, 4);
+}
+
+TEST(gzip_writer, ManyBlocks)
+{
+	BLI_threadapi_init();
+	/* Many more blocks than the queue can hold, with a partial last block. */
+	gzip_test_write_and_read(1000003, 4096, 4);
+}
+
+TEST(gzip_writer, ManyBlocksSingleThread)
+{
+	BLI_threadapi_init();
+	gzip_test_write_and_read(1000003, 4096, 1);
+}
+
+TEST(gzip_writer, ReaderSeek)
+{
+	const size_t data_len = 100000, block_size = 1000;
+	char *data = gzip_test_data_new(data_len);
+	char buf[3000];
+	FILE *fp = tmpfile();
+
+	BLI_threadapi_init();
+	TaskScheduler *scheduler = BLI_task_scheduler_create(4);
+
+	GzipWriter *gw = BLI_gzip_writer_new(fileno(fp), 1, block_size, scheduler);
+	BLI_gzip_writer_write(gw, data, data_len);
+	EXPECT_TRUE(BLI_gzip_writer_free(gw));
+
+	GzipReader *gr = BLI_gzip_reader_new(fileno(fp), scheduler);
+	ASSERT_TRUE(gr != NULL);
+
+	/* Forward, backward, within and across blocks. */
+	const size_t offsets[] = {50500, 99000, 10, 1000, 50600, 0, 98999};
+	for (int i = 0; i < (int)ARRAY_SIZE(offsets); i++) {
+		const size_t offset = offsets[i];
+		const int len = (int)MIN2(sizeof(buf), data_len - offset);
+		EXPECT_TRUE(BLI_gzip_reader_seek(gr, offset));
+		EXPECT_EQ(BLI_gzip_reader_read(gr, buf, sizeof(buf)), len);
+		EXPECT_EQ(memcmp(buf, data + offset, len), 0);
+	}
+
+	EXPECT_TRUE(BLI_gzip_reader_seek(gr, data_len));
+	EXPECT_EQ(BLI_gzip_reader_read(gr, buf, sizeof(buf)), 0);
+	EXPECT_FALSE(BLI_gzip_reader_seek(gr, data_len + 1));
+
+	BLI_gzip_reader_free(gr);
+	BLI_task_scheduler_free(scheduler);
+	fclose(fp);
+	MEM_freeN(data);
+}
+
+TEST(gzip_writer, ReaderSeekFreesReadAhead)
+{
+	const size_t data_len = 10000000, block_size = 10000;
+	/* Current block and the read-ahead of 4 threads, twice as much is allowed
+	 * for the tasks cached by the task pool of the reader. */
+	const size_t mem_max = 2 * (1 + 4 * 2) * block_size;
+	char *data = gzip_test_data_new(data_len);
+	char buf[500];
+	FILE *fp = tmpfile();
+
+	BLI_threadapi_init();
+	TaskScheduler *scheduler = BLI_task_scheduler_create(4);
+
+	GzipWriter *gw = BLI_gzip_writer_new(fileno(fp), 1, block_size, scheduler);
+	BLI_gzip_writer_write(gw, data, data_len);
+	EXPECT_TRUE(BLI_gzip_writer_free(gw));
+
+	GzipReader *gr = BLI_gzip_reader_new(fileno(fp), scheduler);
+	ASSERT_TRUE(gr != NULL);
+	const size_t mem_in_use = MEM_get_memory_in_use();
+
+	/* Read a few blocks at positions forward and backward, blocks read ahead
+	 * for earlier positions must not stay allocated until the reader is freed. */
+	const int regions[] = {0, 2, 4, 6, 8, 9, 7, 5, 3, 1};
+	for (int i = 0; i < (int)ARRAY_SIZE(regions); i++) {
+		const size_t offset = (size_t)regions[i] * 1000000 + 10;
+		EXPECT_TRUE(BLI_gzip_reader_seek(gr, offset));
+		for (size_t pos = offset; pos < offset + 5 * block_size; pos += sizeof(buf)) {
+			EXPECT_EQ(BLI_gzip_reader_read(gr, buf, sizeof(buf)), (int)sizeof(buf));
+			EXPECT_EQ(memcmp(buf, data + pos, sizeof(buf)), 0);
+		}
+	}
+
+	/* Read-ahead of the last position may still be running. */
+	const double time_start = PIL_check_seconds_timer();
+	while ((MEM_get_memory_in_use() - mem_in_use > mem_max) && (PIL_check_seconds_timer() - time_start < 10.0)) {
+		PIL_sleep_ms(10);
+	}
+	EXPECT_LE(MEM_get_memory_in_use() - mem_in_use, mem_max);
+
+	BLI_gzip_reader_free(gr);
+	BLI_task_scheduler_free(scheduler);
+	fclose(fp);
+	MEM_freeN(data);
+}
+
+TEST(gzip_writer, ReaderRegularGzip)
+{
+	FILE *fp = tmpfile();
+	gzFile gzfile = gzdopen(dup(fileno(fp)), "wb1");
+	gzwrite(gzfile, "data", 4);
+	gzclose(gzfile);
+
+	/* Not written by GzipWriter, caller has to use zlib. */
+	BLI_threadapi_init();
+	TaskScheduler *scheduler = BLI_task_scheduler_create(4);
+	EXPECT_TRUE(BLI_gzip_reader_new(fileno(fp), scheduler) == NULL);
+	BLI_task_scheduler_free(scheduler);
+	fclose(fp);
+}
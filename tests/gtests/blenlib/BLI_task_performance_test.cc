@@ -0,0 +1,108 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "atomic_ops.h"
+
+extern "C" {
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+#include "PIL_time.h"
+}
+
+/* Number of tasks pushed from the main thread in the flat test. */
+#define NUM_FLAT_TASKS 1000000
+
+/* Depth of the binary tree of tasks spawned from worker threads. */
+#define TREE_DEPTH 19
+
+/* Tiny tasks, so the scheduling overhead is what is being measured. */
+
+static void task_flat_func(TaskPool *__restrict pool, void *UNUSED(taskdata), int UNUSED(thread_id))
+{
+	uint32_t *count = (uint32_t *)BLI_task_pool_userdata(pool);
+	atomic_add_and_fetch_uint32(count, 1);
+}
+
+static void task_tree_func(TaskPool *__restrict pool, void *taskdata, int thread_id)
+{
+	uint32_t *count = (uint32_t *)BLI_task_pool_userdata(pool);
+	const int depth = GET_INT_FROM_POINTER(taskdata);
+
+	atomic_add_and_fetch_uint32(count, 1);
+
+	if (depth > 0) {
+		for (int i = 0; i < 2; i++) {
+			BLI_task_pool_push_from_thread(pool, task_tree_func, SET_INT_IN_POINTER(depth - 1), false,
+			                               TASK_PRIORITY_LOW, thread_id);
+		}
+	}
+}
+
+static double task_flat_run(TaskScheduler *scheduler)
+{
+	uint32_t count = 0;
+	TaskPool *pool = BLI_task_pool_create(scheduler, &count);
+
+	const double time_start = PIL_check_seconds_timer();
+	for (int i = 0; i < NUM_FLAT_TASKS; i++) {
+		BLI_task_pool_push(pool, task_flat_func, NULL, false, TASK_PRIORITY_LOW);
+	}
+	BLI_task_pool_work_and_wait(pool);
+	const double time = PIL_check_seconds_timer() - time_start;
+
+	EXPECT_EQ(count, NUM_FLAT_TASKS);
+	BLI_task_pool_free(pool);
+	return time;
+}
+
+static double task_tree_run(TaskScheduler *scheduler)
+{
+	uint32_t count = 0;
+	TaskPool *pool = BLI_task_pool_create(scheduler, &count);
+
+	const double time_start = PIL_check_seconds_timer();
+	BLI_task_pool_push(pool, task_tree_func, SET_INT_IN_POINTER(TREE_DEPTH), false, TASK_PRIORITY_LOW);
+	BLI_task_pool_work_and_wait(pool);
+	const double time = PIL_check_seconds_timer() - time_start;
+
+	EXPECT_EQ(count, (1u << (TREE_DEPTH + 1)) - 1);
+	BLI_task_pool_free(pool);
+	return time;
+}
+
+static void task_scheduler_benchmark(const char *id, double (*run)(TaskScheduler *), const int num_tasks)
+{
+	const int max_threads = MAX2(BLI_system_thread_count(), 2);
+
+	BLI_threadapi_init();
+
+	printf("\n========== STARTING %s ==========\n", id);
+	printf("Threads    Global queue (Mtasks/s)    Work stealing (Mtasks/s)\n");
+	for (int num_threads = 1; num_threads <= max_threads; num_threads++) {
+		TaskScheduler *scheduler = BLI_task_scheduler_create_ex(num_threads, 0);
+		const double time_global = run(scheduler);
+		BLI_task_scheduler_free(scheduler);
+
+		scheduler = BLI_task_scheduler_create_ex(num_threads, TASK_SCHEDULER_WORK_STEALING);
+		const double time_stealing = run(scheduler);
+		BLI_task_scheduler_free(scheduler);
+
+		printf("%02d         %10.3f                 %10.3f\n",
+		       num_threads,
+		       num_tasks / time_global * 1e-6,
+		       num_tasks / time_stealing * 1e-6);
+	}
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(task, SchedulerFlatTinyTasks)
+{
+	task_scheduler_benchmark("SchedulerFlatTinyTasks", task_flat_run, NUM_FLAT_TASKS);
+}
+
+TEST(task, SchedulerTreeTinyTasks)
+{
+	task_scheduler_benchmark("SchedulerTreeTinyTasks", task_tree_run, (1 << (TREE_DEPTH + 1)) - 1);
+}
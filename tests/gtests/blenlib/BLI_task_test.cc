@@ -5,9 +5,13 @@
 
 #include "atomic_ops.h"
 
+#include "MEM_guardedalloc.h"
+
 extern "C" {
+#include "BLI_memarena.h"
 #include "BLI_mempool.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 };
 
@@ -74,3 +78,298 @@ TEST(task, MempoolIter)
 
 	BLI_mempool_destroy(mempool);
 }
+
+/* *** Work stealing scheduler *** */
+
+#define TREE_DEPTH 12
+
+static void task_tree_func(TaskPool *__restrict pool, void *taskdata, int thread_id)
+{
+	int *count = (int *)BLI_task_pool_userdata(pool);
+	const int depth = GET_INT_FROM_POINTER(taskdata);
+
+	atomic_add_and_fetch_uint32((uint32_t *)count, 1);
+
+	if (depth > 0) {
+		/* Spawn from worker threads, so tasks end up in per-thread deques. */
+		for (int i = 0; i < 2; i++) {
+			BLI_task_pool_push_from_thread(pool, task_tree_func, SET_INT_IN_POINTER(depth - 1), false,
+			                               TASK_PRIORITY_LOW, thread_id);
+		}
+	}
+}
+
+static void task_tree_test(const int flag)
+{
+	int count = 0;
+
+	BLI_threadapi_init();
+	TaskScheduler *scheduler = BLI_task_scheduler_create_ex(4, flag);
+	TaskPool *pool = BLI_task_pool_create(scheduler, &count);
+
+	BLI_task_pool_push(pool, task_tree_func, SET_INT_IN_POINTER(TREE_DEPTH), false, TASK_PRIORITY_LOW);
+	BLI_task_pool_work_and_wait(pool);
+
+	/* All nodes of the full binary tree are to be executed exactly once. */
+	EXPECT_EQ(count, (1 << (TREE_DEPTH + 1)) - 1);
+
+	BLI_task_pool_free(pool);
+	BLI_task_scheduler_free(scheduler);
+}
+
+TEST(task, TreeSpawn)
+{
+	task_tree_test(0);
+}
+
+TEST(task, TreeSpawnWorkStealing)
+{
+	task_tree_test(TASK_SCHEDULER_WORK_STEALING);
+}
+
+/* *** Task graph *** */
+
+#define GRAPH_NUM_LAYERS 16
+#define GRAPH_LAYER_WIDTH 8
+
+static void task_graph_node_func(TaskPool *__restrict pool, void *taskdata, int UNUSED(thread_id))
+{
+	int *layer_done = (int *)BLI_task_pool_userdata(pool);
+	const int layer = GET_INT_FROM_POINTER(taskdata);
+
+	/* All nodes of the previous layer are to be finished already. */
+	if (layer > 0) {
+		EXPECT_EQ(layer_done[layer - 1], GRAPH_LAYER_WIDTH);
+	}
+	atomic_add_and_fetch_uint32((uint32_t *)&layer_done[layer], 1);
+}
+
+static void task_graph_test(const int flag)
+{
+	TaskNode *nodes[GRAPH_NUM_LAYERS][GRAPH_LAYER_WIDTH];
+
+	BLI_threadapi_init();
+	TaskScheduler *scheduler = BLI_task_scheduler_create_ex(4, flag);
+	TaskGraph *graph = BLI_task_graph_create();
+
+	for (int layer = 0; layer < GRAPH_NUM_LAYERS; layer++) {
+		for (int i = 0; i < GRAPH_LAYER_WIDTH; i++) {
+			nodes[layer][i] = BLI_task_graph_node_create(graph, task_graph_node_func,
+			                                             SET_INT_IN_POINTER(layer), NULL);
+			if (layer > 0) {
+				for (int j = 0; j < GRAPH_LAYER_WIDTH; j++) {
+					BLI_task_graph_edge_create(graph, nodes[layer - 1][j], nodes[layer][i]);
+				}
+			}
+		}
+	}
+
+	/* Graph is to be re-usable without re-creation. */
+	for (int run = 0; run < 3; run++) {
+		int layer_done[GRAPH_NUM_LAYERS] = {0};
+		BLI_task_graph_work_and_wait(graph, scheduler, layer_done);
+		for (int layer = 0; layer < GRAPH_NUM_LAYERS; layer++) {
+			EXPECT_EQ(layer_done[layer], GRAPH_LAYER_WIDTH);
+		}
+	}
+
+	BLI_task_graph_free(graph);
+	BLI_task_scheduler_free(scheduler);
+}
+
+TEST(task, Graph)
+{
+	task_graph_test(0);
+}
+
+TEST(task, GraphWorkStealing)
+{
+	task_graph_test(TASK_SCHEDULER_WORK_STEALING);
+}
+
+/* *** Parallel range *** */
+
+#define RANGE_NUM_ITEMS 100000
+
+static void task_range_sum_func(void *__restrict UNUSED(userdata),
+                                const int iter,
+                                const ParallelRangeTLS *__restrict tls)
+{
+	int64_t *sum = (int64_t *)tls->userdata_chunk;
+	*sum += iter;
+}
+
+static void task_range_sum_reduce(void *__restrict UNUSED(userdata),
+                                  void *__restrict chunk_join,
+                                  void *__restrict chunk)
+{
+	*(int64_t *)chunk_join += *(int64_t *)chunk;
+}
+
+static void task_range_sum_test(const eTaskSchedulingMode scheduling_mode, const bool use_threading)
+{
+	int64_t sum = 0;
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = use_threading;
+	settings.scheduling_mode = scheduling_mode;
+	settings.userdata_chunk = &sum;
+	settings.userdata_chunk_size = sizeof(sum);
+	settings.func_reduce = task_range_sum_reduce;
+
+	BLI_task_parallel_range(0, RANGE_NUM_ITEMS, NULL, task_range_sum_func, &settings);
+
+	EXPECT_EQ(sum, (int64_t)RANGE_NUM_ITEMS * (RANGE_NUM_ITEMS - 1) / 2);
+}
+
+TEST(task, RangeReduce)
+{
+	task_range_sum_test(TASK_SCHEDULING_STATIC, false);
+	task_range_sum_test(TASK_SCHEDULING_STATIC, true);
+	task_range_sum_test(TASK_SCHEDULING_DYNAMIC, true);
+	task_range_sum_test(TASK_SCHEDULING_GUIDED, true);
+}
+
+/* *** Thread local allocators *** */
+
+#define LOCAL_NUM_THREADS 8
+#define LOCAL_NUM_ITEMS_PER_TASK 20000
+
+static void task_mempool_local_func(TaskPool *__restrict pool, void *taskdata, int UNUSED(thread_id))
+{
+	BLI_mempool_local local = *(BLI_mempool_local *)BLI_task_pool_userdata(pool);
+	const int task_index = GET_INT_FROM_POINTER(taskdata);
+	int **items = (int **)MEM_mallocN(sizeof(*items) * LOCAL_NUM_ITEMS_PER_TASK, __func__);
+
+	for (int i = 0; i < LOCAL_NUM_ITEMS_PER_TASK; i++) {
+		items[i] = (int *)BLI_mempool_local_alloc(&local);
+		items[i][0] = task_index;
+		items[i][1] = i;
+		/* Free some, so elements also go back and forth between threads and the pool. */
+		if ((i % 3) == 0) {
+			BLI_mempool_local_free(&local, items[i / 3]);
+			items[i / 3] = NULL;
+		}
+	}
+	for (int i = 0; i < LOCAL_NUM_ITEMS_PER_TASK; i++) {
+		if (items[i] != NULL) {
+			EXPECT_EQ(items[i][0], task_index);
+			EXPECT_EQ(items[i][1], i);
+		}
+	}
+
+	BLI_mempool_local_flush(&local);
+	MEM_freeN(items);
+}
+
+TEST(task, MempoolLocal)
+{
+	BLI_mempool *mempool = BLI_mempool_create(sizeof(int[4]), 0, 512,
+	                                           BLI_MEMPOOL_ALLOW_ITER | BLI_MEMPOOL_ALLOW_LOCAL);
+	BLI_mempool_local local;
+	int count[LOCAL_NUM_THREADS] = {0};
+	int *item;
+
+	BLI_threadapi_init();
+	BLI_mempool_local_init(mempool, &local);
+
+	TaskScheduler *scheduler = BLI_task_scheduler_create(LOCAL_NUM_THREADS);
+	TaskPool *task_pool = BLI_task_pool_create(scheduler, &local);
+	for (int i = 0; i < LOCAL_NUM_THREADS; i++) {
+		BLI_task_pool_push(task_pool, task_mempool_local_func, SET_INT_IN_POINTER(i), false, TASK_PRIORITY_HIGH);
+	}
+	BLI_task_pool_work_and_wait(task_pool);
+	BLI_task_pool_free(task_pool);
+	BLI_task_scheduler_free(scheduler);
+
+	/* Each task frees a third of its elements. */
+	const int num_items_per_task = LOCAL_NUM_ITEMS_PER_TASK - (LOCAL_NUM_ITEMS_PER_TASK + 2) / 3;
+	EXPECT_EQ(BLI_mempool_len(mempool), num_items_per_task * LOCAL_NUM_THREADS);
+
+	BLI_mempool_iter iter;
+	BLI_mempool_iternew(mempool, &iter);
+	while ((item = (int *)BLI_mempool_iterstep(&iter))) {
+		EXPECT_TRUE(item[0] >= 0 && item[0] < LOCAL_NUM_THREADS);
+		count[item[0]]++;
+	}
+	for (int i = 0; i < LOCAL_NUM_THREADS; i++) {
+		EXPECT_EQ(count[i], num_items_per_task);
+	}
+
+	/* Regular API must work again. */
+	item = (int *)BLI_mempool_alloc(mempool);
+	BLI_mempool_free(mempool, item);
+
+	BLI_mempool_destroy(mempool);
+}
+
+typedef struct ArenaChunk {
+	MemArena *arena;
+	int num_items;
+} ArenaChunk;
+
+static void task_memarena_func(void *__restrict userdata,
+                               const int iter,
+                               const ParallelRangeTLS *__restrict tls)
+{
+	ArenaChunk *chunk = (ArenaChunk *)tls->userdata_chunk;
+	int **items = (int **)userdata;
+
+	if (chunk->arena == NULL) {
+		chunk->arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
+	}
+	items[iter] = (int *)BLI_memarena_alloc(chunk->arena, sizeof(int) * (1 + iter % 7));
+	items[iter][0] = iter;
+	chunk->num_items++;
+}
+
+static void task_memarena_reduce(void *__restrict UNUSED(userdata),
+                                 void *__restrict chunk_join,
+                                 void *__restrict chunk)
+{
+	ArenaChunk *join = (ArenaChunk *)chunk_join;
+	ArenaChunk *other = (ArenaChunk *)chunk;
+
+	if (other->arena != NULL) {
+		if (join->arena == NULL) {
+			join->arena = other->arena;
+		}
+		else {
+			BLI_memarena_merge(join->arena, other->arena);
+			BLI_memarena_free(other->arena);
+		}
+		other->arena = NULL;
+	}
+	join->num_items += other->num_items;
+}
+
+TEST(task, MemArenaMerge)
+{
+	int **items = (int **)MEM_mallocN(sizeof(*items) * RANGE_NUM_ITEMS, __func__);
+	ArenaChunk chunk = {NULL, 0};
+
+	BLI_threadapi_init();
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = true;
+	settings.userdata_chunk = &chunk;
+	settings.userdata_chunk_size = sizeof(chunk);
+	settings.func_reduce = task_memarena_reduce;
+
+	BLI_task_parallel_range(0, RANGE_NUM_ITEMS, items, task_memarena_func, &settings);
+
+	EXPECT_EQ(chunk.num_items, RANGE_NUM_ITEMS);
+	ASSERT_TRUE(chunk.arena != NULL);
+
+	/* All memory is now owned by the merged arena. */
+	for (int i = 0; i < RANGE_NUM_ITEMS; i++) {
+		EXPECT_EQ(items[i][0], i);
+	}
+	void *extra = BLI_memarena_alloc(chunk.arena, 64);
+	EXPECT_TRUE(extra != NULL);
+
+	BLI_memarena_free(chunk.arena);
+	MEM_freeN(items);
+}
@@ -0,0 +1,119 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_rand.h"
+#include "PIL_time.h"
+#include "oldnewmap.h"
+}
+
+/* Number of random lookups done with the linear search, it doesn't scale to all blocks. */
+#define LINEAR_LOOKUP_MAX 10000
+
+/* Block layout of a synthetic file: unique old addresses, the order blocks are written in. */
+static const void **oldnewmap_perf_addresses_new(const int num, RNG *rng)
+{
+	const void **addrs = (const void **)MEM_malloc_arrayN(num, sizeof(*addrs), __func__);
+	uintptr_t addr = 0x7f0000000000;
+
+	for (int i = 0; i < num; i++) {
+		/* Allocations of varying size, as in a written file. */
+		addr += 16 * (1 + (uintptr_t)(BLI_rng_get_int(rng) % 64));
+		addrs[i] = (const void *)addr;
+	}
+	return addrs;
+}
+
+/* Previous implementation: search from the last hit, forwards then backwards. */
+static int linear_lookup(const OldNewMap *onm, const void *addr, int *lasthit)
+{
+	const OldNew *entries = onm->entries;
+	int i = *lasthit + 1;
+
+	if (i < onm->nentries && entries[i].old == addr) {
+		return (*lasthit = i);
+	}
+	while (++i < onm->nentries) {
+		if (entries[i].old == addr) {
+			return (*lasthit = i);
+		}
+	}
+	for (i = MIN2(*lasthit + 1, onm->nentries); i--; ) {
+		if (entries[i].old == addr) {
+			return (*lasthit = i);
+		}
+	}
+	return -1;
+}
+
+static void oldnewmap_perf_run(const int num)
+{
+	RNG *rng = BLI_rng_new(num);
+	const void **addrs = oldnewmap_perf_addresses_new(num, rng);
+	const void **addrs_random = (const void **)MEM_dupallocN(addrs);
+	int *data = (int *)MEM_malloc_arrayN(num, sizeof(int), __func__);
+	const int num_linear = MIN2(num, LINEAR_LOOKUP_MAX);
+	double time_start, time_insert, time_seq, time_random, time_linear_seq, time_linear_random;
+	int lasthit = 0, found = 0;
+
+	/* Lookups in random order, like library linking of a large scene. */
+	BLI_rng_shuffle_array(rng, addrs_random, sizeof(*addrs_random), (unsigned int)num);
+
+	OldNewMap *onm = blo_oldnewmap_new();
+
+	time_start = PIL_check_seconds_timer();
+	blo_oldnewmap_reserve(onm, num);
+	for (int i = 0; i < num; i++) {
+		blo_oldnewmap_insert(onm, addrs[i], &data[i], 0);
+	}
+	time_insert = PIL_check_seconds_timer() - time_start;
+
+	time_start = PIL_check_seconds_timer();
+	for (int i = 0; i < num; i++) {
+		found += blo_oldnewmap_lookup_and_inc(onm, addrs[i], true) != NULL;
+	}
+	time_seq = PIL_check_seconds_timer() - time_start;
+
+	time_start = PIL_check_seconds_timer();
+	for (int i = 0; i < num; i++) {
+		found += blo_oldnewmap_lookup_and_inc(onm, addrs_random[i], true) != NULL;
+	}
+	time_random = PIL_check_seconds_timer() - time_start;
+	EXPECT_EQ(found, num * 2);
+
+	time_start = PIL_check_seconds_timer();
+	for (int i = 0; i < num; i++) {
+		found += linear_lookup(onm, addrs[i], &lasthit) != -1;
+	}
+	time_linear_seq = PIL_check_seconds_timer() - time_start;
+
+	time_start = PIL_check_seconds_timer();
+	for (int i = 0; i < num_linear; i++) {
+		found += linear_lookup(onm, addrs_random[i], &lasthit) != -1;
+	}
+	time_linear_random = PIL_check_seconds_timer() - time_start;
+	EXPECT_EQ(found, num * 3 + num_linear);
+
+	printf("%7d blocks: insert %7.4f s\n", num, time_insert);
+	printf("    hash:   sequential %7.4f s, random %7.4f s\n", time_seq, time_random);
+	printf("    linear: sequential %7.4f s, random %7.4f s (%d lookups, %.4f s for all)\n",
+	       time_linear_seq, time_linear_random, num_linear, time_linear_random * num / num_linear);
+
+	blo_oldnewmap_free(onm);
+	MEM_freeN(data);
+	MEM_freeN(addrs_random);
+	MEM_freeN(addrs);
+	BLI_rng_free(rng);
+}
+
+TEST(oldnewmap, HashVsLinear)
+{
+	printf("\n========== STARTING %s ==========\n", "HashVsLinear");
+	oldnewmap_perf_run(10000);
+	oldnewmap_perf_run(100000);
+	oldnewmap_perf_run(500000);
+	printf("========== ENDED %s ==========\n\n", "HashVsLinear");
+}
@@ -0,0 +1,127 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "oldnewmap.h"
+}
+
+/* Fake old addresses, aligned like pointers written to a file. */
+#define OLD_ADDR(i) ((const void *)(uintptr_t)(0x10000 + (uintptr_t)(i) * 16))
+
+TEST(oldnewmap, InsertLookup)
+{
+	OldNewMap *onm = blo_oldnewmap_new();
+	const int num = 100000;
+	int *data = (int *)MEM_malloc_arrayN(num, sizeof(int), __func__);
+
+	for (int i = 0; i < num; i++) {
+		blo_oldnewmap_insert(onm, OLD_ADDR(i), &data[i], 0);
+	}
+	EXPECT_EQ(onm->nentries, num);
+
+	/* Entries keep insertion order. */
+	for (int i = 0; i < num; i++) {
+		EXPECT_EQ(onm->entries[i].old, OLD_ADDR(i));
+	}
+
+	for (int i = num - 1; i >= 0; i -= 7) {
+		EXPECT_EQ(blo_oldnewmap_lookup_and_inc(onm, OLD_ADDR(i), true), &data[i]);
+		EXPECT_EQ(blo_oldnewmap_lookup_entry(onm, OLD_ADDR(i))->nr, 1);
+	}
+	EXPECT_EQ(blo_oldnewmap_lookup_and_inc(onm, OLD_ADDR(num), true), (void *)NULL);
+	EXPECT_EQ(blo_oldnewmap_lookup_and_inc(onm, NULL, true), (void *)NULL);
+
+	blo_oldnewmap_free(onm);
+	MEM_freeN(data);
+}
+
+TEST(oldnewmap, NullIgnored)
+{
+	OldNewMap *onm = blo_oldnewmap_new();
+	int data;
+
+	blo_oldnewmap_insert(onm, NULL, &data, 0);
+	blo_oldnewmap_insert(onm, OLD_ADDR(1), NULL, 0);
+	EXPECT_EQ(onm->nentries, 0);
+
+	blo_oldnewmap_free(onm);
+}
+
+TEST(oldnewmap, Duplicate)
+{
+	OldNewMap *onm = blo_oldnewmap_new();
+	int data[2];
+
+	/* The latest entry is found, both are kept. */
+	blo_oldnewmap_insert(onm, OLD_ADDR(1), &data[0], 0);
+	blo_oldnewmap_insert(onm, OLD_ADDR(1), &data[1], 0);
+	EXPECT_EQ(onm->nentries, 2);
+	EXPECT_EQ(blo_oldnewmap_lookup_and_inc(onm, OLD_ADDR(1), false), &data[1]);
+
+	blo_oldnewmap_free(onm);
+}
+
+TEST(oldnewmap, ReserveClear)
+{
+	OldNewMap *onm = blo_oldnewmap_new();
+	int data[3];
+
+	blo_oldnewmap_insert(onm, OLD_ADDR(1), &data[0], 0);
+	blo_oldnewmap_reserve(onm, 50000);
+	EXPECT_GE(onm->entriessize, 50000);
+	EXPECT_EQ(blo_oldnewmap_lookup_and_inc(onm, OLD_ADDR(1), false), &data[0]);
+
+	blo_oldnewmap_insert(onm, OLD_ADDR(2), &data[1], 0);
+	blo_oldnewmap_clear(onm);
+	EXPECT_EQ(onm->nentries, 0);
+	EXPECT_EQ(blo_oldnewmap_lookup_and_inc(onm, OLD_ADDR(1), false), (void *)NULL);
+	EXPECT_EQ(blo_oldnewmap_lookup_and_inc(onm, OLD_ADDR(2), false), (void *)NULL);
+
+	blo_oldnewmap_insert(onm, OLD_ADDR(2), &data[2], 0);
+	EXPECT_EQ(blo_oldnewmap_lookup_and_inc(onm, OLD_ADDR(2), false), &data[2]);
+
+	blo_oldnewmap_free(onm);
+}
+
+TEST(oldnewmap, ClearUsedSlots)
+{
+	OldNewMap *onm = blo_oldnewmap_new();
+	const int num = 1000;
+	int data;
+
+	/* Enough entries for many collisions, without growing the table. */
+	for (int pass = 0; pass < 2; pass++) {
+		for (int i = 0; i < num; i++) {
+			blo_oldnewmap_insert(onm, OLD_ADDR(i * 3 + pass), &data, 0);
+		}
+		if (pass == 1) {
+			blo_oldnewmap_insert(onm, OLD_ADDR(1), &data, 0);
+		}
+		blo_oldnewmap_clear(onm);
+
+		for (int slot = 0; slot < (1 << onm->map_bit); slot++) {
+			EXPECT_EQ(onm->map[slot], -1);
+		}
+	}
+
+	blo_oldnewmap_free(onm);
+}
+
+TEST(oldnewmap, FreeUnused)
+{
+	OldNewMap *onm = blo_oldnewmap_new();
+
+	blo_oldnewmap_insert(onm, OLD_ADDR(1), MEM_mallocN(4, __func__), 0);
+	blo_oldnewmap_insert(onm, OLD_ADDR(2), MEM_mallocN(4, __func__), 0);
+	void *used = blo_oldnewmap_lookup_and_inc(onm, OLD_ADDR(2), true);
+
+	blo_oldnewmap_free_unused(onm);
+	EXPECT_EQ(onm->entries[0].newp, (void *)NULL);
+	EXPECT_EQ(onm->entries[1].newp, used);
+
+	MEM_freeN(used);
+	blo_oldnewmap_free(onm);
+}
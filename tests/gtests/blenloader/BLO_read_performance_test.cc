@@ -0,0 +1,75 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_string.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_blender.h"
+#include "BKE_global.h"
+#include "BKE_modifier.h"
+#include "BKE_node.h"
+
+#include "BLO_readfile.h"
+
+#include "DNA_genfile.h"
+
+#include "RNA_define.h"
+
+#include "PIL_time.h"
+}
+
+/* Files which are shipped with Blender, see BLENDER_SOURCE_DIR in CMakeLists.txt. */
+#define DATAFILES_DIR BLENDER_SOURCE_DIR "/release/datafiles/"
+
+#define READ_REPEAT 20
+
+static void read_blend_perf(const char *filename)
+{
+	char filepath[1024];
+	double time_min = 0.0, time_total = 0.0;
+
+	BLI_snprintf(filepath, sizeof(filepath), "%s%s", DATAFILES_DIR, filename);
+
+	for (int i = 0; i < READ_REPEAT; i++) {
+		const double time_start = PIL_check_seconds_timer();
+		BlendFileData *bfd = BLO_read_from_file(filepath, NULL, BLO_READ_SKIP_NONE);
+		const double time = PIL_check_seconds_timer() - time_start;
+
+		ASSERT_TRUE(bfd != NULL) << filepath;
+		BLO_blendfiledata_free(bfd);
+
+		time_min = (i == 0) ? time : MIN2(time_min, time);
+		time_total += time;
+	}
+
+	printf("%-24s best %.4f s, average %.4f s\n", filename, time_min, time_total / READ_REPEAT);
+}
+
+TEST(blo_read, DataFiles)
+{
+	BLI_threadapi_init();
+	DNA_sdna_current_init();
+	BKE_blender_globals_init();
+	BKE_modifier_init();
+	RNA_init();
+	/* Reading node trees looks up their types. */
+	init_nodesystem();
+
+	printf("\n========== STARTING %s ==========\n", "DataFiles");
+
+	read_blend_perf("startup.blend");
+	read_blend_perf("workspaces.blend");
+	read_blend_perf("preview.blend");
+	read_blend_perf("preview_cycles.blend");
+
+	printf("========== ENDED %s ==========\n\n", "DataFiles");
+
+	free_nodesystem();
+	RNA_exit();
+	BKE_blender_globals_clear();
+	DNA_sdna_current_free();
+	BLI_threadapi_exit();
+}
@@ -0,0 +1,188 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "COM_FFTConvolution.h"
+#include "COM_FastGaussianBlurOperation.h"
+#include "COM_MemoryBuffer.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "BLI_rect.h"
+#include "PIL_time.h"
+}
+
+/* Same frame and radii as the --sweep of tests/python/compositor_benchmark.py. */
+#define FRAME_WIDTH 1920
+#define FRAME_HEIGHT 1080
+
+/* The direct kernels take minutes for the largest radii,
+ * they are timed on rows in the middle of the frame and scaled to the whole frame. */
+#define DIRECT_ROWS 4
+
+static MemoryBuffer *frame_new(RNG *rng)
+{
+	rcti rect;
+	BLI_rcti_init(&rect, 0, FRAME_WIDTH, 0, FRAME_HEIGHT);
+	MemoryBuffer *frame = new MemoryBuffer(COM_DT_COLOR, &rect);
+	float *buffer = frame->getBuffer();
+	for (int i = 0; i < FRAME_WIDTH * FRAME_HEIGHT * COM_NUM_CHANNELS_COLOR; i++) {
+		buffer[i] = BLI_rng_get_float(rng);
+	}
+	return frame;
+}
+
+/* Gaussian ending at three times sigma, see RE_filter_value. */
+static float gauss_weight(float x, float radius)
+{
+	const float sigma = radius / 3.0f;
+	return expf(-0.5f * (x * x) / (sigma * sigma));
+}
+
+/* The 2D kernel of GaussianBokehBlurOperation. */
+static float *gausstab_2d_new(int radius)
+{
+	const int size = 2 * radius + 1;
+	float *gausstab = (float *)MEM_malloc_arrayN(size * size, sizeof(float), __func__);
+	for (int j = 0; j < size; j++) {
+		for (int i = 0; i < size; i++) {
+			const float dx = i - radius, dy = j - radius;
+			gausstab[j * size + i] = gauss_weight(sqrtf(dx * dx + dy * dy), radius);
+		}
+	}
+	return gausstab;
+}
+
+/* Direct 2D kernel, like GaussianBokehBlurOperation::executePixel. */
+static void blur_direct_2d(MemoryBuffer *output, MemoryBuffer *input, const float *gausstab,
+                           int radius, int ymin, int ymax)
+{
+	const int size = 2 * radius + 1;
+	const float *buffer = input->getBuffer();
+
+	for (int y = ymin; y < ymax; y++) {
+		for (int x = 0; x < FRAME_WIDTH; x++) {
+			float accum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			float multiplier_accum = 0.0f;
+			const int nymin = max_ii(y - radius, 0), nymax = min_ii(y + radius + 1, FRAME_HEIGHT);
+			const int nxmin = max_ii(x - radius, 0), nxmax = min_ii(x + radius + 1, FRAME_WIDTH);
+			for (int ny = nymin; ny < nymax; ny++) {
+				const float *row = &gausstab[(ny - y + radius) * size - x + radius];
+				const float *color = &buffer[(ny * FRAME_WIDTH + nxmin) * 4];
+				for (int nx = nxmin; nx < nxmax; nx++, color += 4) {
+					const float multiplier = row[nx];
+					madd_v4_v4fl(accum, color, multiplier);
+					multiplier_accum += multiplier;
+				}
+			}
+			mul_v4_v4fl(output->getElem(x, y), accum, 1.0f / multiplier_accum);
+		}
+	}
+}
+
+/* Direct X pass, like GaussianXBlurOperation::executePixel. */
+static void blur_direct_x(MemoryBuffer *output, MemoryBuffer *input, const float *gausstab,
+                          int radius, int ymin, int ymax)
+{
+	for (int y = ymin; y < ymax; y++) {
+		for (int x = 0; x < FRAME_WIDTH; x++) {
+			float accum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			float multiplier_accum = 0.0f;
+			const int nxmin = max_ii(x - radius, 0), nxmax = min_ii(x + radius + 1, FRAME_WIDTH);
+			for (int nx = nxmin; nx < nxmax; nx++) {
+				const float multiplier = gausstab[nx - x + radius];
+				madd_v4_v4fl(accum, input->getElem(nx, y), multiplier);
+				multiplier_accum += multiplier;
+			}
+			mul_v4_v4fl(output->getElem(x, y), accum, 1.0f / multiplier_accum);
+		}
+	}
+}
+
+/* Direct Y pass, like GaussianYBlurOperation::executePixel. */
+static void blur_direct_y(MemoryBuffer *output, MemoryBuffer *input, const float *gausstab,
+                          int radius, int ymin, int ymax)
+{
+	for (int y = ymin; y < ymax; y++) {
+		for (int x = 0; x < FRAME_WIDTH; x++) {
+			float accum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+			float multiplier_accum = 0.0f;
+			const int nymin = max_ii(y - radius, 0), nymax = min_ii(y + radius + 1, FRAME_HEIGHT);
+			for (int ny = nymin; ny < nymax; ny++) {
+				const float multiplier = gausstab[ny - y + radius];
+				madd_v4_v4fl(accum, input->getElem(x, ny), multiplier);
+				multiplier_accum += multiplier;
+			}
+			mul_v4_v4fl(output->getElem(x, y), accum, 1.0f / multiplier_accum);
+		}
+	}
+}
+
+static void blur_perf(int radius)
+{
+	RNG *rng = BLI_rng_new(0);
+	MemoryBuffer *input = frame_new(rng);
+	MemoryBuffer *output = frame_new(rng);
+	MemoryBuffer *temp = frame_new(rng);
+	const int size = 2 * radius + 1;
+	const int ymin = (FRAME_HEIGHT - DIRECT_ROWS) / 2;
+	const double direct_scale = (double)FRAME_HEIGHT / DIRECT_ROWS;
+	double time_start;
+
+	float *gausstab = (float *)MEM_malloc_arrayN(size, sizeof(float), __func__);
+	for (int i = 0; i < size; i++) {
+		gausstab[i] = gauss_weight(i - radius, radius);
+	}
+	float *gausstab_2d = gausstab_2d_new(radius);
+
+	time_start = PIL_check_seconds_timer();
+	blur_direct_2d(output, input, gausstab_2d, radius, ymin, ymin + DIRECT_ROWS);
+	const double time_direct_2d = (PIL_check_seconds_timer() - time_start) * direct_scale;
+
+	time_start = PIL_check_seconds_timer();
+	FFTConvolution::convolve(output, input, COM_NUM_CHANNELS_COLOR,
+	                         gausstab_2d, size, size, 1, radius, radius, true);
+	const double time_fft = PIL_check_seconds_timer() - time_start;
+
+	/* The Y pass reads the X pass of the rows around the timed ones. */
+	blur_direct_x(temp, input, gausstab, radius,
+	              max_ii(ymin - radius, 0), min_ii(ymin + DIRECT_ROWS + radius, FRAME_HEIGHT));
+	time_start = PIL_check_seconds_timer();
+	blur_direct_x(temp, input, gausstab, radius, ymin, ymin + DIRECT_ROWS);
+	blur_direct_y(output, temp, gausstab, radius, ymin, ymin + DIRECT_ROWS);
+	const double time_direct_separable = (PIL_check_seconds_timer() - time_start) * direct_scale;
+
+	time_start = PIL_check_seconds_timer();
+	MemoryBuffer *iir = input->duplicate();
+	FastGaussianBlurOperation::IIR_gauss_normalized(iir, radius / 3.0f, 3);
+	const double time_iir = PIL_check_seconds_timer() - time_start;
+
+	printf("radius %3d: 2D direct %8.2f s, FFT %6.2f s (%6.1fx), "
+	       "separable direct %6.2f s, IIR %5.2f s (%5.1fx)%s\n",
+	       radius, time_direct_2d, time_fft, time_direct_2d / time_fft,
+	       time_direct_separable, time_iir, time_direct_separable / time_iir,
+	       FFTConvolution::isEfficient(size, size) ? "" : " (FFT not used)");
+
+	MEM_freeN(gausstab);
+	MEM_freeN(gausstab_2d);
+	delete iir;
+	delete input;
+	delete output;
+	delete temp;
+	BLI_rng_free(rng);
+}
+
+TEST(compositor_blur, GaussianSweep)
+{
+	printf("\n========== STARTING %s ==========\n", "GaussianSweep");
+	printf("direct kernels timed on %d rows and scaled to %dx%d\n",
+	       DIRECT_ROWS, FRAME_WIDTH, FRAME_HEIGHT);
+
+	for (int radius = 16; radius <= 512; radius *= 2) {
+		blur_perf(radius);
+	}
+
+	printf("========== ENDED %s ==========\n\n", "GaussianSweep");
+}
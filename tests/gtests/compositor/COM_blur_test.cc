@@ -0,0 +1,234 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "COM_FFTConvolution.h"
+#include "COM_FastGaussianBlurOperation.h"
+#include "COM_MemoryBuffer.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+#include "BLI_rect.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+}
+
+/* FFTConvolution::convolve transforms blocks in parallel when there are at least 8 blocks per
+ * thread, otherwise it transforms the rows and columns of each block in parallel. The number of
+ * threads is fixed, so the image and kernel sizes below decide which of both is tested. */
+#define NUM_THREADS 4
+
+/* Value written to the channels which are not convolved. */
+#define UNTOUCHED -7.0f
+
+static void blur_test_init()
+{
+	/* Only has effect before the global task scheduler is created. */
+	BLI_system_num_threads_override_set(NUM_THREADS);
+	BLI_threadapi_init();
+	ASSERT_EQ(BLI_task_scheduler_num_threads(BLI_task_scheduler_get()), NUM_THREADS);
+}
+
+static MemoryBuffer *buffer_new(int width, int height, RNG *rng)
+{
+	rcti rect;
+	BLI_rcti_init(&rect, 0, width, 0, height);
+	MemoryBuffer *buffer = new MemoryBuffer(COM_DT_COLOR, &rect);
+	float *data = buffer->getBuffer();
+	for (int i = 0; i < width * height * COM_NUM_CHANNELS_COLOR; i++) {
+		data[i] = rng ? BLI_rng_get_float(rng) : UNTOUCHED;
+	}
+	return buffer;
+}
+
+/* output(x, y) = sum(kernel(i, j) * input(x + i - center_x, y + j - center_y)) over the pixels
+ * inside the input, divided by the sum of their weights when normalizing. */
+static void convolve_direct(MemoryBuffer *output, MemoryBuffer *input, int num_channels,
+                            const float *kernel, int kernel_width, int kernel_height, int kernel_channels,
+                            int center_x, int center_y, bool normalize)
+{
+	const int width = input->getWidth(), height = input->getHeight();
+
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			for (int ch = 0; ch < num_channels; ch++) {
+				const int kernel_ch = (kernel_channels == 1) ? 0 : ch;
+				double sum = 0.0, weight_sum = 0.0;
+				for (int j = 0; j < kernel_height; j++) {
+					const int yy = y + j - center_y;
+					if (yy < 0 || yy >= height) {
+						continue;
+					}
+					for (int i = 0; i < kernel_width; i++) {
+						const int xx = x + i - center_x;
+						if (xx < 0 || xx >= width) {
+							continue;
+						}
+						const float weight = kernel[(j * kernel_width + i) * kernel_channels + kernel_ch];
+						sum += (double)weight * input->getElem(xx, yy)[ch];
+						weight_sum += weight;
+					}
+				}
+				output->getElem(x, y)[ch] = (float)((normalize && weight_sum != 0.0) ? sum / weight_sum : sum);
+			}
+		}
+	}
+}
+
+static void fft_convolution_test(int width, int height, int kernel_width, int kernel_height, int kernel_channels,
+                                 int center_x, int center_y, bool normalize)
+{
+	/* Leave the alpha channel out, it must not be written. */
+	const int num_channels = 3;
+	RNG *rng = BLI_rng_new(width * height + kernel_width);
+	MemoryBuffer *input = buffer_new(width, height, rng);
+	MemoryBuffer *expected = buffer_new(width, height, NULL);
+	MemoryBuffer *result = buffer_new(width, height, NULL);
+
+	const int kernel_len = kernel_width * kernel_height * kernel_channels;
+	float *kernel = (float *)MEM_malloc_arrayN(kernel_len, sizeof(float), __func__);
+	double kernel_sum = 0.0;
+	for (int i = 0; i < kernel_len; i++) {
+		/* Positive weights, so normalizing never divides by (almost) zero. */
+		kernel[i] = 0.25f + BLI_rng_get_float(rng);
+		kernel_sum += kernel[i];
+	}
+
+	convolve_direct(expected, input, num_channels, kernel, kernel_width, kernel_height, kernel_channels,
+	                center_x, center_y, normalize);
+	FFTConvolution::convolve(result, input, num_channels, kernel, kernel_width, kernel_height, kernel_channels,
+	                         center_x, center_y, normalize);
+
+	/* Single precision transforms, the error grows with the sum of the weights. */
+	const float tolerance = normalize ? 1e-5f : 1e-6f * (float)(kernel_sum / kernel_channels);
+	for (int y = 0; y < height && !::testing::Test::HasFailure(); y++) {
+		for (int x = 0; x < width; x++) {
+			const float *expected_elem = expected->getElem(x, y);
+			const float *result_elem = result->getElem(x, y);
+			for (int ch = 0; ch < num_channels; ch++) {
+				EXPECT_NEAR(expected_elem[ch], result_elem[ch], tolerance) << "at " << x << ", " << y << " channel " << ch;
+			}
+			EXPECT_EQ(result_elem[3], UNTOUCHED) << "at " << x << ", " << y;
+		}
+	}
+
+	MEM_freeN(kernel);
+	delete input;
+	delete expected;
+	delete result;
+	BLI_rng_free(rng);
+}
+
+/* 45x23 image and 33x17 kernel: a single 128x64 block, its rows and columns are transformed in parallel. */
+TEST(compositor_blur, FFTConvolutionSingleBlock)
+{
+	blur_test_init();
+	fft_convolution_test(45, 23, 33, 17, 1, 5, 11, false);
+	fft_convolution_test(45, 23, 33, 17, 1, 5, 11, true);
+}
+
+/* 61x37 image and 9x7 kernel: 3x4 blocks of 24x10 pixels, too few to transform them in parallel. */
+TEST(compositor_blur, FFTConvolutionBlocks)
+{
+	blur_test_init();
+	fft_convolution_test(61, 37, 9, 7, 1, 2, 5, false);
+	fft_convolution_test(61, 37, 9, 7, 1, 2, 5, true);
+}
+
+/* 61x37 image and 5x3 kernel: 6x7 blocks of 12x6 pixels, transformed in parallel.
+ * Also uses a kernel with different weights per channel. */
+TEST(compositor_blur, FFTConvolutionThreadedBlocks)
+{
+	blur_test_init();
+	fft_convolution_test(61, 37, 5, 3, 1, 3, 0, false);
+	fft_convolution_test(61, 37, 5, 3, 1, 3, 0, true);
+	fft_convolution_test(61, 37, 5, 3, COM_NUM_CHANNELS_COLOR, 4, 2, false);
+	fft_convolution_test(61, 37, 5, 3, COM_NUM_CHANNELS_COLOR, 4, 2, true);
+}
+
+/* Direct gaussian blur of one direction, normalized with the weights inside the image
+ * like the X and Y passes of the regular gaussian blur. */
+static void gauss_direct(MemoryBuffer *output, MemoryBuffer *input, float sigma, bool horizontal)
+{
+	const int width = input->getWidth(), height = input->getHeight();
+	const int radius = (int)ceilf(4.0f * sigma);
+
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			double sum[4] = {0.0, 0.0, 0.0, 0.0}, weight_sum = 0.0;
+			for (int i = -radius; i <= radius; i++) {
+				const int xx = horizontal ? x + i : x, yy = horizontal ? y : y + i;
+				if (xx < 0 || xx >= width || yy < 0 || yy >= height) {
+					continue;
+				}
+				const double weight = exp(-0.5 * (double)(i * i) / (double)(sigma * sigma));
+				const float *elem = input->getElem(xx, yy);
+				for (int ch = 0; ch < 4; ch++) {
+					sum[ch] += weight * elem[ch];
+				}
+				weight_sum += weight;
+			}
+			for (int ch = 0; ch < 4; ch++) {
+				output->getElem(x, y)[ch] = (float)(sum[ch] / weight_sum);
+			}
+		}
+	}
+}
+
+/* The recursive filter approximates the gaussian, compare with a tolerance,
+ * which also holds for the pixels next to the borders. */
+static void iir_gauss_test(int width, int height, float sigma, float tolerance)
+{
+	RNG *rng = BLI_rng_new(width + height);
+	MemoryBuffer *input = buffer_new(width, height, rng);
+	MemoryBuffer *temp = buffer_new(width, height, NULL);
+	MemoryBuffer *expected = buffer_new(width, height, NULL);
+
+	/* A step in the middle and noise on top of a ramp, so extending the border pixels instead of
+	 * normalizing the weights inside the image makes a difference next to the borders. */
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			float *elem = input->getElem(x, y);
+			for (int ch = 0; ch < 4; ch++) {
+				elem[ch] = ((x < width / 2) == (y < height / 2) ? 0.2f : 0.8f) + 0.2f * (elem[ch] - 0.5f) +
+				           0.3f * (float)(x + y) / (float)(width + height);
+			}
+		}
+	}
+
+	gauss_direct(temp, input, sigma, true);
+	gauss_direct(expected, temp, sigma, false);
+
+	MemoryBuffer *result = input->duplicate();
+	FastGaussianBlurOperation::IIR_gauss_normalized(result, sigma, 3);
+
+	float max_error = 0.0f;
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			const float *expected_elem = expected->getElem(x, y);
+			const float *result_elem = result->getElem(x, y);
+			for (int ch = 0; ch < 4; ch++) {
+				max_error = max_ff(max_error, fabsf(expected_elem[ch] - result_elem[ch]));
+			}
+		}
+	}
+	EXPECT_LE(max_error, tolerance) << "sigma " << sigma;
+
+	delete input;
+	delete temp;
+	delete expected;
+	delete result;
+	BLI_rng_free(rng);
+}
+
+TEST(compositor_blur, IIRGaussNormalized)
+{
+	blur_test_init();
+	/* The recursive filter is least accurate for small sigma, the error peaks at the step. */
+	iir_gauss_test(83, 47, 1.5f, 0.03f);
+	iir_gauss_test(83, 47, 4.0f, 0.015f);
+	/* Kernel larger than the image height. */
+	iir_gauss_test(83, 47, 15.0f, 0.015f);
+}
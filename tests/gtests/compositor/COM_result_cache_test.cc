@@ -0,0 +1,214 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "COM_MemoryBuffer.h"
+#include "COM_ResultCache.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_rect.h"
+#include "BLI_string.h"
+#include "BKE_colortools.h"
+#include "BKE_node.h"
+#include "DNA_color_types.h"
+#include "DNA_genfile.h"
+#include "DNA_image_types.h"
+#include "DNA_node_types.h"
+}
+
+#define BUFFER_WIDTH 16
+#define BUFFER_HEIGHT 8
+#define BUFFER_SIZE (BUFFER_WIDTH * BUFFER_HEIGHT * COM_NUM_CHANNELS_COLOR * sizeof(float))
+
+static MemoryBuffer *buffer_new(float value)
+{
+	rcti rect;
+	BLI_rcti_init(&rect, 0, BUFFER_WIDTH, 0, BUFFER_HEIGHT);
+	MemoryBuffer *buffer = new MemoryBuffer(COM_DT_COLOR, &rect);
+	float *data = buffer->getBuffer();
+	for (int i = 0; i < BUFFER_WIDTH * BUFFER_HEIGHT * COM_NUM_CHANNELS_COLOR; i++) {
+		data[i] = value;
+	}
+	return buffer;
+}
+
+/* Check that the key is stored with the buffer of the value, the read copy is freed. */
+static bool cache_has(ResultCacheKey key, float value)
+{
+	MemoryBuffer *buffer = ResultCache::read(key);
+	if (buffer == NULL) {
+		return false;
+	}
+	const bool equal = (buffer->getBuffer()[0] == value) &&
+	                   (buffer->getBuffer()[BUFFER_WIDTH * BUFFER_HEIGHT * COM_NUM_CHANNELS_COLOR - 1] == value);
+	delete buffer;
+	return equal;
+}
+
+TEST(compositor_result_cache, StoreRead)
+{
+	ResultCache::setLimit(4 * BUFFER_SIZE);
+	EXPECT_TRUE(ResultCache::isEnabled());
+
+	MemoryBuffer *buffer = buffer_new(1.0f);
+	ResultCache::store(1, buffer);
+	EXPECT_TRUE(cache_has(1, 1.0f));
+	EXPECT_FALSE(cache_has(2, 1.0f));
+
+	/* Reading returns a copy, the stored buffer stays valid. */
+	MemoryBuffer *copy = ResultCache::read(1);
+	ASSERT_TRUE(copy != NULL);
+	EXPECT_NE(copy, buffer);
+	copy->getBuffer()[0] = 5.0f;
+	delete copy;
+	EXPECT_TRUE(cache_has(1, 1.0f));
+
+	/* A key which is already stored keeps its buffer. */
+	ResultCache::store(1, buffer_new(2.0f));
+	EXPECT_TRUE(cache_has(1, 1.0f));
+
+	ResultCache::clear();
+	EXPECT_FALSE(cache_has(1, 1.0f));
+	ResultCache::setLimit(0);
+	EXPECT_FALSE(ResultCache::isEnabled());
+}
+
+TEST(compositor_result_cache, EvictLeastRecentlyUsed)
+{
+	ResultCache::setLimit(3 * BUFFER_SIZE);
+
+	ResultCache::store(1, buffer_new(1.0f));
+	ResultCache::store(2, buffer_new(2.0f));
+	ResultCache::store(3, buffer_new(3.0f));
+	/* Key 2 becomes the most recently used, key 1 the least. */
+	EXPECT_TRUE(cache_has(2, 2.0f));
+
+	ResultCache::store(4, buffer_new(4.0f));
+	EXPECT_FALSE(cache_has(1, 1.0f));
+	EXPECT_TRUE(cache_has(2, 2.0f));
+	EXPECT_TRUE(cache_has(3, 3.0f));
+	EXPECT_TRUE(cache_has(4, 4.0f));
+
+	/* Now 2, 3 and 4 are used in that order. */
+	ResultCache::store(5, buffer_new(5.0f));
+	EXPECT_FALSE(cache_has(2, 2.0f));
+	EXPECT_TRUE(cache_has(3, 3.0f));
+
+	/* Buffers larger than the limit are not stored and don't evict others. */
+	ResultCache::setLimit(3 * BUFFER_SIZE - 1);
+	EXPECT_FALSE(cache_has(4, 4.0f));
+	ResultCache::setLimit(BUFFER_SIZE - 1);
+	EXPECT_FALSE(cache_has(3, 3.0f));
+	EXPECT_FALSE(cache_has(5, 5.0f));
+	ResultCache::store(6, buffer_new(6.0f));
+	EXPECT_FALSE(cache_has(6, 6.0f));
+
+	ResultCache::setLimit(0);
+}
+
+/* Node with storage of a DNA struct, like the nodes of a tree localized for execution. */
+class ResultCacheNode {
+public:
+	bNodeType type;
+	bNode node;
+
+	ResultCacheNode(int node_type, const char *storagename, void *storage)
+	{
+		memset(&type, 0, sizeof(type));
+		memset(&node, 0, sizeof(node));
+		BLI_strncpy(type.storagename, storagename, sizeof(type.storagename));
+		node.type = node_type;
+		node.typeinfo = &type;
+		node.storage = storage;
+	}
+
+	ResultCacheKey key() const
+	{
+		ResultCacheHash hash;
+		hash.addNode(&node);
+		return hash.end();
+	}
+};
+
+static void result_cache_node_test_init()
+{
+	/* Node storage is hashed using the DNA of the structs. */
+	if (DNA_sdna_current_get() == NULL) {
+		DNA_sdna_current_init();
+	}
+}
+
+TEST(compositor_result_cache, NodeKey)
+{
+	result_cache_node_test_init();
+
+	NodeBlurData *data = (NodeBlurData *)MEM_callocN(sizeof(NodeBlurData), __func__);
+	data->sizex = 10;
+	data->sizey = 10;
+	data->fac = 1.0f;
+	ResultCacheNode node(CMP_NODE_BLUR, "NodeBlurData", data);
+	const ResultCacheKey key = node.key();
+	EXPECT_NE(key, 0);
+
+	/* A copy of the node has the same key. */
+	ResultCacheNode node_copy(CMP_NODE_BLUR, "NodeBlurData", MEM_dupallocN(data));
+	EXPECT_EQ(node_copy.key(), key);
+
+	/* Changing a setting changes the key, changing it back restores it. */
+	data->sizex = 11;
+	EXPECT_NE(node.key(), key);
+	data->sizex = 10;
+	data->fac = 0.5f;
+	EXPECT_NE(node.key(), key);
+	data->fac = 1.0f;
+	EXPECT_EQ(node.key(), key);
+
+	node.node.custom1 = 1;
+	EXPECT_NE(node.key(), key);
+	node.node.custom1 = 0;
+	node.node.custom3 = 1.0f;
+	EXPECT_NE(node.key(), key);
+	node.node.custom3 = 0.0f;
+	EXPECT_EQ(node.key(), key);
+
+	MEM_freeN(node.node.storage);
+	MEM_freeN(node_copy.node.storage);
+}
+
+TEST(compositor_result_cache, NodeKeySkipsPointers)
+{
+	result_cache_node_test_init();
+
+	/* The scene of the image user is a pointer, only its values are hashed. */
+	ImageUser *iuser = (ImageUser *)MEM_callocN(sizeof(ImageUser), __func__);
+	iuser->framenr = 1;
+	ResultCacheNode node(CMP_NODE_IMAGE, "ImageUser", iuser);
+	const ResultCacheKey key = node.key();
+
+	iuser->scene = (Scene *)iuser;
+	EXPECT_EQ(node.key(), key);
+	iuser->framenr = 2;
+	EXPECT_NE(node.key(), key);
+
+	MEM_freeN(iuser);
+}
+
+TEST(compositor_result_cache, NodeKeyCurveMapping)
+{
+	result_cache_node_test_init();
+
+	/* Curve mappings are hashed by their points, copies have different pointers. */
+	CurveMapping *cumap = curvemapping_add(4, 0.0f, 0.0f, 1.0f, 1.0f);
+	CurveMapping *cumap_copy = curvemapping_copy(cumap);
+	ResultCacheNode node(CMP_NODE_CURVE_RGB, "CurveMapping", cumap);
+	ResultCacheNode node_copy(CMP_NODE_CURVE_RGB, "CurveMapping", cumap_copy);
+	const ResultCacheKey key = node.key();
+	EXPECT_EQ(node_copy.key(), key);
+
+	cumap_copy->cm[1].curve[0].y = 0.25f;
+	EXPECT_NE(node_copy.key(), key);
+
+	curvemapping_free(cumap);
+	curvemapping_free(cumap_copy);
+}
@@ -0,0 +1,171 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "COM_ConvertOperation.h"
+#include "COM_MathBaseOperation.h"
+#include "COM_MixOperation.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_rand.h"
+#include "PIL_time.h"
+}
+
+/* 4K frame, processed row by row like full frame execution does. */
+#define FRAME_WIDTH 3840
+#define FRAME_HEIGHT 2160
+
+static float *frame_new(int channels, RNG *rng)
+{
+	const size_t len = (size_t)FRAME_WIDTH * FRAME_HEIGHT * channels;
+	float *frame = (float *)MEM_malloc_arrayN(len, sizeof(float), __func__);
+	for (size_t i = 0; i < len; i++) {
+		frame[i] = BLI_rng_get_float(rng);
+	}
+	return frame;
+}
+
+static void print_timings(const char *name, double time_scalar, double time_row)
+{
+	printf("%-24s scalar %.4f s, row kernel %.4f s (%.2fx)\n",
+	       name, time_scalar, time_row, time_scalar / time_row);
+}
+
+static void mix_row_perf(const char *name, MixBaseOperation &op)
+{
+	RNG *rng = BLI_rng_new(0);
+	float *value = frame_new(1, rng);
+	float *color1 = frame_new(4, rng);
+	float *color2 = frame_new(4, rng);
+	float *output = frame_new(4, rng);
+	double time_start;
+
+	time_start = PIL_check_seconds_timer();
+	for (int y = 0; y < FRAME_HEIGHT; y++) {
+		const size_t row = (size_t)y * FRAME_WIDTH;
+		op.MixBaseOperation::mixRow(output + row * 4, value + row, color1 + row * 4, color2 + row * 4,
+		                            1, 4, 4, FRAME_WIDTH);
+	}
+	const double time_scalar = PIL_check_seconds_timer() - time_start;
+
+	time_start = PIL_check_seconds_timer();
+	for (int y = 0; y < FRAME_HEIGHT; y++) {
+		const size_t row = (size_t)y * FRAME_WIDTH;
+		op.mixRow(output + row * 4, value + row, color1 + row * 4, color2 + row * 4,
+		          1, 4, 4, FRAME_WIDTH);
+	}
+	print_timings(name, time_scalar, PIL_check_seconds_timer() - time_start);
+
+	MEM_freeN(value);
+	MEM_freeN(color1);
+	MEM_freeN(color2);
+	MEM_freeN(output);
+	BLI_rng_free(rng);
+}
+
+static void math_row_perf(const char *name, MathBaseOperation &op)
+{
+	RNG *rng = BLI_rng_new(0);
+	float *value1 = frame_new(1, rng);
+	float *value2 = frame_new(1, rng);
+	float *output = frame_new(1, rng);
+	double time_start;
+
+	time_start = PIL_check_seconds_timer();
+	for (int y = 0; y < FRAME_HEIGHT; y++) {
+		const size_t row = (size_t)y * FRAME_WIDTH;
+		op.MathBaseOperation::mathRow(output + row, value1 + row, value2 + row, 1, 1, FRAME_WIDTH);
+	}
+	const double time_scalar = PIL_check_seconds_timer() - time_start;
+
+	time_start = PIL_check_seconds_timer();
+	for (int y = 0; y < FRAME_HEIGHT; y++) {
+		const size_t row = (size_t)y * FRAME_WIDTH;
+		op.mathRow(output + row, value1 + row, value2 + row, 1, 1, FRAME_WIDTH);
+	}
+	print_timings(name, time_scalar, PIL_check_seconds_timer() - time_start);
+
+	MEM_freeN(value1);
+	MEM_freeN(value2);
+	MEM_freeN(output);
+	BLI_rng_free(rng);
+}
+
+static void convert_row_perf(const char *name, ConvertBaseOperation &op, int input_channels)
+{
+	RNG *rng = BLI_rng_new(0);
+	float *input = frame_new(input_channels, rng);
+	float *output = frame_new(4, rng);
+	double time_start;
+
+	time_start = PIL_check_seconds_timer();
+	for (int y = 0; y < FRAME_HEIGHT; y++) {
+		const size_t row = (size_t)y * FRAME_WIDTH;
+		op.ConvertBaseOperation::convertRow(output + row * 4, input + row * input_channels,
+		                                    input_channels, 4, FRAME_WIDTH);
+	}
+	const double time_scalar = PIL_check_seconds_timer() - time_start;
+
+	time_start = PIL_check_seconds_timer();
+	for (int y = 0; y < FRAME_HEIGHT; y++) {
+		const size_t row = (size_t)y * FRAME_WIDTH;
+		op.convertRow(output + row * 4, input + row * input_channels, input_channels, 4, FRAME_WIDTH);
+	}
+	print_timings(name, time_scalar, PIL_check_seconds_timer() - time_start);
+
+	MEM_freeN(input);
+	MEM_freeN(output);
+	BLI_rng_free(rng);
+}
+
+#define MIX_ROW_PERF(name) \
+	do { \
+		Mix##name##Operation op; \
+		mix_row_perf("Mix " #name, op); \
+	} while (0)
+
+#define MATH_ROW_PERF(name) \
+	do { \
+		Math##name##Operation op; \
+		math_row_perf("Math " #name, op); \
+	} while (0)
+
+TEST(compositor_row_kernels, Frame4K)
+{
+	printf("\n========== STARTING %s ==========\n", "Frame4K");
+
+	MIX_ROW_PERF(Add);
+	MIX_ROW_PERF(Blend);
+	MIX_ROW_PERF(Darken);
+	MIX_ROW_PERF(Difference);
+	MIX_ROW_PERF(Lighten);
+	MIX_ROW_PERF(Multiply);
+	MIX_ROW_PERF(Screen);
+	MIX_ROW_PERF(Subtract);
+
+	MATH_ROW_PERF(Add);
+	MATH_ROW_PERF(Subtract);
+	MATH_ROW_PERF(Multiply);
+	MATH_ROW_PERF(Divide);
+	MATH_ROW_PERF(Minimum);
+	MATH_ROW_PERF(Maximum);
+	MATH_ROW_PERF(LessThan);
+	MATH_ROW_PERF(GreaterThan);
+	MATH_ROW_PERF(Absolute);
+
+	{
+		ConvertValueToColorOperation op;
+		convert_row_perf("Convert Value to Color", op, 1);
+	}
+	{
+		ConvertPremulToStraightOperation op;
+		convert_row_perf("Convert Premul to Straight", op, 4);
+	}
+	{
+		ConvertStraightToPremulOperation op;
+		convert_row_perf("Convert Straight to Premul", op, 4);
+	}
+
+	printf("========== ENDED %s ==========\n\n", "Frame4K");
+}
@@ -0,0 +1,176 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "COM_ConvertOperation.h"
+#include "COM_MathBaseOperation.h"
+#include "COM_MixOperation.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_rand.h"
+}
+
+/* Odd width, so vectorized kernels also run their remainder. */
+#define ROW_WIDTH 67
+
+/* The row functions of the base classes call the scalar per pixel code,
+ * the subclasses override them with vectorized kernels when built with SSE2. */
+
+static float *row_new(int channels, RNG *rng)
+{
+	float *row = (float *)MEM_malloc_arrayN(ROW_WIDTH * channels, sizeof(float), __func__);
+	for (int i = 0; i < ROW_WIDTH * channels; i++) {
+		row[i] = BLI_rng_get_float(rng) * 4.0f - 2.0f;
+		/* Zero every few values, for Divide by zero and transparent pixels. */
+		if (BLI_rng_get_int(rng) % 5 == 0) {
+			row[i] = 0.0f;
+		}
+	}
+	return row;
+}
+
+static void row_expect_eq(const float *expected, const float *result, int len)
+{
+	for (int i = 0; i < len; i++) {
+		EXPECT_FLOAT_EQ(expected[i], result[i]) << "at " << i;
+	}
+}
+
+static void mix_row_test(MixBaseOperation &op)
+{
+	RNG *rng = BLI_rng_new(0);
+	float *value = row_new(1, rng);
+	float *color1 = row_new(4, rng);
+	float *color2 = row_new(4, rng);
+	float expected[ROW_WIDTH * 4], result[ROW_WIDTH * 4];
+
+	for (int flag = 0; flag < 4; flag++) {
+		op.setUseValueAlphaMultiply(flag & 1);
+		op.setUseClamp(flag & 2);
+
+		/* Buffers of every input, and a constant value and color. */
+		const int value_strides[2] = {1, 0};
+		const int color_strides[2] = {4, 0};
+		for (int s = 0; s < 2; s++) {
+			op.MixBaseOperation::mixRow(expected, value, color1, color2,
+			                            value_strides[s], 4, color_strides[s], ROW_WIDTH);
+			op.mixRow(result, value, color1, color2,
+			          value_strides[s], 4, color_strides[s], ROW_WIDTH);
+			row_expect_eq(expected, result, ROW_WIDTH * 4);
+		}
+	}
+
+	MEM_freeN(value);
+	MEM_freeN(color1);
+	MEM_freeN(color2);
+	BLI_rng_free(rng);
+}
+
+static void math_row_test(MathBaseOperation &op)
+{
+	RNG *rng = BLI_rng_new(0);
+	float *value1 = row_new(1, rng);
+	float *value2 = row_new(1, rng);
+	const float zero = 0.0f;
+	float expected[ROW_WIDTH], result[ROW_WIDTH];
+
+	for (int clamp = 0; clamp < 2; clamp++) {
+		op.setUseClamp(clamp);
+
+		op.MathBaseOperation::mathRow(expected, value1, value2, 1, 1, ROW_WIDTH);
+		op.mathRow(result, value1, value2, 1, 1, ROW_WIDTH);
+		row_expect_eq(expected, result, ROW_WIDTH);
+
+		/* Constant inputs are broadcast. */
+		op.MathBaseOperation::mathRow(expected, value1, value2 + 3, 1, 0, ROW_WIDTH);
+		op.mathRow(result, value1, value2 + 3, 1, 0, ROW_WIDTH);
+		row_expect_eq(expected, result, ROW_WIDTH);
+
+		op.MathBaseOperation::mathRow(expected, value1 + 3, value2, 0, 1, ROW_WIDTH);
+		op.mathRow(result, value1 + 3, value2, 0, 1, ROW_WIDTH);
+		row_expect_eq(expected, result, ROW_WIDTH);
+
+		/* Constant zero, as in Divide by zero. */
+		op.MathBaseOperation::mathRow(expected, value1, &zero, 1, 0, ROW_WIDTH);
+		op.mathRow(result, value1, &zero, 1, 0, ROW_WIDTH);
+		row_expect_eq(expected, result, ROW_WIDTH);
+	}
+
+	MEM_freeN(value1);
+	MEM_freeN(value2);
+	BLI_rng_free(rng);
+}
+
+static void convert_row_test(ConvertBaseOperation &op, int input_channels, int output_channels)
+{
+	RNG *rng = BLI_rng_new(0);
+	float *input = row_new(input_channels, rng);
+	float expected[ROW_WIDTH * 4], result[ROW_WIDTH * 4];
+
+	if (input_channels == 4) {
+		/* Alpha around the threshold under which Premul to Straight gives black. */
+		const float alphas[] = {0.0f, -0.0f, 1e-6f, -1e-6f, 1e-5f, -1e-5f, 2e-5f};
+		for (int i = 0; i < (int)ARRAY_SIZE(alphas); i++) {
+			input[i * 4 + 3] = alphas[i];
+		}
+	}
+
+	op.ConvertBaseOperation::convertRow(expected, input, input_channels, output_channels, ROW_WIDTH);
+	op.convertRow(result, input, input_channels, output_channels, ROW_WIDTH);
+	row_expect_eq(expected, result, ROW_WIDTH * output_channels);
+
+	MEM_freeN(input);
+	BLI_rng_free(rng);
+}
+
+#define MIX_ROW_TEST(name) \
+	TEST(compositor_row_kernels, Mix##name) \
+	{ \
+		Mix##name##Operation op; \
+		mix_row_test(op); \
+	}
+
+#define MATH_ROW_TEST(name) \
+	TEST(compositor_row_kernels, Math##name) \
+	{ \
+		Math##name##Operation op; \
+		math_row_test(op); \
+	}
+
+MIX_ROW_TEST(Add)
+MIX_ROW_TEST(Blend)
+MIX_ROW_TEST(Darken)
+MIX_ROW_TEST(Difference)
+MIX_ROW_TEST(Lighten)
+MIX_ROW_TEST(Multiply)
+MIX_ROW_TEST(Screen)
+MIX_ROW_TEST(Subtract)
+
+MATH_ROW_TEST(Add)
+MATH_ROW_TEST(Subtract)
+MATH_ROW_TEST(Multiply)
+MATH_ROW_TEST(Divide)
+MATH_ROW_TEST(Minimum)
+MATH_ROW_TEST(Maximum)
+MATH_ROW_TEST(LessThan)
+MATH_ROW_TEST(GreaterThan)
+MATH_ROW_TEST(Absolute)
+
+TEST(compositor_row_kernels, ConvertValueToColor)
+{
+	ConvertValueToColorOperation op;
+	convert_row_test(op, 1, 4);
+}
+
+TEST(compositor_row_kernels, ConvertPremulToStraight)
+{
+	ConvertPremulToStraightOperation op;
+	convert_row_test(op, 4, 4);
+}
+
+TEST(compositor_row_kernels, ConvertStraightToPremul)
+{
+	ConvertStraightToPremulOperation op;
+	convert_row_test(op, 4, 4);
+}
@@ -0,0 +1,63 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "COM_WorkScheduler.h"
+
+extern "C" {
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
+}
+
+/* Differs from the system thread count, so the WorkScheduler creates its own task scheduler. */
+#define FIXED_THREADS 3
+
+static void work_scheduler_test_init()
+{
+	BLI_threadapi_init();
+}
+
+static void count_threads_cb(void *__restrict userdata, const int /*iter*/, const ParallelRangeTLS *__restrict tls)
+{
+	bool *thread_used = (bool *)userdata;
+	thread_used[tls->thread_id] = true;
+	/* Keep the thread busy, so the other threads get iterations as well. */
+	PIL_sleep_ms(1);
+}
+
+TEST(compositor_work_scheduler, FixedThreads)
+{
+	work_scheduler_test_init();
+	const int system_threads = BLI_system_thread_count();
+	const int fixed_threads = (system_threads == FIXED_THREADS) ? FIXED_THREADS + 1 : FIXED_THREADS;
+
+	/* The number of threads of the system shares the global task scheduler. */
+	WorkScheduler::initialize(false, system_threads);
+	EXPECT_EQ(WorkScheduler::get_task_scheduler(), BLI_task_scheduler_get());
+
+	WorkScheduler::initialize(false, fixed_threads);
+	TaskScheduler *scheduler = WorkScheduler::get_task_scheduler();
+	EXPECT_NE(scheduler, BLI_task_scheduler_get());
+	EXPECT_EQ(BLI_task_scheduler_num_threads(scheduler), fixed_threads);
+
+	/* The scheduler is kept while the number of threads doesn't change. */
+	WorkScheduler::initialize(false, fixed_threads);
+	EXPECT_EQ(WorkScheduler::get_task_scheduler(), scheduler);
+
+	/* Loops of operations run on the threads of the scheduler. */
+	bool thread_used[BLENDER_MAX_THREADS] = {false};
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+	settings.scheduler = WorkScheduler::get_task_scheduler();
+	BLI_task_parallel_range(0, 64 * fixed_threads, thread_used, count_threads_cb, &settings);
+	for (int i = fixed_threads; i < BLENDER_MAX_THREADS; i++) {
+		EXPECT_FALSE(thread_used[i]) << "thread " << i;
+	}
+
+	WorkScheduler::deinitialize();
+	EXPECT_EQ(WorkScheduler::get_task_scheduler(), BLI_task_scheduler_get());
+
+	BLI_threadapi_exit();
+}
@@ -0,0 +1,262 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Measures the end-to-end time of compositing, from starting the render
+until the composite result is written, for a set of generated node trees.
+
+Example Usage:
+
+./blender.bin --background --factory-startup \
+    --python tests/python/compositor_benchmark.py -- \
+    --resolution=1920x1080 --repeat=5 --json=/tmp/after.json \
+    --compare=/tmp/before.json
+
+The trees are built from an image generated in memory, so no files are
+needed and no scene is rendered. The result cache is disabled so that
+every repetition composites the whole tree.
+
+Write the statistics of one build with --json, and pass that file with
+--compare when running another build to print the speedup per tree.
+
+Pass --sweep to also blur with radii from 16 to 512 pixels, which compares
+the FFT and recursive blurs with the direct kernels of older builds. The
+largest direct kernels take minutes per repetition, use --repeat=1 there.
+"""
+
+import json
+import sys
+import time
+
+import bpy
+
+
+def tree_clear(tree):
+    for node in tree.nodes[:]:
+        tree.nodes.remove(node)
+
+
+def tree_add_image(tree, image):
+    node = tree.nodes.new("CompositorNodeImage")
+    node.image = image
+    return node
+
+
+def tree_add_composite(tree, socket):
+    node = tree.nodes.new("CompositorNodeComposite")
+    tree.links.new(socket, node.inputs["Image"])
+    return node
+
+
+def build_blur(tree, image):
+    """ Large gaussian blur, many chunks depend on many input chunks. """
+    source = tree_add_image(tree, image)
+    blur = tree.nodes.new("CompositorNodeBlur")
+    blur.filter_type = 'GAUSS'
+    blur.size_x = 64
+    blur.size_y = 64
+    tree.links.new(source.outputs["Image"], blur.inputs["Image"])
+    tree_add_composite(tree, blur.outputs["Image"])
+
+
+def build_chain(tree, image):
+    """ Long chain of per pixel operations, many small execution groups. """
+    socket = tree_add_image(tree, image).outputs["Image"]
+    for i in range(24):
+        if i % 3 == 0:
+            node = tree.nodes.new("CompositorNodeHueSat")
+            node.inputs["Saturation"].default_value = 1.05
+        elif i % 3 == 1:
+            node = tree.nodes.new("CompositorNodeGamma")
+            node.inputs["Gamma"].default_value = 1.01
+        else:
+            node = tree.nodes.new("CompositorNodeBrightContrast")
+            node.inputs["Contrast"].default_value = 2.0
+        tree.links.new(socket, node.inputs["Image"])
+        socket = node.outputs["Image"]
+        if i % 8 == 7:
+            # force a buffer between parts of the chain
+            blur = tree.nodes.new("CompositorNodeBlur")
+            blur.size_x = 2
+            blur.size_y = 2
+            tree.links.new(socket, blur.inputs["Image"])
+            socket = blur.outputs["Image"]
+    tree_add_composite(tree, socket)
+
+
+def build_glare(tree, image):
+    """ Single threaded operation followed by per pixel operations. """
+    source = tree_add_image(tree, image)
+    glare = tree.nodes.new("CompositorNodeGlare")
+    glare.glare_type = 'FOG_GLOW'
+    glare.quality = 'HIGH'
+    tree.links.new(source.outputs["Image"], glare.inputs["Image"])
+    mix = tree.nodes.new("CompositorNodeMixRGB")
+    mix.blend_type = 'SCREEN'
+    tree.links.new(source.outputs["Image"], mix.inputs[1])
+    tree.links.new(glare.outputs["Image"], mix.inputs[2])
+    tree_add_composite(tree, mix.outputs["Image"])
+
+
+def build_gaussian(radius, use_bokeh):
+    """ Gaussian blur, separable or with a 2D kernel. """
+    def build(tree, image):
+        source = tree_add_image(tree, image)
+        blur = tree.nodes.new("CompositorNodeBlur")
+        blur.filter_type = 'GAUSS'
+        blur.use_bokeh = use_bokeh
+        blur.size_x = radius
+        blur.size_y = radius
+        tree.links.new(source.outputs["Image"], blur.inputs["Image"])
+        tree_add_composite(tree, blur.outputs["Image"])
+    return build
+
+
+def build_bokeh(radius):
+    """ Bokeh blur with a hexagonal bokeh, the size is relative to the image. """
+    def build(tree, image):
+        source = tree_add_image(tree, image)
+        bokeh_image = tree.nodes.new("CompositorNodeBokehImage")
+        bokeh_image.flaps = 6
+        blur = tree.nodes.new("CompositorNodeBokehBlur")
+        # the node clamps the size to 10% of the largest image dimension
+        blur.inputs["Size"].default_value = min(10.0, radius * 100.0 / max(image.size))
+        tree.links.new(source.outputs["Image"], blur.inputs["Image"])
+        tree.links.new(bokeh_image.outputs["Image"], blur.inputs["Bokeh"])
+        tree_add_composite(tree, blur.outputs["Image"])
+    return build
+
+
+TREES = {
+    "blur": build_blur,
+    "chain": build_chain,
+    "glare": build_glare,
+}
+
+SWEEP_RADII = (16, 32, 64, 128, 256, 512)
+
+SWEEP_TREES = {}
+for radius in SWEEP_RADII:
+    SWEEP_TREES["gaussian_%d" % radius] = build_gaussian(radius, False)
+    SWEEP_TREES["gaussian_bokeh_%d" % radius] = build_gaussian(radius, True)
+    SWEEP_TREES["bokeh_%d" % radius] = build_bokeh(radius)
+del radius
+
+
+def benchmark_tree(scene, build, image, repeat):
+    tree = scene.node_tree
+    tree_clear(tree)
+    build(tree, image)
+
+    timings = []
+    for _ in range(repeat):
+        start = time.perf_counter()
+        bpy.ops.render.render()
+        timings.append(time.perf_counter() - start)
+    return timings
+
+
+def statistics(timings):
+    timings = sorted(timings)
+    return {
+        "min": timings[0],
+        "median": timings[len(timings) // 2],
+        "max": timings[-1],
+        "timings": timings,
+    }
+
+
+def print_comparison(results, baseline):
+    print("\n%-20s %12s %12s %9s" % ("tree", "baseline", "current", "speedup"))
+    for name, stats in sorted(results["trees"].items()):
+        base = baseline.get("trees", {}).get(name)
+        if base is None:
+            print("%-20s %12s %11.4fs %9s" % (name, "-", stats["median"], "-"))
+            continue
+        print("%-20s %11.4fs %11.4fs %8.2fx" %
+              (name, base["median"], stats["median"], base["median"] / stats["median"]))
+
+
+def main():
+    import argparse
+
+    argv = sys.argv
+    argv = argv[argv.index("--") + 1:] if "--" in argv else []
+
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--resolution", default="1920x1080",
+                        help="Resolution of the image, as WIDTHxHEIGHT")
+    parser.add_argument("--repeat", type=int, default=5,
+                        help="Number of times every tree is composited")
+    parser.add_argument("--tree", action="append", choices=sorted(TREES.keys()) + sorted(SWEEP_TREES.keys()),
+                        help="Tree to benchmark, can be passed multiple times (default all)")
+    parser.add_argument("--sweep", action="store_true",
+                        help="Also benchmark the blurs with radii %s" % ", ".join(str(r) for r in SWEEP_RADII))
+    parser.add_argument("--full-frame", action="store_true",
+                        help="Use the full frame execution mode")
+    parser.add_argument("--json", help="File to write the statistics to")
+    parser.add_argument("--compare", help="Statistics of another run to compare with")
+    args = parser.parse_args(argv)
+
+    width, height = (int(x) for x in args.resolution.lower().split("x"))
+
+    scene = bpy.context.scene
+    scene.render.resolution_x = width
+    scene.render.resolution_y = height
+    scene.render.resolution_percentage = 100
+    scene.render.use_compositing = True
+    scene.render.use_sequencer = False
+    scene.use_nodes = True
+    scene.node_tree.use_full_frame = args.full_frame
+    scene.node_tree.cache_size = 0
+
+    image = bpy.data.images.new("benchmark", width, height, float_buffer=True)
+    image.generated_type = 'COLOR_GRID'
+
+    results = {
+        "resolution": [width, height],
+        "repeat": args.repeat,
+        "full_frame": args.full_frame,
+        "trees": {},
+    }
+    trees = dict(TREES)
+    trees.update(SWEEP_TREES)
+    names = args.tree or sorted(TREES.keys())
+    if args.sweep and not args.tree:
+        names += sorted(SWEEP_TREES.keys())
+
+    for name in names:
+        stats = statistics(benchmark_tree(scene, trees[name], image, args.repeat))
+        results["trees"][name] = stats
+        print("%-20s median %.4fs  min %.4fs  max %.4fs" %
+              (name, stats["median"], stats["min"], stats["max"]))
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(results, f, indent=2)
+
+    if args.compare:
+        with open(args.compare) as f:
+            print_comparison(results, json.load(f))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,182 @@
+# Apache License, Version 2.0
+
+# ./blender.bin --background -noaudio --factory-startup --python tests/python/cycles_persistent_data_test.py -- --verbose
+
+# Renders with persistent data keep the synced scene between frames, and only
+# sync the data which changed. Compare animations rendered with and without it.
+
+import bpy
+import os
+import shutil
+import tempfile
+import unittest
+
+FRAMES = (1, 2, 3)
+
+
+def keyframes(data, path, values):
+    for frame, value in zip(FRAMES, values):
+        setattr(data, path, value)
+        data.keyframe_insert(path, frame=frame)
+
+
+def emission_node_tree(id_data, node_type, color, strength):
+    id_data.use_nodes = True
+    tree = id_data.node_tree
+    for node in list(tree.nodes):
+        if node.type not in {'OUTPUT_MATERIAL', 'OUTPUT_LAMP', 'OUTPUT_WORLD'}:
+            tree.nodes.remove(node)
+    output = tree.nodes[0]
+    node = tree.nodes.new(node_type)
+    node.inputs["Color"].default_value = color
+    node.inputs["Strength"].default_value = strength
+    tree.links.new(node.outputs[0], output.inputs["Surface"])
+    return node
+
+
+def grid_mesh(name, size, subdivisions):
+    verts = []
+    faces = []
+    for y in range(subdivisions + 1):
+        for x in range(subdivisions + 1):
+            verts.append(((x / subdivisions - 0.5) * size, 0.0, (y / subdivisions - 0.5) * size))
+    for y in range(subdivisions):
+        for x in range(subdivisions):
+            i = y * (subdivisions + 1) + x
+            faces.append((i, i + 1, i + subdivisions + 2, i + subdivisions + 1))
+    mesh = bpy.data.meshes.new(name)
+    mesh.from_pydata(verts, [], faces)
+    mesh.update()
+    return mesh
+
+
+def add_object(scene, name, data, location):
+    ob = bpy.data.objects.new(name, data)
+    ob.location = location
+    scene.master_collection.objects.link(ob)
+    return ob
+
+
+class PersistentDataTest(unittest.TestCase):
+
+    def setUp(self):
+        self.tempdir = tempfile.mkdtemp()
+
+        scene = bpy.context.scene
+        for ob in list(scene.objects):
+            bpy.data.objects.remove(ob)
+        self.scene = scene
+
+        render = scene.render
+        render.engine = 'CYCLES'
+        render.resolution_x = 48
+        render.resolution_y = 32
+        render.resolution_percentage = 100
+        render.image_settings.file_format = 'PNG'
+        render.image_settings.color_depth = '16'
+        scene.cycles.samples = 4
+        scene.frame_start = FRAMES[0]
+        scene.frame_end = FRAMES[-1]
+
+        camera = add_object(scene, "Camera", bpy.data.cameras.new("Camera"), (0.0, -8.0, 0.0))
+        camera.rotation_euler = (1.5707963, 0.0, 0.0)
+        scene.camera = camera
+
+        # Wall behind everything, with a material which doesn't change.
+        wall = add_object(scene, "Wall", grid_mesh("Wall", 20.0, 1), (0.0, 4.0, 0.0))
+        material = bpy.data.materials.new("Wall")
+        wall.data.materials.append(material)
+        material.use_nodes = True
+
+        # Object which moves.
+        mover = add_object(scene, "Mover", grid_mesh("Mover", 1.0, 1), (0.0, 0.0, 0.0))
+        keyframes(mover, "location", ((-2.0, 0.0, 1.0), (0.0, 0.0, 1.0), (2.0, 0.0, 1.0)))
+
+        # Mesh which deforms with an animated shape key.
+        deformer = add_object(scene, "Deformer", grid_mesh("Deformer", 1.5, 4), (0.0, 0.0, -1.0))
+        deformer.shape_key_add(name="Basis")
+        key = deformer.shape_key_add(name="Wave")
+        for i, point in enumerate(key.data):
+            point.co.x += 1.5 * (i % 2)
+        keyframes(key, "value", (0.0, 0.5, 1.0))
+
+        # Material with an animated emission strength.
+        glow = bpy.data.materials.new("Glow")
+        deformer.data.materials.append(glow)
+        node = emission_node_tree(glow, "ShaderNodeEmission", (1.0, 0.5, 0.1, 1.0), 1.0)
+        keyframes(node.inputs["Strength"], "default_value", (0.5, 2.0, 5.0))
+
+        # Lamp with an animated strength.
+        lamp_data = bpy.data.lamps.new("Lamp", 'POINT')
+        node = emission_node_tree(lamp_data, "ShaderNodeEmission", (1.0, 1.0, 1.0, 1.0), 100.0)
+        keyframes(node.inputs["Strength"], "default_value", (100.0, 400.0, 50.0))
+        add_object(scene, "Lamp", lamp_data, (1.0, -3.0, 2.0))
+
+        # World with an animated color.
+        world = bpy.data.worlds.new("World")
+        scene.world = world
+        node = emission_node_tree(world, "ShaderNodeBackground", (0.1, 0.1, 0.1, 1.0), 1.0)
+        keyframes(node.inputs["Color"], "default_value",
+                  ((0.1, 0.1, 0.1, 1.0), (0.1, 0.4, 0.1, 1.0), (0.1, 0.1, 0.6, 1.0)))
+
+    def tearDown(self):
+        shutil.rmtree(self.tempdir)
+
+    def render_animation(self, name, persistent_data):
+        self.scene.render.use_persistent_data = persistent_data
+        self.scene.render.filepath = os.path.join(self.tempdir, name + "_")
+        bpy.ops.render.render(animation=True)
+        return [self.load_frame(name, frame) for frame in FRAMES]
+
+    def render_frame(self, name, frame, persistent_data):
+        self.scene.render.use_persistent_data = persistent_data
+        self.scene.frame_set(frame)
+        bpy.ops.render.render()
+        filepath = os.path.join(self.tempdir, "%s_%04d.png" % (name, frame))
+        bpy.data.images["Render Result"].save_render(filepath)
+        return self.load_frame(name, frame)
+
+    def load_frame(self, name, frame):
+        filepath = os.path.join(self.tempdir, "%s_%04d.png" % (name, frame))
+        self.assertTrue(os.path.exists(filepath), filepath)
+        image = bpy.data.images.load(filepath)
+        pixels = image.pixels[:]
+        bpy.data.images.remove(image)
+        return pixels
+
+    def assertImagesEqual(self, pixels1, pixels2, msg):
+        self.assertEqual(len(pixels1), len(pixels2))
+        max_diff = max(abs(a - b) for a, b in zip(pixels1, pixels2))
+        self.assertLess(max_diff, 1e-3, msg)
+
+    def assertImagesDiffer(self, pixels1, pixels2, msg):
+        max_diff = max(abs(a - b) for a, b in zip(pixels1, pixels2))
+        self.assertGreater(max_diff, 0.05, msg)
+
+    def test_animation(self):
+        reference = self.render_animation("reference", False)
+        persistent = self.render_animation("persistent", True)
+
+        for i in range(1, len(FRAMES)):
+            self.assertImagesDiffer(reference[i - 1], reference[i], "frame %d is not animated" % FRAMES[i])
+        for frame, pixels_ref, pixels in zip(FRAMES, reference, persistent):
+            self.assertImagesEqual(pixels_ref, pixels, "frame %d differs with persistent data" % frame)
+
+    def test_edit_between_renders(self):
+        reference = self.render_frame("reference", FRAMES[0], False)
+        self.render_frame("persistent", FRAMES[0], True)
+
+        # Edits made between renders are synced as well.
+        self.scene.objects["Mover"].animation_data_clear()
+        self.scene.objects["Mover"].location = (0.0, 0.0, -2.0)
+        edited = self.render_frame("edited", FRAMES[0], True)
+        self.assertImagesDiffer(reference, edited, "edit is not rendered with persistent data")
+
+        edited_ref = self.render_frame("edited_reference", FRAMES[0], False)
+        self.assertImagesEqual(edited_ref, edited, "edit differs with persistent data")
+
+
+if __name__ == '__main__':
+    import sys
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()